@@ -0,0 +1,113 @@
+#include "base32.h"
+
+// ============================================================================
+// === TABELA DE DECODIFICAÇÃO ===
+// ============================================================================
+// Valor de 5 bits de cada caractere (A-Z, a-z, 2-7); 0xFF para os demais.
+// O OR dos valores de um grupo tem os bits altos ligados se houver caractere inválido.
+static const uint8_t DECODE_TABLE[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static const uint8_t INVALID_BITS = 0xE0;
+
+// Bytes produzidos por um grupo final com 'chars' caracteres (0 = combinação impossível)
+static const uint8_t TAIL_BYTES[8] = {0, 0, 1, 0, 2, 3, 0, 4};
+
+// Remove o padding final; não aceita mais de 6 '=' (máximo do RFC 4648)
+static size_t strip_padding(const uint8_t *encoded, size_t encodedLength) {
+    size_t len = encodedLength;
+    while (len > 0 && encoded[len - 1] == '=' && encodedLength - len < 6) len--;
+    return len;
+}
+
+// Grava os 'count' bytes mais altos de um grupo de 40 bits
+static inline void store_group(uint8_t *out, uint64_t bits, size_t count) {
+    for (size_t i = 0; i < count; i++) out[i] = (uint8_t)(bits >> (32 - 8 * i));
+}
+
+// ============================================================================
+// === DECODIFICAÇÃO ===
+// ============================================================================
+
+int base32_decodedLength(const uint8_t *encoded, size_t encodedLength) {
+    size_t chars = strip_padding(encoded, encodedLength);
+    size_t tail = chars % 8;
+    if (tail != 0 && TAIL_BYTES[tail] == 0) return BASE32_ERR_INVALID_LENGTH;
+    return (int)((chars / 8) * 5 + TAIL_BYTES[tail]);
+}
+
+int base32_decode(const uint8_t *encoded, size_t encodedLength, uint8_t *result, size_t bufSize) {
+    if (!encoded) return BASE32_ERR_INVALID_CHAR;
+    size_t chars = strip_padding(encoded, encodedLength);
+    int total = base32_decodedLength(encoded, encodedLength);
+    if (total < 0) return total;
+    if ((size_t)total > bufSize) return BASE32_ERR_TOO_LONG; // Nada é escrito
+    // Padding só é aceito se a string completa tiver múltiplo de 8 caracteres
+    if (chars != encodedLength && encodedLength % 8 != 0) return BASE32_ERR_INVALID_LENGTH;
+
+    const uint8_t *in = encoded;
+    uint8_t *out = result;
+    // Grupos completos: 8 consultas à tabela, um teste de validade e 5 bytes gravados
+    for (size_t g = chars / 8; g > 0; g--, in += 8, out += 5) {
+        uint8_t v0 = DECODE_TABLE[in[0]], v1 = DECODE_TABLE[in[1]], v2 = DECODE_TABLE[in[2]], v3 = DECODE_TABLE[in[3]];
+        uint8_t v4 = DECODE_TABLE[in[4]], v5 = DECODE_TABLE[in[5]], v6 = DECODE_TABLE[in[6]], v7 = DECODE_TABLE[in[7]];
+        if ((v0 | v1 | v2 | v3 | v4 | v5 | v6 | v7) & INVALID_BITS) return BASE32_ERR_INVALID_CHAR;
+        uint64_t bits = ((uint64_t)v0 << 35) | ((uint64_t)v1 << 30) | ((uint64_t)v2 << 25) | ((uint64_t)v3 << 20) |
+                        ((uint64_t)v4 << 15) | ((uint64_t)v5 << 10) | ((uint64_t)v6 << 5) | (uint64_t)v7;
+        store_group(out, bits, 5);
+    }
+    // Grupo final incompleto: completa com zeros e grava só os bytes inteiros
+    size_t tail = chars % 8;
+    if (tail > 0) {
+        uint64_t bits = 0;
+        uint8_t invalid = 0;
+        for (size_t i = 0; i < 8; i++) {
+            uint8_t v = i < tail ? DECODE_TABLE[in[i]] : 0;
+            invalid |= v;
+            bits = (bits << 5) | (v & 0x1F);
+        }
+        if (invalid & INVALID_BITS) return BASE32_ERR_INVALID_CHAR;
+        store_group(out, bits, TAIL_BYTES[tail]);
+    }
+    return total;
+}
+
+// ============================================================================
+// === CODIFICAÇÃO ===
+// ============================================================================
+
+int base32_encode(const uint8_t *data, size_t length, char *result, size_t bufSize) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+    size_t needed = (length * 8 + 4) / 5; // Sem padding
+    if (!result || needed + 1 > bufSize) return 0;
+    uint32_t buffer = 0;
+    int bitsLeft = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        buffer = (buffer << 8) | data[i];
+        bitsLeft += 8;
+        while (bitsLeft >= 5) {
+            result[count++] = ALPHABET[(buffer >> (bitsLeft - 5)) & 0x1F];
+            bitsLeft -= 5;
+        }
+    }
+    if (bitsLeft > 0) result[count++] = ALPHABET[(buffer << (5 - bitsLeft)) & 0x1F];
+    result[count] = '\0';
+    return count;
+}
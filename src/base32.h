@@ -0,0 +1,48 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t
+
+// ============================================================================
+// === BASE32 (RFC 4648) ===
+// ============================================================================
+// Sem dependência do Arduino: compila também no ambiente 'native' (testes no host).
+// O decodificador é estrito: aceita o alfabeto em maiúsculas ou minúsculas e
+// padding '=' apenas no final; qualquer outro caractere é erro.
+
+// --- Códigos de Erro de base32_decode() (valores negativos) ---
+constexpr int BASE32_ERR_INVALID_CHAR = -1;   // Caractere fora do alfabeto (ou '=' no meio)
+constexpr int BASE32_ERR_INVALID_LENGTH = -2; // Quantidade de caracteres impossível (resto 1, 3 ou 6 em 8)
+constexpr int BASE32_ERR_TOO_LONG = -3;       // Resultado maior que o buffer de saída
+
+/**
+ * @brief Calcula, sem decodificar, quantos bytes a string Base32 produz.
+ *        Ignora o padding final; não valida os caracteres.
+ * @param encoded Ponteiro para a string Base32.
+ * @param encodedLength Comprimento da string.
+ * @return Número de bytes do resultado, ou BASE32_ERR_INVALID_LENGTH.
+ */
+int base32_decodedLength(const uint8_t *encoded, size_t encodedLength);
+
+/**
+ * @brief Decodifica uma string Base32 em um buffer binário.
+ *        Usa uma tabela de 256 entradas e processa grupos de 8 caracteres (40 bits) por vez.
+ *        O tamanho do resultado é calculado antes de escrever qualquer byte: se não
+ *        couber em 'bufSize' nada é escrito e BASE32_ERR_TOO_LONG é retornado.
+ * @param encoded Ponteiro para a string Base32 codificada.
+ * @param encodedLength Comprimento da string Base32.
+ * @param result Buffer onde o resultado binário será armazenado.
+ * @param bufSize Tamanho do buffer de resultado (limite do resultado aceito).
+ * @return O número de bytes decodificados (0 para entrada vazia), ou um código BASE32_ERR_* negativo.
+ */
+int base32_decode(const uint8_t *encoded, size_t encodedLength, uint8_t *result, size_t bufSize);
+
+/**
+ * @brief Codifica bytes em Base32 (RFC 4648, alfabeto maiúsculo, sem padding '=').
+ * @param data Bytes de entrada.
+ * @param length Número de bytes.
+ * @param result Buffer de saída (recebe '\0' no final).
+ * @param bufSize Tamanho do buffer; precisa de ceil(length * 8 / 5) + 1.
+ * @return Número de caracteres escritos (sem o '\0'), ou 0 se o buffer for pequeno.
+ */
+int base32_encode(const uint8_t *data, size_t length, char *result, size_t bufSize);
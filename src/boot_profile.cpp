@@ -0,0 +1,137 @@
+#include "boot_profile.h"
+#include "globals.h"
+#include "config.h"
+#include <stdarg.h> // Para va_list
+
+#ifdef ARDUINO
+#include <esp_timer.h> // Para esp_timer_get_time()
+#endif
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+enum class BootStage : uint8_t {
+    SETUP,      // Fases do setup() em andamento
+    FRAME,      // setup() terminou, aguardando a primeira tela
+    WAIT,       // Primeira tela desenhada, aguardando o usuário abrir os códigos
+    CODE,       // Tela de códigos aberta, aguardando o primeiro código
+    DONE
+};
+
+static BootProfile profile = {};
+static BootStage stage = BootStage::DONE; // Sem bootprof_begin() os ganchos não fazem nada
+static uint64_t phase_start_us = 0;
+
+// Microssegundos desde o reset (esp_timer não dá a volta como micros())
+static uint64_t now_us() {
+#ifdef ARDUINO
+    return (uint64_t)esp_timer_get_time();
+#else
+    return micros();
+#endif
+}
+
+static void add_phase(const char *name, uint64_t end_us) {
+    if (profile.count < BOOT_MAX_PHASES) {
+        uint32_t us = (uint32_t)(end_us - phase_start_us);
+        profile.phases[profile.count++] = {name, us};
+        profile.total_us += us;
+    }
+    phase_start_us = end_us;
+}
+
+static void report() {
+    Serial.println("[BOOT] Perfil do boot:");
+    for (int i = 0; i < profile.count; i++) {
+        Serial.printf("[BOOT]   %-12s %9.1f ms\n", profile.phases[i].name, profile.phases[i].us / 1000.0);
+    }
+    if (profile.user_wait_us > 0) {
+        Serial.printf("[BOOT]   (espera no menu: %.1f ms, fora do total)\n", profile.user_wait_us / 1000.0);
+    }
+    Serial.printf("[BOOT] Reset -> %s: %.1f ms (orçamento %lu ms)%s\n",
+                  service_count > 0 ? "primeiro código" : "primeira tela (sem serviços)", profile.total_us / 1000.0,
+                  (unsigned long)BOOT_BUDGET_MS, profile.total_us > BOOT_BUDGET_MS * 1000 ? " [ACIMA DO ORÇAMENTO]" : "");
+    char json[384];
+    bootprof_formatJson(json, sizeof(json));
+    Serial.printf("BOOTPROF %s\n", json);
+}
+
+static void finish() {
+    stage = BootStage::DONE;
+    profile.complete = true;
+    report();
+}
+
+// snprintf acumulado: 'pos' para no fim do buffer em vez de passar dele
+static void append(char *out, size_t size, size_t *pos, const char *fmt, ...) {
+    if (*pos >= size) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(&out[*pos], size - *pos, fmt, args);
+    va_end(args);
+    if (n > 0) *pos += (size_t)n;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void bootprof_begin() {
+    profile = {};
+    phase_start_us = 0; // "runtime": do reset até o início do setup()
+    stage = BootStage::SETUP;
+    add_phase("runtime", now_us());
+}
+
+void bootprof_mark(const char *phase) {
+    if (stage != BootStage::SETUP) return;
+    add_phase(phase, now_us());
+}
+
+void bootprof_endSetup() {
+    if (stage == BootStage::SETUP) stage = BootStage::FRAME;
+}
+
+void bootprof_frameDrawn() {
+    if (stage != BootStage::FRAME) return;
+    uint64_t now = now_us();
+    add_phase("first_frame", now);
+    if (service_count == 0) {
+        finish();
+        return;
+    }
+    stage = current_screen == ScreenState::SCREEN_TOTP_VIEW ? BootStage::CODE : BootStage::WAIT;
+}
+
+void bootprof_codeRequested() {
+    if (stage != BootStage::WAIT) return;
+    uint64_t now = now_us();
+    profile.user_wait_us = (uint32_t)(now - phase_start_us);
+    phase_start_us = now;
+    stage = BootStage::CODE;
+}
+
+void bootprof_codeDrawn() {
+    if (stage != BootStage::CODE) return;
+    uint64_t now = now_us();
+    add_phase("first_code", now);
+    finish();
+}
+
+const BootProfile &bootprof_get() {
+    return profile;
+}
+
+size_t bootprof_formatJson(char *out, size_t size) {
+    if (size == 0) return 0;
+    size_t pos = 0;
+    append(out, size, &pos, "{\"build\":\"%s %s\",\"phases\":{", __DATE__, __TIME__);
+    for (int i = 0; i < profile.count; i++) {
+        append(out, size, &pos, "%s\"%s\":%lu", i ? "," : "", profile.phases[i].name, (unsigned long)profile.phases[i].us);
+    }
+    append(out, size, &pos, "},\"user_wait_us\":%lu,\"total_us\":%lu,\"budget_us\":%lu,\"complete\":%s}",
+           (unsigned long)profile.user_wait_us, (unsigned long)profile.total_us,
+           (unsigned long)(BOOT_BUDGET_MS * 1000), profile.complete ? "true" : "false");
+    return pos < size ? pos : size - 1;
+}
@@ -0,0 +1,59 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include "types.h"  // Para BootProfile
+
+// ============================================================================
+// === PERFIL DO BOOT (RESET -> PRIMEIRO CÓDIGO NA TELA) ===
+// ============================================================================
+// Cada fase do setup() termina com bootprof_mark(); o relógio é o esp_timer
+// (microssegundos desde o reset, 64 bits), então a primeira fase ("runtime")
+// cobre a inicialização do ESP-IDF/Arduino antes do setup(). Depois do setup()
+// vêm a primeira tela desenhada ("first_frame") e, como o boot para no menu, o
+// primeiro código na tela ("first_code"), medido a partir do momento em que o
+// usuário abre a tela de códigos: a espera no menu é informada à parte e fica
+// fora do total. Ao concluir, o perfil vai para a Serial como tabela ("[BOOT]")
+// e como uma linha JSON ("BOOTPROF {...}") para comparar builds.
+
+/**
+ * @brief Zera o perfil e registra a fase "runtime" (reset até agora). Primeira linha do setup().
+ */
+void bootprof_begin();
+
+/**
+ * @brief Encerra a fase atual com o nome dado (literal: só o ponteiro é guardado).
+ */
+void bootprof_mark(const char *phase);
+
+/**
+ * @brief Fim do setup(): o que vier até a primeira tela desenhada conta como "first_frame".
+ */
+void bootprof_endSetup();
+
+/**
+ * @brief Chamar depois de cada desenho de tela no loop. O primeiro encerra "first_frame";
+ *        sem serviços, também conclui o perfil (não haverá código para mostrar).
+ */
+void bootprof_frameDrawn();
+
+/**
+ * @brief A tela de códigos foi aberta: termina a espera do usuário e começa "first_code".
+ */
+void bootprof_codeRequested();
+
+/**
+ * @brief Um código TOTP chegou à tela. O primeiro conclui o perfil e o imprime.
+ */
+void bootprof_codeDrawn();
+
+/**
+ * @brief Perfil atual (completo ou não).
+ */
+const BootProfile &bootprof_get();
+
+/**
+ * @brief Escreve o perfil como uma linha JSON (sem o prefixo "BOOTPROF "):
+ *        {"build":"...","phases":{"runtime":us,...},"user_wait_us":..,"total_us":..,"budget_us":..}
+ * @return Comprimento escrito (truncado em 'size' - 1, como snprintf).
+ */
+size_t bootprof_formatJson(char *out, size_t size);
@@ -0,0 +1,296 @@
+#include <TimeLib.h>
+#include "code_table.h"
+#include "globals.h"
+#include "totp.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "code_timeline.h"
+#include "storage.h"
+#include "crypto/sha_backend.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+static RolloverStats rollover_stats = {0, 0, 0, 0, 0, 0};
+static uint32_t rollover_detect_us = 0;   // micros() da última troca de buffer
+static bool rollover_pending_draw = false; // Virada detectada, aguardando chegar à tela
+
+static uint32_t last_use[KEY_CACHE_SLOTS]; // Relógio lógico do último pedido de código de cada slot
+static uint32_t use_clock = 0;
+
+// Slot com os midstates prontos do id, ou -1 (chave fora do cache, ou o slot mudou de
+// dono sem passar por prepare_service_key)
+static int prepared_slot(int index) {
+    int slot = keystore_slot(index);
+    return slot >= 0 && code_table.key_valid[slot] && code_table.key_owner[slot] == index ? slot : -1;
+}
+
+// Janela que contém 'timestamp': da última fronteira de período de qualquer serviço
+// válido até a próxima. Dentro dela nenhum serviço muda de código.
+static void window_for(uint64_t timestamp, uint64_t *start, uint64_t *end) {
+    uint64_t ws = 0, we = UINT64_MAX;
+    bool any = false;
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        if (codetable_timeBasedAt(slot) < 0) continue;
+        uint32_t period = code_table.keys[slot].period;
+        uint64_t s = timestamp - timestamp % period;
+        if (s > ws) ws = s;
+        if (s + period < we) we = s + period;
+        any = true;
+    }
+    if (!any) { // Sem chaves válidas: janela do período padrão
+        ws = timestamp - timestamp % TOTP_INTERVAL_SECONDS;
+        we = ws + TOTP_INTERVAL_SECONDS;
+    }
+    *start = ws;
+    *end = we;
+}
+
+// Preenche um buffer inteiro para a janela dada. Códigos já pré-calculados na
+// linha do tempo são só copiados; o HMAC roda apenas para os que faltam.
+static void fill_buffer(uint8_t buf, uint64_t start, uint64_t end) {
+    uint32_t *codes = code_table.codes[buf];
+    bool time_based[KEY_CACHE_SLOTS];
+    bool missing[KEY_CACHE_SLOTS];
+    int hits = 0, misses = 0;
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        int id = codetable_timeBasedAt(slot);
+        time_based[slot] = id >= 0;
+        missing[slot] = false;
+        if (id < 0) {
+            codes[slot] = 0;
+        } else if (timeline_lookup(id, start, &codes[slot])) {
+            hits++;
+        } else {
+            missing[slot] = true;
+            misses++;
+        }
+    }
+    if (hits == 0) {
+        codetable_generate(code_table.keys, time_based, KEY_CACHE_SLOTS, start, codes); // Lote completo
+    } else if (misses > 0) {
+        sha_backend_acquire();
+        for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+            if (missing[slot]) codes[slot] = generateTOTPFromState(&code_table.keys[slot], start);
+        }
+        sha_backend_release();
+    }
+    code_table.window_start[buf] = start;
+    code_table.window_end[buf] = end;
+    code_table.ready[buf] = true;
+}
+
+// ============================================================================
+// === PREPARAÇÃO DE CHAVES ===
+// ============================================================================
+
+// Prepara os midstates de um serviço no slot da sua chave, já decodificada na arena
+static bool prepare_service_key(int index) {
+    int slot = keystore_slot(index);
+    if (slot < 0) return false;
+    const TOTPService &service = services[index];
+    const uint8_t *key;
+    size_t key_len = 0;
+    bool ok = keystore_get(index, &key, &key_len) &&
+              prepareTOTPKey(key, key_len, &code_table.keys[slot], service.algorithm, service.digits, service.period);
+    code_table.key_valid[slot] = ok;
+    code_table.key_owner[slot] = (int16_t)index;
+    if (!ok) {
+        Serial.printf("[ERROR] Chave inválida para '%s'. Len: %d\n", namestore_get(index), (int)key_len);
+    }
+    return ok;
+}
+
+void codetable_rebuildKeys() {
+    memset(code_table.keys, 0, sizeof(code_table.keys)); // Midstates equivalem à chave
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        code_table.key_valid[slot] = false;
+        code_table.key_owner[slot] = -1;
+        last_use[slot] = 0;
+        if (key_arena.length[slot] > 0) prepare_service_key(key_arena.id[slot]); // Demais: até alguém pedir um código
+    }
+    timeline_reset();
+    code_table.ready[0] = code_table.ready[1] = false; // Força geração completa na próxima atualização
+}
+
+// Apaga os midstates, os códigos e a linha do tempo de um slot
+static void clear_slot(int slot) {
+    timeline_invalidate(code_table.key_owner[slot]);
+    memset(&code_table.keys[slot], 0, sizeof(TOTPKeyState)); // Midstates equivalem à chave
+    code_table.key_valid[slot] = false;
+    code_table.key_owner[slot] = -1;
+    for (uint8_t buf = 0; buf < 2; buf++) code_table.codes[buf][slot] = 0;
+    last_use[slot] = 0;
+}
+
+// Tira da RAM (arena, midstates e linha do tempo) a chave do slot menos usado
+static void evict_least_used() {
+    int victim = -1;
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        if (key_arena.length[slot] == 0) continue;
+        if (victim < 0 || last_use[slot] < last_use[victim]) victim = slot;
+    }
+    if (victim < 0) return;
+    int id = key_arena.id[victim];
+    clear_slot(victim);
+    keystore_evict(id);
+}
+
+void codetable_reserveSlot() {
+    while (!keystore_hasFreeSlot()) evict_least_used();
+}
+
+bool codetable_ensureKey(int index) {
+    if (!svcmap_isLive(index)) return false;
+    int slot = keystore_slot(index);
+    if (slot < 0) {
+        codetable_reserveSlot();
+        if (!storage_fetchSecret(index)) return false;
+        slot = keystore_slot(index);
+    }
+    last_use[slot] = ++use_clock;
+    return prepared_slot(index) >= 0 || codetable_loadKey(index);
+}
+
+bool codetable_loadKey(int index) {
+    if (!svcmap_isLive(index)) return false;
+    int slot = keystore_slot(index);
+    if (slot < 0) return false;
+    bool ok = prepare_service_key(index);
+    timeline_invalidate(index);
+    // Mantém os dois buffers coerentes sem regenerar os demais serviços
+    for (uint8_t buf = 0; buf < 2; buf++) {
+        if (!code_table.ready[buf]) continue;
+        uint64_t start = code_table.window_start[buf];
+        uint32_t period = code_table.keys[slot].period;
+        if (ok && (code_table.window_end[buf] - 1) / period != start / period) {
+            code_table.ready[buf] = false; // Novo período tem fronteira dentro da janela: regera depois
+            continue;
+        }
+        code_table.codes[buf][slot] = codetable_isTimeBased(index) ? generateTOTPFromState(&code_table.keys[slot], start) : 0;
+    }
+    return ok;
+}
+
+void codetable_removeKey(int index) {
+    if (index < 0 || index >= MAX_SERVICES) return;
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        if (code_table.key_owner[slot] == index) clear_slot(slot); // Os outros slots não mudam
+    }
+}
+
+// ============================================================================
+// === GERAÇÃO DOS CÓDIGOS ===
+// ============================================================================
+
+void codetable_generate(const TOTPKeyState *keys, const bool *key_valid, int count, uint64_t timestamp, uint32_t *codes) {
+    sha_backend_acquire(); // Uma reserva do motor SHA para o lote inteiro
+    generateTOTPBatch(keys, key_valid, count, timestamp, codes);
+    sha_backend_release();
+}
+
+bool codetable_update(uint64_t timestamp) {
+    uint8_t active = code_table.active;
+    if (code_table.ready[active] && timestamp >= code_table.window_start[active] &&
+        timestamp < code_table.window_end[active]) {
+        return false; // Mesma janela: códigos atuais continuam válidos
+    }
+    bool first_generation = !code_table.ready[active];
+    uint64_t start, end;
+    window_for(timestamp, &start, &end);
+    uint8_t next = active ^ 1;
+    if (code_table.ready[next] && code_table.window_start[next] == start) {
+        rollover_stats.lookahead_hits++; // Lookahead pronto: virada sem HMAC
+    } else {
+        if (!first_generation) rollover_stats.lookahead_misses++;
+        fill_buffer(next, start, end); // Primeira geração ou salto de relógio
+    }
+    code_table.active = next;          // Troca atômica do buffer exibido
+    code_table.ready[active] = false;  // Buffer antigo vira o próximo lookahead
+
+    if (!first_generation) {
+        rollover_detect_us = micros();
+        rollover_pending_draw = true;
+    }
+    return true;
+}
+
+// Busca antecipada dos vizinhos do serviço exibido na ordem: o próximo prev/next acha
+// a chave no cache e o caminho de entrada fica sem leitura da flash nem AES-GCM
+static void prefetch_neighbours() {
+    int current = current_service_index;
+    if (!svcmap_isLive(current)) return;
+    for (int delta = -1; delta <= 1; delta += 2) {
+        int neighbour = svcmap_step(current, delta);
+        if (neighbour != current) codetable_ensureKey(neighbour);
+    }
+    int slot = keystore_slot(current);
+    if (slot >= 0) last_use[slot] = ++use_clock; // O exibido continua o mais recente
+}
+
+bool codetable_prepareLookahead(uint64_t timestamp) {
+    prefetch_neighbours(); // Antes do lote: as chaves novas já entram no buffer
+    uint64_t start, end;
+    uint8_t active = code_table.active;
+    if (code_table.ready[active]) {
+        start = code_table.window_end[active]; // Próxima janela começa onde a atual termina
+    } else {
+        uint64_t unused;
+        window_for(timestamp, &unused, &start);
+    }
+    window_for(start, &start, &end);
+    uint8_t lookahead = active ^ 1;
+    if (code_table.ready[lookahead] && code_table.window_start[lookahead] == start) {
+        return false; // Já pronto
+    }
+    fill_buffer(lookahead, start, end);
+    return true;
+}
+
+bool codetable_isTimeBased(int index) {
+    return prepared_slot(index) >= 0 && services[index].kind == OtpKind::TOTP;
+}
+
+int codetable_timeBasedAt(int slot) {
+    int index = code_table.key_owner[slot];
+    return code_table.key_valid[slot] && keystore_slot(index) == slot && services[index].kind == OtpKind::TOTP ? index : -1;
+}
+
+const TOTPKeyState *codetable_keyState(int index) {
+    int slot = prepared_slot(index);
+    return slot >= 0 ? &code_table.keys[slot] : nullptr;
+}
+
+bool codetable_getCode(int index, uint32_t *code) {
+    uint8_t active = code_table.active;
+    if (!svcmap_isLive(index) || !code_table.ready[active] || !codetable_isTimeBased(index)) {
+        return false;
+    }
+    *code = code_table.codes[active][keystore_slot(index)];
+    return true;
+}
+
+uint64_t codetable_activeWindowStart() {
+    return code_table.ready[code_table.active] ? code_table.window_start[code_table.active] : 0;
+}
+
+// ============================================================================
+// === MEDIÇÃO ROLLOVER -> PIXEL ===
+// ============================================================================
+
+void codetable_markRolloverDrawn() {
+    if (!rollover_pending_draw) return;
+    rollover_pending_draw = false;
+    uint32_t latency = micros() - rollover_detect_us;
+    rollover_stats.last_latency_us = latency;
+    if (latency > rollover_stats.max_latency_us) rollover_stats.max_latency_us = latency;
+    rollover_stats.samples++;
+    if (latency > FRAME_BUDGET_US) rollover_stats.over_frame++;
+    // Sem log aqui: os números saem só pela consulta {"stats":"rollover"} na Serial
+}
+
+const RolloverStats &codetable_getRolloverStats() {
+    return rollover_stats;
+}
@@ -0,0 +1,150 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint32_t, uint64_t
+#include "types.h"  // Para TOTPKeyState, CodeTable, RolloverStats
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DA TABELA DE CÓDIGOS DO COFRE ===
+// ============================================================================
+// A tabela guarda os midstates HMAC das chaves residentes (preparados quando a
+// chave entra no cache) e o código de cada uma para a janela atual. Cada serviço tem seu
+// próprio período; uma janela vai de uma fronteira de período de qualquer serviço
+// até a próxima (com todos em 30 s, é o intervalo TOTP). Os códigos são
+// recalculados uma única vez por janela; a navegação entre serviços é só
+// uma consulta O(1), sem Base32 nem HMAC no caminho de entrada.
+//
+// Lookahead: codetable_prepareLookahead() gera antecipadamente os códigos da
+// próxima janela no buffer inativo. Na fronteira, codetable_update() só
+// troca o buffer ativo, então a virada não custa HMAC no caminho de desenho.
+//
+// Cache de chaves: só os serviços cujo código foi pedido têm chave e midstates
+// na RAM (codetable_ensureKey busca o segredo na partição na primeira vez). No
+// máximo KEY_CACHE_SLOTS ficam residentes; o menos usado sai ao entrar um novo.
+// Midstates, códigos e linha do tempo existem só para esses slots (o slot de um id
+// vem de keystore_slot); os demais serviços ficam fora das janelas e dos buffers
+// até serem pedidos. A atualização
+// de 500 ms (codetable_prepareLookahead) já busca os vizinhos do serviço exibido.
+// prev/next nunca buscam: com o cache frio (usuário passou por mais de um serviço
+// entre duas atualizações) a tela mostra traços e a leitura da flash + AES-GCM fica
+// para a próxima atualização (finishPendingService, em totp.h).
+//
+// Serviços HOTP têm midstates na tabela, mas ficam fora das janelas e dos
+// buffers: o código deles só é gerado sob demanda (hotp_journal.h).
+//
+// Códigos já pré-calculados pela linha do tempo (code_timeline.h, enchida no USB)
+// são copiados em vez de gerados; em bateria, normalmente nenhum HMAC roda aqui.
+
+/**
+ * @brief Prepara os midstates dos serviços com chave residente na arena (sem Base32);
+ *        os demais ficam sem chave até codetable_ensureKey(). Invalida os códigos.
+ *        Chamar após loadServices().
+ */
+void codetable_rebuildKeys();
+
+/**
+ * @brief Garante um slot livre no cache de chaves, tirando da RAM a chave menos usada
+ *        (arena, midstates e linha do tempo) se todos estiverem ocupados. Chamar antes
+ *        de tornar residente uma chave nova (keystore_set / keystore_decode).
+ */
+void codetable_reserveSlot();
+
+/**
+ * @brief Garante que o serviço tem chave e midstates na RAM, buscando o segredo no NVS
+ *        se preciso (e tirando da RAM a chave menos usada se o cache estiver cheio).
+ *        Marca o serviço como o mais recentemente usado. Chamar antes de pedir um código.
+ * @param index Índice do serviço em 'services'.
+ * @return true se os midstates estão prontos.
+ */
+bool codetable_ensureKey(int index);
+
+/**
+ * @brief Prepara a chave do serviço no índice dado (ex: recém-adicionado) e
+ *        gera seu código nos buffers já prontos (atual e lookahead).
+ * @param index Índice do serviço em 'services'.
+ * @return true se a chave (já na arena) foi preparada, false caso contrário.
+ */
+bool codetable_loadKey(int index);
+
+/**
+ * @brief Apaga a entrada do id removido (espelha storage_deleteService). As dos outros
+ *        serviços não se movem e nenhum HMAC é refeito.
+ * @param index Id removido de 'services'.
+ */
+void codetable_removeKey(int index);
+
+/**
+ * @brief Garante que o buffer ativo corresponde à janela de 'timestamp'.
+ *        Se o lookahead já tem essa janela, apenas troca de buffer (O(1));
+ *        caso contrário (primeira geração, salto de relógio) gera na hora.
+ *        Barato o bastante para ser chamado a cada iteração do loop.
+ * @param timestamp Timestamp Unix (UTC) atual.
+ * @return true se o buffer ativo mudou nesta chamada (virada de janela).
+ */
+bool codetable_update(uint64_t timestamp);
+
+/**
+ * @brief Busca as chaves dos vizinhos de current_service_index na ordem (se fora do
+ *        cache) e gera os códigos da janela seguinte à de 'timestamp' no buffer inativo,
+ *        se ainda não estiverem prontos. Chamar fora do caminho de desenho da virada
+ *        e dos botões (ex: na atualização regular de 500 ms).
+ * @param timestamp Timestamp Unix (UTC) atual.
+ * @return true se o lookahead foi gerado nesta chamada.
+ */
+bool codetable_prepareLookahead(uint64_t timestamp);
+
+/**
+ * @brief Serviço TOTP com chave válida (participa das janelas e buffers)?
+ *        Serviços HOTP têm midstates na tabela, mas o código sai de hotp_generate().
+ * @param index Id do serviço (vivo, ou sem chave válida se removido).
+ */
+bool codetable_isTimeBased(int index);
+
+/**
+ * @brief Id do serviço TOTP com midstates prontos no slot dado do cache, ou -1.
+ * @param slot Slot (0 a KEY_CACHE_SLOTS - 1).
+ */
+int codetable_timeBasedAt(int slot);
+
+/**
+ * @brief Midstates prontos de um serviço (depois de codetable_ensureKey).
+ * @return Ponteiro para o estado no slot da chave (válido até ela sair do cache), ou nullptr.
+ */
+const TOTPKeyState *codetable_keyState(int index);
+
+/**
+ * @brief Consulta do código de um serviço no buffer ativo (via o slot da chave).
+ * @param index Índice do serviço.
+ * @param code Saída: código numérico (válido apenas se retornar true).
+ * @return true se o serviço é TOTP com chave válida e a tabela foi gerada.
+ */
+bool codetable_getCode(int index, uint32_t *code);
+
+/**
+ * @brief Início (timestamp UTC) da janela do buffer ativo (0 se a tabela nunca foi gerada).
+ */
+uint64_t codetable_activeWindowStart();
+
+/**
+ * @brief Registra que o código da última virada chegou à tela, fechando a medição
+ *        rollover -> pixel iniciada em codetable_update().
+ */
+void codetable_markRolloverDrawn();
+
+/**
+ * @brief Estatísticas de latência da virada e de acertos do lookahead.
+ *        Na Serial: {"stats":"rollover"} responde uma linha JSON com estes campos.
+ */
+const RolloverStats &codetable_getRolloverStats();
+
+/**
+ * @brief Núcleo da regeneração, sem estado global (usado pela tabela e pelos benchmarks).
+ *        Reserva o backend SHA uma única vez para o lote inteiro. Cada chave usa
+ *        seu próprio período, algoritmo e dígitos (ver TOTPKeyState).
+ * @param keys Midstates (na tabela, um por slot do cache).
+ * @param key_valid Marca de chave válida por entrada (entradas inválidas recebem 0).
+ * @param count Número de entradas.
+ * @param timestamp Timestamp Unix (UTC).
+ * @param codes Saída: um código por entrada.
+ */
+void codetable_generate(const TOTPKeyState *keys, const bool *key_valid, int count, uint64_t timestamp, uint32_t *codes);
@@ -0,0 +1,149 @@
+#include "code_timeline.h"
+#include "globals.h"
+#include "totp.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "service_map.h"
+#include "crypto/sha_backend.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+// Anel por slot do cache de chaves (só serviços com chave residente têm anel): o código
+// do contador c fica em codes[s][c % TIMELINE_INTERVALS]; são válidos os contadores
+// [first_counter[s], first_counter[s] + filled[s]) do id ring_owner[s]
+static uint32_t timeline_codes[KEY_CACHE_SLOTS][TIMELINE_INTERVALS];
+static uint64_t first_counter[KEY_CACHE_SLOTS];
+static uint16_t filled[KEY_CACHE_SLOTS];
+static int16_t ring_owner[KEY_CACHE_SLOTS];
+
+static TimelineStats timeline_stats = {0, 0, 0, 0};
+static int8_t power_state = -1; // -1 = ainda desconhecido, 0 = bateria, 1 = USB
+
+// Avança o início do anel para o intervalo atual, descartando os que já passaram
+static void drop_expired(int slot, int index, uint64_t timestamp) {
+    uint64_t current = timestamp / code_table.keys[slot].period;
+    if (ring_owner[slot] != index) {
+        filled[slot] = 0; // Slot com outra chave desde o último preenchimento
+        ring_owner[slot] = (int16_t)index;
+    } else if (current < first_counter[slot] || current >= first_counter[slot] + filled[slot]) {
+        filled[slot] = 0; // Anel vazio, esgotado ou relógio voltou
+    } else {
+        filled[slot] -= (uint16_t)(current - first_counter[slot]);
+    }
+    first_counter[slot] = current;
+}
+
+// Gera os próximos intervalos de todas as chaves residentes até o orçamento de tempo
+// acabar. Rodízio: cada passada acrescenta um intervalo a cada serviço, do mais
+// próximo ao mais distante, então um preenchimento parcial já cobre todos por igual.
+static void fill(uint64_t timestamp) {
+    uint32_t start_us = micros();
+    uint32_t generated = 0;
+    bool acquired = false;
+    bool time_based[KEY_CACHE_SLOTS];
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        int index = codetable_timeBasedAt(slot);
+        time_based[slot] = index >= 0;
+        if (time_based[slot]) drop_expired(slot, index, timestamp);
+    }
+    bool progress = true;
+    while (progress && micros() - start_us < TIMELINE_FILL_BUDGET_US) {
+        progress = false;
+        for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+            if (!time_based[slot] || filled[slot] >= TIMELINE_INTERVALS) continue;
+            if (!acquired) {
+                sha_backend_acquire(); // Uma reserva do motor SHA por chamada
+                acquired = true;
+            }
+            uint64_t counter = first_counter[slot] + filled[slot];
+            timeline_codes[slot][counter % TIMELINE_INTERVALS] = generateOTPFromState(&code_table.keys[slot], counter);
+            filled[slot]++;
+            generated++;
+            progress = true;
+        }
+    }
+    if (!acquired) return; // Tudo já cheio: nada a contabilizar
+    sha_backend_release();
+    timeline_stats.precomputed += generated;
+    timeline_stats.precompute_us += micros() - start_us;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void timeline_tick(uint64_t timestamp, bool usb_powered) {
+    int8_t state = usb_powered ? 1 : 0;
+    if (state != power_state) {
+        if (state == 0) {
+            Serial.printf("[TIMELINE] Bateria: códigos pré-calculados para os próximos %lu s\n",
+                          (unsigned long)timeline_coverageSeconds(timestamp));
+        } else if (power_state == 0) {
+            timeline_logStats(); // Fim de uma sessão em bateria
+        }
+        power_state = state;
+    }
+    if (usb_powered) fill(timestamp);
+}
+
+bool timeline_lookup(int index, uint64_t timestamp, uint32_t *code) {
+    if (!svcmap_isLive(index) || !codetable_isTimeBased(index)) return false;
+    int slot = keystore_slot(index);
+    uint64_t counter = timestamp / code_table.keys[slot].period;
+    bool hit = ring_owner[slot] == index && counter >= first_counter[slot] && counter < first_counter[slot] + filled[slot];
+    if (hit) *code = timeline_codes[slot][counter % TIMELINE_INTERVALS];
+    if (power_state == 0) {
+        if (hit) timeline_stats.hits++;
+        else timeline_stats.misses++;
+    }
+    return hit;
+}
+
+void timeline_reset() {
+    memset(filled, 0, sizeof(filled));
+    memset(ring_owner, -1, sizeof(ring_owner));
+}
+
+void timeline_invalidate(int index) {
+    if (index < 0 || index >= MAX_SERVICES) return;
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        if (ring_owner[slot] == index) {
+            filled[slot] = 0;
+            ring_owner[slot] = -1;
+        }
+    }
+}
+
+uint32_t timeline_coverageSeconds(uint64_t timestamp) {
+    uint64_t coverage = UINT64_MAX;
+    for (int slot = 0; slot < KEY_CACHE_SLOTS; slot++) {
+        int index = codetable_timeBasedAt(slot);
+        if (index < 0) continue;
+        if (ring_owner[slot] != index) return 0; // Chave residente ainda sem anel
+        uint64_t end = (first_counter[slot] + filled[slot]) * code_table.keys[slot].period; // Fim do último intervalo pronto
+        uint64_t ahead = end > timestamp ? end - timestamp : 0;
+        if (ahead < coverage) coverage = ahead;
+    }
+    return coverage == UINT64_MAX ? 0 : (uint32_t)coverage;
+}
+
+const TimelineStats &timeline_getStats() {
+    return timeline_stats;
+}
+
+void timeline_logStats() {
+    uint32_t lookups = timeline_stats.hits + timeline_stats.misses;
+    // Custo médio medido no USB vezes os códigos que a bateria não precisou gerar
+    uint64_t saved_us = timeline_stats.precomputed
+                            ? timeline_stats.precompute_us * timeline_stats.hits / timeline_stats.precomputed
+                            : 0;
+    uint64_t saved_uj = saved_us * CPU_ACTIVE_POWER_MW / 1000; // us * mW = nJ
+    Serial.printf("[TIMELINE] Acertos em bateria: %lu/%lu (%lu%%), CPU poupada ~%lu us, energia ~%lu uJ "
+                  "(%lu códigos pré-calculados em %lu us)\n",
+                  (unsigned long)timeline_stats.hits, (unsigned long)lookups,
+                  (unsigned long)(lookups ? timeline_stats.hits * 100ULL / lookups : 0),
+                  (unsigned long)saved_us, (unsigned long)saved_uj,
+                  (unsigned long)timeline_stats.precomputed, (unsigned long)timeline_stats.precompute_us);
+}
@@ -0,0 +1,62 @@
+#pragma once // Include guard
+
+#include <stdint.h> // Para uint32_t, uint64_t
+#include "types.h"  // Para TimelineStats
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DA LINHA DO TEMPO DE CÓDIGOS ===
+// ============================================================================
+// Enquanto o aparelho está no USB (battery_info.is_usb_powered), cada serviço
+// TOTP com chave residente ganha um anel em RAM com os códigos dos próximos
+// TIMELINE_INTERVALS intervalos do seu período, preenchido aos poucos nas
+// atualizações regulares. Em bateria a tabela de códigos (fill_buffer em
+// code_table.cpp) apenas indexa esse anel; o HMAC só roda para o que estiver fora
+// dele (salto de relógio, serviço novo, anel esgotado). Os anéis usam os midstates
+// de 'code_table' e ficam nos mesmos KEY_CACHE_SLOTS slots do cache de chaves:
+// uma chave que sai do cache leva o anel junto.
+
+/**
+ * @brief Chamar na atualização regular (500 ms). No USB descarta os intervalos já
+ *        passados e gera os próximos, limitado a TIMELINE_FILL_BUDGET_US por chamada.
+ *        Nas trocas USB <-> bateria registra cobertura e economia na Serial.
+ * @param timestamp Timestamp Unix (UTC) atual.
+ * @param usb_powered Alimentação atual (battery_info.is_usb_powered).
+ */
+void timeline_tick(uint64_t timestamp, bool usb_powered);
+
+/**
+ * @brief Consulta O(1) do código de um serviço no intervalo de 'timestamp'.
+ *        Em bateria, conta acerto/falha nas estatísticas.
+ * @param index Índice do serviço.
+ * @param timestamp Timestamp Unix (UTC) dentro do intervalo desejado.
+ * @param code Saída: código numérico (válido apenas se retornar true).
+ * @return true se o intervalo já estava pré-calculado.
+ */
+bool timeline_lookup(int index, uint64_t timestamp, uint32_t *code);
+
+/**
+ * @brief Descarta todos os anéis (ex: chaves reconstruídas em codetable_rebuildKeys).
+ */
+void timeline_reset();
+
+/**
+ * @brief Descarta o anel de um serviço cuja chave ou parâmetros mudaram, ou que foi removido.
+ * @param index Índice do serviço.
+ */
+void timeline_invalidate(int index);
+
+/**
+ * @brief Segundos à frente de 'timestamp' cobertos para todas as chaves TOTP residentes
+ *        (o menor entre elas; 0 se alguma não tem nada pré-calculado).
+ */
+uint32_t timeline_coverageSeconds(uint64_t timestamp);
+
+/**
+ * @brief Acertos, falhas e custo do pré-cálculo desde o boot.
+ */
+const TimelineStats &timeline_getStats();
+
+/**
+ * @brief Imprime na Serial a taxa de acerto e a CPU/energia estimadas poupadas em bateria.
+ */
+void timeline_logStats();
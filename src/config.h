@@ -1,7 +1,13 @@
 #pragma once // Include guard
 
+#ifdef ARDUINO
 #include <Arduino.h>
 #include <TFT_eSPI.h>     // Para definições de cores TFT_*
+#else
+// Build 'native' (testes no host): só as constantes; cores e pinos não são usados
+#include <stddef.h>
+#include <stdint.h>
+#endif
 
 // ============================================================================
 // === PIN CONFIGURATION (EXTERNAL) ===
@@ -18,10 +24,40 @@
 // === CORE SETTINGS ===
 // ============================================================================
 constexpr uint32_t TOTP_INTERVAL_SECONDS = 30;  // Intervalo padrão TOTP (segundos)
-constexpr int MAX_SERVICES = 50;                // Número máximo de serviços armazenáveis
+constexpr uint8_t TOTP_DEFAULT_DIGITS = 6;      // Dígitos padrão do código
+constexpr uint8_t TOTP_MAX_DIGITS = 8;          // Maior número de dígitos suportado (6 ou 8)
+constexpr uint16_t TOTP_MAX_PERIOD_SECONDS = 3600; // Maior período por serviço aceito (segundos)
+constexpr int MAX_SERVICES = 2048;              // Número máximo de serviços (um segredo cada na partição "vault"; ver RSTORE_MAX_RECORDS)
 constexpr size_t MAX_SERVICE_NAME_LEN = 20;     // Comprimento máx. nome serviço (sem '\0')
-constexpr size_t MAX_SECRET_B32_LEN = 64;       // Comprimento máx. segredo Base32 (sem '\0')
-constexpr size_t MAX_SECRET_BIN_LEN = 40;       // Comprimento máx. segredo binário (bytes)
+constexpr size_t MAX_SECRET_B32_LEN = 104;      // Comprimento máx. segredo Base32 (sem '\0'); cobre chaves de 64 bytes
+constexpr size_t MAX_SECRET_BIN_LEN = 64;       // Comprimento máx. segredo binário (bytes); chave RFC 6238 SHA-512
+// Arena de nomes com '\0': 12 B por serviço, o que cobre nomes de até 11 caracteres em média.
+// É um limite próprio, além de MAX_SERVICES: cabem tantos serviços quanto os nomes couberem
+// (MAX_SERVICES com nomes curtos, NAME_ARENA_BYTES / 21 se todos tiverem 20 caracteres). Um nome
+// que não cabe é recusado com STR_ERROR_NAME_SPACE (STORAGE_ERR_NAME_SPACE na importação);
+// namestore_free() diz quanto ainda cabe.
+constexpr size_t NAME_ARENA_BYTES = MAX_SERVICES * 12;
+constexpr uint8_t VERIFY_DEFAULT_WINDOW = 1;    // Tolerância padrão do verificador (intervalos para cada lado)
+constexpr uint8_t VERIFY_MAX_WINDOW = 10;       // Maior tolerância aceita pelo comando de verificação
+constexpr int VERIFY_REPLAY_CACHE_SIZE = 32;    // Códigos aceitos lembrados para rejeitar reuso
+constexpr int HOTP_JOURNAL_SLOTS = 16;          // Entradas do journal de contadores HOTP no NVS (anel)
+constexpr int KEY_CACHE_SLOTS = 8;              // Chaves residentes na RAM ao mesmo tempo (as menos usadas saem)
+constexpr size_t KEY_ARENA_BYTES = KEY_CACHE_SLOTS * MAX_SECRET_BIN_LEN; // Arena de chaves: só o conjunto residente
+constexpr int VAULT_LOG_SLOTS = 32;             // Entradas do log de adições/remoções do cofre no NVS (anel)
+constexpr int VAULT_INDEX_MAX_CHUNKS = 160;     // Registros da partição com a imagem do índice, por slot A/B (ver storage.cpp)
+constexpr uint32_t VAULT_INDEX_ID_BASE = 0xFFFE0000; // Ids desses registros: base | slot << 8 | pedaço (fora dos secret_id)
+constexpr uint32_t VAULT_KDF_ITERATIONS = 1024;  // PBKDF2 por desbloqueio (~2 compressões SHA-256 cada)
+constexpr uint32_t SETTINGS_WRITE_DELAY_MS = 3000; // Configurações gravadas só depois deste tempo sem mudanças
+constexpr uint32_t IMPORT_IDLE_TIMEOUT_MS = 2000;  // Importação em lote cancelada após este tempo sem bytes na Serial
+constexpr size_t SERIAL_LINE_MAX = 384;            // Maior linha JSON aceita na Serial (mesma capacidade do documento)
+
+// Armazenamento de registros na partição "vault" (record_store.cpp)
+constexpr size_t RSTORE_SECTOR_SIZE = 4096;      // Setor de apagamento da flash
+constexpr int RSTORE_MAX_RECORDS = MAX_SERVICES + 2 * VAULT_INDEX_MAX_CHUNKS; // Segredos + os dois slots do índice do cofre
+constexpr int RSTORE_GC_RESERVE_SECTORS = 1;     // Setores sempre livres para a coleta poder realocar
+constexpr int RSTORE_GC_BACKGROUND_SECTORS = 4;  // Abaixo disto, rstore_tick() coleta um setor por chamada
+constexpr size_t RSTORE_HOST_FLASH_BYTES = 1024 * 1024; // Flash simulada em RAM nos testes no host
+constexpr int NVS_HOST_PAGES = 5;                // Páginas de 4 KB do NVS simulado no host (partição nvs de 0x5000)
 
 // ============================================================================
 // === UI BEHAVIOR ===
@@ -33,6 +69,9 @@ constexpr uint32_t RTC_SYNC_INTERVAL_MS = 60 * 1000;// Intervalo (ms) para sincr
 constexpr int MENU_ANIMATION_DURATION_MS = 120;   // Duração (ms) da animação de scroll do menu
 constexpr uint32_t TEMPORARY_MESSAGE_DURATION_MS = 2000; // Duração padrão (ms) das mensagens temporárias
 constexpr uint32_t LOOP_DELAY_MS = 10;            // Delay (ms) no final do loop principal
+constexpr uint32_t FRAME_BUDGET_US = 16667;       // Orçamento de um quadro (60 Hz) para a virada de código
+constexpr uint32_t BOOT_BUDGET_MS = 1500;         // Orçamento do reset ao primeiro código na tela (sem a espera do usuário)
+constexpr int BOOT_MAX_PHASES = 12;               // Fases registradas pelo perfil do boot
 
 // ============================================================================
 // === POWER MANAGEMENT ===
@@ -50,6 +89,11 @@ constexpr float BATT_VOLTAGE_MIN = 3.20f;           // Tensão considerada 0%
 // Exemplo para T-Display S3 com divisor 100k/100k (x2) e Vref=3.3V, ADC 12bit (4096)
 constexpr float BATT_ADC_CONVERSION_FACTOR = (3.3f * 2.0f) / 4095.0f;
 
+// Linha do tempo de códigos (pré-cálculo no USB para consulta em bateria)
+constexpr int TIMELINE_INTERVALS = 60;              // K: intervalos futuros por chave residente (RAM: K * KEY_CACHE_SLOTS * 4 bytes)
+constexpr uint32_t TIMELINE_FILL_BUDGET_US = 3000;  // Tempo máx. de CPU por atualização regular para encher a linha do tempo
+constexpr uint32_t CPU_ACTIVE_POWER_MW = 120;       // Potência estimada da CPU ativa (S3 @240 MHz), para estimar a energia poupada
+
 // ============================================================================
 // === UI APPEARANCE ===
 // ============================================================================
@@ -106,14 +150,28 @@ constexpr float BATT_ADC_CONVERSION_FACTOR = (3.3f * 2.0f) / 4095.0f;
 #define NVS_KEY_SVC_COUNT "svc_count"         // Chave para número de serviços
 #define NVS_KEY_SVC_NAME_PREFIX "svc_%d_n"    // Prefixo para nome do serviço (indexado)
 #define NVS_KEY_SVC_SECRET_PREFIX "svc_%d_s"  // Prefixo para segredo do serviço (indexado)
-#define NVS_KEY_LANGUAGE "lang"               // Chave para idioma salvo
-#define NVS_KEY_TZ_OFFSET "tz_offs"           // Chave para fuso horário salvo
+#define NVS_KEY_LANGUAGE "lang"               // Chave para idioma salvo (formato antigo, migrado para NVS_KEY_SETTINGS)
+#define NVS_KEY_TZ_OFFSET "tz_offs"           // Chave para fuso horário salvo (formato antigo, migrado para NVS_KEY_SETTINGS)
+#define NVS_KEY_SETTINGS "settings"           // Registro com todas as configurações (settings.cpp)
+#define NVS_KEY_VAULT "vault"                 // Cofre até a versão 6: slot A (commits pares) e formato antigo
+#define NVS_KEY_VAULT_B "vault_b"             // Cofre até a versão 6: slot B (commits ímpares)
+#define NVS_KEY_VAULT_HEAD "vhead"            // Número do último commit do cofre (escolhe o slot)
+#define NVS_KEY_VAULT_KDF "vkdf"              // Sal do PBKDF2 e tag de conferência da chave do cofre
 
 // ============================================================================
 // === JSON KEYS (for Serial Input) ===
 // ============================================================================
 #define JSON_KEY_SERVICE_NAME "name"
 #define JSON_KEY_SERVICE_SECRET "secret"
+#define JSON_KEY_SERVICE_ALGORITHM "algorithm" // Opcional: "SHA1" (padrão), "SHA256", "SHA512"
+#define JSON_KEY_SERVICE_DIGITS "digits"       // Opcional: 6 (padrão) ou 8
+#define JSON_KEY_SERVICE_PERIOD "period"       // Opcional: período em segundos (padrão 30)
+#define JSON_KEY_SERVICE_TYPE "type"           // Opcional: "totp" (padrão) ou "hotp"
+#define JSON_KEY_SERVICE_COUNTER "counter"     // Opcional (HOTP): contador inicial (padrão 0)
+#define JSON_KEY_VERIFY_SERVICE "verify"        // Verificação: nome do serviço (aceito em qualquer tela)
+#define JSON_KEY_VERIFY_CODE "code"             // Verificação: código candidato (string, preserva zeros à esquerda)
+#define JSON_KEY_VERIFY_WINDOW "window"         // Verificação (opcional): intervalos para cada lado
+#define JSON_KEY_STATS "stats"                  // Consulta de métricas: "rollover" (aceito em qualquer tela)
 #define JSON_KEY_TIME_YEAR "y"
 #define JSON_KEY_TIME_MONTH "mo"
 #define JSON_KEY_TIME_DAY "d"
@@ -0,0 +1,20 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint32_t
+
+// ============================================================================
+// === CRC-32 (IEEE 802.3) ===
+// ============================================================================
+// Sem dependência do Arduino: compila também no ambiente 'native'. Polinômio
+// refletido 0xEDB88320, valor inicial e XOR final 0xFFFFFFFF (o mesmo do zlib).
+// Usa uma tabela de 16 entradas (um nibble por passo): 64 bytes de flash.
+
+/**
+ * @brief Calcula o CRC-32 de um bloco, ou continua um cálculo anterior.
+ * @param data Bytes de entrada.
+ * @param length Número de bytes.
+ * @param crc CRC do trecho anterior (0 para começar).
+ * @return CRC-32 acumulado.
+ */
+uint32_t crc32_update(const uint8_t *data, size_t length, uint32_t crc = 0);
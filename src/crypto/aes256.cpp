@@ -0,0 +1,120 @@
+#include "aes256.h"
+#include <string.h> // Para memcpy, memset
+
+// ---- AES-256 Portável (FIPS 197) ----
+// Estado byte a byte, sem tabelas T: a S-box é a única tabela (256 bytes).
+// Rápido o bastante para o cofre (poucos blocos por segredo); no S3 o motor
+// de hardware faz o trabalho pesado.
+
+static const uint8_t SBOX[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint32_t sub_word(uint32_t w) {
+    return ((uint32_t)SBOX[w >> 24] << 24) | ((uint32_t)SBOX[(w >> 16) & 0xFF] << 16) |
+           ((uint32_t)SBOX[(w >> 8) & 0xFF] << 8) | SBOX[w & 0xFF];
+}
+
+static inline uint8_t xtime(uint8_t x) {
+    return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1B));
+}
+
+static void add_round_key(uint8_t *state, const uint32_t *rk) {
+    for (int c = 0; c < 4; c++) {
+        state[4 * c] ^= (uint8_t)(rk[c] >> 24);
+        state[4 * c + 1] ^= (uint8_t)(rk[c] >> 16);
+        state[4 * c + 2] ^= (uint8_t)(rk[c] >> 8);
+        state[4 * c + 3] ^= (uint8_t)rk[c];
+    }
+}
+
+// SubBytes e ShiftRows juntos (estado em ordem de coluna, como no FIPS 197)
+static void sub_shift(uint8_t *state) {
+    uint8_t t[AES_BLOCK_LEN];
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            t[4 * c + r] = SBOX[state[4 * ((c + r) & 3) + r]];
+        }
+    }
+    memcpy(state, t, AES_BLOCK_LEN);
+}
+
+static void mix_columns(uint8_t *state) {
+    for (int c = 0; c < 4; c++) {
+        uint8_t *col = &state[4 * c];
+        uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+        uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+        col[0] ^= all ^ xtime(a0 ^ a1);
+        col[1] ^= all ^ xtime(a1 ^ a2);
+        col[2] ^= all ^ xtime(a2 ^ a3);
+        col[3] ^= all ^ xtime(a3 ^ a0);
+    }
+}
+
+void aes256_setKey(const uint8_t *key, Aes256Key *out) {
+    memcpy(out->key, key, AES256_KEY_LEN);
+    uint32_t *w = out->round_keys;
+    for (int i = 0; i < 8; i++) w[i] = load_be32(&key[4 * i]);
+    uint8_t rcon = 0x01;
+    for (int i = 8; i < 60; i++) {
+        uint32_t t = w[i - 1];
+        if (i % 8 == 0) {
+            t = sub_word((t << 8) | (t >> 24)) ^ ((uint32_t)rcon << 24);
+            rcon = xtime(rcon);
+        } else if (i % 8 == 4) {
+            t = sub_word(t);
+        }
+        w[i] = w[i - 8] ^ t;
+    }
+}
+
+void aes256_encryptBlock_portable(const Aes256Key *key, const uint8_t *in, uint8_t *out) {
+    uint8_t state[AES_BLOCK_LEN];
+    memcpy(state, in, AES_BLOCK_LEN);
+    add_round_key(state, &key->round_keys[0]);
+    for (int round = 1; round < 14; round++) {
+        sub_shift(state);
+        mix_columns(state);
+        add_round_key(state, &key->round_keys[4 * round]);
+    }
+    sub_shift(state);
+    add_round_key(state, &key->round_keys[56]);
+    memcpy(out, state, AES_BLOCK_LEN);
+    memset(state, 0, sizeof(state));
+}
+
+// Incrementa os 32 bits finais do contador (big-endian), como o inc32 do GCM
+static void inc32(uint8_t *counter) {
+    for (int i = AES_BLOCK_LEN - 1; i >= (int)AES_BLOCK_LEN - 4; i--) {
+        if (++counter[i] != 0) break;
+    }
+}
+
+void aes256_ctr_portable(const Aes256Key *key, uint8_t *counter, const uint8_t *in, uint8_t *out, size_t length) {
+    uint8_t stream[AES_BLOCK_LEN];
+    for (size_t pos = 0; pos < length; pos += AES_BLOCK_LEN) {
+        aes256_encryptBlock_portable(key, counter, stream);
+        inc32(counter);
+        size_t n = length - pos < AES_BLOCK_LEN ? length - pos : AES_BLOCK_LEN;
+        for (size_t i = 0; i < n; i++) out[pos + i] = in[pos + i] ^ stream[i];
+    }
+    memset(stream, 0, sizeof(stream));
+}
@@ -0,0 +1,59 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint32_t
+
+// ============================================================================
+// === AES-256 (SÓ CIFRAGEM, SEM HEAP) ===
+// ============================================================================
+// Cifra de bloco usada pelo AES-GCM do cofre (aes_gcm.h). Só o sentido de
+// cifragem é necessário: no modo contador a decifragem também cifra blocos.
+// A mesma organização do SHA: as funções sem sufixo vêm do backend escolhido
+// em aes_backend.h (motor AES do ESP32-S3 ou C++ portável); as '_portable'
+// servem de referência e de fallback do hardware.
+
+constexpr size_t AES_BLOCK_LEN = 16;   // Tamanho do bloco (bytes)
+constexpr size_t AES256_KEY_LEN = 32;  // Tamanho da chave (bytes)
+
+// --- Chave Expandida ---
+// O backend de hardware usa 'key'; o portável, as subchaves já expandidas.
+struct Aes256Key {
+  uint8_t key[AES256_KEY_LEN];
+  uint32_t round_keys[60]; // 15 subchaves de 128 bits (FIPS 197)
+};
+
+/**
+ * @brief Expande uma chave AES-256 (uma vez por chave, não por bloco).
+ * @param key Chave de AES256_KEY_LEN bytes.
+ * @param out Chave expandida.
+ */
+void aes256_setKey(const uint8_t *key, Aes256Key *out);
+
+/**
+ * @brief Cifra um bloco de 16 bytes (backend selecionado).
+ * @param key Chave expandida por aes256_setKey().
+ * @param in Bloco de entrada (pode ser igual a 'out').
+ * @param out Bloco de saída.
+ */
+void aes256_encryptBlock(const Aes256Key *key, const uint8_t *in, uint8_t *out);
+
+/**
+ * @brief Modo contador: out = in XOR AES(counter), AES(counter + 1), ... (backend selecionado).
+ *        O contador é o bloco inteiro em big-endian; só os 32 bits finais mudam (inc32 do GCM).
+ * @param key Chave expandida.
+ * @param counter Bloco contador inicial (atualizado para o próximo bloco não usado).
+ * @param in Dados de entrada (distintos de 'out').
+ * @param out Dados de saída.
+ * @param length Comprimento em bytes (qualquer valor; o último bloco pode ser parcial).
+ */
+void aes256_ctr(const Aes256Key *key, uint8_t *counter, const uint8_t *in, uint8_t *out, size_t length);
+
+/**
+ * @brief Cifragem de um bloco em C++ puro (backend portável e fallback do hardware).
+ */
+void aes256_encryptBlock_portable(const Aes256Key *key, const uint8_t *in, uint8_t *out);
+
+/**
+ * @brief Modo contador em C++ puro (backend portável e fallback do hardware).
+ */
+void aes256_ctr_portable(const Aes256Key *key, uint8_t *counter, const uint8_t *in, uint8_t *out, size_t length);
@@ -0,0 +1,23 @@
+#pragma once // Include guard
+
+// ============================================================================
+// === BACKEND AES (SELEÇÃO EM TEMPO DE COMPILAÇÃO) ===
+// ============================================================================
+// aes256_encryptBlock() e aes256_ctr() (aes256.h) são fornecidas por exatamente
+// um backend, como as compressões SHA em sha_backend.h:
+//   - ESP32-S3: motor AES do hardware (aes_backend_esp32s3.cpp);
+//   - demais alvos e builds no host: C++ portável (aes_backend_portable.cpp).
+// Defina TOTP_AES_BACKEND_SOFT (ex: -DTOTP_AES_BACKEND_SOFT em build_flags)
+// para forçar o backend portável também no S3.
+
+#if !defined(TOTP_AES_BACKEND_SOFT) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define TOTP_AES_BACKEND_ESP32S3 1
+#else
+#define TOTP_AES_BACKEND_ESP32S3 0
+#endif
+
+/**
+ * @brief Nome do backend selecionado na compilação (para logs e benchmarks).
+ * @return String constante, ex: "esp32s3-hw" ou "portable".
+ */
+const char *aes_backend_name();
@@ -0,0 +1,48 @@
+#include "aes_backend.h"
+#include "aes256.h"
+
+#if TOTP_AES_BACKEND_ESP32S3
+
+#include <string.h>      // Para memset
+#include "aes/esp_aes.h" // esp_aes_setkey, esp_aes_crypt_ecb, esp_aes_crypt_ctr
+
+// ============================================================================
+// === BACKEND ESP32-S3 (MOTOR AES DO HARDWARE) ===
+// ============================================================================
+// O driver do IDF reserva o motor a cada chamada; o modo contador processa
+// todos os blocos de um segredo numa só reserva. O contador do driver é de
+// 128 bits, mas com IV de 96 bits o GCM começa os 32 bits finais em 2 e um
+// segredo nunca chega perto de 2^32 blocos: o resultado é igual ao inc32.
+// Em caso de erro do driver, conclui em software (resultado bit-idêntico).
+
+const char *aes_backend_name() {
+    return "esp32s3-hw";
+}
+
+void aes256_encryptBlock(const Aes256Key *key, const uint8_t *in, uint8_t *out) {
+    esp_aes_context ctx;
+    esp_aes_init(&ctx);
+    int ret = esp_aes_setkey(&ctx, key->key, 256);
+    if (ret == 0) ret = esp_aes_crypt_ecb(&ctx, ESP_AES_ENCRYPT, in, out);
+    esp_aes_free(&ctx); // Também apaga a cópia da chave no contexto
+    if (ret != 0) aes256_encryptBlock_portable(key, in, out);
+}
+
+void aes256_ctr(const Aes256Key *key, uint8_t *counter, const uint8_t *in, uint8_t *out, size_t length) {
+    uint8_t start[AES_BLOCK_LEN];
+    memcpy(start, counter, AES_BLOCK_LEN);
+    uint8_t stream[AES_BLOCK_LEN];
+    size_t offset = 0;
+    esp_aes_context ctx;
+    esp_aes_init(&ctx);
+    int ret = esp_aes_setkey(&ctx, key->key, 256);
+    if (ret == 0) ret = esp_aes_crypt_ctr(&ctx, length, &offset, counter, stream, in, out);
+    esp_aes_free(&ctx);
+    memset(stream, 0, sizeof(stream));
+    if (ret != 0) {
+        memcpy(counter, start, AES_BLOCK_LEN); // Driver pode ter avançado o contador
+        aes256_ctr_portable(key, counter, in, out, length);
+    }
+}
+
+#endif // TOTP_AES_BACKEND_ESP32S3
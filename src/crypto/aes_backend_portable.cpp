@@ -0,0 +1,22 @@
+#include "aes_backend.h"
+#include "aes256.h"
+
+#if !TOTP_AES_BACKEND_ESP32S3
+
+// ============================================================================
+// === BACKEND PORTÁVEL (HOST E ALVOS SEM ACELERADOR) ===
+// ============================================================================
+
+const char *aes_backend_name() {
+    return "portable";
+}
+
+void aes256_encryptBlock(const Aes256Key *key, const uint8_t *in, uint8_t *out) {
+    aes256_encryptBlock_portable(key, in, out);
+}
+
+void aes256_ctr(const Aes256Key *key, uint8_t *counter, const uint8_t *in, uint8_t *out, size_t length) {
+    aes256_ctr_portable(key, counter, in, out, length);
+}
+
+#endif // !TOTP_AES_BACKEND_ESP32S3
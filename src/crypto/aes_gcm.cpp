@@ -0,0 +1,118 @@
+#include "aes_gcm.h"
+#include <string.h> // Para memcpy, memset
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+// ---- GHASH ----
+// Multiplicação em GF(2^128) bit a bit, sem tabelas nem desvios dependentes da
+// chave: poucos blocos por segredo, então o custo é irrelevante frente ao NVS.
+
+// (x_hi, x_lo) = (x_hi, x_lo) * H
+static void gf_mult(const AesGcmKey *key, uint64_t *x_hi, uint64_t *x_lo) {
+    uint64_t z_hi = 0, z_lo = 0;
+    uint64_t v_hi = key->h_hi, v_lo = key->h_lo;
+    for (int i = 0; i < 128; i++) {
+        uint64_t bit = i < 64 ? (*x_hi >> (63 - i)) & 1 : (*x_lo >> (127 - i)) & 1;
+        uint64_t mask = 0 - bit;
+        z_hi ^= v_hi & mask;
+        z_lo ^= v_lo & mask;
+        uint64_t carry = 0 - (v_lo & 1);
+        v_lo = (v_lo >> 1) | (v_hi << 63);
+        v_hi = (v_hi >> 1) ^ (0xE100000000000000ULL & carry);
+    }
+    *x_hi = z_hi;
+    *x_lo = z_lo;
+}
+
+// Absorve 'length' bytes (último bloco completado com zeros)
+static void ghash_update(const AesGcmKey *key, uint64_t *s_hi, uint64_t *s_lo, const uint8_t *data, size_t length) {
+    for (size_t pos = 0; pos < length; pos += AES_BLOCK_LEN) {
+        uint8_t block[AES_BLOCK_LEN] = {0};
+        size_t n = length - pos < AES_BLOCK_LEN ? length - pos : AES_BLOCK_LEN;
+        memcpy(block, &data[pos], n);
+        *s_hi ^= load_be64(block);
+        *s_lo ^= load_be64(block + 8);
+        gf_mult(key, s_hi, s_lo);
+    }
+}
+
+// Tag = AES(J0) XOR GHASH(aad || cifrado || comprimentos em bits)
+static void compute_tag(const AesGcmKey *key, const uint8_t *j0, const uint8_t *aad, size_t aadLength,
+                        const uint8_t *cipher, size_t length, uint8_t *tag) {
+    uint64_t s_hi = 0, s_lo = 0;
+    ghash_update(key, &s_hi, &s_lo, aad, aadLength);
+    ghash_update(key, &s_hi, &s_lo, cipher, length);
+    s_hi ^= (uint64_t)aadLength * 8;
+    s_lo ^= (uint64_t)length * 8;
+    gf_mult(key, &s_hi, &s_lo);
+    uint8_t mask[AES_BLOCK_LEN];
+    aes256_encryptBlock(&key->aes, j0, mask);
+    store_be64(tag, s_hi);
+    store_be64(tag + 8, s_lo);
+    for (size_t i = 0; i < AES_GCM_TAG_LEN; i++) tag[i] ^= mask[i];
+    memset(mask, 0, sizeof(mask));
+}
+
+// J0 = IV || 0^31 || 1 (IV de 96 bits)
+static void make_j0(const uint8_t *iv, uint8_t *j0) {
+    memcpy(j0, iv, AES_GCM_IV_LEN);
+    j0[12] = j0[13] = j0[14] = 0;
+    j0[15] = 1;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void aesgcm_setKey(const uint8_t *key, AesGcmKey *out) {
+    aes256_setKey(key, &out->aes);
+    uint8_t h[AES_BLOCK_LEN] = {0};
+    aes256_encryptBlock(&out->aes, h, h);
+    out->h_hi = load_be64(h);
+    out->h_lo = load_be64(h + 8);
+    memset(h, 0, sizeof(h));
+}
+
+void aesgcm_clearKey(AesGcmKey *key) {
+    volatile uint8_t *p = (volatile uint8_t *)key; // Não deixa o compilador omitir a limpeza
+    for (size_t i = 0; i < sizeof(AesGcmKey); i++) p[i] = 0;
+}
+
+void aesgcm_encrypt(const AesGcmKey *key, const uint8_t *iv, const uint8_t *aad, size_t aadLength,
+                    const uint8_t *in, uint8_t *out, size_t length, uint8_t *tag) {
+    uint8_t j0[AES_BLOCK_LEN], counter[AES_BLOCK_LEN];
+    make_j0(iv, j0);
+    memcpy(counter, j0, AES_BLOCK_LEN);
+    counter[15] = 2; // inc32(J0)
+    aes256_ctr(&key->aes, counter, in, out, length);
+    compute_tag(key, j0, aad, aadLength, out, length, tag);
+}
+
+bool aesgcm_decrypt(const AesGcmKey *key, const uint8_t *iv, const uint8_t *aad, size_t aadLength,
+                    const uint8_t *in, uint8_t *out, size_t length, const uint8_t *tag) {
+    uint8_t j0[AES_BLOCK_LEN], expected[AES_GCM_TAG_LEN];
+    make_j0(iv, j0);
+    compute_tag(key, j0, aad, aadLength, in, length, expected);
+    uint8_t diff = 0;
+    for (size_t i = 0; i < AES_GCM_TAG_LEN; i++) diff |= expected[i] ^ tag[i]; // Tempo constante
+    if (diff != 0) {
+        memset(out, 0, length);
+        return false;
+    }
+    uint8_t counter[AES_BLOCK_LEN];
+    memcpy(counter, j0, AES_BLOCK_LEN);
+    counter[15] = 2;
+    aes256_ctr(&key->aes, counter, in, out, length);
+    return true;
+}
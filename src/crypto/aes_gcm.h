@@ -0,0 +1,62 @@
+#pragma once // Include guard
+
+#include "aes256.h"
+
+// ============================================================================
+// === AES-256-GCM (SEM HEAP) ===
+// ============================================================================
+// Cifragem autenticada dos segredos do cofre (NIST SP 800-38D), só com IV de
+// 96 bits e tag de 128 bits. O modo contador vem do backend AES (hardware no
+// S3); o GHASH é em software, com H calculado uma vez por chave. Um registro
+// adulterado, trocado de lugar (AAD) ou lido com a chave errada é recusado
+// inteiro, sem liberar nenhum byte decifrado.
+
+constexpr size_t AES_GCM_IV_LEN = 12;  // IV (nonce) de 96 bits
+constexpr size_t AES_GCM_TAG_LEN = 16; // Tag de autenticação
+
+// --- Chave GCM Preparada ---
+struct AesGcmKey {
+  Aes256Key aes;
+  uint64_t h_hi, h_lo; // Subchave do GHASH, H = AES(K, 0^128), em big-endian
+};
+
+/**
+ * @brief Prepara a chave (expansão AES e subchave H) uma única vez.
+ * @param key Chave de AES256_KEY_LEN bytes.
+ * @param out Chave preparada.
+ */
+void aesgcm_setKey(const uint8_t *key, AesGcmKey *out);
+
+/**
+ * @brief Apaga a chave preparada (fim da sessão).
+ */
+void aesgcm_clearKey(AesGcmKey *key);
+
+/**
+ * @brief Cifra e autentica 'length' bytes.
+ * @param key Chave preparada.
+ * @param iv IV de AES_GCM_IV_LEN bytes; nunca repetir com a mesma chave.
+ * @param aad Dados autenticados e não cifrados (pode ser nullptr se aadLength for 0).
+ * @param aadLength Comprimento de 'aad'.
+ * @param in Texto claro.
+ * @param out Texto cifrado, 'length' bytes (distinto de 'in').
+ * @param length Comprimento em bytes.
+ * @param tag Saída: tag de AES_GCM_TAG_LEN bytes.
+ */
+void aesgcm_encrypt(const AesGcmKey *key, const uint8_t *iv, const uint8_t *aad, size_t aadLength,
+                    const uint8_t *in, uint8_t *out, size_t length, uint8_t *tag);
+
+/**
+ * @brief Confere a tag e decifra 'length' bytes. A tag é conferida antes de decifrar.
+ * @param key Chave preparada.
+ * @param iv IV usado na cifragem.
+ * @param aad Mesmos dados autenticados da cifragem.
+ * @param aadLength Comprimento de 'aad'.
+ * @param in Texto cifrado.
+ * @param out Texto claro, 'length' bytes (distinto de 'in'); zerado se a tag não conferir.
+ * @param length Comprimento em bytes.
+ * @param tag Tag de AES_GCM_TAG_LEN bytes.
+ * @return true se a tag confere.
+ */
+bool aesgcm_decrypt(const AesGcmKey *key, const uint8_t *iv, const uint8_t *aad, size_t aadLength,
+                    const uint8_t *in, uint8_t *out, size_t length, const uint8_t *tag);
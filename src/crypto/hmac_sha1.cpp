@@ -0,0 +1,30 @@
+#include "hmac_sha1.h"
+#include <string.h> // Para memcpy, memset
+
+void hmac_sha1_prepare(const uint8_t *key, size_t keyLength, HmacSha1Key *out) {
+    uint8_t key_block[SHA1_BLOCK_LEN] = {0};
+    if (keyLength > SHA1_BLOCK_LEN) {
+        sha1_digest(key, keyLength, key_block);
+    } else {
+        memcpy(key_block, key, keyLength);
+    }
+
+    uint8_t pad[SHA1_BLOCK_LEN];
+    for (size_t i = 0; i < SHA1_BLOCK_LEN; i++) pad[i] = key_block[i] ^ 0x36;
+    sha1_init(&out->inner);
+    sha1_compress(&out->inner, pad);
+
+    for (size_t i = 0; i < SHA1_BLOCK_LEN; i++) pad[i] = key_block[i] ^ 0x5C;
+    sha1_init(&out->outer);
+    sha1_compress(&out->outer, pad);
+
+    // Não deixa material da chave na pilha
+    memset(key_block, 0, sizeof(key_block));
+    memset(pad, 0, sizeof(pad));
+}
+
+void hmac_sha1_short(const HmacSha1Key *key, const uint8_t *msg, size_t msgLength, uint8_t *out) {
+    uint8_t inner_hash[SHA1_DIGEST_LEN];
+    sha1_finishShort(&key->inner, SHA1_BLOCK_LEN, msg, msgLength, inner_hash);
+    sha1_finishShort(&key->outer, SHA1_BLOCK_LEN, inner_hash, SHA1_DIGEST_LEN, out);
+}
@@ -0,0 +1,36 @@
+#pragma once // Include guard
+
+#include "sha1.h"
+
+// ============================================================================
+// === HMAC-SHA1 COM MIDSTATES (SEM HEAP) ===
+// ============================================================================
+// HMAC (RFC 2104) construído sobre o SHA-1 portável. A chave é absorvida uma
+// única vez em dois midstates; cada mensagem curta custa então duas compressões.
+
+// --- Chave HMAC Pré-processada ---
+struct HmacSha1Key {
+  Sha1State inner; // SHA-1 após absorver o bloco K ^ ipad
+  Sha1State outer; // SHA-1 após absorver o bloco K ^ opad
+};
+
+// Maior mensagem aceita por hmac_sha1_short() (cabe em um único bloco com padding)
+constexpr size_t HMAC_SHA1_MAX_SHORT_MSG = SHA1_BLOCK_LEN - 9;
+
+/**
+ * @brief Pré-processa uma chave HMAC-SHA1 em midstates ipad/opad.
+ *        Chaves maiores que 64 bytes são substituídas pelo seu SHA-1 (RFC 2104).
+ * @param key Ponteiro para a chave binária.
+ * @param keyLength Comprimento da chave em bytes.
+ * @param out Estrutura de saída com os dois midstates.
+ */
+void hmac_sha1_prepare(const uint8_t *key, size_t keyLength, HmacSha1Key *out);
+
+/**
+ * @brief Calcula o HMAC-SHA1 de uma mensagem curta a partir de uma chave pré-processada.
+ * @param key Chave preparada por hmac_sha1_prepare().
+ * @param msg Ponteiro para a mensagem.
+ * @param msgLength Comprimento da mensagem; no máximo HMAC_SHA1_MAX_SHORT_MSG bytes.
+ * @param out Buffer de saída de SHA1_DIGEST_LEN bytes.
+ */
+void hmac_sha1_short(const HmacSha1Key *key, const uint8_t *msg, size_t msgLength, uint8_t *out);
@@ -0,0 +1,146 @@
+#include "hmac_sha1_batch.h"
+
+// ============================================================================
+// === TIPO DE FAIXAS ===
+// ============================================================================
+// 'Lanes' guarda uma palavra de 32 bits por faixa. Com SIMD no host é um vetor
+// nativo do GCC; nos demais alvos é um array com os mesmos operadores, que o
+// compilador expande em código escalar intercalado. O núcleo é o mesmo.
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+
+typedef uint32_t Lanes __attribute__((vector_size(4 * HMAC_SHA1_BATCH_LANES)));
+static const char *const BATCH_IMPL_NAME =
+#if defined(__SSE2__)
+    "sse2x4";
+#else
+    "neonx4";
+#endif
+
+#else
+
+struct Lanes {
+    uint32_t v[HMAC_SHA1_BATCH_LANES];
+    uint32_t &operator[](size_t l) { return v[l]; }
+    uint32_t operator[](size_t l) const { return v[l]; }
+};
+
+#define LANES_BINARY_OP(op)                                                        \
+    static inline Lanes operator op(const Lanes &x, const Lanes &y) {              \
+        Lanes r;                                                                   \
+        for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) r.v[l] = x.v[l] op y.v[l]; \
+        return r;                                                                  \
+    }
+LANES_BINARY_OP(+)
+LANES_BINARY_OP(^)
+LANES_BINARY_OP(&)
+LANES_BINARY_OP(|)
+#undef LANES_BINARY_OP
+
+static inline Lanes operator+(const Lanes &x, uint32_t k) {
+    Lanes r;
+    for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) r.v[l] = x.v[l] + k;
+    return r;
+}
+static inline Lanes operator~(const Lanes &x) {
+    Lanes r;
+    for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) r.v[l] = ~x.v[l];
+    return r;
+}
+static inline Lanes operator<<(const Lanes &x, int n) {
+    Lanes r;
+    for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) r.v[l] = x.v[l] << n;
+    return r;
+}
+static inline Lanes operator>>(const Lanes &x, int n) {
+    Lanes r;
+    for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) r.v[l] = x.v[l] >> n;
+    return r;
+}
+
+static const char *const BATCH_IMPL_NAME = "scalar-x4";
+
+#endif
+
+// ============================================================================
+// === FUNÇÕES AUXILIARES ===
+// ============================================================================
+
+static inline Lanes lanes_fill(uint32_t x) {
+    Lanes r;
+    for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) r[l] = x;
+    return r;
+}
+
+static inline Lanes rol_lanes(Lanes x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+// Compressão SHA-1 de um bloco por faixa (mesma estrutura de sha1_compress_portable)
+static void sha1_compress_lanes(Lanes st[5], Lanes w[16]) {
+    Lanes a = st[0], b = st[1], c = st[2], d = st[3], e = st[4];
+    for (int t = 0; t < 80; t++) {
+        Lanes wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            wt = rol_lanes(w[(t + 13) & 15] ^ w[(t + 8) & 15] ^ w[(t + 2) & 15] ^ w[t & 15], 1);
+            w[t & 15] = wt;
+        }
+        Lanes tmp;
+        if (t < 20)      tmp = rol_lanes(a, 5) + ((b & c) | (~b & d)) + e + wt + 0x5A827999u;
+        else if (t < 40) tmp = rol_lanes(a, 5) + (b ^ c ^ d) + e + wt + 0x6ED9EBA1u;
+        else if (t < 60) tmp = rol_lanes(a, 5) + ((b & c) | (b & d) | (c & d)) + e + wt + 0x8F1BBCDCu;
+        else             tmp = rol_lanes(a, 5) + (b ^ c ^ d) + e + wt + 0xCA62C1D6u;
+        e = d; d = c; c = rol_lanes(b, 30); b = a; a = tmp;
+    }
+    st[0] = st[0] + a; st[1] = st[1] + b; st[2] = st[2] + c; st[3] = st[3] + d; st[4] = st[4] + e;
+}
+
+// ============================================================================
+// === HMAC-SHA1 EM LOTE ===
+// ============================================================================
+
+void hmac_sha1_counter_batch(const HmacSha1Key *const *keys, const uint64_t *counters, size_t count,
+                             uint8_t (*out)[SHA1_DIGEST_LEN]) {
+    for (size_t base = 0; base < count; base += HMAC_SHA1_BATCH_LANES) {
+        size_t used = count - base < HMAC_SHA1_BATCH_LANES ? count - base : HMAC_SHA1_BATCH_LANES;
+        Lanes st[5], w[16];
+
+        // Bloco interno: contador (2 palavras) + padding para 64 + 8 bytes.
+        // Faixas sobrando na última rodada repetem o primeiro par e são descartadas.
+        for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) {
+            size_t src = base + (l < used ? l : 0);
+            for (int i = 0; i < 5; i++) st[i][l] = keys[src]->inner.h[i];
+            w[0][l] = (uint32_t)(counters[src] >> 32);
+            w[1][l] = (uint32_t)counters[src];
+        }
+        w[2] = lanes_fill(0x80000000u);
+        for (int i = 3; i < 15; i++) w[i] = lanes_fill(0);
+        w[15] = lanes_fill((SHA1_BLOCK_LEN + 8) * 8);
+        sha1_compress_lanes(st, w);
+
+        // Bloco externo: hash interno (5 palavras) + padding para 64 + 20 bytes
+        for (int i = 0; i < 5; i++) w[i] = st[i];
+        w[5] = lanes_fill(0x80000000u);
+        for (int i = 6; i < 15; i++) w[i] = lanes_fill(0);
+        w[15] = lanes_fill((SHA1_BLOCK_LEN + SHA1_DIGEST_LEN) * 8);
+        for (size_t l = 0; l < HMAC_SHA1_BATCH_LANES; l++) {
+            size_t src = base + (l < used ? l : 0);
+            for (int i = 0; i < 5; i++) st[i][l] = keys[src]->outer.h[i];
+        }
+        sha1_compress_lanes(st, w);
+
+        for (size_t l = 0; l < used; l++) {
+            for (int i = 0; i < 5; i++) store_be32(out[base + l] + 4 * i, st[i][l]);
+        }
+    }
+}
+
+const char *hmac_sha1_batch_name() {
+    return BATCH_IMPL_NAME;
+}
@@ -0,0 +1,44 @@
+#pragma once // Include guard
+
+#include "hmac_sha1.h"
+
+// ============================================================================
+// === HMAC-SHA1 EM LOTE (VÁRIAS FAIXAS INTERCALADAS) ===
+// ============================================================================
+// Calcula HMAC-SHA1(chave_i, contador_i) para N pares de uma vez, processando
+// HMAC_SHA1_BATCH_LANES agendas de mensagem SHA-1 em paralelo:
+//   - host com SSE2/NEON: extensões vetoriais do GCC (uma faixa por elemento);
+//   - ESP32-S3 e demais: as mesmas operações em escalar intercalado (as faixas
+//     são independentes, o que esconde latências sem precisar de SIMD).
+// O resultado é idêntico, byte a byte, ao de hmac_sha1_short() com o contador
+// de 8 bytes big-endian. Sempre usa a compressão em software (não o backend SHA).
+
+constexpr size_t HMAC_SHA1_BATCH_LANES = 4; // Faixas processadas por rodada
+
+// Uso do lote na regeneração da tabela (codetable_generate). Com o motor SHA do
+// S3 selecionado o padrão é o caminho um-a-um no hardware; defina
+// TOTP_BATCH_HMAC=1 para comparar (ver test/bench_batch_hmac).
+#ifndef TOTP_BATCH_HMAC
+#include "sha_backend.h"
+#if TOTP_SHA_BACKEND_ESP32S3
+#define TOTP_BATCH_HMAC 0
+#else
+#define TOTP_BATCH_HMAC 1
+#endif
+#endif
+
+/**
+ * @brief Calcula HMAC-SHA1 de N contadores de 64 bits, cada um com sua chave pré-processada.
+ * @param keys Vetor de N ponteiros para chaves preparadas por hmac_sha1_prepare().
+ * @param counters Vetor de N contadores (codificados como 8 bytes big-endian, RFC 4226).
+ * @param count Número de pares (N). Qualquer valor; a última rodada é completada internamente.
+ * @param out Saída: N hashes de SHA1_DIGEST_LEN bytes.
+ */
+void hmac_sha1_counter_batch(const HmacSha1Key *const *keys, const uint64_t *counters, size_t count,
+                             uint8_t (*out)[SHA1_DIGEST_LEN]);
+
+/**
+ * @brief Implementação de faixas selecionada na compilação (para logs e benchmarks).
+ * @return String constante, ex: "sse2x4" ou "scalar-x4".
+ */
+const char *hmac_sha1_batch_name();
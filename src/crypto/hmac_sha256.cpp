@@ -0,0 +1,30 @@
+#include "hmac_sha256.h"
+#include <string.h> // Para memcpy, memset
+
+void hmac_sha256_prepare(const uint8_t *key, size_t keyLength, HmacSha256Key *out) {
+    uint8_t key_block[SHA256_BLOCK_LEN] = {0};
+    if (keyLength > SHA256_BLOCK_LEN) {
+        sha256_digest(key, keyLength, key_block);
+    } else {
+        memcpy(key_block, key, keyLength);
+    }
+
+    uint8_t pad[SHA256_BLOCK_LEN];
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) pad[i] = key_block[i] ^ 0x36;
+    sha256_init(&out->inner);
+    sha256_compress(&out->inner, pad);
+
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) pad[i] = key_block[i] ^ 0x5C;
+    sha256_init(&out->outer);
+    sha256_compress(&out->outer, pad);
+
+    // Não deixa material da chave na pilha
+    memset(key_block, 0, sizeof(key_block));
+    memset(pad, 0, sizeof(pad));
+}
+
+void hmac_sha256_short(const HmacSha256Key *key, const uint8_t *msg, size_t msgLength, uint8_t *out) {
+    uint8_t inner_hash[SHA256_DIGEST_LEN];
+    sha256_finishShort(&key->inner, SHA256_BLOCK_LEN, msg, msgLength, inner_hash);
+    sha256_finishShort(&key->outer, SHA256_BLOCK_LEN, inner_hash, SHA256_DIGEST_LEN, out);
+}
@@ -0,0 +1,36 @@
+#pragma once // Include guard
+
+#include "sha256.h"
+
+// ============================================================================
+// === HMAC-SHA256 COM MIDSTATES (SEM HEAP) ===
+// ============================================================================
+// Mesma organização do hmac_sha1.h: a chave é absorvida uma única vez em dois
+// midstates; cada mensagem curta custa então duas compressões.
+
+// --- Chave HMAC Pré-processada ---
+struct HmacSha256Key {
+  Sha256State inner; // SHA-256 após absorver o bloco K ^ ipad
+  Sha256State outer; // SHA-256 após absorver o bloco K ^ opad
+};
+
+// Maior mensagem aceita por hmac_sha256_short() (cabe em um único bloco com padding)
+constexpr size_t HMAC_SHA256_MAX_SHORT_MSG = SHA256_BLOCK_LEN - 9;
+
+/**
+ * @brief Pré-processa uma chave HMAC-SHA256 em midstates ipad/opad.
+ *        Chaves maiores que 64 bytes são substituídas pelo seu SHA-256 (RFC 2104).
+ * @param key Ponteiro para a chave binária.
+ * @param keyLength Comprimento da chave em bytes.
+ * @param out Estrutura de saída com os dois midstates.
+ */
+void hmac_sha256_prepare(const uint8_t *key, size_t keyLength, HmacSha256Key *out);
+
+/**
+ * @brief Calcula o HMAC-SHA256 de uma mensagem curta a partir de uma chave pré-processada.
+ * @param key Chave preparada por hmac_sha256_prepare().
+ * @param msg Ponteiro para a mensagem.
+ * @param msgLength Comprimento da mensagem; no máximo HMAC_SHA256_MAX_SHORT_MSG bytes.
+ * @param out Buffer de saída de SHA256_DIGEST_LEN bytes.
+ */
+void hmac_sha256_short(const HmacSha256Key *key, const uint8_t *msg, size_t msgLength, uint8_t *out);
@@ -0,0 +1,30 @@
+#include "hmac_sha512.h"
+#include <string.h> // Para memcpy, memset
+
+void hmac_sha512_prepare(const uint8_t *key, size_t keyLength, HmacSha512Key *out) {
+    uint8_t key_block[SHA512_BLOCK_LEN] = {0};
+    if (keyLength > SHA512_BLOCK_LEN) {
+        sha512_digest(key, keyLength, key_block);
+    } else {
+        memcpy(key_block, key, keyLength);
+    }
+
+    uint8_t pad[SHA512_BLOCK_LEN];
+    for (size_t i = 0; i < SHA512_BLOCK_LEN; i++) pad[i] = key_block[i] ^ 0x36;
+    sha512_init(&out->inner);
+    sha512_compress(&out->inner, pad);
+
+    for (size_t i = 0; i < SHA512_BLOCK_LEN; i++) pad[i] = key_block[i] ^ 0x5C;
+    sha512_init(&out->outer);
+    sha512_compress(&out->outer, pad);
+
+    // Não deixa material da chave na pilha
+    memset(key_block, 0, sizeof(key_block));
+    memset(pad, 0, sizeof(pad));
+}
+
+void hmac_sha512_short(const HmacSha512Key *key, const uint8_t *msg, size_t msgLength, uint8_t *out) {
+    uint8_t inner_hash[SHA512_DIGEST_LEN];
+    sha512_finishShort(&key->inner, SHA512_BLOCK_LEN, msg, msgLength, inner_hash);
+    sha512_finishShort(&key->outer, SHA512_BLOCK_LEN, inner_hash, SHA512_DIGEST_LEN, out);
+}
@@ -0,0 +1,36 @@
+#pragma once // Include guard
+
+#include "sha512.h"
+
+// ============================================================================
+// === HMAC-SHA512 COM MIDSTATES (SEM HEAP) ===
+// ============================================================================
+// Mesma organização do hmac_sha1.h: a chave é absorvida uma única vez em dois
+// midstates; cada mensagem curta custa então duas compressões.
+
+// --- Chave HMAC Pré-processada ---
+struct HmacSha512Key {
+  Sha512State inner; // SHA-512 após absorver o bloco K ^ ipad
+  Sha512State outer; // SHA-512 após absorver o bloco K ^ opad
+};
+
+// Maior mensagem aceita por hmac_sha512_short() (cabe em um único bloco com padding)
+constexpr size_t HMAC_SHA512_MAX_SHORT_MSG = SHA512_BLOCK_LEN - 17;
+
+/**
+ * @brief Pré-processa uma chave HMAC-SHA512 em midstates ipad/opad.
+ *        Chaves maiores que 128 bytes são substituídas pelo seu SHA-512 (RFC 2104).
+ * @param key Ponteiro para a chave binária.
+ * @param keyLength Comprimento da chave em bytes.
+ * @param out Estrutura de saída com os dois midstates.
+ */
+void hmac_sha512_prepare(const uint8_t *key, size_t keyLength, HmacSha512Key *out);
+
+/**
+ * @brief Calcula o HMAC-SHA512 de uma mensagem curta a partir de uma chave pré-processada.
+ * @param key Chave preparada por hmac_sha512_prepare().
+ * @param msg Ponteiro para a mensagem.
+ * @param msgLength Comprimento da mensagem; no máximo HMAC_SHA512_MAX_SHORT_MSG bytes.
+ * @param out Buffer de saída de SHA512_DIGEST_LEN bytes.
+ */
+void hmac_sha512_short(const HmacSha512Key *key, const uint8_t *msg, size_t msgLength, uint8_t *out);
@@ -0,0 +1,28 @@
+#include "pbkdf2.h"
+#include "sha_backend.h"
+#include <string.h> // Para memcpy, memset
+
+void pbkdf2_hmac_sha256(const uint8_t *password, size_t passwordLength, const uint8_t *salt, size_t saltLength,
+                        uint32_t iterations, uint8_t *out, size_t outLength) {
+    HmacSha256Key key;
+    hmac_sha256_prepare(password, passwordLength, &key);
+    uint8_t msg[PBKDF2_MAX_SALT_LEN + 4];
+    memcpy(msg, salt, saltLength);
+    msg[saltLength] = msg[saltLength + 1] = msg[saltLength + 2] = 0;
+    msg[saltLength + 3] = 1; // INT(1): só o primeiro bloco
+
+    uint8_t u[SHA256_DIGEST_LEN], t[SHA256_DIGEST_LEN];
+    sha_backend_acquire(); // Uma reserva do motor SHA para todas as iterações
+    hmac_sha256_short(&key, msg, saltLength + 4, u);
+    memcpy(t, u, sizeof(t));
+    for (uint32_t i = 1; i < iterations; i++) {
+        hmac_sha256_short(&key, u, sizeof(u), u);
+        for (size_t j = 0; j < sizeof(t); j++) t[j] ^= u[j];
+    }
+    sha_backend_release();
+    memcpy(out, t, outLength);
+
+    memset(&key, 0, sizeof(key));
+    memset(u, 0, sizeof(u));
+    memset(t, 0, sizeof(t));
+}
@@ -0,0 +1,27 @@
+#pragma once // Include guard
+
+#include "hmac_sha256.h"
+
+// ============================================================================
+// === PBKDF2-HMAC-SHA256 (UM BLOCO, SEM HEAP) ===
+// ============================================================================
+// Derivação da chave do cofre (RFC 8018). A senha é absorvida uma vez nos
+// midstates HMAC; cada iteração custa então duas compressões SHA-256 (motor
+// de hardware no S3). Só o primeiro bloco de saída: até 32 bytes, o bastante
+// para uma chave AES-256.
+
+// Maior sal aceito (sal || INT(1) cabe em hmac_sha256_short)
+constexpr size_t PBKDF2_MAX_SALT_LEN = HMAC_SHA256_MAX_SHORT_MSG - 4;
+
+/**
+ * @brief Deriva até SHA256_DIGEST_LEN bytes de uma senha e um sal.
+ * @param password Senha (qualquer comprimento).
+ * @param passwordLength Comprimento da senha em bytes.
+ * @param salt Sal; no máximo PBKDF2_MAX_SALT_LEN bytes.
+ * @param saltLength Comprimento do sal.
+ * @param iterations Número de iterações (>= 1).
+ * @param out Saída de 'outLength' bytes.
+ * @param outLength Comprimento da saída; no máximo SHA256_DIGEST_LEN.
+ */
+void pbkdf2_hmac_sha256(const uint8_t *password, size_t passwordLength, const uint8_t *salt, size_t saltLength,
+                        uint32_t iterations, uint8_t *out, size_t outLength);
@@ -0,0 +1,100 @@
+#include "sha1.h"
+#include <string.h> // Para memcpy, memset
+
+// ============================================================================
+// === FUNÇÕES AUXILIARES ===
+// ============================================================================
+
+static inline uint32_t rol32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static void store_digest(const Sha1State *state, uint8_t *out) {
+    for (int i = 0; i < 5; i++) store_be32(out + 4 * i, state->h[i]);
+}
+
+// Escreve o padding SHA-1 (0x80, zeros, comprimento em bits big-endian) no fim do bloco
+static void write_padding(uint8_t *block, size_t used, uint64_t totalLength) {
+    block[used] = 0x80;
+    memset(block + used + 1, 0, SHA1_BLOCK_LEN - 8 - used - 1);
+    uint64_t bits = totalLength * 8;
+    for (int i = 0; i < 8; i++) block[SHA1_BLOCK_LEN - 1 - i] = (uint8_t)(bits >> (8 * i));
+}
+
+// ============================================================================
+// === SHA-1 ===
+// ============================================================================
+
+void sha1_init(Sha1State *state) {
+    state->h[0] = 0x67452301;
+    state->h[1] = 0xEFCDAB89;
+    state->h[2] = 0x98BADCFE;
+    state->h[3] = 0x10325476;
+    state->h[4] = 0xC3D2E1F0;
+}
+
+void sha1_compress_portable(Sha1State *state, const uint8_t *block) {
+    // Agenda de mensagens em janela circular de 16 palavras (64 bytes de pilha)
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++) w[i] = load_be32(block + 4 * i);
+
+    uint32_t a = state->h[0], b = state->h[1], c = state->h[2], d = state->h[3], e = state->h[4];
+    for (int t = 0; t < 80; t++) {
+        uint32_t wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            wt = rol32(w[(t + 13) & 15] ^ w[(t + 8) & 15] ^ w[(t + 2) & 15] ^ w[t & 15], 1);
+            w[t & 15] = wt;
+        }
+        uint32_t f, k;
+        if (t < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+        else if (t < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+        else if (t < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+        uint32_t tmp = rol32(a, 5) + f + e + k + wt;
+        e = d; d = c; c = rol32(b, 30); b = a; a = tmp;
+    }
+    state->h[0] += a; state->h[1] += b; state->h[2] += c; state->h[3] += d; state->h[4] += e;
+}
+
+void sha1_finishShort(const Sha1State *state, uint64_t prefixLength, const uint8_t *tail, size_t tailLength, uint8_t *out) {
+    uint8_t block[SHA1_BLOCK_LEN];
+    memcpy(block, tail, tailLength);
+    write_padding(block, tailLength, prefixLength + tailLength);
+    Sha1State st = *state;
+    sha1_compress(&st, block);
+    store_digest(&st, out);
+}
+
+void sha1_digest(const uint8_t *data, size_t length, uint8_t *out) {
+    Sha1State st;
+    sha1_init(&st);
+    size_t full = length - (length % SHA1_BLOCK_LEN);
+    for (size_t off = 0; off < full; off += SHA1_BLOCK_LEN) sha1_compress(&st, data + off);
+
+    // Cauda + padding: pode ocupar um ou dois blocos
+    uint8_t block[SHA1_BLOCK_LEN];
+    size_t rem = length - full;
+    memcpy(block, data + full, rem);
+    if (rem > SHA1_BLOCK_LEN - 9) {
+        block[rem] = 0x80;
+        memset(block + rem + 1, 0, SHA1_BLOCK_LEN - rem - 1);
+        sha1_compress(&st, block);
+        memset(block, 0, SHA1_BLOCK_LEN - 8);
+        uint64_t bits = (uint64_t)length * 8;
+        for (int i = 0; i < 8; i++) block[SHA1_BLOCK_LEN - 1 - i] = (uint8_t)(bits >> (8 * i));
+    } else {
+        write_padding(block, rem, length);
+    }
+    sha1_compress(&st, block);
+    store_digest(&st, out);
+}
@@ -0,0 +1,61 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint32_t, uint64_t
+
+// ============================================================================
+// === SHA-1 (SEM HEAP) ===
+// ============================================================================
+// Implementação autocontida do SHA-1 (FIPS 180-4). A compressão vem do backend
+// escolhido em sha_backend.h; padding e finalização são comuns. Todo o estado
+// fica em estruturas fornecidas pelo chamador (normalmente na pilha); nenhuma
+// função aloca memória nem possui caminho de erro.
+
+constexpr size_t SHA1_BLOCK_LEN = 64;  // Tamanho do bloco de compressão (bytes)
+constexpr size_t SHA1_DIGEST_LEN = 20; // Tamanho do hash de saída (bytes)
+
+// --- Estado de Encadeamento do SHA-1 (H0..H4) ---
+struct Sha1State {
+  uint32_t h[5];
+};
+
+/**
+ * @brief Inicializa o estado com os valores iniciais padrão do SHA-1.
+ * @param state Estado a ser inicializado.
+ */
+void sha1_init(Sha1State *state);
+
+/**
+ * @brief Aplica a função de compressão do SHA-1 sobre um bloco de 64 bytes.
+ *        Implementada pelo backend selecionado em sha_backend.h (hardware ou portável).
+ * @param state Estado de encadeamento (atualizado no lugar).
+ * @param block Bloco de entrada de SHA1_BLOCK_LEN bytes.
+ */
+void sha1_compress(Sha1State *state, const uint8_t *block);
+
+/**
+ * @brief Compressão SHA-1 em C++ puro. Usada pelo backend portável e como
+ *        referência/fallback pelo backend de hardware.
+ * @param state Estado de encadeamento (atualizado no lugar).
+ * @param block Bloco de entrada de SHA1_BLOCK_LEN bytes.
+ */
+void sha1_compress_portable(Sha1State *state, const uint8_t *block);
+
+/**
+ * @brief Finaliza um hash cujo prefixo (múltiplo de 64 bytes) já foi absorvido em 'state',
+ *        processando a cauda curta e o padding em uma única compressão.
+ * @param state Midstate após o prefixo (não é modificado).
+ * @param prefixLength Número de bytes já absorvidos (múltiplo de SHA1_BLOCK_LEN).
+ * @param tail Bytes restantes da mensagem.
+ * @param tailLength Comprimento da cauda; deve ser no máximo 55 bytes.
+ * @param out Buffer de saída de SHA1_DIGEST_LEN bytes.
+ */
+void sha1_finishShort(const Sha1State *state, uint64_t prefixLength, const uint8_t *tail, size_t tailLength, uint8_t *out);
+
+/**
+ * @brief Calcula o SHA-1 de uma mensagem de qualquer tamanho.
+ * @param data Ponteiro para a mensagem.
+ * @param length Comprimento da mensagem em bytes.
+ * @param out Buffer de saída de SHA1_DIGEST_LEN bytes.
+ */
+void sha1_digest(const uint8_t *data, size_t length, uint8_t *out);
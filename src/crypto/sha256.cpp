@@ -0,0 +1,111 @@
+#include "sha256.h"
+#include <string.h> // Para memcpy, memset
+
+// ============================================================================
+// === FUNÇÕES AUXILIARES ===
+// ============================================================================
+
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static inline uint32_t ror32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static void store_digest(const Sha256State *state, uint8_t *out) {
+    for (int i = 0; i < 8; i++) store_be32(out + 4 * i, state->h[i]);
+}
+
+// Escreve o padding (0x80, zeros, comprimento em bits big-endian) no fim do bloco
+static void write_padding(uint8_t *block, size_t used, uint64_t totalLength) {
+    block[used] = 0x80;
+    memset(block + used + 1, 0, SHA256_BLOCK_LEN - 8 - used - 1);
+    uint64_t bits = totalLength * 8;
+    for (int i = 0; i < 8; i++) block[SHA256_BLOCK_LEN - 1 - i] = (uint8_t)(bits >> (8 * i));
+}
+
+// ============================================================================
+// === SHA-256 ===
+// ============================================================================
+
+void sha256_init(Sha256State *state) {
+    state->h[0] = 0x6a09e667; state->h[1] = 0xbb67ae85; state->h[2] = 0x3c6ef372; state->h[3] = 0xa54ff53a;
+    state->h[4] = 0x510e527f; state->h[5] = 0x9b05688c; state->h[6] = 0x1f83d9ab; state->h[7] = 0x5be0cd19;
+}
+
+void sha256_compress_portable(Sha256State *state, const uint8_t *block) {
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++) w[i] = load_be32(block + 4 * i);
+
+    uint32_t a = state->h[0], b = state->h[1], c = state->h[2], d = state->h[3];
+    uint32_t e = state->h[4], f = state->h[5], g = state->h[6], h = state->h[7];
+    for (int t = 0; t < 64; t++) {
+        uint32_t wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            uint32_t w15 = w[(t + 1) & 15], w2 = w[(t + 14) & 15];
+            uint32_t s0 = ror32(w15, 7) ^ ror32(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = ror32(w2, 17) ^ ror32(w2, 19) ^ (w2 >> 10);
+            wt = w[t & 15] + s0 + w[(t + 9) & 15] + s1;
+            w[t & 15] = wt;
+        }
+        uint32_t S1 = ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + S1 + ch + K256[t] + wt;
+        uint32_t S0 = ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = S0 + maj;
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+    }
+    state->h[0] += a; state->h[1] += b; state->h[2] += c; state->h[3] += d;
+    state->h[4] += e; state->h[5] += f; state->h[6] += g; state->h[7] += h;
+}
+
+void sha256_finishShort(const Sha256State *state, uint64_t prefixLength, const uint8_t *tail, size_t tailLength, uint8_t *out) {
+    uint8_t block[SHA256_BLOCK_LEN];
+    memcpy(block, tail, tailLength);
+    write_padding(block, tailLength, prefixLength + tailLength);
+    Sha256State st = *state;
+    sha256_compress(&st, block);
+    store_digest(&st, out);
+}
+
+void sha256_digest(const uint8_t *data, size_t length, uint8_t *out) {
+    Sha256State st;
+    sha256_init(&st);
+    size_t full = length - (length % SHA256_BLOCK_LEN);
+    for (size_t off = 0; off < full; off += SHA256_BLOCK_LEN) sha256_compress(&st, data + off);
+
+    // Cauda + padding: pode ocupar um ou dois blocos
+    uint8_t block[SHA256_BLOCK_LEN];
+    size_t rem = length - full;
+    memcpy(block, data + full, rem);
+    if (rem > SHA256_BLOCK_LEN - 9) {
+        block[rem] = 0x80;
+        memset(block + rem + 1, 0, SHA256_BLOCK_LEN - rem - 1);
+        sha256_compress(&st, block);
+        memset(block, 0, SHA256_BLOCK_LEN - 8);
+        uint64_t bits = (uint64_t)length * 8;
+        for (int i = 0; i < 8; i++) block[SHA256_BLOCK_LEN - 1 - i] = (uint8_t)(bits >> (8 * i));
+    } else {
+        write_padding(block, rem, length);
+    }
+    sha256_compress(&st, block);
+    store_digest(&st, out);
+}
@@ -0,0 +1,57 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint32_t, uint64_t
+
+// ============================================================================
+// === SHA-256 (SEM HEAP) ===
+// ============================================================================
+// Mesma organização do sha1.h: compressão fornecida pelo backend selecionado
+// em sha_backend.h; padding e finalização comuns; estado sempre do chamador.
+
+constexpr size_t SHA256_BLOCK_LEN = 64;  // Tamanho do bloco de compressão (bytes)
+constexpr size_t SHA256_DIGEST_LEN = 32; // Tamanho do hash de saída (bytes)
+
+// --- Estado de Encadeamento do SHA-256 (H0..H7) ---
+struct Sha256State {
+  uint32_t h[8];
+};
+
+/**
+ * @brief Inicializa o estado com os valores iniciais padrão do SHA-256.
+ * @param state Estado a ser inicializado.
+ */
+void sha256_init(Sha256State *state);
+
+/**
+ * @brief Aplica a compressão do SHA-256 sobre um bloco de 64 bytes (backend selecionado).
+ * @param state Estado de encadeamento (atualizado no lugar).
+ * @param block Bloco de entrada de SHA256_BLOCK_LEN bytes.
+ */
+void sha256_compress(Sha256State *state, const uint8_t *block);
+
+/**
+ * @brief Compressão SHA-256 em C++ puro (backend portável e fallback do hardware).
+ * @param state Estado de encadeamento (atualizado no lugar).
+ * @param block Bloco de entrada de SHA256_BLOCK_LEN bytes.
+ */
+void sha256_compress_portable(Sha256State *state, const uint8_t *block);
+
+/**
+ * @brief Finaliza um hash cujo prefixo (múltiplo de 64 bytes) já está em 'state',
+ *        processando a cauda curta e o padding em uma única compressão.
+ * @param state Midstate após o prefixo (não é modificado).
+ * @param prefixLength Número de bytes já absorvidos (múltiplo de SHA256_BLOCK_LEN).
+ * @param tail Bytes restantes da mensagem.
+ * @param tailLength Comprimento da cauda; deve ser no máximo 55 bytes.
+ * @param out Buffer de saída de SHA256_DIGEST_LEN bytes.
+ */
+void sha256_finishShort(const Sha256State *state, uint64_t prefixLength, const uint8_t *tail, size_t tailLength, uint8_t *out);
+
+/**
+ * @brief Calcula o SHA-256 de uma mensagem de qualquer tamanho.
+ * @param data Ponteiro para a mensagem.
+ * @param length Comprimento da mensagem em bytes.
+ * @param out Buffer de saída de SHA256_DIGEST_LEN bytes.
+ */
+void sha256_digest(const uint8_t *data, size_t length, uint8_t *out);
@@ -0,0 +1,125 @@
+#include "sha512.h"
+#include <string.h> // Para memcpy, memset
+
+// ============================================================================
+// === FUNÇÕES AUXILIARES ===
+// ============================================================================
+
+static const uint64_t K512[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+static inline uint64_t ror64(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) { p[i] = (uint8_t)v; v >>= 8; }
+}
+
+static void store_digest(const Sha512State *state, uint8_t *out) {
+    for (int i = 0; i < 8; i++) store_be64(out + 8 * i, state->h[i]);
+}
+
+// Padding com campo de comprimento de 128 bits (64 bits altos sempre zero)
+static void write_padding(uint8_t *block, size_t used, uint64_t totalLength) {
+    block[used] = 0x80;
+    memset(block + used + 1, 0, SHA512_BLOCK_LEN - 8 - used - 1);
+    store_be64(block + SHA512_BLOCK_LEN - 8, totalLength * 8);
+}
+
+// ============================================================================
+// === SHA-512 ===
+// ============================================================================
+
+void sha512_init(Sha512State *state) {
+    state->h[0] = 0x6a09e667f3bcc908ULL; state->h[1] = 0xbb67ae8584caa73bULL;
+    state->h[2] = 0x3c6ef372fe94f82bULL; state->h[3] = 0xa54ff53a5f1d36f1ULL;
+    state->h[4] = 0x510e527fade682d1ULL; state->h[5] = 0x9b05688c2b3e6c1fULL;
+    state->h[6] = 0x1f83d9abfb41bd6bULL; state->h[7] = 0x5be0cd19137e2179ULL;
+}
+
+void sha512_compress_portable(Sha512State *state, const uint8_t *block) {
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) w[i] = load_be64(block + 8 * i);
+
+    uint64_t a = state->h[0], b = state->h[1], c = state->h[2], d = state->h[3];
+    uint64_t e = state->h[4], f = state->h[5], g = state->h[6], h = state->h[7];
+    for (int t = 0; t < 80; t++) {
+        uint64_t wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            uint64_t w15 = w[(t + 1) & 15], w2 = w[(t + 14) & 15];
+            uint64_t s0 = ror64(w15, 1) ^ ror64(w15, 8) ^ (w15 >> 7);
+            uint64_t s1 = ror64(w2, 19) ^ ror64(w2, 61) ^ (w2 >> 6);
+            wt = w[t & 15] + s0 + w[(t + 9) & 15] + s1;
+            w[t & 15] = wt;
+        }
+        uint64_t S1 = ror64(e, 14) ^ ror64(e, 18) ^ ror64(e, 41);
+        uint64_t ch = (e & f) ^ (~e & g);
+        uint64_t t1 = h + S1 + ch + K512[t] + wt;
+        uint64_t S0 = ror64(a, 28) ^ ror64(a, 34) ^ ror64(a, 39);
+        uint64_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint64_t t2 = S0 + maj;
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+    }
+    state->h[0] += a; state->h[1] += b; state->h[2] += c; state->h[3] += d;
+    state->h[4] += e; state->h[5] += f; state->h[6] += g; state->h[7] += h;
+}
+
+void sha512_finishShort(const Sha512State *state, uint64_t prefixLength, const uint8_t *tail, size_t tailLength, uint8_t *out) {
+    uint8_t block[SHA512_BLOCK_LEN];
+    memcpy(block, tail, tailLength);
+    write_padding(block, tailLength, prefixLength + tailLength);
+    Sha512State st = *state;
+    sha512_compress(&st, block);
+    store_digest(&st, out);
+}
+
+void sha512_digest(const uint8_t *data, size_t length, uint8_t *out) {
+    Sha512State st;
+    sha512_init(&st);
+    size_t full = length - (length % SHA512_BLOCK_LEN);
+    for (size_t off = 0; off < full; off += SHA512_BLOCK_LEN) sha512_compress(&st, data + off);
+
+    // Cauda + padding: pode ocupar um ou dois blocos
+    uint8_t block[SHA512_BLOCK_LEN];
+    size_t rem = length - full;
+    memcpy(block, data + full, rem);
+    if (rem > SHA512_BLOCK_LEN - 17) {
+        block[rem] = 0x80;
+        memset(block + rem + 1, 0, SHA512_BLOCK_LEN - rem - 1);
+        sha512_compress(&st, block);
+        memset(block, 0, SHA512_BLOCK_LEN - 8);
+        store_be64(block + SHA512_BLOCK_LEN - 8, (uint64_t)length * 8);
+    } else {
+        write_padding(block, rem, length);
+    }
+    sha512_compress(&st, block);
+    store_digest(&st, out);
+}
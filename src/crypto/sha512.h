@@ -0,0 +1,57 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint64_t
+
+// ============================================================================
+// === SHA-512 (SEM HEAP) ===
+// ============================================================================
+// Mesma organização do sha1.h. O comprimento da mensagem é limitado a 2^64 bits
+// (os 64 bits altos do campo de 128 bits do padding são sempre zero).
+
+constexpr size_t SHA512_BLOCK_LEN = 128; // Tamanho do bloco de compressão (bytes)
+constexpr size_t SHA512_DIGEST_LEN = 64; // Tamanho do hash de saída (bytes)
+
+// --- Estado de Encadeamento do SHA-512 (H0..H7) ---
+struct Sha512State {
+  uint64_t h[8];
+};
+
+/**
+ * @brief Inicializa o estado com os valores iniciais padrão do SHA-512.
+ * @param state Estado a ser inicializado.
+ */
+void sha512_init(Sha512State *state);
+
+/**
+ * @brief Aplica a compressão do SHA-512 sobre um bloco de 128 bytes (backend selecionado).
+ * @param state Estado de encadeamento (atualizado no lugar).
+ * @param block Bloco de entrada de SHA512_BLOCK_LEN bytes.
+ */
+void sha512_compress(Sha512State *state, const uint8_t *block);
+
+/**
+ * @brief Compressão SHA-512 em C++ puro.
+ * @param state Estado de encadeamento (atualizado no lugar).
+ * @param block Bloco de entrada de SHA512_BLOCK_LEN bytes.
+ */
+void sha512_compress_portable(Sha512State *state, const uint8_t *block);
+
+/**
+ * @brief Finaliza um hash cujo prefixo (múltiplo de 128 bytes) já está em 'state',
+ *        processando a cauda curta e o padding em uma única compressão.
+ * @param state Midstate após o prefixo (não é modificado).
+ * @param prefixLength Número de bytes já absorvidos (múltiplo de SHA512_BLOCK_LEN).
+ * @param tail Bytes restantes da mensagem.
+ * @param tailLength Comprimento da cauda; deve ser no máximo 111 bytes.
+ * @param out Buffer de saída de SHA512_DIGEST_LEN bytes.
+ */
+void sha512_finishShort(const Sha512State *state, uint64_t prefixLength, const uint8_t *tail, size_t tailLength, uint8_t *out);
+
+/**
+ * @brief Calcula o SHA-512 de uma mensagem de qualquer tamanho.
+ * @param data Ponteiro para a mensagem.
+ * @param length Comprimento da mensagem em bytes.
+ * @param out Buffer de saída de SHA512_DIGEST_LEN bytes.
+ */
+void sha512_digest(const uint8_t *data, size_t length, uint8_t *out);
@@ -0,0 +1,40 @@
+#pragma once // Include guard
+
+// ============================================================================
+// === BACKEND DE HASH (SELEÇÃO EM TEMPO DE COMPILAÇÃO) ===
+// ============================================================================
+// As funções de compressão declaradas em sha1.h, sha256.h e sha512.h
+// (sha*_compress) são fornecidas por exatamente um backend:
+//   - ESP32-S3 com TOTP_SHA_BACKEND_HW definido: motor SHA do hardware (sha_backend_esp32s3.cpp);
+//   - padrão, demais alvos e builds no host: C++ portável (sha_backend_portable.cpp).
+// O motor do S3 é opcional (ambiente lilygo-t-display-s3-sha-hw do platformio.ini,
+// que só acrescenta -DTOTP_SHA_BACKEND_HW) até que test/test_sha_backend e
+// test/test_sha_hw_vs_portable (HMAC do RFC 2202/4231, motor x compressão portável)
+// passem na placa com ele; só então deve virar o padrão. TOTP_SHA_BACKEND_SOFT
+// continua forçando o backend portável.
+// Os chamadores (HMAC, TOTP, regeneração em lote, PBKDF2 do cofre) não mudam.
+
+#if defined(TOTP_SHA_BACKEND_HW) && !defined(TOTP_SHA_BACKEND_SOFT) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define TOTP_SHA_BACKEND_ESP32S3 1
+#else
+#define TOTP_SHA_BACKEND_ESP32S3 0
+#endif
+
+/**
+ * @brief Reserva o backend para uma sequência de compressões (ex: regeneração em lote).
+ *        Chamadas podem ser aninhadas; cada sha_backend_acquire() exige um sha_backend_release().
+ *        Opcional: cada compressão isolada também reserva e libera o backend sozinha.
+ *        No backend portável não faz nada.
+ */
+void sha_backend_acquire();
+
+/**
+ * @brief Libera o backend reservado por sha_backend_acquire().
+ */
+void sha_backend_release();
+
+/**
+ * @brief Nome do backend selecionado na compilação (para logs e benchmarks).
+ * @return String constante, ex: "esp32s3-hw" ou "portable".
+ */
+const char *sha_backend_name();
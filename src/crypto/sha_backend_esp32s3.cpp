@@ -0,0 +1,83 @@
+#include "sha_backend.h"
+#include "sha1.h"
+#include "sha256.h"
+#include "sha512.h"
+
+#if TOTP_SHA_BACKEND_ESP32S3
+
+#include "sha/sha_dma.h" // esp_sha_acquire_hardware, esp_sha_dma, esp_sha_{read,write}_digest_state
+
+// ============================================================================
+// === BACKEND ESP32-S3 (MOTOR SHA DO HARDWARE) ===
+// ============================================================================
+// Cada compressão carrega o midstate nos registradores de digest, processa um
+// bloco com is_first_block = false (continua do estado carregado) e lê o
+// resultado de volta. Assim os midstates HMAC em cache funcionam igual ao
+// backend portável, e o resultado é bit-idêntico.
+// esp_sha_{write,read}_digest_state trocam a imagem do digest em bytes big-endian
+// (como o port mbedtls do IDF a guarda); Sha1State/Sha256State guardam as palavras
+// H na ordem do host. Cada palavra é invertida na ida e na volta.
+// SHA-512 continua em software: o motor guarda o digest de 64 bits em palavras
+// de 32 bits trocadas, e o ganho para um bloco de HMAC não compensa a conversão.
+
+static int hw_acquire_depth = 0; // Reservas aninhadas (apenas a task principal usa o TOTP)
+
+void sha_backend_acquire() {
+    if (hw_acquire_depth++ == 0) {
+        esp_sha_acquire_hardware();
+    }
+}
+
+void sha_backend_release() {
+    if (hw_acquire_depth > 0 && --hw_acquire_depth == 0) {
+        esp_sha_release_hardware();
+    }
+}
+
+const char *sha_backend_name() {
+    return "esp32s3-hw";
+}
+
+// Palavras H (ordem do host) <-> imagem big-endian do digest usada pelo motor
+static void swap_words(const uint32_t *in, uint32_t *out, size_t words) {
+    for (size_t i = 0; i < words; i++) out[i] = __builtin_bswap32(in[i]);
+}
+
+void sha1_compress(Sha1State *state, const uint8_t *block) {
+    uint32_t digest[5];
+    swap_words(state->h, digest, 5);
+    sha_backend_acquire();
+    esp_sha_write_digest_state(SHA1, digest);
+    int ret = esp_sha_dma(SHA1, block, SHA1_BLOCK_LEN, NULL, 0, false);
+    if (ret == 0) {
+        esp_sha_read_digest_state(SHA1, digest);
+        swap_words(digest, state->h, 5);
+    }
+    sha_backend_release();
+    if (ret != 0) {
+        // Falha do DMA (raro): o estado não foi alterado, conclui em software
+        sha1_compress_portable(state, block);
+    }
+}
+
+void sha256_compress(Sha256State *state, const uint8_t *block) {
+    uint32_t digest[8];
+    swap_words(state->h, digest, 8);
+    sha_backend_acquire();
+    esp_sha_write_digest_state(SHA2_256, digest);
+    int ret = esp_sha_dma(SHA2_256, block, SHA256_BLOCK_LEN, NULL, 0, false);
+    if (ret == 0) {
+        esp_sha_read_digest_state(SHA2_256, digest);
+        swap_words(digest, state->h, 8);
+    }
+    sha_backend_release();
+    if (ret != 0) {
+        sha256_compress_portable(state, block);
+    }
+}
+
+void sha512_compress(Sha512State *state, const uint8_t *block) {
+    sha512_compress_portable(state, block);
+}
+
+#endif // TOTP_SHA_BACKEND_ESP32S3
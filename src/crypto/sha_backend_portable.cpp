@@ -0,0 +1,31 @@
+#include "sha_backend.h"
+#include "sha1.h"
+#include "sha256.h"
+#include "sha512.h"
+
+#if !TOTP_SHA_BACKEND_ESP32S3
+
+// ============================================================================
+// === BACKEND PORTÁVEL (HOST E ALVOS SEM ACELERADOR) ===
+// ============================================================================
+
+void sha_backend_acquire() {}
+void sha_backend_release() {}
+
+const char *sha_backend_name() {
+    return "portable";
+}
+
+void sha1_compress(Sha1State *state, const uint8_t *block) {
+    sha1_compress_portable(state, block);
+}
+
+void sha256_compress(Sha256State *state, const uint8_t *block) {
+    sha256_compress_portable(state, block);
+}
+
+void sha512_compress(Sha512State *state, const uint8_t *block) {
+    sha512_compress_portable(state, block);
+}
+
+#endif // !TOTP_SHA_BACKEND_ESP32S3
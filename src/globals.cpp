@@ -15,7 +15,7 @@ RTC_DS3231 rtc;                                   // Objeto RTC (usa Wire padrã
 MFRC522 mfrc522(SDA_PIN, RST_PIN);                // Objeto RFID com pinos definidos em config.h
 OneButton btn_prev(PIN_BUTTON_0, true, true);     // Botão PREV (ativo baixo, pullup interno habilitado)
 OneButton btn_next(PIN_BUTTON_1, true, true);     // Botão NEXT (ativo baixo, pullup interno habilitado)
-Preferences preferences;                          // Objeto NVS
+NvsStore preferences;                             // Objeto NVS (backend em nvs_backend_*.cpp)
 
 // --- Application State ---
 ScreenState current_screen = ScreenState::SCREEN_MENU_MAIN; // Inicia na tela de boot
@@ -23,7 +23,10 @@ ScreenState previous_screen = ScreenState::SCREEN_MENU_MAIN; // Padrão para vol
 TOTPService services[MAX_SERVICES];                // Aloca memória para o array de serviços
 int service_count = 0;                             // Nenhum serviço carregado inicialmente
 int current_service_index = -1;                    // Nenhum serviço selecionado inicialmente
-CurrentTOTPInfo current_totp = { "------", 0, false }; // Inicializa com placeholder, sem intervalo, chave inválida
+CurrentTOTPInfo current_totp = { "------", 0, false, false }; // Inicializa com placeholder, sem intervalo, chave inválida
+CodeTable code_table = {};                         // Sem chaves; códigos inválidos até a primeira geração
+NameArena name_arena = {};                         // Arena vazia (preenchida em loadServices)
+KeyArena key_arena = {};                           // Arena vazia (preenchida em loadServices)
 BatteryInfo battery_info = { 0.0f, false, 0 };     // Estado inicial da bateria
 int gmt_offset_hours = 0;                          // Fuso padrão GMT+0
 Language current_language = Language::PT_BR;      // Idioma padrão (será sobrescrito pelo NVS se existir)
@@ -42,7 +45,9 @@ const int NUM_MENU_OPTIONS = sizeof(menuOptionIDs) / sizeof(menuOptionIDs[0]);
 uint8_t current_brightness_level = 0;              // Brilho inicial (será definido no setup)
 MenuState main_menu_state = { 0, 0, -1, -1, 0, false }; // Estado inicial do menu principal
 MenuState lang_menu_state = { 0, 0, -1, -1, 0, false }; // Estado inicial do menu de idioma
-TempData temp_data = { "", "", 0, 0, 0, 0, 0, Language::PT_BR, "" }; // Dados temporários zerados/padrão
+TempData temp_data = { "", "", OtpAlgorithm::SHA1, TOTP_DEFAULT_DIGITS, TOTP_INTERVAL_SECONDS, OtpKind::TOTP, 0, 0, 0, 0, 0, 0, Language::PT_BR, "" }; // Dados temporários zerados/padrão
+
+bool is_menu_animating = false;                    // Menu parado inicialmente
 
 // --- Timers ---
 uint32_t last_interaction_time = 0;
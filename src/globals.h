@@ -4,7 +4,7 @@
 #include <RTClib.h>       // Para RTC_DS3231
 #include <TFT_eSPI.h>     // Para TFT_eSPI, TFT_eSprite
 #include "OneButton.h"    // Para OneButton
-#include <Preferences.h>  // Para Preferences (NVS)
+#include "nvs_backend.h"  // Para NvsStore (NVS)
 #include <MFRC522.h>      // Para MFRC522
 
 #include "types.h"        // Nossos enums e structs (ScreenState, TOTPService, etc.)
@@ -25,15 +25,18 @@ extern RTC_DS3231 rtc;               // Objeto do Real-Time Clock
 extern MFRC522 mfrc522;             // Objeto do leitor RFID
 extern OneButton btn_prev;           // Botão "Anterior" ou "Esquerda"
 extern OneButton btn_next;           // Botão "Próximo" ou "Direita"
-extern Preferences preferences;     // Objeto para acesso ao NVS
+extern NvsStore preferences;        // Objeto para acesso ao NVS
 
 // --- Application State ---
 extern ScreenState current_screen;        // Tela atualmente ativa
 extern ScreenState previous_screen;       // Tela anterior (para voltar de mensagens/confirmações)
-extern TOTPService services[MAX_SERVICES]; // Array para armazenar os serviços TOTP
-extern int service_count;                 // Número de serviços atualmente carregados
-extern int current_service_index;         // Índice do serviço TOTP sendo exibido/editado (-1 se nenhum)
+extern TOTPService services[MAX_SERVICES]; // Serviços por id estável (ver service_map.h; ids livres ficam zerados)
+extern int service_count;                 // Número de serviços atualmente carregados (ids vivos)
+extern int current_service_index;         // Id do serviço TOTP sendo exibido/editado (-1 se nenhum)
 extern CurrentTOTPInfo current_totp;      // Informações sobre o código TOTP atual (código, validade)
+extern CodeTable code_table;              // Midstates e códigos das chaves residentes (uma geração por intervalo)
+extern NameArena name_arena;              // Nomes de todos os serviços, contíguos
+extern KeyArena key_arena;                // Cache das chaves binárias residentes (KEY_CACHE_SLOTS)
 extern BatteryInfo battery_info;          // Informações sobre a bateria (voltagem, percentual, USB)
 extern int gmt_offset_hours;              // Fuso horário em horas (e.g., -3 para GMT-3)
 extern Language current_language;         // Idioma atualmente selecionado para a UI
@@ -47,7 +50,7 @@ extern uint8_t current_brightness_level; // Nível de brilho atual aplicado (0-d
 extern MenuState main_menu_state;        // Estado do menu principal (índice, scroll, animação)
 extern MenuState lang_menu_state;        // Estado do menu de seleção de idioma
 extern TempData temp_data;               // Dados temporários para adição/edição (serviço, hora, idioma, rfid)
-bool is_menu_animating;                  // Flag para indicar se o menu está animando (scrolling)
+extern bool is_menu_animating;           // Flag para indicar se o menu está animando (scrolling)
 
 // --- Timers ---
 extern uint32_t last_interaction_time;   // Millis() da última interação do usuário (botões, serial)
@@ -0,0 +1,187 @@
+#include "hotp_journal.h"
+#include "globals.h"
+#include "i18n.h"
+#include "totp.h"
+#include "storage.h"
+#include "code_table.h"
+#include "service_map.h"
+#include "crypto/sha_backend.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+// Entrada do journal como gravada no NVS (putBytes de 16 bytes). O serviço é
+// identificado pelo secret_id, único por serviço mesmo com nomes repetidos e nunca
+// entregue a um serviço novo enquanto o journal o citar (hotp_secretIdLimit).
+struct JournalEntry {
+    uint32_t seq;       // Ordem de gravação; a entrada vai para o slot seq % HOTP_JOURNAL_SLOTS
+    uint32_t secret_id; // TOTPService::secret_id do serviço
+    uint64_t counter;   // Novo contador (próximo a usar) após o código gerado
+};
+
+static JournalEntry journal[HOTP_JOURNAL_SLOTS];
+static bool slot_used[HOTP_JOURNAL_SLOTS];
+static int slot_service[HOTP_JOURNAL_SLOTS];        // Id do serviço de cada entrada (-1 se não existe mais)
+static uint64_t folded_counter[MAX_SERVICES];       // Valor do contador no commit mais novo do cofre, por id
+static uint64_t fallback_counter[MAX_SERVICES];     // Valor no commit anterior (o que o boot carrega se o mais novo falhar)
+static uint32_t next_seq = 0;
+static HotpJournalStats journal_stats = {0, 0, 0};
+
+// Serviço HOTP vivo com o secret_id dado; -1 se foi removido
+static int find_hotp_service(uint32_t secret_id) {
+    int slots = svcmap_slots();
+    for (int i = 0; i < slots; i++) {
+        if (svcmap_isLive(i) && services[i].kind == OtpKind::HOTP && services[i].secret_id == secret_id) return i;
+    }
+    return -1;
+}
+
+static void slot_key(int slot, char *key, size_t size) {
+    snprintf(key, size, "hj_%d", slot);
+}
+
+// A entrada ainda é a única cópia persistida do contador do seu serviço, considerando
+// o cofre até 'folded' (folded_counter: só o commit mais novo; fallback_counter: os dois)?
+static bool entry_needed(int slot, const uint64_t *folded) {
+    if (!slot_used[slot] || slot_service[slot] < 0) return false; // Vazia ou serviço removido
+    const JournalEntry &entry = journal[slot];
+    if (folded[slot_service[slot]] >= entry.counter) return false; // Já no registro principal
+    for (int s = 0; s < HOTP_JOURNAL_SLOTS; s++) {
+        if (s != slot && slot_used[s] && journal[s].secret_id == entry.secret_id && journal[s].seq > entry.seq) {
+            return false; // Superada por uma entrada mais nova do mesmo serviço
+        }
+    }
+    return true;
+}
+
+// Grava o cofre (um commit), o que dobra os contadores de todos os serviços de
+// uma vez (storage_writeVault chama hotp_markFolded). Requer o namespace aberto.
+static bool fold_vault() {
+    if (!storage_writeVault()) {
+        Serial.println("[ERROR] HOTP: falha ao dobrar os contadores no cofre");
+        return false;
+    }
+    journal_stats.fold_writes++;
+    return true;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void hotp_recoverJournal() {
+    // Contadores do commit carregado; o outro slot é desconhecido, então nenhuma entrada
+    // conta como gravada nos dois até mais dois commits. Ids ainda livres ficam em 0.
+    memset(folded_counter, 0, sizeof(folded_counter));
+    memset(fallback_counter, 0, sizeof(fallback_counter));
+    int slots = svcmap_slots();
+    for (int i = 0; i < slots; i++) {
+        folded_counter[i] = services[i].counter;
+    }
+    next_seq = 0;
+    int entries = 0, recovered = 0;
+    for (int s = 0; s < HOTP_JOURNAL_SLOTS; s++) {
+        char key[8];
+        slot_key(s, key, sizeof(key));
+        slot_used[s] = preferences.getBytesLength(key) == sizeof(JournalEntry) &&
+                       preferences.getBytes(key, &journal[s], sizeof(JournalEntry)) == sizeof(JournalEntry);
+        slot_service[s] = -1;
+        if (!slot_used[s]) continue;
+        entries++;
+        if (journal[s].seq >= next_seq) next_seq = journal[s].seq + 1;
+        int index = find_hotp_service(journal[s].secret_id); // Serviço removido: entrada ignorada
+        slot_service[s] = index;
+        if (index >= 0 && journal[s].counter > services[index].counter) {
+            services[index].counter = journal[s].counter; // Nunca diminui: fica o maior valor persistido
+            recovered++;
+        }
+    }
+    if (entries > 0) {
+        Serial.printf("[HOTP] Journal: %d entradas, %d contadores adiantados\n", entries, recovered);
+    }
+}
+
+bool hotp_generate(int index, uint32_t *code) {
+    if (!svcmap_isLive(index) || services[index].kind != OtpKind::HOTP ||
+        !codetable_ensureKey(index)) { // Antes de abrir o namespace: pode ler o segredo
+        return false;
+    }
+    if (!preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return false;
+    }
+    uint64_t counter = services[index].counter;
+    int slot = next_seq % HOTP_JOURNAL_SLOTS;
+    // A dobra preguiçosa ficou para trás: só reutiliza a entrada quando os dois commits do
+    // cofre (o mais novo e o de fallback) já têm o contador dela (no máximo duas dobras)
+    if (entry_needed(slot, fallback_counter)) journal_stats.forced_folds++;
+    while (entry_needed(slot, fallback_counter)) {
+        if (!fold_vault()) {
+            preferences.end();
+            return false;
+        }
+    }
+    JournalEntry entry = {next_seq, services[index].secret_id, counter + 1};
+    char key[8];
+    slot_key(slot, key, sizeof(key));
+    bool ok = preferences.putBytes(key, &entry, sizeof(entry)) == sizeof(entry);
+    preferences.end();
+    if (!ok) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return false; // Sem o contador persistido, nenhum código é mostrado
+    }
+    journal[slot] = entry;
+    slot_used[slot] = true;
+    slot_service[slot] = index;
+    next_seq++;
+    journal_stats.journal_writes++;
+
+    services[index].counter = counter + 1;
+    sha_backend_acquire();
+    *code = generateOTPFromState(codetable_keyState(index), counter); // Residente desde o ensureKey acima
+    sha_backend_release();
+    return true;
+}
+
+void hotp_tick() {
+    int needed = 0;
+    for (int s = 0; s < HOTP_JOURNAL_SLOTS; s++) {
+        if (entry_needed(s, folded_counter)) needed++;
+    }
+    if (needed * 2 < HOTP_JOURNAL_SLOTS) return; // Ainda há folga no anel
+    if (!preferences.begin("totp-app", false)) return;
+    fold_vault(); // Uma gravação; cobre todas as entradas do journal
+    preferences.end();
+}
+
+void hotp_markFolded() {
+    // Nada é apagado: o commit anterior continua sendo o fallback do boot (A/B), e as
+    // entradas que só ele não tem ainda são necessárias se o novo não puder ser lido
+    int slots = svcmap_slots();
+    for (int i = 0; i < slots; i++) {
+        fallback_counter[i] = folded_counter[i];
+        folded_counter[i] = services[i].counter;
+    }
+}
+
+void hotp_removeService(int index) {
+    if (index < 0 || index >= MAX_SERVICES) return;
+    folded_counter[index] = 0;
+    fallback_counter[index] = 0;
+    for (int s = 0; s < HOTP_JOURNAL_SLOTS; s++) {
+        if (slot_service[s] == index) slot_service[s] = -1; // Entradas dos outros ids continuam válidas
+    }
+}
+
+uint32_t hotp_secretIdLimit() {
+    uint32_t limit = 0;
+    for (int s = 0; s < HOTP_JOURNAL_SLOTS; s++) {
+        if (slot_used[s] && journal[s].secret_id >= limit) limit = journal[s].secret_id + 1;
+    }
+    return limit;
+}
+
+const HotpJournalStats &hotp_getStats() {
+    return journal_stats;
+}
@@ -0,0 +1,73 @@
+#pragma once // Include guard
+
+#include <stdint.h> // Para uint32_t
+#include "types.h"  // Para HotpJournalStats
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DO JOURNAL DE CONTADORES HOTP ===
+// ============================================================================
+// O registro principal do contador de cada serviço HOTP fica no cofre
+// (storage_writeVault, junto com a lista). Cada código gerado grava só uma
+// entrada pequena (16 bytes) num anel de HOTP_JOURNAL_SLOTS chaves "hj_%d":
+// {sequência, secret_id do serviço, novo contador}. O journal é dobrado regravando o
+// cofre, no máximo uma vez por atualização regular e só quando metade do anel
+// ainda não está no commit mais novo. Entradas nunca são apagadas, só sobrescritas
+// pelo anel, e só depois que os dois commits do cofre (o mais novo e o anterior,
+// que o boot carrega se o mais novo estiver corrompido) têm o contador delas; se
+// não, o anel faz antes uma dobra síncrona.
+//
+// Recuperação: no boot o contador é o maior entre o cofre e as
+// entradas do journal do serviço. Como a entrada é gravada antes de o código
+// aparecer e toda gravação só aumenta o contador, uma queda de energia em
+// qualquer ponto nunca faz o contador voltar atrás (no máximo pula um código).
+// Entradas de um serviço removido não têm mais dono e são ignoradas; como o
+// secret_id delas não é reutilizado enquanto estiverem no anel, nunca passam
+// para um serviço novo, nem com o mesmo nome.
+
+/**
+ * @brief Lê o journal e aplica as entradas aos contadores já carregados em 'services'.
+ *        Chamar em loadServices(), com o namespace do NVS já aberto e depois de
+ *        preencher services[i].counter com os valores do cofre.
+ */
+void hotp_recoverJournal();
+
+/**
+ * @brief Gera o código HOTP do contador atual e avança o contador (uma gravação no NVS).
+ *        O código só é devolvido depois que o novo contador foi persistido.
+ * @param index Índice de um serviço HOTP com chave válida.
+ * @param code Saída: código numérico com os dígitos do serviço.
+ * @return true se o contador foi persistido e o código gerado.
+ */
+bool hotp_generate(int index, uint32_t *code);
+
+/**
+ * @brief Dobra preguiçosa: se ao menos metade do anel ainda é necessária, regrava o
+ *        cofre com todos os contadores (no máximo uma gravação por chamada).
+ *        Chamar na atualização regular (500 ms).
+ */
+void hotp_tick();
+
+/**
+ * @brief Registra um commit do cofre: os contadores atuais estão no commit mais novo e
+ *        o anterior passa a ser o de fallback. Não apaga entradas do journal.
+ *        Chamado por storage_writeVault() depois da virada do commit.
+ */
+void hotp_markFolded();
+
+/**
+ * @brief Esquece o estado do id removido (espelha storage_deleteService); as entradas
+ *        do journal dele deixam de ser necessárias.
+ * @param index Id removido de 'services'.
+ */
+void hotp_removeService(int index);
+
+/**
+ * @brief Menor secret_id acima de todos os citados pelo journal (0 se vazio). O próximo
+ *        secret_id entregue a um serviço novo não pode ficar abaixo dele.
+ */
+uint32_t hotp_secretIdLimit();
+
+/**
+ * @brief Gravações feitas no NVS pelo journal (entradas, dobras e dobras síncronas).
+ */
+const HotpJournalStats &hotp_getStats();
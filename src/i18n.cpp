@@ -52,6 +52,7 @@ const char json_pt_br[] PROGMEM = R"({
   "CONFIRM_DELETE_PROMPT": "Deletar servico:",
   "SERVICE_ADDED": "Servico Adicionado!",
   "SERVICE_DELETED": "Servico Deletado",
+  "SERVICES_IMPORTED_FMT": "Importados: %lu\nRejeitados: %lu",
   "TIME_ADJUSTED_FMT": "Hora Ajustada:\n%02d:%02d:%02d",
   "TIMEZONE_SAVED_FMT": "Fuso Salvo:\nGMT %+d",
   "LANG_SAVED": "Idioma Salvo!",
@@ -70,6 +71,7 @@ const char json_pt_br[] PROGMEM = R"({
   "ERROR_NVS_SAVE": "[NVS] Erro ao salvar",
   "ERROR_B32_DECODE": "Falha chave B32!",
   "ERROR_MAX_SERVICES": "Max Servicos!",
+  "ERROR_NAME_SPACE": "Sem espaco p/ nomes!",
   "ERROR_TOTP_GENERATION": "Erro Geracao TOTP",
   "ERROR_RFID_READ": "Erro Leitura RFID",
   "STATUS_CONNECTING_RTC": "Conectando RTC...",
@@ -120,6 +122,7 @@ const char json_en_us[] PROGMEM = R"({
   "CONFIRM_DELETE_PROMPT": "Delete service:",
   "SERVICE_ADDED": "Service Added!",
   "SERVICE_DELETED": "Service Deleted",
+  "SERVICES_IMPORTED_FMT": "Imported: %lu\nRejected: %lu",
   "TIME_ADJUSTED_FMT": "Time Adjusted:\n%02d:%02d:%02d",
   "TIMEZONE_SAVED_FMT": "Zone Saved:\nGMT %+d",
   "LANG_SAVED": "Language Saved!",
@@ -138,6 +141,7 @@ const char json_en_us[] PROGMEM = R"({
   "ERROR_NVS_SAVE": "[NVS] Save error",
   "ERROR_B32_DECODE": "B32 Key Error!",
   "ERROR_MAX_SERVICES": "Max Services!",
+  "ERROR_NAME_SPACE": "No room for names!",
   "ERROR_TOTP_GENERATION": "TOTP Gen Error",
   "ERROR_RFID_READ": "RFID Read Error",
   "STATUS_CONNECTING_RTC": "Connecting RTC...",
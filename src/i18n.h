@@ -10,7 +10,7 @@
 /**
  * @brief Inicializa o sistema i18n carregando e parseando o JSON
  *        do idioma especificado da PROGMEM para a RAM.
- *        Deve ser chamado no setup() após loadSettings() ter definido o idioma inicial
+ *        Deve ser chamado no setup() após settings_load() ter definido o idioma inicial
  *        e sempre que o idioma for alterado.
  * @param lang O idioma a ser carregado.
  * @return true se o JSON foi parseado com sucesso, false caso contrário.
@@ -4,8 +4,14 @@
 #include "types.h"
 #include "ui.h"
 #include "totp.h"
+#include "base32.h"
+#include "verifier.h"
 #include "i18n.h"
 #include "hardware.h"
+#include "settings.h"
+#include "service_map.h"
+#include "service_import.h"
+#include "code_table.h"
 
 
 // ---- Callbacks dos Botões ----
@@ -16,8 +22,10 @@ void btn_prev_click() {
     switch (current_screen) {
         case SCREEN_TOTP_VIEW:
             if (service_count > 0) {
-                current_service_index = (current_service_index - 1 + service_count) % service_count; // Volta para serviço anterior
-                if (!decodeCurrentServiceKey()) { 
+                current_service_index = svcmap_isLive(current_service_index)
+                                            ? svcmap_step(current_service_index, -1) // Volta para serviço anterior na ordem
+                                            : svcmap_at(0);
+                if (!selectCurrentService(false)) { // Sem busca do segredo no botão
                     // Decodificação falhou, exibe mensagem de erro
                     ui_showTemporaryMessage(getText(StringID::STR_ERROR_B32_DECODE), COLOR_ERROR);
                 }
@@ -77,6 +85,19 @@ void btn_prev_click() {
     if (needs_full_redraw) ui_drawScreen(true);
 }
 
+void btn_prev_long_press_start() {
+    last_interaction_time = millis();
+    // Serviço HOTP na tela de códigos: gera o próximo código (avança e persiste o contador)
+    if (current_screen == SCREEN_TOTP_VIEW && svcmap_isLive(current_service_index) &&
+        services[current_service_index].kind == OtpKind::HOTP) {
+        if (!advanceCurrentHOTP()) {
+            ui_showTemporaryMessage(getText(STR_ERROR_NVS_SAVE), COLOR_ERROR);
+            return;
+        }
+        ui_drawScreen(false); // Só o sprite do código muda
+    }
+}
+
 void btn_next_click() {
     last_interaction_time = millis();
     bool needs_full_redraw = false;
@@ -84,8 +105,10 @@ void btn_next_click() {
     switch (current_screen) {
         case SCREEN_TOTP_VIEW:
             if (service_count > 0) {
-                current_service_index = (current_service_index + 1) % service_count; // Avança para próximo serviço
-                if (!decodeCurrentServiceKey()) { 
+                current_service_index = svcmap_isLive(current_service_index)
+                                            ? svcmap_step(current_service_index, 1) // Avança para próximo serviço na ordem
+                                            : svcmap_at(0);
+                if (!selectCurrentService(false)) { // Sem busca do segredo no botão
                     // Decodificação falhou, exibe mensagem de erro
                     ui_showTemporaryMessage(getText(StringID::STR_ERROR_B32_DECODE), COLOR_ERROR);
                 }
@@ -141,9 +164,11 @@ void btn_next_click() {
             }
             break;
         case SCREEN_SERVICE_ADD_CONFIRM: // Confirma adição
-             if(storage_saveService(temp_service_name, temp_service_secret)){
-                 current_service_index = service_count - 1; // Seleciona o recém-adicionado
-                 decodeCurrentServiceKey(); // Decodifica chave
+             if(storage_saveService(temp_service_name, temp_service_secret,
+                                    temp_data.service_algorithm, temp_data.service_digits, temp_data.service_period,
+                                    temp_data.service_kind, temp_data.service_counter)){
+                 current_service_index = svcmap_at(service_count - 1); // Seleciona o recém-adicionado (fim da ordem)
+                 selectCurrentService(); // Consulta a tabela de códigos
                  ui_showTemporaryMessage(getText(STR_SERVICE_ADDED), COLOR_SUCCESS); // Mostra sucesso
                  // A mensagem chamará changeScreen(SCREEN_MENU_MAIN), precisamos ir para TOTP
                  // TODO: Melhorar lógica pós-mensagem para ir para tela correta
@@ -201,9 +226,7 @@ void btn_next_long_press_start() {
             }
             break;
         case SCREEN_TIMEZONE_EDIT: // Salva fuso horário
-            preferences.begin("totp-app", false); // Abre NVS para escrita
-            preferences.putInt(NVS_KEY_TZ_OFFSET, gmt_offset_hours);
-            preferences.end();
+            settings_setTimezone(gmt_offset_hours); // Gravado no NVS por settings_tick() após alguns segundos sem mudanças
             Serial.printf("[NVS] Fuso salvo: GMT%+d\n", gmt_offset_hours);
             snprintf(message_buffer, sizeof(message_buffer), getText(STR_TIMEZONE_SAVED_FMT), gmt_offset_hours);
             ui_showTemporaryMessage(message_buffer, COLOR_SUCCESS);
@@ -212,11 +235,8 @@ void btn_next_long_press_start() {
         case SCREEN_LANGUAGE_SELECT: // Salva idioma selecionado
              change_screen_handled = true; // Sempre lida com a tela
              if (current_language_menu_index != current_language) { // Se mudou
-                 current_language = (Language)current_language_menu_index;
+                 settings_setLanguage((Language)current_language_menu_index); // Atualiza current_language; gravação adiada
                  //current_strings = languages[current_language]; // Atualiza ponteiro global
-                 preferences.begin("totp-app", false);
-                 preferences.putInt(NVS_KEY_LANGUAGE, (int)current_language);
-                 preferences.end();
                  Serial.printf("[LANG] Idioma salvo: %d\n", current_language);
                  // Mostra msg de sucesso e força redraw completo da tela anterior (menu)
                  // A função de mensagem chamará changeScreen(SCREEN_MENU_MAIN)
@@ -234,9 +254,130 @@ void btn_next_long_press_start() {
 
 
 // ---- Funções de Entrada Serial ----
+
+// Modo verificador: {"verify":"<serviço>","code":"123456","window":2}. Aceito em qualquer tela;
+// responde uma linha JSON na Serial (para automação de bancada), sem mexer na UI.
+static void processCodeVerify(JsonDocument &doc) {
+    const char* name = doc[JSON_KEY_VERIFY_SERVICE] | "";
+    const char* code = doc[JSON_KEY_VERIFY_CODE] | "";
+    int window = doc[JSON_KEY_VERIFY_WINDOW] | (int)VERIFY_DEFAULT_WINDOW;
+    if(window < 0) window = 0;
+    if(window > VERIFY_MAX_WINDOW) window = VERIFY_MAX_WINDOW;
+
+    int offset = 0;
+    uint32_t start_us = micros();
+    VerifyResult result = verifier_check(name, code, (uint8_t)window, now(), &offset);
+    uint32_t elapsed_us = micros() - start_us;
+
+    // Resposta serializada pelo ArduinoJson: o nome vem do host e pode ter aspas, '\\' ou controles
+    StaticJsonDocument<192> reply;
+    reply[JSON_KEY_VERIFY_SERVICE] = name;
+    reply["result"] = verifier_resultName(result);
+    if(result == VerifyResult::ACCEPTED || result == VerifyResult::REPLAYED){
+        reply["offset"] = offset;
+    }
+    reply["us"] = (unsigned long)elapsed_us;
+    serializeJson(reply, Serial);
+    Serial.println();
+}
+
+// Consulta de métricas: {"stats":"rollover"}. Aceita em qualquer tela; responde uma linha JSON
+// na Serial, sem mexer na UI (a virada em si não escreve nada no canal das ferramentas).
+static void processStatsQuery(JsonDocument &doc) {
+    const char* which = doc[JSON_KEY_STATS] | "";
+    if(strcmp(which, "rollover") != 0){
+        Serial.println("{\"stats\":\"unknown\"}");
+        return;
+    }
+    const RolloverStats &stats = codetable_getRolloverStats();
+    Serial.printf("{\"stats\":\"rollover\",\"samples\":%lu,\"last_us\":%lu,\"max_us\":%lu,"
+                  "\"over_frame\":%lu,\"lookahead_hits\":%lu,\"lookahead_misses\":%lu}\n",
+                  (unsigned long)stats.samples, (unsigned long)stats.last_latency_us,
+                  (unsigned long)stats.max_latency_us, (unsigned long)stats.over_frame,
+                  (unsigned long)stats.lookahead_hits, (unsigned long)stats.lookahead_misses);
+}
+
+// Importação em lote: um array JSON de serviços ([{"name":..,"secret":..}, ...]) enviado na tela de
+// adição. Os bytes são consumidos conforme chegam, sem esperar o fim da linha nem guardar o documento;
+// o lote é gravado de uma vez no ']' final, sem confirmação por botão. Responde uma linha JSON na Serial.
+static void processServiceImport() {
+    Serial.println("[SERIAL] RX: importação em lote");
+    import_begin();
+    ImportStatus status = ImportStatus::RUNNING;
+    uint32_t last_byte_ms = millis();
+    char chunk[64];
+    while (status == ImportStatus::RUNNING) {
+        size_t available = Serial.available();
+        if (available == 0) {
+            if (millis() - last_byte_ms > IMPORT_IDLE_TIMEOUT_MS) { // Envio interrompido: nada é gravado
+                import_cancel();
+                status = ImportStatus::FAILED;
+            } else {
+                delay(1);
+            }
+            continue;
+        }
+        size_t length = Serial.readBytes(chunk, available < sizeof(chunk) ? available : sizeof(chunk));
+        status = import_feed(chunk, length); // Bytes depois do ']' final no mesmo bloco são descartados
+        last_byte_ms = millis();
+    }
+    last_interaction_time = millis();
+
+    const ImportStats &stats = import_getStats();
+    Serial.printf("{\"import\":\"%s\",\"imported\":%lu,\"rejected\":%lu,\"full\":%lu,\"names_full\":%lu,"
+                  "\"bytes\":%lu,\"us\":%lu}\n",
+                  status == ImportStatus::DONE ? "ok" : "error", (unsigned long)stats.imported,
+                  (unsigned long)stats.rejected, (unsigned long)stats.over_capacity,
+                  (unsigned long)stats.over_name_space, (unsigned long)stats.bytes,
+                  (unsigned long)(stats.parse_us + stats.commit_us));
+    if (status != ImportStatus::DONE) {
+        ui_showTemporaryMessage(getText(STR_ERROR_JSON_INVALID_SERVICE), COLOR_ERROR);
+        changeScreen(SCREEN_MENU_MAIN);
+        return;
+    }
+    if (stats.imported > 0) {
+        current_service_index = svcmap_at(service_count - (int)stats.imported); // Primeiro importado
+        selectCurrentService();
+    }
+    snprintf(message_buffer, sizeof(message_buffer), getText(STR_SERVICES_IMPORTED_FMT), (unsigned long)stats.imported,
+             (unsigned long)(stats.rejected + stats.over_capacity + stats.over_name_space));
+    ui_showTemporaryMessage(message_buffer, stats.imported > 0 ? COLOR_SUCCESS : COLOR_ERROR);
+}
+
+// Linha da Serial sendo recebida: os bytes entram conforme chegam e só a linha completa
+// ('\n') é processada, sem esperar pelo resto dentro do loop
+static char serial_line[SERIAL_LINE_MAX + 1];
+static size_t serial_line_len = 0;
+static bool serial_line_overflow = false; // Linha maior que o buffer: descartada inteira no '\n'
+
+// Acumula os bytes disponíveis; true quando 'serial_line' tem uma linha completa
+static bool serial_readLine() {
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c == '\n') {
+            serial_line[serial_line_len] = '\0';
+            bool complete = !serial_line_overflow;
+            if (serial_line_overflow) Serial.printf("[SERIAL] Linha com mais de %u bytes descartada\n", (unsigned)SERIAL_LINE_MAX);
+            serial_line_len = 0;
+            serial_line_overflow = false;
+            return complete;
+        }
+        if (serial_line_len < SERIAL_LINE_MAX) serial_line[serial_line_len++] = c;
+        else serial_line_overflow = true;
+    }
+    return false;
+}
+
 void processSerialInput() {
-    if (Serial.available() > 0) {
-        String input = Serial.readStringUntil('\n');
+    if (current_screen == SCREEN_SERVICE_ADD_WAIT && serial_line_len == 0 && !serial_line_overflow) {
+        while (Serial.available() > 0 && isspace(Serial.peek())) Serial.read(); // Quebras de linha antes do documento
+        if (Serial.available() > 0 && Serial.peek() == '[') {
+            processServiceImport();
+            return;
+        }
+    }
+    if (serial_readLine()) {
+        String input(serial_line);
         input.trim();
         if (input.length() == 0) return; // Ignora linhas vazias
 
@@ -244,17 +385,29 @@ void processSerialInput() {
         last_interaction_time = millis(); // Considera entrada serial como interação
 
         // Tenta parsear o JSON
-        StaticJsonDocument<256> doc; // Ajustar tamanho se necessário
+        StaticJsonDocument<384> doc; // Comporta segredo de 104 chars + parâmetros OTP opcionais
         DeserializationError error = deserializeJson(doc, input);
 
+        bool input_screen = current_screen == SCREEN_SERVICE_ADD_WAIT || current_screen == SCREEN_TIME_EDIT;
         if (error) {
+            if (!input_screen) { // Fora das telas de entrada: só o log, sem mexer na UI
+                Serial.printf("[SERIAL] JSON inválido: %s\n", error.c_str());
+                return;
+            }
             // Mostra erro de parsing
             snprintf(message_buffer, sizeof(message_buffer), getText(STR_ERROR_JSON_PARSE_FMT), error.c_str());
             ui_showTemporaryMessage(message_buffer, COLOR_ERROR);
             // Volta ao menu em caso de erro nas telas de entrada
-            if (current_screen == SCREEN_SERVICE_ADD_WAIT || current_screen == SCREEN_TIME_EDIT) {
-                changeScreen(SCREEN_MENU_MAIN);
-            }
+            changeScreen(SCREEN_MENU_MAIN);
+            return;
+        }
+
+        if (doc.containsKey(JSON_KEY_VERIFY_SERVICE)) {
+            processCodeVerify(doc);
+            return;
+        }
+        if (doc.containsKey(JSON_KEY_STATS)) {
+            processStatsQuery(doc);
             return;
         }
 
@@ -286,11 +439,54 @@ void processServiceAdd(JsonDocument &doc) {
         changeScreen(SCREEN_MENU_MAIN); return;
     }
 
-    // TODO: Adicionar validação dos caracteres do segredo Base32 se desejado
+    // Parâmetros OTP opcionais (padrão SHA1 / 6 dígitos / 30 s, como no Google Authenticator)
+    OtpAlgorithm algorithm = OtpAlgorithm::SHA1;
+    if(doc.containsKey(JSON_KEY_SERVICE_ALGORITHM)){
+        const char* algo = doc[JSON_KEY_SERVICE_ALGORITHM] | "";
+        if(strcasecmp(algo, "SHA1") == 0) algorithm = OtpAlgorithm::SHA1;
+        else if(strcasecmp(algo, "SHA256") == 0) algorithm = OtpAlgorithm::SHA256;
+        else if(strcasecmp(algo, "SHA512") == 0) algorithm = OtpAlgorithm::SHA512;
+        else {
+            ui_showTemporaryMessage(getText(STR_ERROR_JSON_INVALID_SERVICE), COLOR_ERROR);
+            changeScreen(SCREEN_MENU_MAIN); return;
+        }
+    }
+    OtpKind kind = OtpKind::TOTP;
+    if(doc.containsKey(JSON_KEY_SERVICE_TYPE)){
+        const char* type = doc[JSON_KEY_SERVICE_TYPE] | "";
+        if(strcasecmp(type, "totp") == 0) kind = OtpKind::TOTP;
+        else if(strcasecmp(type, "hotp") == 0) kind = OtpKind::HOTP;
+        else {
+            ui_showTemporaryMessage(getText(STR_ERROR_JSON_INVALID_SERVICE), COLOR_ERROR);
+            changeScreen(SCREEN_MENU_MAIN); return;
+        }
+    }
+    uint64_t counter = doc[JSON_KEY_SERVICE_COUNTER] | (uint64_t)0;
+    int digits = doc[JSON_KEY_SERVICE_DIGITS] | (int)TOTP_DEFAULT_DIGITS;
+    int period = doc[JSON_KEY_SERVICE_PERIOD] | (int)TOTP_INTERVAL_SECONDS;
+    if((digits != 6 && digits != 8) || period <= 0 || period > (int)TOTP_MAX_PERIOD_SECONDS){
+        ui_showTemporaryMessage(getText(STR_ERROR_JSON_INVALID_SERVICE), COLOR_ERROR);
+        changeScreen(SCREEN_MENU_MAIN); return;
+    }
+
+    // Valida o Base32 antes da confirmação (caracteres, comprimento e tamanho da chave)
+    uint8_t key_check[MAX_SECRET_BIN_LEN];
+    int key_len = base32_decode((const uint8_t *)secret, strlen(secret), key_check, sizeof(key_check));
+    memset(key_check, 0, sizeof(key_check));
+    if(key_len <= 0){
+        Serial.printf("[ERROR] Segredo Base32 rejeitado (código %d)\n", key_len);
+        ui_showTemporaryMessage(getText(STR_ERROR_SECRET_INVALID), COLOR_ERROR);
+        changeScreen(SCREEN_MENU_MAIN); return;
+    }
 
     // Copia dados válidos para variáveis temporárias e vai para confirmação
     strncpy(temp_service_name, name, sizeof(temp_service_name) - 1); temp_service_name[sizeof(temp_service_name) - 1] = '\0';
     strncpy(temp_service_secret, secret, sizeof(temp_service_secret) - 1); temp_service_secret[sizeof(temp_service_secret) - 1] = '\0';
+    temp_data.service_algorithm = algorithm;
+    temp_data.service_digits = (uint8_t)digits;
+    temp_data.service_period = (uint16_t)period;
+    temp_data.service_kind = kind;
+    temp_data.service_counter = counter;
     changeScreen(SCREEN_SERVICE_ADD_CONFIRM);
 }
 
@@ -324,6 +520,7 @@ void processTimeSet(JsonDocument &doc) {
 
 void configureButtonCallbacks(){
     btn_prev.attachClick(btn_prev_click);
+    btn_prev.attachLongPressStart(btn_prev_long_press_start);
     btn_next.attachClick(btn_next_click);
     btn_next.attachDoubleClick(btn_next_double_click);
     btn_next.attachLongPressStart(btn_next_long_press_start);
@@ -18,8 +18,11 @@ void attachButtons();
 void input_tick();
 
 /**
- * @brief Verifica se há dados na Serial, lê uma linha JSON, faz o parse
- *        e chama as funções apropriadas para processar os dados (adição de serviço ou ajuste de hora).
+ * @brief Junta os bytes disponíveis na Serial (sem bloquear) e, quando uma linha JSON
+ *        termina ('\n'), faz o parse e chama as funções apropriadas para processar os dados
+ *        (adição de serviço, ajuste de hora, verificação ou consulta de métricas).
+ *        Linhas maiores que SERIAL_LINE_MAX são descartadas.
+ *        Na tela de adição, um array JSON de serviços é importado em lote, em fluxo (service_import.h).
  *        Normalmente chamado por input_tick(), mas pode ser chamado diretamente se necessário.
  */
 void processSerialInput();
@@ -0,0 +1,96 @@
+#include <string.h>
+#include "key_store.h"
+#include "globals.h"
+#include "base32.h"
+
+// ============================================================================
+// === ARENA DE CHAVES ===
+// ============================================================================
+
+// Libera os bytes da chave do slot e fecha o buraco na arena.
+// Os offsets não seguem a ordem dos slots (chaves entram conforme são buscadas).
+static void release_bytes(int slot) {
+    uint8_t len = key_arena.length[slot];
+    if (len == 0) return;
+    uint16_t start = key_arena.offset[slot];
+    memmove(&key_arena.data[start], &key_arena.data[start + len], key_arena.used - start - len);
+    key_arena.used -= len;
+    memset(&key_arena.data[key_arena.used], 0, len); // Não deixa a chave na cauda liberada
+    for (int s = 0; s < KEY_CACHE_SLOTS; s++) {
+        if (key_arena.length[s] > 0 && key_arena.offset[s] > start) key_arena.offset[s] -= len;
+    }
+    key_arena.offset[slot] = 0;
+    key_arena.length[slot] = 0;
+    key_arena.id[slot] = -1;
+}
+
+static int free_slot() {
+    for (int s = 0; s < KEY_CACHE_SLOTS; s++) {
+        if (key_arena.length[s] == 0) return s;
+    }
+    return -1;
+}
+
+void keystore_clear() {
+    memset(&key_arena, 0, sizeof(key_arena)); // Não deixa chaves antigas na RAM
+    memset(key_arena.id, -1, sizeof(key_arena.id));
+}
+
+size_t keystore_decode(int index, const char *secret_b32) {
+    if (!secret_b32) return 0;
+    // Caractere inválido ou mais que MAX_SECRET_BIN_LEN bytes: código de erro negativo
+    uint8_t key_bin[MAX_SECRET_BIN_LEN];
+    int decoded_len = base32_decode((const uint8_t *)secret_b32, strlen(secret_b32), key_bin, sizeof(key_bin));
+    size_t ok_len = decoded_len > 0 && keystore_set(index, key_bin, decoded_len) ? decoded_len : 0;
+    memset(key_bin, 0, sizeof(key_bin)); // Cópia temporária sai da pilha
+    return ok_len;
+}
+
+bool keystore_set(int index, const uint8_t *key, size_t length) {
+    if (index < 0 || index >= MAX_SERVICES || !key || length == 0 || length > MAX_SECRET_BIN_LEN) {
+        return false;
+    }
+    int slot = keystore_slot(index);
+    if (slot < 0) slot = free_slot();
+    if (slot < 0) return false; // Cache cheio: quem chama libera um slot antes
+    release_bytes(slot);
+    key_arena.offset[slot] = key_arena.used; // Cabe sempre: no máximo KEY_CACHE_SLOTS chaves de MAX_SECRET_BIN_LEN
+    key_arena.length[slot] = (uint8_t)length;
+    key_arena.id[slot] = (int16_t)index;
+    memcpy(&key_arena.data[key_arena.used], key, length);
+    key_arena.used += length;
+    return true;
+}
+
+int keystore_slot(int index) {
+    if (index < 0 || index >= MAX_SERVICES) return -1;
+    for (int s = 0; s < KEY_CACHE_SLOTS; s++) {
+        if (key_arena.length[s] > 0 && key_arena.id[s] == index) return s;
+    }
+    return -1;
+}
+
+bool keystore_hasFreeSlot() {
+    return free_slot() >= 0;
+}
+
+bool keystore_get(int index, const uint8_t **key, size_t *length) {
+    int slot = keystore_slot(index);
+    if (slot < 0) return false;
+    *key = &key_arena.data[key_arena.offset[slot]];
+    *length = key_arena.length[slot];
+    return true;
+}
+
+void keystore_evict(int index) {
+    int slot = keystore_slot(index);
+    if (slot >= 0) release_bytes(slot);
+}
+
+size_t keystore_encodeBase32(int index, char *out, size_t outSize) {
+    const uint8_t *key;
+    size_t len;
+    if (!keystore_get(index, &key, &len)) return 0;
+    int written = base32_encode(key, len, out, outSize);
+    return written > 0 ? (size_t)written : 0;
+}
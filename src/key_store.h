@@ -0,0 +1,77 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t
+#include "types.h"  // Para KeyArena
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DA ARENA DE CHAVES BINÁRIAS ===
+// ============================================================================
+// Cache das chaves binárias residentes: KEY_CACHE_SLOTS slots, cada um com o id de
+// 'services' dono da chave (um id fora do cache, ou removido, não tem chave na RAM).
+// Um segredo Base32 é decodificado uma única vez, ao adicionar o serviço; as demais
+// chaves vêm já binárias da partição, só quando um código é pedido (storage_fetchSecret),
+// e saem da RAM quando a tabela de códigos precisa do slot (codetable_reserveSlot).
+// As chaves ficam contíguas e sem padding; a ordem na arena é a ordem em que foram
+// carregadas. Os slots são os mesmos da tabela de códigos (midstates, códigos e linha
+// do tempo): keystore_slot() é o único caminho de um id até eles.
+
+/**
+ * @brief Esvazia a arena e apaga os bytes das chaves. Chamar antes de recarregar os serviços.
+ */
+void keystore_clear();
+
+/**
+ * @brief Decodifica um segredo Base32 e o torna a chave residente do id dado.
+ * @param index Id do serviço (ver service_map.h).
+ * @param secret_b32 Segredo Base32 terminado em '\0'.
+ * @return Comprimento da chave em bytes, ou 0 se o segredo for inválido (caractere fora do
+ *         alfabeto, comprimento impossível), longo demais (mais que MAX_SECRET_BIN_LEN)
+ *         ou se não houver slot livre.
+ */
+size_t keystore_decode(int index, const char *secret_b32);
+
+/**
+ * @brief Torna residente a chave binária do id dado, substituindo a anterior (mesmo slot)
+ *        ou ocupando um slot livre. Não tira outra chave da RAM.
+ * @param index Id do serviço (0 <= index < MAX_SERVICES).
+ * @param key Bytes da chave.
+ * @param length Comprimento em bytes (1 a MAX_SECRET_BIN_LEN).
+ * @return true se a chave ficou residente; false se todos os slots estão ocupados.
+ */
+bool keystore_set(int index, const uint8_t *key, size_t length);
+
+/**
+ * @brief Tira a chave do id da RAM (bytes apagados). Também ao remover o serviço.
+ * @param index Id do serviço.
+ */
+void keystore_evict(int index);
+
+/**
+ * @brief Slot do cache que guarda a chave do id (busca em KEY_CACHE_SLOTS entradas).
+ * @return Slot (0 a KEY_CACHE_SLOTS - 1), ou -1 se a chave não está residente.
+ */
+int keystore_slot(int index);
+
+/**
+ * @brief Há slot livre para mais uma chave?
+ */
+bool keystore_hasFreeSlot();
+
+/**
+ * @brief Consulta da chave binária de um serviço (via keystore_slot).
+ * @param index Índice do serviço.
+ * @param key Saída: ponteiro para os bytes dentro da arena (válido até a próxima liberação).
+ * @param length Saída: comprimento em bytes.
+ * @return true se a chave do id está residente.
+ */
+bool keystore_get(int index, const uint8_t **key, size_t *length);
+
+/**
+ * @brief Codifica a chave de um serviço em Base32 (RFC 4648, sem padding) para persistência.
+ * @param index Índice do serviço.
+ * @param out Buffer de saída (terminado em '\0').
+ * @param outSize Tamanho do buffer; MAX_SECRET_B32_LEN + 1 sempre basta.
+ * @return Número de caracteres escritos, ou 0 se o índice não existe ou o buffer for pequeno.
+ */
+size_t keystore_encodeBase32(int index, char *out, size_t outSize);
@@ -10,9 +10,7 @@
 #include <TimeLib.h>
 #include <TFT_eSPI.h>
 #include "OneButton.h"
-#include <Preferences.h>
 #include <MFRC522.h>
-#include "mbedtls/md.h"
 
 #include "config.h"
 #include "globals.h"
@@ -20,10 +18,21 @@
 #include "hardware.h"
 #include "i18n.h"
 #include "storage.h"
+#include "service_map.h"
 #include "totp.h"
+#include "code_table.h"
+#include "code_timeline.h"
+#include "hotp_journal.h"
+#include "record_store.h"
+#include "settings.h"
+#include "boot_profile.h"
 #include "input.h"
 #include "ui.h"
 
+// O Test Runner do PlatformIO (test_build_src) compila src/ junto com os testes,
+// que fornecem seus próprios setup()/loop().
+#ifndef PIO_UNIT_TESTING
+
 // ---- Protótipos de Funções ----
 // Core Logic & Hardware
 void setup();
@@ -32,48 +41,39 @@ void loop();
 
 // ---- Setup e Loop Principal ----
 void setup() {
+  bootprof_begin(); // Perfil do boot: cada fase abaixo termina num bootprof_mark()
   Serial.begin(115200);
   while (!Serial); // Espera Serial (opcional, mas bom para debug inicial)
+  bootprof_mark("serial");
   Serial.println("\n[SETUP] Iniciando TOTP Authenticator Multi-Idioma v4.1...");
 
-  // Carrega configurações ANTES de usar textos na inicialização do HW
-  preferences.begin("totp-app", true); // Abre NVS para leitura
-  int saved_lang_index = preferences.getInt(NVS_KEY_LANGUAGE, (int)Language::PT_BR); // Padrão PT_BR se não existir
-  if (saved_lang_index >= 0 && saved_lang_index < NUM_LANGUAGES) {
-      current_language = (Language)saved_lang_index;
-  } else {
-      current_language = Language::PT_BR; // Fallback se valor salvo for inválido
-      Serial.printf("[WARN] Idioma NVS inválido (%d), usando padrão.\n", saved_lang_index);
-  }
-  //current_strings = languages[current_language]; // Define ponteiro global para textos
-  gmt_offset_hours = preferences.getInt(NVS_KEY_TZ_OFFSET, 0); // Padrão GMT+0
-  preferences.end(); // Fecha NVS
+  // Carrega configurações ANTES de usar textos na inicialização do HW (um registro, uma leitura do NVS)
+  settings_load();
   Serial.printf("[SETUP] Idioma: %d, Fuso: GMT%+d\n", current_language, gmt_offset_hours);
+  bootprof_mark("settings");
 
   // Inicializa Hardware (RTC, TFT, Pinos)
   initBaseHardware(); // Usa getText internamente para msg de erro RTC se necessário
+  bootprof_mark("hardware");
 
   // Inicializa Sprites
   initSprites();
+  bootprof_mark("sprites");
 
   // Carrega Serviços do NVS
   loadServices();
+  codetable_rebuildKeys(); // Só o índice foi lido: segredos vêm do NVS quando cada serviço é exibido
+  bootprof_mark("services");
 
-  // Decodifica chave do serviço inicial (se houver)
-  if (service_count > 0) {
-    current_service_index = 0; // Começa no primeiro
-    if (!decodeCurrentServiceKey()) {
-        // O erro já foi logado em decodeCurrentServiceKey
-        // A UI mostrará o erro B32
-    }
-  } else {
-    current_totp.valid_key_loaded = false; // Nenhum serviço
-    snprintf(current_totp.code, sizeof(current_totp.code), "%s", getText(STR_TOTP_CODE_ERROR));
-  }
+  // Só escolhe o serviço inicial: o boot abre no menu, então o desbloqueio do cofre
+  // (PBKDF2) e a decifragem do segredo ficam para a entrada na tela de códigos (changeScreen)
+  current_service_index = service_count > 0 ? svcmap_at(0) : -1; // Começa no primeiro da ordem
+  invalidateCurrentTOTP();
 
   // Configura callbacks dos botões
   configureButtonCallbacks();
   Serial.println("[SETUP] Botões configurados.");
+  bootprof_mark("buttons");
 
   // Configuração inicial de energia e timers
   updateBatteryStatus();
@@ -82,9 +82,11 @@ void setup() {
   last_interaction_time = millis();
   last_rtc_sync_time = millis();
   last_screen_update_time = 0; // Força atualização da tela no primeiro loop
+  bootprof_mark("power");
 
   changeScreen(SCREEN_MENU_MAIN); // Inicia na tela do menu principal
   Serial.println("[SETUP] Inicialização concluída.");
+  bootprof_endSetup(); // Até a primeira tela desenhada no loop: "first_frame"
 }
 
 void loop() {
@@ -97,10 +99,8 @@ void loop() {
         readRFIDCard(); // Lê cartão RFID
     }
 
-  // Processa entrada Serial apenas em telas específicas
-  if (current_screen == SCREEN_SERVICE_ADD_WAIT || current_screen == SCREEN_TIME_EDIT) {
-    processSerialInput();
-  }
+  // Processa entrada Serial: adição/hora nas telas de entrada, verificação de códigos em qualquer tela
+  processSerialInput();
 
   uint32_t currentMillis = millis();
 
@@ -113,22 +113,44 @@ void loop() {
   // Ajusta o brilho da tela com base na inatividade e alimentação
   updateScreenBrightness();
 
+  // Virada de intervalo TOTP: verificada a cada iteração (não a cada 500 ms) para que o
+  // novo código, já calculado pelo lookahead, chegue à tela no mesmo ciclo
+  bool totpRollover = false;
+  if (current_screen == SCREEN_TOTP_VIEW && service_count > 0) {
+    totpRollover = updateCurrentTOTP();
+  }
+
   // Verifica se é hora de uma atualização regular da tela
   bool needsRegularUpdate = false;
   if (currentMillis - last_screen_update_time >= SCREEN_UPDATE_INTERVAL_MS) {
     needsRegularUpdate = true;
     last_screen_update_time = currentMillis;
     updateBatteryStatus(); // Atualiza info da bateria
-    // Atualiza o código TOTP se necessário
-    if (current_screen == SCREEN_TOTP_VIEW && service_count > 0) {
-      updateCurrentTOTP();
-    }
+    hotp_tick();           // Dobra preguiçosa do journal HOTP (no máximo uma gravação)
+    storage_tick();        // Compactação do log do cofre (no máximo uma gravação)
+    rstore_tick();         // Coleta de um setor da partição "vault", se o espaço livre estiver baixo
+    settings_tick(currentMillis); // Configurações alteradas: uma gravação depois de alguns segundos sem mudanças
+    if (current_screen == SCREEN_TOTP_VIEW) finishPendingService(); // Chave deixada pelo prev/next
   }
 
-  // Redesenha a tela se for a atualização regular OU se o menu estiver animando
-  if (needsRegularUpdate || is_menu_animating) {
+  // Redesenha a tela se for a atualização regular, uma virada de código OU se o menu estiver animando
+  if (needsRegularUpdate || totpRollover || is_menu_animating) {
     ui_drawScreen(false); // Chama desenho parcial (atualiza header dinâmico e conteúdo)
+    if (totpRollover) codetable_markRolloverDrawn(); // Fecha a medição virada -> pixel
+    bootprof_frameDrawn(); // Só a primeira tela conta para o perfil do boot
+  }
+
+  // Lookahead: prepara os códigos do próximo intervalo fora do caminho de desenho da virada
+  if (needsRegularUpdate && !totpRollover && current_screen == SCREEN_TOTP_VIEW && service_count > 0) {
+    codetable_prepareLookahead(now());
+  }
+
+  // Linha do tempo: no USB, pré-calcula os próximos intervalos para consulta em bateria
+  if (needsRegularUpdate && !totpRollover) {
+    timeline_tick(now(), battery_info.is_usb_powered);
   }
 
   delay(LOOP_DELAY_MS); // Pequeno delay para ceder tempo e suavizar animação
 }
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,84 @@
+#include <string.h>
+#include "name_store.h"
+#include "globals.h"
+
+// ============================================================================
+// === ARENA DE NOMES ===
+// ============================================================================
+
+// Recolhe os buracos: move os nomes vivos para o início, na ordem em que já estão
+static void compact() {
+    static uint16_t ids[MAX_SERVICES]; // Fora da pilha: MAX_SERVICES ids
+    int n = 0;
+    for (int i = 0; i < MAX_SERVICES; i++) { // Inserção por offset (no máximo MAX_SERVICES nomes)
+        if (name_arena.length[i] == 0) continue;
+        int j = n++;
+        for (; j > 0 && name_arena.offset[ids[j - 1]] > name_arena.offset[i]; j--) ids[j] = ids[j - 1];
+        ids[j] = (uint16_t)i;
+    }
+    uint16_t pos = 0;
+    for (int k = 0; k < n; k++) {
+        uint16_t size = name_arena.length[ids[k]] + 1;
+        memmove(&name_arena.data[pos], &name_arena.data[name_arena.offset[ids[k]]], size);
+        name_arena.offset[ids[k]] = pos;
+        pos += size;
+    }
+    memset(&name_arena.data[pos], 0, name_arena.used - pos);
+    name_arena.used = pos;
+    name_arena.holes = 0;
+}
+
+void namestore_clear() {
+    memset(&name_arena, 0, sizeof(name_arena));
+}
+
+bool namestore_set(int index, const char *name, size_t length) {
+    if (index < 0 || index >= MAX_SERVICES || !name || length == 0 || length > MAX_SERVICE_NAME_LEN) return false;
+    namestore_remove(index);
+    if (name_arena.used + length + 1 > NAME_ARENA_BYTES) {
+        if (name_arena.used - name_arena.holes + length + 1 > NAME_ARENA_BYTES) return false;
+        compact();
+    }
+    name_arena.offset[index] = name_arena.used;
+    name_arena.length[index] = (uint8_t)length;
+    memcpy(&name_arena.data[name_arena.used], name, length);
+    name_arena.used += length;
+    name_arena.data[name_arena.used++] = '\0';
+    return true;
+}
+
+const char *namestore_get(int index) {
+    if (index < 0 || index >= MAX_SERVICES || name_arena.length[index] == 0) return "";
+    return &name_arena.data[name_arena.offset[index]];
+}
+
+size_t namestore_length(int index) {
+    if (index < 0 || index >= MAX_SERVICES) return 0;
+    return name_arena.length[index];
+}
+
+int namestore_find(const char *name) {
+    size_t length = strlen(name);
+    if (length == 0 || length > MAX_SERVICE_NAME_LEN) return -1;
+    for (int i = 0; i < MAX_SERVICES; i++) { // Compara o comprimento antes dos bytes
+        if (name_arena.length[i] == length && memcmp(&name_arena.data[name_arena.offset[i]], name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void namestore_remove(int index) {
+    if (index < 0 || index >= MAX_SERVICES || name_arena.length[index] == 0) return;
+    uint16_t start = name_arena.offset[index];
+    uint16_t size = name_arena.length[index] + 1;
+    memset(&name_arena.data[start], 0, size);
+    if (start + size == name_arena.used) name_arena.used = start; // Último da arena: só encolhe
+    else name_arena.holes += size;
+    name_arena.offset[index] = 0;
+    name_arena.length[index] = 0;
+}
+
+size_t namestore_free() {
+    return NAME_ARENA_BYTES - name_arena.used + name_arena.holes;
+}
@@ -0,0 +1,53 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include "types.h"  // Para NameArena
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DA ARENA DE NOMES ===
+// ============================================================================
+// Nomes dos serviços por id de 'services' (ver service_map.h), contíguos e cada
+// um com seu '\0'. Um nome novo entra no fim da arena; remover só apaga os bytes
+// do nome, sem mover os demais. Os buracos são recolhidos de uma vez quando um
+// nome novo não cabe mais no fim.
+
+/**
+ * @brief Esvazia a arena. Chamar antes de recarregar os serviços.
+ */
+void namestore_clear();
+
+/**
+ * @brief Grava o nome do id dado (substituindo o anterior, se houver).
+ * @param index Id do serviço.
+ * @param name Caracteres do nome (sem '\0' obrigatório).
+ * @param length Comprimento (1 a MAX_SERVICE_NAME_LEN).
+ * @return false se o comprimento for inválido ou o nome não couber na arena, mesmo sem os buracos.
+ */
+bool namestore_set(int index, const char *name, size_t length);
+
+/**
+ * @brief Nome de um serviço (O(1)).
+ * @return Ponteiro para o nome dentro da arena (válido até o próximo namestore_set), ou "" se o id não tem nome.
+ */
+const char *namestore_get(int index);
+
+/**
+ * @brief Comprimento do nome de um serviço (sem o '\0'), sem percorrê-lo.
+ */
+size_t namestore_length(int index);
+
+/**
+ * @brief Busca por nome exato: compara primeiro os comprimentos, só depois os bytes.
+ * @return Id de um serviço com esse nome (o de menor id), ou -1.
+ */
+int namestore_find(const char *name);
+
+/**
+ * @brief Apaga o nome do id dado sem mover os demais (espelha storage_deleteService).
+ */
+void namestore_remove(int index);
+
+/**
+ * @brief Bytes ainda livres na arena, contando os buracos.
+ */
+size_t namestore_free();
@@ -0,0 +1,101 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint32_t, uint64_t
+#include <Arduino.h>  // Para String (no host, o de test/host)
+#include "types.h"    // Para NvsStats
+
+#ifdef ARDUINO
+#include <Preferences.h> // Para Preferences (NVS do ESP-IDF)
+#else
+#include <string>
+#endif
+
+// ============================================================================
+// === ACESSO AO NVS (SELEÇÃO DO BACKEND EM TEMPO DE COMPILAÇÃO) ===
+// ============================================================================
+// Todo acesso ao NVS (cofre, log, journal HOTP, idioma e fuso) passa pelo objeto
+// global 'preferences' desta classe, que tem a mesma interface do subconjunto de
+// Preferences usado pelo projeto. A implementação vem de exatamente um backend:
+//   - alvo (ARDUINO): Preferences do Arduino-ESP32 (nvs_backend_preferences.cpp),
+//     que só acrescenta a contagem de operações e bytes e o tempo medido;
+//   - host: modelo do NVS do ESP-IDF em RAM (nvs_backend_host.cpp), com
+//     entradas de 32 bytes em páginas de 4 KB, coleta de páginas, latência
+//     modelada por operação, apagamentos contados por página, espelho opcional
+//     num arquivo e injeção de quedas de energia.
+// Assim os testes de armazenamento e os benchmarks rodam no Linux (pio test -e
+// native-storage) e medem o mesmo código que roda na placa.
+
+class NvsStore {
+public:
+    bool begin(const char *name, bool readOnly = false);
+    void end();
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putInt(const char *key, int32_t value);
+    int32_t getInt(const char *key, int32_t defaultValue = 0);
+    size_t putUInt(const char *key, uint32_t value);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    size_t putULong64(const char *key, uint64_t value);
+    uint64_t getULong64(const char *key, uint64_t defaultValue = 0);
+    size_t putString(const char *key, const char *value);
+    String getString(const char *key, const char *defaultValue = "");
+    size_t putBytes(const char *key, const void *value, size_t length);
+    size_t getBytes(const char *key, void *buffer, size_t length);
+    size_t getBytesLength(const char *key);
+
+private:
+#ifdef ARDUINO
+    Preferences prefs;
+#else
+    std::string ns;        // Namespace aberto
+    bool opened = false;
+    bool read_only = false;
+#endif
+};
+
+/**
+ * @brief Contadores cumulativos de acesso ao NVS (todas as instâncias).
+ */
+const NvsStats &nvs_getStats();
+
+#ifndef ARDUINO
+// ---- Controle do modelo no host (testes e benchmarks) ----
+
+/**
+ * @brief Apaga todo o NVS simulado (todas as chaves e páginas) e zera o desgaste e os contadores.
+ */
+void nvs_hostReset();
+
+/**
+ * @brief Espelha o NVS simulado num arquivo: carrega-o agora (se existir) e o regrava
+ *        após cada gravação bem-sucedida. O desgaste por página também é guardado, então
+ *        acumula entre execuções. nullptr volta a só RAM.
+ * @return false se o arquivo existe mas é inválido (o NVS fica vazio).
+ */
+bool nvs_hostAttachFile(const char *path);
+
+/**
+ * @brief Queda de energia simulada: depois de 'operations' gravações ou remoções
+ *        bem-sucedidas, todas as seguintes falham sem efeito (como no NVS, cada item
+ *        é gravado inteiro ou não é gravado). UINT32_MAX desliga a injeção ("religa").
+ */
+void nvs_hostFailAfter(uint32_t operations);
+
+/**
+ * @brief A queda simulada por nvs_hostFailAfter() já aconteceu?
+ */
+bool nvs_hostPowerLost();
+
+/**
+ * @brief Apagamentos de uma página do modelo (0 a NVS_HOST_PAGES - 1).
+ */
+uint32_t nvs_hostPageErases(int page);
+
+/**
+ * @brief Entradas de 32 bytes ocupadas por itens vivos, em todas as páginas.
+ */
+uint32_t nvs_hostUsedEntries();
+#endif
@@ -0,0 +1,450 @@
+#include "nvs_backend.h"
+#include "config.h"
+
+#ifndef ARDUINO
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+// ============================================================================
+// === BACKEND HOST: MODELO DO NVS DO ESP-IDF ===
+// ============================================================================
+// Guarda os valores num mapa em RAM e, em paralelo, modela onde o NVS real os
+// gravaria: páginas de 4 KB com NVS_ENTRIES_PER_PAGE entradas de 32 bytes,
+// sempre acrescentadas (uma entrada nunca é regravada antes de a página ser apagada).
+//   - inteiro: 1 entrada; string: 1 + dados; blob: 1 índice + pedaços de
+//     (1 + dados), cada pedaço dentro de uma página;
+//   - regravar ou remover marca as entradas antigas como apagadas (bitmap);
+//     gravar o mesmo valor de novo não grava nada (o ESP-IDF compara antes);
+//   - sem espaço na página ativa, abre uma página livre, mas sempre sobra uma
+//     para a coleta: sem ela, a página mais antiga tem os itens vivos copiados
+//     para a ativa e é apagada (o desgaste contado em nvs_hostPageErases).
+// A latência de cada operação é somada em NvsStats::busy_us, com custos da
+// ordem dos medidos num ESP32-S3 com flash QSPI (ajustar aqui se medir outros).
+
+static const uint32_t NVS_ENTRIES_PER_PAGE = 126;
+static const uint32_t NVS_KEY_MAX_LEN = 15;           // Sem o '\0' (NVS_KEY_NAME_MAX_SIZE - 1)
+
+static const uint32_t LATENCY_LOOKUP_US = 10;         // Busca no índice em RAM do NVS
+static const uint32_t LATENCY_READ_ENTRY_US = 2;      // Leitura de 32 bytes (cache da flash)
+static const uint32_t LATENCY_WRITE_ENTRY_US = 45;    // Gravação de 32 bytes + bitmap de estado
+static const uint32_t LATENCY_ERASE_ITEM_US = 30;     // Entradas marcadas como apagadas
+static const uint32_t LATENCY_PAGE_ERASE_US = 25000;  // Apagamento de um setor de 4 KB
+
+enum ItemType : uint8_t { ITEM_U32 = 1, ITEM_I32 = 2, ITEM_U64 = 3, ITEM_STRING = 4, ITEM_BLOB = 5 };
+
+struct Chunk {
+    uint8_t page;
+    uint8_t entries;
+};
+
+struct Item {
+    uint8_t type;
+    std::vector<uint8_t> value;
+    std::vector<Chunk> chunks; // Onde as entradas do item estão no modelo de páginas
+};
+
+struct Page {
+    bool in_use;      // Aberta desde o último apagamento
+    uint32_t seq;     // Ordem de abertura (a menor é a próxima a coletar)
+    uint32_t written; // Entradas gravadas (vivas ou apagadas)
+    uint32_t erased;  // Entradas marcadas como apagadas
+    uint32_t erases;  // Apagamentos da página (desgaste)
+};
+
+static std::map<std::string, Item> items; // Chave: namespace + '\0' + chave
+static Page pages[NVS_HOST_PAGES];
+static int active_page = -1;
+static uint32_t next_page_seq = 0;
+static NvsStats nvs_stats = {0, 0, 0, 0, 0, 0, 0, 0};
+static uint32_t fail_after = UINT32_MAX;  // Gravações até a queda simulada
+static bool power_lost = false;
+static std::string mirror_path;           // Arquivo espelho ("" = só RAM)
+
+static std::string full_key(const std::string &ns, const char *key) {
+    std::string k = ns;
+    k.push_back('\0');
+    return k + key;
+}
+
+static uint32_t data_entries(size_t bytes) {
+    return (uint32_t)((bytes + 31) / 32);
+}
+
+static uint32_t free_pages() {
+    uint32_t count = 0;
+    for (int p = 0; p < NVS_HOST_PAGES; p++) {
+        if (!pages[p].in_use) count++;
+    }
+    return count;
+}
+
+static bool open_page(bool use_reserve) {
+    if (free_pages() <= (use_reserve ? 0u : 1u)) return false;
+    for (int n = 1; n <= NVS_HOST_PAGES; n++) { // Em anel a partir da ativa, como a lista de páginas do NVS
+        int p = (active_page + n + NVS_HOST_PAGES) % NVS_HOST_PAGES;
+        if (pages[p].in_use) continue;
+        pages[p].in_use = true;
+        pages[p].seq = next_page_seq++;
+        pages[p].written = pages[p].erased = 0;
+        active_page = p;
+        return true;
+    }
+    return false;
+}
+
+// Reserva 'entries' entradas contíguas na página ativa (abrindo outra se preciso)
+static bool allocate(uint32_t entries, bool use_reserve, Chunk *chunk) {
+    if (active_page < 0 || pages[active_page].written + entries > NVS_ENTRIES_PER_PAGE) {
+        if (!open_page(use_reserve)) return false;
+    }
+    *chunk = {(uint8_t)active_page, (uint8_t)entries};
+    pages[active_page].written += entries;
+    nvs_stats.entries_written += entries;
+    nvs_stats.busy_us += entries * LATENCY_WRITE_ENTRY_US;
+    return true;
+}
+
+static void release(const Item &item) {
+    for (const Chunk &chunk : item.chunks) pages[chunk.page].erased += chunk.entries;
+    nvs_stats.busy_us += LATENCY_ERASE_ITEM_US;
+}
+
+// Coleta a página mais antiga: copia os pedaços vivos para a ativa (podendo usar a reserva)
+static bool collect_oldest() {
+    int victim = -1;
+    for (int p = 0; p < NVS_HOST_PAGES; p++) {
+        if (pages[p].in_use && p != active_page && (victim < 0 || pages[p].seq < pages[victim].seq)) victim = p;
+    }
+    if (victim < 0) return false;
+    for (auto &entry : items) {
+        for (Chunk &chunk : entry.second.chunks) {
+            if (chunk.page != victim) continue;
+            Chunk moved;
+            if (!allocate(chunk.entries, true, &moved)) return false;
+            nvs_stats.busy_us += chunk.entries * LATENCY_READ_ENTRY_US;
+            chunk = moved;
+        }
+    }
+    pages[victim].in_use = false;
+    pages[victim].erases++;
+    nvs_stats.page_erases++;
+    nvs_stats.busy_us += LATENCY_PAGE_ERASE_US;
+    return true;
+}
+
+// Garante que um pedaço de 'entries' cabe sem usar a página reservada para a coleta
+static bool make_room(uint32_t entries) {
+    for (int attempts = 0; attempts <= NVS_HOST_PAGES; attempts++) {
+        if (active_page >= 0 && pages[active_page].written + entries <= NVS_ENTRIES_PER_PAGE) return true;
+        if (free_pages() > 1) return true; // allocate() abre uma página nova
+        if (!collect_oldest()) return false;
+    }
+    return false;
+}
+
+// Distribui o item nas páginas do modelo. Retorna false se o NVS está cheio.
+static bool place(Item *item) {
+    item->chunks.clear();
+    Chunk chunk;
+    if (item->type != ITEM_BLOB) {
+        uint32_t entries = item->type == ITEM_STRING ? 1 + data_entries(item->value.size()) : 1;
+        if (!make_room(entries) || !allocate(entries, false, &chunk)) return false;
+        item->chunks.push_back(chunk);
+        return true;
+    }
+    size_t remaining = item->value.size();
+    do { // Pedaços de dados, cada um dentro de uma página
+        if (!make_room(2)) return false;
+        uint32_t room = NVS_ENTRIES_PER_PAGE - (active_page >= 0 ? pages[active_page].written : NVS_ENTRIES_PER_PAGE);
+        if (room < 2) room = NVS_ENTRIES_PER_PAGE; // allocate() abre uma página nova
+        size_t bytes = remaining < (room - 1) * 32 ? remaining : (room - 1) * 32;
+        if (!allocate(1 + data_entries(bytes), false, &chunk)) return false;
+        item->chunks.push_back(chunk);
+        remaining -= bytes;
+    } while (remaining > 0);
+    if (!make_room(1) || !allocate(1, false, &chunk)) return false; // Índice do blob
+    item->chunks.push_back(chunk);
+    return true;
+}
+
+// ---- Arquivo espelho ----
+static const uint32_t MIRROR_MAGIC = 0x4853564E; // "NVSH"
+
+static void mirror_save() {
+    if (mirror_path.empty()) return;
+    std::string tmp = mirror_path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return;
+    uint32_t header[2] = {MIRROR_MAGIC, (uint32_t)NVS_HOST_PAGES};
+    fwrite(header, sizeof(header), 1, f);
+    for (int p = 0; p < NVS_HOST_PAGES; p++) fwrite(&pages[p].erases, sizeof(uint32_t), 1, f);
+    uint32_t count = (uint32_t)items.size();
+    fwrite(&count, sizeof(count), 1, f);
+    for (const auto &entry : items) {
+        uint32_t key_len = (uint32_t)entry.first.size();
+        uint32_t value_len = (uint32_t)entry.second.value.size();
+        fwrite(&key_len, sizeof(key_len), 1, f);
+        fwrite(entry.first.data(), 1, key_len, f);
+        fwrite(&entry.second.type, 1, 1, f);
+        fwrite(&value_len, sizeof(value_len), 1, f);
+        fwrite(entry.second.value.data(), 1, value_len, f);
+    }
+    bool ok = fclose(f) == 0;
+    if (ok) rename(tmp.c_str(), mirror_path.c_str()); // Troca atômica: o arquivo nunca fica pela metade
+}
+
+// Lê o espelho; os itens são redistribuídos em ordem nas páginas (o desgaste é preservado)
+static bool mirror_load() {
+    FILE *f = fopen(mirror_path.c_str(), "rb");
+    if (!f) return true; // Ainda não existe: NVS vazio
+    uint32_t header[2];
+    uint32_t erases[NVS_HOST_PAGES];
+    uint32_t count = 0;
+    bool ok = fread(header, sizeof(header), 1, f) == 1 && header[0] == MIRROR_MAGIC &&
+              header[1] == (uint32_t)NVS_HOST_PAGES && fread(erases, sizeof(erases), 1, f) == 1 &&
+              fread(&count, sizeof(count), 1, f) == 1;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint32_t key_len, value_len;
+        Item item;
+        ok = fread(&key_len, sizeof(key_len), 1, f) == 1 && key_len < 64;
+        std::string key(ok ? key_len : 0, '\0');
+        ok = ok && fread(&key[0], 1, key_len, f) == key_len && fread(&item.type, 1, 1, f) == 1 &&
+             fread(&value_len, sizeof(value_len), 1, f) == 1 && value_len <= 65536;
+        if (!ok) break;
+        item.value.resize(value_len);
+        ok = fread(item.value.data(), 1, value_len, f) == value_len && place(&item);
+        if (ok) items[key] = item;
+    }
+    fclose(f);
+    if (!ok) {
+        nvs_hostReset();
+        return false;
+    }
+    for (int p = 0; p < NVS_HOST_PAGES; p++) pages[p].erases = erases[p];
+    return true;
+}
+
+// ---- Operações ----
+static bool valid_key(const char *key) {
+    return key && key[0] && strlen(key) <= NVS_KEY_MAX_LEN;
+}
+
+// Mais uma gravação ou remoção é possível antes da queda simulada?
+static bool power_ok() {
+    if (power_lost) return false;
+    if (fail_after == 0) {
+        power_lost = true;
+        return false;
+    }
+    if (fail_after != UINT32_MAX) fail_after--;
+    return true;
+}
+
+static const Item *find(const std::string &ns, const char *key) {
+    nvs_stats.reads++;
+    nvs_stats.busy_us += LATENCY_LOOKUP_US;
+    if (!valid_key(key)) return nullptr;
+    auto it = items.find(full_key(ns, key));
+    return it == items.end() ? nullptr : &it->second;
+}
+
+static size_t store(const std::string &ns, bool opened, bool read_only, const char *key, uint8_t type,
+                    const void *value, size_t length) {
+    if (!opened || read_only || !valid_key(key) || (length > 0 && !value)) return 0;
+    nvs_stats.busy_us += LATENCY_LOOKUP_US;
+    std::string k = full_key(ns, key);
+    auto it = items.find(k);
+    const uint8_t *bytes = (const uint8_t *)value;
+    if (it != items.end() && it->second.type == type && it->second.value.size() == length &&
+        memcmp(it->second.value.data(), bytes, length) == 0) {
+        nvs_stats.writes++; // Valor igual: o ESP-IDF não grava nada
+        nvs_stats.busy_us += data_entries(length) * LATENCY_READ_ENTRY_US;
+        return length;
+    }
+    if (!power_ok()) return 0;
+    Item item;
+    item.type = type;
+    item.value.assign(bytes, bytes + length);
+    if (!place(&item)) return 0; // NVS cheio: o valor antigo continua valendo
+    if (it != items.end()) {
+        release(it->second);
+        it->second = item;
+    } else {
+        items[k] = item;
+    }
+    nvs_stats.writes++;
+    nvs_stats.bytes_written += (uint32_t)length;
+    mirror_save();
+    return length;
+}
+
+template <typename T>
+static T load(const std::string &ns, bool opened, const char *key, uint8_t type, T default_value) {
+    if (!opened) return default_value;
+    const Item *item = find(ns, key);
+    if (!item || item->type != type || item->value.size() != sizeof(T)) return default_value;
+    T value;
+    memcpy(&value, item->value.data(), sizeof(T));
+    nvs_stats.bytes_read += sizeof(T);
+    nvs_stats.busy_us += LATENCY_READ_ENTRY_US;
+    return value;
+}
+
+// ============================================================================
+// === NvsStore (host) ===
+// ============================================================================
+
+bool NvsStore::begin(const char *name, bool readOnly) {
+    if (!name || !name[0] || strlen(name) > NVS_KEY_MAX_LEN) return false;
+    ns = name;
+    opened = true;
+    read_only = readOnly;
+    return true;
+}
+
+void NvsStore::end() {
+    opened = false;
+}
+
+bool NvsStore::clear() {
+    if (!opened || read_only || !power_ok()) return false;
+    std::string prefix = full_key(ns, "");
+    for (auto it = items.begin(); it != items.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            release(it->second);
+            it = items.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    nvs_stats.removes++;
+    mirror_save();
+    return true;
+}
+
+bool NvsStore::remove(const char *key) {
+    if (!opened || read_only || !valid_key(key)) return false;
+    nvs_stats.busy_us += LATENCY_LOOKUP_US;
+    auto it = items.find(full_key(ns, key));
+    if (it == items.end()) return false;
+    if (!power_ok()) return false;
+    release(it->second);
+    items.erase(it);
+    nvs_stats.removes++;
+    mirror_save();
+    return true;
+}
+
+bool NvsStore::isKey(const char *key) {
+    return opened && find(ns, key) != nullptr;
+}
+
+size_t NvsStore::putInt(const char *key, int32_t value) {
+    return store(ns, opened, read_only, key, ITEM_I32, &value, sizeof(value));
+}
+
+int32_t NvsStore::getInt(const char *key, int32_t defaultValue) {
+    return load<int32_t>(ns, opened, key, ITEM_I32, defaultValue);
+}
+
+size_t NvsStore::putUInt(const char *key, uint32_t value) {
+    return store(ns, opened, read_only, key, ITEM_U32, &value, sizeof(value));
+}
+
+uint32_t NvsStore::getUInt(const char *key, uint32_t defaultValue) {
+    return load<uint32_t>(ns, opened, key, ITEM_U32, defaultValue);
+}
+
+size_t NvsStore::putULong64(const char *key, uint64_t value) {
+    return store(ns, opened, read_only, key, ITEM_U64, &value, sizeof(value));
+}
+
+uint64_t NvsStore::getULong64(const char *key, uint64_t defaultValue) {
+    return load<uint64_t>(ns, opened, key, ITEM_U64, defaultValue);
+}
+
+size_t NvsStore::putString(const char *key, const char *value) {
+    if (!value) return 0;
+    size_t length = strlen(value);
+    return store(ns, opened, read_only, key, ITEM_STRING, value, length + 1) ? length : 0;
+}
+
+String NvsStore::getString(const char *key, const char *defaultValue) {
+    const Item *item = opened ? find(ns, key) : nullptr;
+    if (!item || item->type != ITEM_STRING || item->value.empty()) return String(defaultValue);
+    nvs_stats.bytes_read += (uint32_t)item->value.size();
+    nvs_stats.busy_us += data_entries(item->value.size()) * LATENCY_READ_ENTRY_US;
+    return String((const char *)item->value.data());
+}
+
+size_t NvsStore::putBytes(const char *key, const void *value, size_t length) {
+    if (length == 0) return 0; // Como no Preferences: blob vazio não é gravado
+    return store(ns, opened, read_only, key, ITEM_BLOB, value, length);
+}
+
+size_t NvsStore::getBytes(const char *key, void *buffer, size_t length) {
+    const Item *item = opened ? find(ns, key) : nullptr;
+    if (!item || item->type != ITEM_BLOB || !buffer || item->value.size() > length) return 0;
+    memcpy(buffer, item->value.data(), item->value.size());
+    nvs_stats.bytes_read += (uint32_t)item->value.size();
+    nvs_stats.busy_us += data_entries(item->value.size()) * LATENCY_READ_ENTRY_US;
+    return item->value.size();
+}
+
+size_t NvsStore::getBytesLength(const char *key) {
+    const Item *item = opened ? find(ns, key) : nullptr;
+    return item && item->type == ITEM_BLOB ? item->value.size() : 0;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+const NvsStats &nvs_getStats() {
+    return nvs_stats;
+}
+
+void nvs_hostReset() {
+    items.clear();
+    memset(pages, 0, sizeof(pages));
+    active_page = -1;
+    next_page_seq = 0;
+    nvs_stats = {0, 0, 0, 0, 0, 0, 0, 0};
+    fail_after = UINT32_MAX;
+    power_lost = false;
+    if (!mirror_path.empty()) remove(mirror_path.c_str());
+}
+
+bool nvs_hostAttachFile(const char *path) {
+    mirror_path.clear();
+    nvs_hostReset();
+    if (!path) return true;
+    mirror_path = path;
+    return mirror_load();
+}
+
+void nvs_hostFailAfter(uint32_t operations) {
+    fail_after = operations;
+    power_lost = false;
+}
+
+bool nvs_hostPowerLost() {
+    return power_lost;
+}
+
+uint32_t nvs_hostPageErases(int page) {
+    return page >= 0 && page < NVS_HOST_PAGES ? pages[page].erases : 0;
+}
+
+uint32_t nvs_hostUsedEntries() {
+    uint32_t used = 0;
+    for (int p = 0; p < NVS_HOST_PAGES; p++) {
+        if (pages[p].in_use) used += pages[p].written - pages[p].erased;
+    }
+    return used;
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,137 @@
+#include "nvs_backend.h"
+
+#ifdef ARDUINO
+
+// ============================================================================
+// === BACKEND NA PLACA: Preferences DO ARDUINO-ESP32 ===
+// ============================================================================
+// Repassa cada chamada ao Preferences e só acrescenta os contadores de
+// NvsStats, com o tempo real medido por micros(). Entradas e apagamentos de
+// página não são visíveis por esta API e ficam em zero (ver o modelo no host).
+
+static NvsStats nvs_stats = {0, 0, 0, 0, 0, 0, 0, 0};
+
+// Soma o tempo desde 'start' em busy_us
+static void add_busy(uint32_t start) {
+    nvs_stats.busy_us += micros() - start;
+}
+
+bool NvsStore::begin(const char *name, bool readOnly) {
+    return prefs.begin(name, readOnly);
+}
+
+void NvsStore::end() {
+    prefs.end();
+}
+
+bool NvsStore::clear() {
+    uint32_t start = micros();
+    bool ok = prefs.clear();
+    nvs_stats.removes++;
+    add_busy(start);
+    return ok;
+}
+
+bool NvsStore::remove(const char *key) {
+    uint32_t start = micros();
+    bool ok = prefs.remove(key);
+    nvs_stats.removes++;
+    add_busy(start);
+    return ok;
+}
+
+bool NvsStore::isKey(const char *key) {
+    uint32_t start = micros();
+    bool found = prefs.isKey(key);
+    nvs_stats.reads++;
+    add_busy(start);
+    return found;
+}
+
+// Gravação de 'written' bytes (0 = falhou)
+static size_t count_write(uint32_t start, size_t written) {
+    nvs_stats.writes++;
+    nvs_stats.bytes_written += written;
+    add_busy(start);
+    return written;
+}
+
+// Leitura de 'bytes' bytes
+static void count_read(uint32_t start, size_t bytes) {
+    nvs_stats.reads++;
+    nvs_stats.bytes_read += bytes;
+    add_busy(start);
+}
+
+size_t NvsStore::putInt(const char *key, int32_t value) {
+    uint32_t start = micros();
+    return count_write(start, prefs.putInt(key, value));
+}
+
+int32_t NvsStore::getInt(const char *key, int32_t defaultValue) {
+    uint32_t start = micros();
+    int32_t value = prefs.getInt(key, defaultValue);
+    count_read(start, sizeof(value));
+    return value;
+}
+
+size_t NvsStore::putUInt(const char *key, uint32_t value) {
+    uint32_t start = micros();
+    return count_write(start, prefs.putUInt(key, value));
+}
+
+uint32_t NvsStore::getUInt(const char *key, uint32_t defaultValue) {
+    uint32_t start = micros();
+    uint32_t value = prefs.getUInt(key, defaultValue);
+    count_read(start, sizeof(value));
+    return value;
+}
+
+size_t NvsStore::putULong64(const char *key, uint64_t value) {
+    uint32_t start = micros();
+    return count_write(start, prefs.putULong64(key, value));
+}
+
+uint64_t NvsStore::getULong64(const char *key, uint64_t defaultValue) {
+    uint32_t start = micros();
+    uint64_t value = prefs.getULong64(key, defaultValue);
+    count_read(start, sizeof(value));
+    return value;
+}
+
+size_t NvsStore::putString(const char *key, const char *value) {
+    uint32_t start = micros();
+    return count_write(start, prefs.putString(key, value));
+}
+
+String NvsStore::getString(const char *key, const char *defaultValue) {
+    uint32_t start = micros();
+    String value = prefs.getString(key, defaultValue);
+    count_read(start, value.length());
+    return value;
+}
+
+size_t NvsStore::putBytes(const char *key, const void *value, size_t length) {
+    uint32_t start = micros();
+    return count_write(start, prefs.putBytes(key, value, length));
+}
+
+size_t NvsStore::getBytes(const char *key, void *buffer, size_t length) {
+    uint32_t start = micros();
+    size_t read = prefs.getBytes(key, buffer, length);
+    count_read(start, read);
+    return read;
+}
+
+size_t NvsStore::getBytesLength(const char *key) {
+    uint32_t start = micros();
+    size_t length = prefs.getBytesLength(key);
+    count_read(start, 0);
+    return length;
+}
+
+const NvsStats &nvs_getStats() {
+    return nvs_stats;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,440 @@
+#include "record_store.h"
+#include "config.h"
+#include "crc32.h"
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_partition.h>
+#endif
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+// Setor: SectorHeader seguido de registros alinhados em 4 bytes,
+//   RecordHeader (12) | dados (length, completados até múltiplo de 4)
+// A região ainda apagada (0xFF) marca o fim dos registros de um setor. O CRC
+// cobre id, length, kind e os dados: um registro cortado por queda de energia
+// não confere e encerra a leitura daquele setor.
+struct SectorHeader {
+    uint32_t magic;
+    uint32_t seq; // Ordem de abertura; o menor é o mais antigo (próximo a coletar)
+};
+
+struct RecordHeader {
+    uint32_t id;
+    uint16_t length;
+    uint8_t kind;     // RECORD_PUT ou RECORD_DELETE
+    uint8_t reserved;
+    uint32_t crc;
+};
+
+static const uint32_t SECTOR_MAGIC = 0x52545356; // "VSTR"
+static const uint8_t RECORD_PUT = 1;
+static const uint8_t RECORD_DELETE = 2;
+static const uint32_t EMPTY_ID = 0xFFFFFFFF;     // Flash apagada; nunca um id válido
+static const int MAX_SECTORS = 256;              // 1 MB de partição
+// Menor potência de 2 com carga máxima de 2/3 (sondagens curtas): 4096 para RSTORE_MAX_RECORDS = 2368
+static constexpr int index_bits(int bits = 1) {
+    return (1 << bits) * 2 >= RSTORE_MAX_RECORDS * 3 ? bits : index_bits(bits + 1);
+}
+static const int INDEX_BITS = index_bits();
+static const int INDEX_SLOTS = 1 << INDEX_BITS;
+static const uint32_t NO_SECTOR = 0xFFFFFFFF;
+
+static_assert((INDEX_SLOTS & (INDEX_SLOTS - 1)) == 0, "INDEX_SLOTS deve ser potência de 2");
+static_assert(sizeof(RecordHeader) == 12, "RecordHeader com padding inesperado");
+
+// Índice em RAM: id -> endereço do RecordHeader vivo. Sondagem linear; a remoção
+// desloca as entradas seguintes para trás (sem marcas de removido).
+struct IndexSlot {
+    uint32_t id;   // EMPTY_ID = livre
+    uint32_t addr;
+};
+
+static IndexSlot index_slots[INDEX_SLOTS];
+static uint32_t sector_seq[MAX_SECTORS];   // Seq de cada setor em uso, NO_SECTOR se livre
+static bool sector_erased[MAX_SECTORS];    // Livre e já apagado (pronto para abrir)
+static uint8_t sector_buf[RSTORE_SECTOR_SIZE]; // Um setor lido de uma vez (montagem e coleta)
+static int sector_count = 0;
+static int head_sector = -1;               // Setor recebendo gravações
+static uint32_t head_pos = 0;              // Próximo byte livre no setor atual
+static uint32_t next_seq = 0;
+static bool mounted = false;
+static RecordStoreStats rstore_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static size_t padded(size_t length) {
+    return (length + 3) & ~(size_t)3;
+}
+
+static size_t record_size(size_t length) {
+    return sizeof(RecordHeader) + padded(length);
+}
+
+// ---- Acesso à flash ----
+#ifdef ARDUINO
+static const esp_partition_t *partition = nullptr;
+
+static bool flash_open() {
+    if (!partition) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "vault");
+    }
+    return partition != nullptr;
+}
+
+static size_t flash_size() {
+    return partition->size;
+}
+
+static bool flash_read(uint32_t addr, void *out, size_t length) {
+    return esp_partition_read(partition, addr, out, length) == ESP_OK;
+}
+
+static bool flash_write(uint32_t addr, const void *data, size_t length) {
+    return esp_partition_write(partition, addr, data, length) == ESP_OK;
+}
+
+static bool flash_erase(int sector) {
+    return esp_partition_erase_range(partition, (size_t)sector * RSTORE_SECTOR_SIZE, RSTORE_SECTOR_SIZE) == ESP_OK;
+}
+#else
+// Host: flash NOR simulada em RAM. Apagar leva os bytes a 0xFF; gravar só zera bits.
+static uint8_t host_flash[RSTORE_HOST_FLASH_BYTES];
+static bool host_flash_ready = false;
+
+static bool flash_open() {
+    if (!host_flash_ready) {
+        memset(host_flash, 0xFF, sizeof(host_flash)); // Chip novo: tudo apagado
+        host_flash_ready = true;
+    }
+    return true;
+}
+
+static size_t flash_size() {
+    return sizeof(host_flash);
+}
+
+static bool flash_read(uint32_t addr, void *out, size_t length) {
+    if (addr + length > sizeof(host_flash)) return false;
+    memcpy(out, &host_flash[addr], length);
+    return true;
+}
+
+static bool flash_write(uint32_t addr, const void *data, size_t length) {
+    if (addr + length > sizeof(host_flash)) return false;
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < length; i++) host_flash[addr + i] &= bytes[i];
+    return true;
+}
+
+static bool flash_erase(int sector) {
+    memset(&host_flash[(size_t)sector * RSTORE_SECTOR_SIZE], 0xFF, RSTORE_SECTOR_SIZE);
+    return true;
+}
+
+uint8_t *rstore_hostFlash() {
+    flash_open();
+    return host_flash;
+}
+#endif
+
+// ---- Índice ----
+static uint32_t index_home(uint32_t id) {
+    return (id * 2654435761u) >> (32 - INDEX_BITS); // Hash multiplicativo (Knuth): INDEX_BITS bits altos
+}
+
+static int index_find(uint32_t id) {
+    for (uint32_t i = index_home(id);; i = (i + 1) & (INDEX_SLOTS - 1)) {
+        if (index_slots[i].id == id) return (int)i;
+        if (index_slots[i].id == EMPTY_ID) return -1;
+    }
+}
+
+// Insere ou atualiza; retorna o endereço anterior (ou 0 se o id era novo)
+static uint32_t index_set(uint32_t id, uint32_t addr) {
+    uint32_t i = index_home(id);
+    for (; index_slots[i].id != EMPTY_ID; i = (i + 1) & (INDEX_SLOTS - 1)) {
+        if (index_slots[i].id == id) {
+            uint32_t old = index_slots[i].addr;
+            index_slots[i].addr = addr;
+            return old;
+        }
+    }
+    index_slots[i] = {id, addr};
+    rstore_stats.records++;
+    return 0;
+}
+
+static void index_erase(int slot) {
+    uint32_t hole = (uint32_t)slot;
+    for (uint32_t i = (hole + 1) & (INDEX_SLOTS - 1); index_slots[i].id != EMPTY_ID; i = (i + 1) & (INDEX_SLOTS - 1)) {
+        uint32_t home = index_home(index_slots[i].id);
+        // A entrada em 'i' pode ocupar o buraco se a sua posição ideal não está em (hole, i]
+        if (((i - home) & (INDEX_SLOTS - 1)) >= ((i - hole) & (INDEX_SLOTS - 1))) {
+            index_slots[hole] = index_slots[i];
+            hole = i;
+        }
+    }
+    index_slots[hole].id = EMPTY_ID;
+    rstore_stats.records--;
+}
+
+// ---- Registros ----
+static uint32_t record_crc(const RecordHeader &header, const uint8_t *data) {
+    uint32_t crc = crc32_update((const uint8_t *)&header.id, sizeof(header.id));
+    crc = crc32_update((const uint8_t *)&header.length, sizeof(header.length), crc);
+    crc = crc32_update(&header.kind, sizeof(header.kind), crc);
+    return crc32_update(data, header.length, crc);
+}
+
+// Registro válido no buffer do setor, a partir de 'pos'? Retorna o tamanho ocupado, ou 0.
+static size_t parse_record(uint32_t pos, RecordHeader *header) {
+    if (pos + sizeof(RecordHeader) > RSTORE_SECTOR_SIZE) return 0;
+    memcpy(header, &sector_buf[pos], sizeof(RecordHeader));
+    if (header->id == EMPTY_ID || header->length > RSTORE_MAX_RECORD_LEN ||
+        (header->kind != RECORD_PUT && header->kind != RECORD_DELETE) ||
+        pos + record_size(header->length) > RSTORE_SECTOR_SIZE ||
+        record_crc(*header, &sector_buf[pos + sizeof(RecordHeader)]) != header->crc) {
+        return 0;
+    }
+    return record_size(header->length);
+}
+
+static int oldest_sector() {
+    int oldest = -1;
+    for (int s = 0; s < sector_count; s++) {
+        if (sector_seq[s] != NO_SECTOR && (oldest < 0 || sector_seq[s] < sector_seq[oldest])) oldest = s;
+    }
+    return oldest;
+}
+
+// Abre um setor livre como o novo setor atual. 'reserve' = setores livres que devem sobrar.
+static bool open_sector(int reserve) {
+    if ((int)rstore_stats.free_sectors <= reserve) return false;
+    int start = head_sector < 0 ? 0 : head_sector + 1;
+    for (int n = 0; n < sector_count; n++) {
+        int s = (start + n) % sector_count; // Segue o anel: desgaste igual em todos os setores
+        if (sector_seq[s] != NO_SECTOR) continue;
+        if (!sector_erased[s]) {
+            if (!flash_erase(s)) return false;
+            rstore_stats.sector_erases++;
+        }
+        SectorHeader header = {SECTOR_MAGIC, next_seq};
+        if (!flash_write((uint32_t)s * RSTORE_SECTOR_SIZE, &header, sizeof(header))) return false;
+        sector_seq[s] = next_seq++;
+        sector_erased[s] = false;
+        rstore_stats.free_sectors--;
+        head_sector = s;
+        head_pos = sizeof(SectorHeader);
+        return true;
+    }
+    return false;
+}
+
+// Grava um registro no setor atual (abrindo outro se não couber) e retorna o seu endereço, ou 0
+static uint32_t append(uint32_t id, uint8_t kind, const uint8_t *data, size_t length, int reserve) {
+    size_t size = record_size(length);
+    if (head_sector < 0 || head_pos + size > RSTORE_SECTOR_SIZE) {
+        if (!open_sector(reserve)) return 0;
+    }
+    RecordHeader header = {id, (uint16_t)length, kind, 0, 0};
+    header.crc = record_crc(header, data);
+    uint32_t addr = (uint32_t)head_sector * RSTORE_SECTOR_SIZE + head_pos;
+    // Dados primeiro, cabeçalho por último: o CRC só confere com os dois inteiros
+    if (length > 0 && !flash_write(addr + sizeof(header), data, length)) return 0;
+    if (!flash_write(addr, &header, sizeof(header))) return 0;
+    head_pos += size;
+    rstore_stats.appends++;
+    rstore_stats.bytes_written += size;
+    return addr;
+}
+
+// Coleta o setor mais antigo: copia os registros vivos para o setor atual (podendo
+// usar a reserva), descarta versões antigas e tombstones, e apaga o setor.
+static bool collect_oldest() {
+    int victim = oldest_sector();
+    if (victim < 0 || victim == head_sector) return false;
+    uint32_t base = (uint32_t)victim * RSTORE_SECTOR_SIZE;
+    if (!flash_read(base, sector_buf, RSTORE_SECTOR_SIZE)) return false;
+    for (uint32_t pos = sizeof(SectorHeader); pos < RSTORE_SECTOR_SIZE;) {
+        RecordHeader header;
+        size_t size = parse_record(pos, &header);
+        if (size == 0) break;
+        int slot = header.kind == RECORD_PUT ? index_find(header.id) : -1;
+        if (slot >= 0 && index_slots[slot].addr == base + pos) { // Versão viva: realoca
+            uint32_t addr = append(header.id, RECORD_PUT, &sector_buf[pos + sizeof(RecordHeader)], header.length, 0);
+            if (addr == 0) return false; // Setor antigo continua intacto
+            index_slots[slot].addr = addr;
+            rstore_stats.gc_relocated++;
+        }
+        pos += size;
+    }
+    // Nenhum setor mais antigo sobra: os tombstones deste já não escondem nada
+    if (!flash_erase(victim)) return false;
+    rstore_stats.sector_erases++;
+    sector_seq[victim] = NO_SECTOR;
+    sector_erased[victim] = true;
+    rstore_stats.free_sectors++;
+    rstore_stats.gc_sectors++;
+    return true;
+}
+
+// Garante espaço para um registro de 'size' bytes sem tocar na reserva da coleta
+static bool make_room(size_t size) {
+    if (head_sector >= 0 && head_pos + size <= RSTORE_SECTOR_SIZE) return true;
+    for (int attempts = 0; (int)rstore_stats.free_sectors <= RSTORE_GC_RESERVE_SECTORS; attempts++) {
+        if (attempts >= sector_count || !collect_oldest()) return false; // Só dados vivos: cheio
+        rstore_stats.forced_gc++;
+    }
+    return true;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+bool rstore_begin() {
+    mounted = false;
+    for (int i = 0; i < INDEX_SLOTS; i++) index_slots[i].id = EMPTY_ID;
+    rstore_stats.records = rstore_stats.live_bytes = 0; // Ocupação vem da leitura; contadores são cumulativos
+    head_sector = -1;
+    head_pos = 0;
+    next_seq = 0;
+    if (!flash_open()) return false;
+    sector_count = (int)(flash_size() / RSTORE_SECTOR_SIZE);
+    if (sector_count > MAX_SECTORS) sector_count = MAX_SECTORS;
+
+    // Cabeçalhos de todos os setores; os sem cabeçalho válido são livres
+    int order[MAX_SECTORS];
+    int used = 0;
+    for (int s = 0; s < sector_count; s++) {
+        SectorHeader header;
+        sector_seq[s] = NO_SECTOR;
+        sector_erased[s] = false; // Sem ler o setor inteiro não dá para saber: apaga ao abrir
+        if (flash_read((uint32_t)s * RSTORE_SECTOR_SIZE, &header, sizeof(header)) && header.magic == SECTOR_MAGIC &&
+            header.seq != NO_SECTOR) {
+            sector_seq[s] = header.seq;
+            order[used++] = s;
+        }
+    }
+    rstore_stats.free_sectors = (uint32_t)(sector_count - used);
+    // Do mais antigo ao mais novo (inserção: poucos setores e quase sempre já em ordem de anel)
+    for (int i = 1; i < used; i++) {
+        int s = order[i];
+        int j = i - 1;
+        for (; j >= 0 && sector_seq[order[j]] > sector_seq[s]; j--) order[j + 1] = order[j];
+        order[j + 1] = s;
+    }
+
+    for (int i = 0; i < used; i++) {
+        int s = order[i];
+        uint32_t base = (uint32_t)s * RSTORE_SECTOR_SIZE;
+        if (!flash_read(base, sector_buf, RSTORE_SECTOR_SIZE)) return false;
+        uint32_t pos = sizeof(SectorHeader);
+        while (pos < RSTORE_SECTOR_SIZE) {
+            RecordHeader header;
+            size_t size = parse_record(pos, &header);
+            if (size == 0) break; // Fim dos registros ou gravação interrompida
+            if (header.kind == RECORD_PUT) {
+                index_set(header.id, base + pos);
+            } else {
+                int slot = index_find(header.id);
+                if (slot >= 0) index_erase(slot);
+            }
+            pos += size;
+        }
+        head_sector = s;
+        head_pos = pos;
+        next_seq = sector_seq[s] + 1;
+        // Algo além do último registro (gravação cortada): o setor não recebe mais nada
+        bool tail_clean = true;
+        for (uint32_t p = pos; p < RSTORE_SECTOR_SIZE && tail_clean; p++) tail_clean = sector_buf[p] == 0xFF;
+        if (!tail_clean) head_pos = RSTORE_SECTOR_SIZE;
+    }
+    memset(sector_buf, 0, sizeof(sector_buf));
+
+    // Bytes vivos: soma dos registros apontados pelo índice
+    for (int i = 0; i < INDEX_SLOTS; i++) {
+        if (index_slots[i].id == EMPTY_ID) continue;
+        RecordHeader header;
+        if (flash_read(index_slots[i].addr, &header, sizeof(header))) {
+            rstore_stats.live_bytes += record_size(header.length);
+        }
+    }
+    mounted = true;
+    return true;
+}
+
+bool rstore_isMounted() {
+    return mounted;
+}
+
+bool rstore_put(uint32_t id, const uint8_t *data, size_t length) {
+    if (!mounted || id == EMPTY_ID || !data || length == 0 || length > RSTORE_MAX_RECORD_LEN) return false;
+    int slot = index_find(id);
+    if (slot < 0 && (int)rstore_stats.records >= RSTORE_MAX_RECORDS) return false;
+    size_t size = record_size(length);
+    if (!make_room(size)) return false;
+    uint32_t addr = append(id, RECORD_PUT, data, length, RSTORE_GC_RESERVE_SECTORS);
+    if (addr == 0) return false;
+    uint32_t old = index_set(id, addr);
+    rstore_stats.live_bytes += size;
+    if (old) {
+        RecordHeader header;
+        if (flash_read(old, &header, sizeof(header))) rstore_stats.live_bytes -= record_size(header.length);
+    }
+    return true;
+}
+
+bool rstore_get(uint32_t id, uint8_t *out, size_t capacity, size_t *length) {
+    int slot = mounted ? index_find(id) : -1;
+    if (slot < 0) return false;
+    uint32_t addr = index_slots[slot].addr;
+    RecordHeader header;
+    if (!flash_read(addr, &header, sizeof(header)) || header.id != id || header.length > capacity ||
+        !flash_read(addr + sizeof(header), out, header.length) || record_crc(header, out) != header.crc) {
+        return false;
+    }
+    *length = header.length;
+    return true;
+}
+
+bool rstore_contains(uint32_t id) {
+    return mounted && index_find(id) >= 0;
+}
+
+bool rstore_remove(uint32_t id) {
+    int slot = mounted ? index_find(id) : -1;
+    if (slot < 0) return mounted;
+    if (!make_room(sizeof(RecordHeader))) return false;
+    if (append(id, RECORD_DELETE, nullptr, 0, RSTORE_GC_RESERVE_SECTORS) == 0) return false;
+    // A coleta em make_room() pode ter mudado o endereço do registro, nunca o slot do índice
+    RecordHeader header;
+    if (flash_read(index_slots[slot].addr, &header, sizeof(header))) rstore_stats.live_bytes -= record_size(header.length);
+    index_erase(slot);
+    return true;
+}
+
+void rstore_tick() {
+    if (!mounted || (int)rstore_stats.free_sectors >= RSTORE_GC_BACKGROUND_SECTORS) return;
+    collect_oldest();
+}
+
+void rstore_format() {
+    if (!rstore_begin()) return;
+    // Só os setores em uso: os demais já são livres e são apagados ao abrir
+    for (int s = 0; s < sector_count; s++) {
+        if (sector_seq[s] == NO_SECTOR || !flash_erase(s)) continue;
+        sector_seq[s] = NO_SECTOR;
+        sector_erased[s] = true;
+        rstore_stats.free_sectors++;
+    }
+    for (int i = 0; i < INDEX_SLOTS; i++) index_slots[i].id = EMPTY_ID;
+    head_sector = -1;
+    head_pos = 0;
+    next_seq = 0;
+    rstore_stats.records = rstore_stats.live_bytes = 0;
+}
+
+const RecordStoreStats &rstore_getStats() {
+    return rstore_stats;
+}
@@ -0,0 +1,93 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t, uint32_t
+#include "types.h"  // Para RecordStoreStats
+
+// ============================================================================
+// === ARMAZENAMENTO DE REGISTROS EM LOG (PARTIÇÃO "vault") ===
+// ============================================================================
+// Registros pequenos identificados por um id de 32 bits, gravados só por
+// acréscimo numa partição própria da flash, fora do NVS. Gravar de novo o mesmo
+// id acrescenta uma versão nova; remover acrescenta um tombstone. Um índice em
+// RAM (hash com sondagem linear, RSTORE_MAX_RECORDS registros, memória fixa)
+// leva do id ao endereço da versão viva: consulta O(1) e uma leitura da flash.
+//
+// Os setores formam um anel: o mais antigo é coletado primeiro (a cópia dos
+// registros ainda vivos vai para o setor atual) e apagado. Como nenhum setor
+// mais antigo sobrevive, os tombstones do setor coletado podem ser descartados.
+// O desgaste fica distribuído por igual entre todos os setores.
+//
+// No alvo a flash é a partição de dados "vault" (partitions.csv); no host,
+// RSTORE_HOST_FLASH_BYTES em RAM com a semântica de NOR (gravar só zera bits).
+// O conteúdo de um registro não é interpretado aqui.
+
+constexpr size_t RSTORE_MAX_RECORD_LEN = 512; // Maior registro aceito (bytes de dados)
+
+/**
+ * @brief Monta o armazenamento: lê todos os setores uma vez e reconstrói o índice.
+ *        Registros cortados por queda de energia (CRC inválido) são ignorados.
+ *        Pode ser chamada de novo para simular um boot (nos testes).
+ * @return true se a partição existe e foi montada.
+ */
+bool rstore_begin();
+
+/**
+ * @brief O armazenamento está montado?
+ */
+bool rstore_isMounted();
+
+/**
+ * @brief Grava (ou substitui) o registro 'id'. Uma gravação na flash; coleta um
+ *        setor antes só se o espaço livre estiver na reserva.
+ * @param id Identificador (qualquer valor exceto 0xFFFFFFFF).
+ * @param data Dados do registro.
+ * @param length Comprimento (1 a RSTORE_MAX_RECORD_LEN).
+ * @return true se gravado; false se cheio, montado sem partição ou erro de flash.
+ */
+bool rstore_put(uint32_t id, const uint8_t *data, size_t length);
+
+/**
+ * @brief Lê o registro 'id' (consulta O(1) no índice e uma leitura da flash).
+ * @param id Identificador.
+ * @param out Buffer de saída.
+ * @param capacity Tamanho de 'out'.
+ * @param length Saída: comprimento do registro.
+ * @return true se o registro existe, coube em 'out' e o CRC confere.
+ */
+bool rstore_get(uint32_t id, uint8_t *out, size_t capacity, size_t *length);
+
+/**
+ * @brief O registro 'id' existe? Só consulta o índice.
+ */
+bool rstore_contains(uint32_t id);
+
+/**
+ * @brief Remove o registro 'id' (acrescenta um tombstone). Não mexe em nenhum outro.
+ * @return true se removido ou se já não existia.
+ */
+bool rstore_remove(uint32_t id);
+
+/**
+ * @brief Coleta em segundo plano: com menos de RSTORE_GC_BACKGROUND_SECTORS setores
+ *        livres, coleta o setor mais antigo. No máximo um setor por chamada.
+ */
+void rstore_tick();
+
+/**
+ * @brief Apaga todos os registros (setores em uso) e deixa montado vazio (testes, reset de fábrica).
+ */
+void rstore_format();
+
+/**
+ * @brief Ocupação (lida na montagem) e contadores cumulativos de gravação, coleta e apagamento.
+ */
+const RecordStoreStats &rstore_getStats();
+
+#ifndef ARDUINO
+/**
+ * @brief Host: bytes da flash simulada (RSTORE_HOST_FLASH_BYTES), para os testes
+ *        cortarem ou corromperem uma gravação como uma queda de energia faria.
+ */
+uint8_t *rstore_hostFlash();
+#endif
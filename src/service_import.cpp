@@ -0,0 +1,442 @@
+#include <Arduino.h> // Para micros()
+#include "service_import.h"
+#include "globals.h"
+#include "config.h"
+#include "base32.h"
+#include "storage.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+// Léxico: um caractere por vez, sem voltar atrás
+enum Lexer : uint8_t { LEX_IDLE, LEX_STRING, LEX_ESCAPE, LEX_UNICODE, LEX_NUMBER, LEX_LITERAL };
+
+enum Token : uint8_t {
+    TOKEN_BEGIN_ARRAY, TOKEN_END_ARRAY, TOKEN_BEGIN_OBJECT, TOKEN_END_OBJECT,
+    TOKEN_COMMA, TOKEN_COLON, TOKEN_STRING, TOKEN_NUMBER, TOKEN_LITERAL
+};
+
+// Gramática: o que pode vir a seguir
+enum Expect : uint8_t {
+    EXPECT_ARRAY,       // '[' inicial
+    EXPECT_FIRST_ENTRY, // '{' ou ']' (array vazio)
+    EXPECT_ENTRY,       // '{' depois de ','
+    EXPECT_NEXT_ENTRY,  // ',' ou ']'
+    EXPECT_FIRST_KEY,   // Chave ou '}' (objeto vazio)
+    EXPECT_KEY,         // Chave depois de ','
+    EXPECT_COLON,
+    EXPECT_VALUE,
+    EXPECT_NEXT_FIELD   // ',' ou '}'
+};
+
+enum Field : uint8_t {
+    FIELD_OTHER, FIELD_NAME, FIELD_SECRET, FIELD_ALGORITHM, FIELD_TYPE, FIELD_DIGITS, FIELD_PERIOD, FIELD_COUNTER
+};
+
+// Entrada em andamento: a única parte do documento guardada
+struct Entry {
+    char name[MAX_SERVICE_NAME_LEN + 1];
+    char secret[MAX_SECRET_B32_LEN + 1];
+    uint64_t counter;
+    uint64_t digits;
+    uint64_t period;
+    OtpAlgorithm algorithm;
+    OtpKind kind;
+    bool has_name;
+    bool has_secret;
+    bool invalid; // Algum campo conhecido fora dos limites ou do tipo errado
+};
+
+static bool active = false;
+static bool closed = false; // ']' final lido, falta gravar
+static bool write_failed = false; // Falha ao selar um segredo: lote descartado
+static Lexer lexer = LEX_IDLE;
+static Expect expect = EXPECT_ARRAY;
+static Field field = FIELD_OTHER;
+static int skip_depth = 0; // > 0: dentro de um objeto ou array aninhado (valor ignorado)
+static Entry entry;
+static ImportStats stats = {0, 0, 0, 0, 0, 0, 0};
+
+// String ou literal em andamento, escrita direto no destino escolhido pela chave
+// (nome ou segredo da entrada, 'key', 'word'); sem destino, só é contada
+static char key[16];
+static char word[8]; // "SHA256", "hotp", literais
+static char *text = nullptr;
+static size_t text_capacity = 0;
+static size_t text_length = 0;
+static bool text_bad = false; // Não coube no destino ou contém '\0'
+static uint32_t unicode = 0;  // Escape \uXXXX em andamento
+static int unicode_digits = 0;
+static uint64_t number = 0;
+static bool number_ok = true; // Inteiro não negativo que cabe em 64 bits
+
+static void begin_text(char *out, size_t capacity) {
+    text = out;
+    text_capacity = capacity;
+    text_length = 0;
+    text_bad = false;
+}
+
+static void put_char(uint8_t c) {
+    if (c == 0) text_bad = true;
+    if (text != nullptr) {
+        if (text_length + 1 < text_capacity) text[text_length] = (char)c;
+        else text_bad = true;
+    }
+    text_length++;
+}
+
+static void end_text() {
+    if (text != nullptr) text[text_length < text_capacity ? text_length : text_capacity - 1] = '\0';
+}
+
+// Escape \uXXXX em UTF-8 (metades de par substituto não formam um caractere: inválido)
+static void put_unicode(uint32_t code) {
+    if (code >= 0xD800 && code <= 0xDFFF) {
+        text_bad = true;
+    } else if (code < 0x80) {
+        put_char((uint8_t)code);
+    } else if (code < 0x800) {
+        put_char((uint8_t)(0xC0 | code >> 6));
+        put_char((uint8_t)(0x80 | (code & 0x3F)));
+    } else {
+        put_char((uint8_t)(0xE0 | code >> 12));
+        put_char((uint8_t)(0x80 | (code >> 6 & 0x3F)));
+        put_char((uint8_t)(0x80 | (code & 0x3F)));
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Destino da string que começa: a chave, ou o campo conhecido cujo valor ela é
+static void begin_string() {
+    if (skip_depth > 0) begin_text(nullptr, 0);
+    else if (expect == EXPECT_FIRST_KEY || expect == EXPECT_KEY) begin_text(key, sizeof(key));
+    else if (expect != EXPECT_VALUE) begin_text(nullptr, 0); // A gramática recusa o token
+    else if (field == FIELD_NAME) begin_text(entry.name, sizeof(entry.name));
+    else if (field == FIELD_SECRET) begin_text(entry.secret, sizeof(entry.secret));
+    else if (field == FIELD_ALGORITHM || field == FIELD_TYPE) begin_text(word, sizeof(word));
+    else begin_text(nullptr, 0);
+}
+
+static Field field_of(const char *name) {
+    if (strcmp(name, JSON_KEY_SERVICE_NAME) == 0) return FIELD_NAME;
+    if (strcmp(name, JSON_KEY_SERVICE_SECRET) == 0) return FIELD_SECRET;
+    if (strcmp(name, JSON_KEY_SERVICE_ALGORITHM) == 0) return FIELD_ALGORITHM;
+    if (strcmp(name, JSON_KEY_SERVICE_TYPE) == 0) return FIELD_TYPE;
+    if (strcmp(name, JSON_KEY_SERVICE_DIGITS) == 0) return FIELD_DIGITS;
+    if (strcmp(name, JSON_KEY_SERVICE_PERIOD) == 0) return FIELD_PERIOD;
+    if (strcmp(name, JSON_KEY_SERVICE_COUNTER) == 0) return FIELD_COUNTER;
+    return FIELD_OTHER;
+}
+
+static void begin_entry() {
+    memset(&entry, 0, sizeof(entry));
+    entry.algorithm = OtpAlgorithm::SHA1; // Padrões da adição unitária
+    entry.kind = OtpKind::TOTP;
+    entry.digits = TOTP_DEFAULT_DIGITS;
+    entry.period = TOTP_INTERVAL_SECONDS;
+}
+
+// Valor de um campo (string, número ou literal). Campos desconhecidos são ignorados.
+static void store_field(Token token) {
+    bool is_text = token == TOKEN_STRING && !text_bad;
+    bool is_number = token == TOKEN_NUMBER && number_ok;
+    switch (field) {
+    case FIELD_NAME:
+        entry.has_name = true;
+        if (!is_text || text_length == 0 || text_length > MAX_SERVICE_NAME_LEN) entry.invalid = true;
+        break;
+    case FIELD_SECRET:
+        entry.has_secret = true;
+        if (!is_text || text_length == 0 || text_length > MAX_SECRET_B32_LEN) entry.invalid = true;
+        break;
+    case FIELD_ALGORITHM:
+        if (is_text && strcasecmp(word, "SHA1") == 0) entry.algorithm = OtpAlgorithm::SHA1;
+        else if (is_text && strcasecmp(word, "SHA256") == 0) entry.algorithm = OtpAlgorithm::SHA256;
+        else if (is_text && strcasecmp(word, "SHA512") == 0) entry.algorithm = OtpAlgorithm::SHA512;
+        else entry.invalid = true;
+        break;
+    case FIELD_TYPE:
+        if (is_text && strcasecmp(word, "totp") == 0) entry.kind = OtpKind::TOTP;
+        else if (is_text && strcasecmp(word, "hotp") == 0) entry.kind = OtpKind::HOTP;
+        else entry.invalid = true;
+        break;
+    case FIELD_DIGITS: entry.digits = number; entry.invalid |= !is_number; break;
+    case FIELD_PERIOD: entry.period = number; entry.invalid |= !is_number; break;
+    case FIELD_COUNTER: entry.counter = number; entry.invalid |= !is_number; break;
+    default: break;
+    }
+}
+
+// O Base32 decodifica? (entradas que não couberam ainda são conferidas, para separar
+// "inválida" de "sem espaço")
+static bool secret_decodes(const char *secret) {
+    uint8_t key_check[MAX_SECRET_BIN_LEN];
+    bool ok = base32_decode((const uint8_t *)secret, strlen(secret), key_check, sizeof(key_check)) > 0;
+    memset(key_check, 0, sizeof(key_check));
+    return ok;
+}
+
+// '}' de uma entrada: valida, decodifica, adiciona e sela o segredo, ou conta como rejeitada.
+// Retorna false se o segredo não pôde ser selado: o lote inteiro é descartado.
+static bool finish_entry() {
+    stats.entries++;
+    bool valid = !entry.invalid && entry.has_name && entry.has_secret &&
+                 (entry.digits == 6 || entry.digits == 8) && entry.period > 0 &&
+                 entry.period <= TOTP_MAX_PERIOD_SECONDS;
+    // Decodifica o Base32 direto para a arena de chaves; sem espaço, nem tenta
+    int id = !valid ? STORAGE_ERR_INVALID_SECRET
+             : service_count < MAX_SERVICES
+                 ? storage_importService(entry.name, entry.secret, entry.algorithm, (uint8_t)entry.digits,
+                                         (uint16_t)entry.period, entry.kind, entry.counter)
+                 : STORAGE_ERR_FULL;
+    if (id == STORAGE_ERR_WRITE) {
+        write_failed = true;
+    } else if (id >= 0) {
+        stats.imported++;
+    } else if (id == STORAGE_ERR_FULL && secret_decodes(entry.secret)) {
+        stats.over_capacity++; // Válida, mas já há MAX_SERVICES serviços
+    } else if (id == STORAGE_ERR_NAME_SPACE) {
+        stats.over_name_space++; // Válida (segredo já decodificado), mas o nome não coube na arena
+    } else {
+        stats.rejected++;
+    }
+    memset(&entry, 0, sizeof(entry)); // O segredo em Base32 não fica na RAM
+    return !write_failed;
+}
+
+// Aplica um token à gramática. Retorna false se o documento não é um array de objetos.
+static bool on_token(Token token) {
+    if (skip_depth > 0) { // Valor composto de um campo: só acompanha o aninhamento
+        if (token == TOKEN_BEGIN_ARRAY || token == TOKEN_BEGIN_OBJECT) skip_depth++;
+        else if ((token == TOKEN_END_ARRAY || token == TOKEN_END_OBJECT) && --skip_depth == 0) expect = EXPECT_NEXT_FIELD;
+        return true;
+    }
+    switch (expect) {
+    case EXPECT_ARRAY:
+        if (token != TOKEN_BEGIN_ARRAY) return false;
+        expect = EXPECT_FIRST_ENTRY;
+        return true;
+    case EXPECT_FIRST_ENTRY:
+    case EXPECT_ENTRY:
+        if (token == TOKEN_END_ARRAY && expect == EXPECT_FIRST_ENTRY) {
+            closed = true;
+            return true;
+        }
+        if (token != TOKEN_BEGIN_OBJECT) return false;
+        begin_entry();
+        expect = EXPECT_FIRST_KEY;
+        return true;
+    case EXPECT_NEXT_ENTRY:
+        if (token == TOKEN_COMMA) expect = EXPECT_ENTRY;
+        else if (token == TOKEN_END_ARRAY) closed = true;
+        else return false;
+        return true;
+    case EXPECT_FIRST_KEY:
+    case EXPECT_KEY:
+        if (token == TOKEN_END_OBJECT && expect == EXPECT_FIRST_KEY) {
+            expect = EXPECT_NEXT_ENTRY;
+            return finish_entry();
+        }
+        if (token != TOKEN_STRING) return false;
+        field = text_bad ? FIELD_OTHER : field_of(key);
+        expect = EXPECT_COLON;
+        return true;
+    case EXPECT_COLON:
+        if (token != TOKEN_COLON) return false;
+        expect = EXPECT_VALUE;
+        return true;
+    case EXPECT_VALUE:
+        if (token == TOKEN_BEGIN_ARRAY || token == TOKEN_BEGIN_OBJECT) {
+            if (field != FIELD_OTHER) entry.invalid = true;
+            skip_depth = 1;
+            return true;
+        }
+        if (token != TOKEN_STRING && token != TOKEN_NUMBER && token != TOKEN_LITERAL) return false;
+        store_field(token);
+        expect = EXPECT_NEXT_FIELD;
+        return true;
+    case EXPECT_NEXT_FIELD:
+        if (token == TOKEN_COMMA) {
+            expect = EXPECT_KEY;
+        } else if (token == TOKEN_END_OBJECT) {
+            expect = EXPECT_NEXT_ENTRY;
+            return finish_entry();
+        } else {
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Consome um caractere. Retorna false em erro de sintaxe.
+static bool step(char c) {
+    switch (lexer) {
+    case LEX_STRING:
+        if (c == '"') {
+            end_text();
+            lexer = LEX_IDLE;
+            return on_token(TOKEN_STRING);
+        }
+        if (c == '\\') {
+            lexer = LEX_ESCAPE;
+            return true;
+        }
+        if ((uint8_t)c < 0x20) return false; // Caractere de controle sem escape
+        put_char((uint8_t)c);
+        return true;
+    case LEX_ESCAPE:
+        lexer = LEX_STRING;
+        switch (c) {
+        case '"': case '\\': case '/': put_char((uint8_t)c); return true;
+        case 'b': put_char('\b'); return true;
+        case 'f': put_char('\f'); return true;
+        case 'n': put_char('\n'); return true;
+        case 'r': put_char('\r'); return true;
+        case 't': put_char('\t'); return true;
+        case 'u': unicode = 0; unicode_digits = 0; lexer = LEX_UNICODE; return true;
+        default: return false;
+        }
+    case LEX_UNICODE: {
+        int value = hex_value(c);
+        if (value < 0) return false;
+        unicode = unicode << 4 | (uint32_t)value;
+        if (++unicode_digits == 4) {
+            put_unicode(unicode);
+            lexer = LEX_STRING;
+        }
+        return true;
+    }
+    case LEX_NUMBER:
+        if (c >= '0' && c <= '9') {
+            uint32_t digit = (uint32_t)(c - '0');
+            if (number > (UINT64_MAX - digit) / 10) number_ok = false;
+            else number = number * 10 + digit;
+            return true;
+        }
+        if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') { // Fração ou expoente: não é um inteiro aceito
+            number_ok = false;
+            return true;
+        }
+        lexer = LEX_IDLE;
+        if (!on_token(TOKEN_NUMBER)) return false;
+        break; // O caractere que terminou o número é tratado abaixo
+    case LEX_LITERAL:
+        if (c >= 'a' && c <= 'z') {
+            put_char((uint8_t)c);
+            return true;
+        }
+        end_text();
+        lexer = LEX_IDLE;
+        if (text_bad || (strcmp(word, "true") != 0 && strcmp(word, "false") != 0 && strcmp(word, "null") != 0)) return false;
+        if (!on_token(TOKEN_LITERAL)) return false;
+        break;
+    default:
+        break;
+    }
+    switch (c) {
+    case ' ': case '\t': case '\r': case '\n': return true;
+    case '[': return on_token(TOKEN_BEGIN_ARRAY);
+    case ']': return on_token(TOKEN_END_ARRAY);
+    case '{': return on_token(TOKEN_BEGIN_OBJECT);
+    case '}': return on_token(TOKEN_END_OBJECT);
+    case ',': return on_token(TOKEN_COMMA);
+    case ':': return on_token(TOKEN_COLON);
+    case '"':
+        begin_string();
+        lexer = LEX_STRING;
+        return true;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            number = c == '-' ? 0 : (uint64_t)(c - '0');
+            number_ok = c != '-'; // Negativo: nenhum campo aceita
+            lexer = LEX_NUMBER;
+            return true;
+        }
+        if (c >= 'a' && c <= 'z') {
+            begin_text(word, sizeof(word));
+            put_char((uint8_t)c);
+            lexer = LEX_LITERAL;
+            return true;
+        }
+        return false;
+    }
+}
+
+static void reset_parser() {
+    closed = false;
+    write_failed = false;
+    lexer = LEX_IDLE;
+    expect = EXPECT_ARRAY;
+    field = FIELD_OTHER;
+    skip_depth = 0;
+    text = nullptr;
+    memset(&entry, 0, sizeof(entry));
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void import_begin() {
+    import_cancel();
+    reset_parser();
+    stats = {0, 0, 0, 0, 0, 0, 0};
+    active = true;
+}
+
+ImportStatus import_feed(const char *data, size_t length) {
+    if (!active) return ImportStatus::FAILED;
+    uint32_t start_us = micros();
+    size_t used = 0;
+    bool ok = true;
+    while (ok && !closed && used < length) ok = step(data[used++]);
+    stats.bytes += used;
+    stats.parse_us += micros() - start_us;
+    if (!ok && write_failed) {
+        Serial.println("[IMPORT] Falha ao selar um segredo: lote descartado.");
+        import_cancel();
+        return ImportStatus::FAILED;
+    }
+    if (!ok) {
+        Serial.printf("[IMPORT] JSON inválido no byte %lu: lote descartado.\n", (unsigned long)stats.bytes);
+        import_cancel();
+        return ImportStatus::FAILED;
+    }
+    if (!closed) return ImportStatus::RUNNING;
+
+    active = false;
+    start_us = micros();
+    bool committed = storage_importCommit(); // Uma única gravação do cofre para o lote
+    stats.commit_us = micros() - start_us;
+    reset_parser();
+    if (!committed) {
+        stats.imported = 0;
+        return ImportStatus::FAILED;
+    }
+    return ImportStatus::DONE;
+}
+
+void import_cancel() {
+    if (!active) return;
+    storage_importAbort();
+    reset_parser();
+    stats.imported = 0;
+    active = false;
+}
+
+bool import_isActive() {
+    return active;
+}
+
+const ImportStats &import_getStats() {
+    return stats;
+}
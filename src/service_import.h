@@ -0,0 +1,53 @@
+#pragma once // Include guard
+
+#include <stddef.h> // Para size_t
+#include <stdint.h> // Para uint8_t
+#include "types.h"  // Para ImportStats
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DA IMPORTAÇÃO EM LOTE ===
+// ============================================================================
+// Importa um array JSON de serviços ([{"name":..,"secret":..}, ...], com os mesmos
+// campos opcionais da adição unitária) de qualquer tamanho, sem guardar o documento:
+// o parser consome os bytes conforme chegam e só mantém a entrada em andamento
+// (nome, segredo Base32 e parâmetros, ~150 bytes). Cada objeto é validado, decodificado
+// e tem o segredo selado na partição assim que o '}' chega (storage_importService); o ']'
+// final grava o índice com o lote inteiro de uma vez (storage_importCommit). Entradas
+// inválidas, ou válidas mas sem espaço (MAX_SERVICES atingido ou nome que não cabe na
+// arena de nomes, contados em separado), são contadas e puladas; JSON malformado ou falha ao selar descarta o lote inteiro.
+
+enum class ImportStatus : uint8_t {
+  RUNNING, // Documento ainda aberto: continuar alimentando
+  DONE,    // ']' final lido e lote gravado
+  FAILED   // JSON malformado, cancelado ou falha na gravação: nada do lote ficou no cofre
+};
+
+/**
+ * @brief Começa um novo documento (cancela o anterior, se ainda aberto) e zera as estatísticas.
+ */
+void import_begin();
+
+/**
+ * @brief Consome os próximos bytes do documento. Ao ler o ']' final, grava o lote e para:
+ *        os bytes depois dele não são consumidos (ver ImportStats::bytes).
+ * @param data Bytes recebidos (não precisam terminar num token).
+ * @param length Número de bytes.
+ * @return Estado do documento depois destes bytes (FAILED também se não há importação aberta).
+ */
+ImportStatus import_feed(const char *data, size_t length);
+
+/**
+ * @brief Cancela o documento aberto (ex: a Serial parou de enviar): os serviços já
+ *        adicionados pelo lote saem da RAM e nada é gravado.
+ */
+void import_cancel();
+
+/**
+ * @brief Há um documento aberto, esperando mais bytes?
+ */
+bool import_isActive();
+
+/**
+ * @brief Contadores e tempos do último documento (ou do atual, se ainda aberto).
+ */
+const ImportStats &import_getStats();
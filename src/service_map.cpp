@@ -0,0 +1,70 @@
+#include <string.h>
+#include "service_map.h"
+#include "globals.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+static_assert(MAX_SERVICES <= UINT16_MAX, "ids e posições cabem em uint16_t");
+
+static uint16_t order[MAX_SERVICES];    // Ids vivos na ordem de exibição ('service_count' válidos)
+static uint16_t position[MAX_SERVICES]; // Posição de cada id vivo em 'order'
+static bool live[MAX_SERVICES];
+static uint16_t free_ids[MAX_SERVICES]; // Pilha de ids liberados
+static int free_top = 0;
+static int high_water = 0;             // Ids [0, high_water) já usados alguma vez
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void svcmap_clear() {
+    memset(live, 0, sizeof(live));
+    free_top = 0;
+    high_water = 0;
+    service_count = 0;
+}
+
+int svcmap_alloc() {
+    if (service_count >= MAX_SERVICES) return -1;
+    int id = free_top > 0 ? free_ids[--free_top] : high_water++;
+    live[id] = true;
+    position[id] = (uint16_t)service_count;
+    order[service_count++] = (uint16_t)id;
+    return id;
+}
+
+bool svcmap_release(int id) {
+    if (!svcmap_isLive(id)) return false;
+    live[id] = false;
+    free_ids[free_top++] = (uint16_t)id;
+    service_count--;
+    for (int p = position[id]; p < service_count; p++) {
+        order[p] = order[p + 1];
+        position[order[p]] = (uint16_t)p;
+    }
+    return true;
+}
+
+bool svcmap_isLive(int id) {
+    return id >= 0 && id < high_water && live[id];
+}
+
+int svcmap_slots() {
+    return high_water;
+}
+
+int svcmap_at(int pos) {
+    return pos >= 0 && pos < service_count ? order[pos] : -1;
+}
+
+int svcmap_positionOf(int id) {
+    return svcmap_isLive(id) ? position[id] : -1;
+}
+
+int svcmap_step(int id, int delta) {
+    if (!svcmap_isLive(id)) return -1;
+    int p = (position[id] + delta % service_count + service_count) % service_count;
+    return order[p];
+}
@@ -0,0 +1,60 @@
+#pragma once // Include guard
+
+#include "config.h" // Para MAX_SERVICES
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DO MAPA DE SERVIÇOS ===
+// ============================================================================
+// Cada serviço ocupa um id estável (0 a MAX_SERVICES - 1) do nascimento até ser
+// removido: 'services', as arenas de chaves e nomes, a tabela de códigos, a linha
+// do tempo e o journal HOTP são indexados por esse id, e current_service_index
+// guarda um id. Remover libera só o id removido (pilha de ids livres, O(1)); os
+// demais serviços não mudam de id nem são tocados. A ordem de exibição fica num
+// vetor separado de ids, o único que se desloca (100 bytes no máximo).
+// 'service_count' continua sendo o número de serviços vivos.
+
+/**
+ * @brief Esvazia o mapa (nenhum id vivo, service_count = 0). Chamar antes de recarregar os serviços.
+ */
+void svcmap_clear();
+
+/**
+ * @brief Reserva um id livre (o último liberado, ou um nunca usado) no fim da ordem de exibição.
+ * @return Id do novo serviço, ou -1 se já há MAX_SERVICES serviços.
+ */
+int svcmap_alloc();
+
+/**
+ * @brief Libera o id (ele sai da ordem de exibição e pode ser reutilizado pelo próximo alloc).
+ * @return false se o id não está vivo.
+ */
+bool svcmap_release(int id);
+
+/**
+ * @brief O id pertence a um serviço carregado?
+ */
+bool svcmap_isLive(int id);
+
+/**
+ * @brief Limite dos ids já usados (todo id vivo é menor que isto). Laços sobre os
+ *        arrays por id vão até aqui e pulam os ids que não estão vivos.
+ */
+int svcmap_slots();
+
+/**
+ * @brief Id do serviço na posição dada da ordem de exibição (0 <= position < service_count).
+ * @return Id, ou -1 se a posição não existe.
+ */
+int svcmap_at(int position);
+
+/**
+ * @brief Posição do id na ordem de exibição (O(1)).
+ * @return Posição, ou -1 se o id não está vivo.
+ */
+int svcmap_positionOf(int id);
+
+/**
+ * @brief Id 'delta' posições adiante (ou atrás, se negativo) na ordem de exibição, dando a volta.
+ * @return Id vizinho, ou -1 se o id não está vivo.
+ */
+int svcmap_step(int id, int delta);
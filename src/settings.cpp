@@ -0,0 +1,129 @@
+#include "settings.h"
+#include "globals.h"
+#include "config.h"
+#include "i18n.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+static const uint8_t SETTINGS_VERSION = 1;
+static const int TZ_MIN_HOURS = -12;
+static const int TZ_MAX_HOURS = 14;
+
+static Settings settings = {SETTINGS_VERSION, (uint8_t)Language::PT_BR, 0, 0};
+static bool dirty = false;          // Mudança em RAM ainda não gravada
+static bool legacy_keys = false;    // Chaves antigas a apagar na próxima gravação
+static uint32_t changed_ms = 0;     // millis() da última mudança
+static SettingsStats settings_stats = {0, 0, 0};
+
+// Aplica as configurações aos globais usados pela UI
+static void apply() {
+    current_language = (Language)settings.language;
+    gmt_offset_hours = settings.gmt_offset_hours;
+}
+
+// Corrige valores fora da faixa (registro de outra versão ou chaves antigas inválidas)
+static void sanitize() {
+    if (settings.language >= NUM_LANGUAGES) {
+        Serial.printf("[WARN] Idioma NVS inválido (%d), usando padrão.\n", settings.language);
+        settings.language = (uint8_t)Language::PT_BR;
+    }
+    if (settings.gmt_offset_hours < TZ_MIN_HOURS || settings.gmt_offset_hours > TZ_MAX_HOURS) {
+        Serial.printf("[WARN] Fuso NVS inválido (%d), usando GMT+0.\n", settings.gmt_offset_hours);
+        settings.gmt_offset_hours = 0;
+    }
+    settings.version = SETTINGS_VERSION;
+    settings.reserved = 0;
+}
+
+static void mark_dirty() {
+    if (dirty) settings_stats.coalesced++; // A gravação pendente passa a levar esta mudança também
+    dirty = true;
+    changed_ms = millis();
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+void settings_load() {
+    settings = {SETTINGS_VERSION, (uint8_t)Language::PT_BR, 0, 0};
+    dirty = legacy_keys = false;
+    if (preferences.begin("totp-app", true)) {
+        Settings stored;
+        settings_stats.reads++;
+        if (preferences.getBytes(NVS_KEY_SETTINGS, &stored, sizeof(stored)) == sizeof(stored) &&
+            stored.version == SETTINGS_VERSION) {
+            settings = stored;
+        } else if (preferences.isKey(NVS_KEY_LANGUAGE) || preferences.isKey(NVS_KEY_TZ_OFFSET)) {
+            // Formato antigo (uma chave por configuração): lido só neste boot
+            settings_stats.reads += 2;
+            settings.language = (uint8_t)preferences.getInt(NVS_KEY_LANGUAGE, (int)Language::PT_BR);
+            settings.gmt_offset_hours = (int8_t)preferences.getInt(NVS_KEY_TZ_OFFSET, 0);
+            legacy_keys = true;
+            mark_dirty();
+        }
+        preferences.end();
+    }
+    sanitize();
+    apply();
+}
+
+const Settings &settings_get() {
+    return settings;
+}
+
+void settings_setLanguage(Language language) {
+    if ((uint8_t)language >= NUM_LANGUAGES) return;
+    current_language = language;
+    if (settings.language == (uint8_t)language) return;
+    settings.language = (uint8_t)language;
+    mark_dirty();
+}
+
+bool settings_setTimezone(int offset_hours) {
+    if (offset_hours < TZ_MIN_HOURS || offset_hours > TZ_MAX_HOURS) return false;
+    gmt_offset_hours = offset_hours;
+    if (settings.gmt_offset_hours != offset_hours) {
+        settings.gmt_offset_hours = (int8_t)offset_hours;
+        mark_dirty();
+    }
+    return true;
+}
+
+void settings_tick(uint32_t now_ms) {
+    if (dirty && now_ms - changed_ms >= SETTINGS_WRITE_DELAY_MS) settings_flush();
+}
+
+bool settings_flush() {
+    if (!dirty) return true;
+    if (!preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return false;
+    }
+    bool ok = preferences.putBytes(NVS_KEY_SETTINGS, &settings, sizeof(settings)) == sizeof(settings);
+    if (ok && legacy_keys) { // Registro gravado: as chaves antigas não são mais lidas
+        preferences.remove(NVS_KEY_LANGUAGE);
+        preferences.remove(NVS_KEY_TZ_OFFSET);
+        legacy_keys = false;
+    }
+    preferences.end();
+    if (!ok) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        changed_ms = millis(); // Nova tentativa depois de mais um intervalo
+        return false;
+    }
+    dirty = false;
+    settings_stats.writes++;
+    Serial.printf("[NVS] Configurações salvas: idioma %d, fuso GMT%+d\n", settings.language, settings.gmt_offset_hours);
+    return true;
+}
+
+bool settings_pending() {
+    return dirty;
+}
+
+const SettingsStats &settings_getStats() {
+    return settings_stats;
+}
@@ -0,0 +1,61 @@
+#pragma once // Include guard
+
+#include <stdint.h> // Para uint32_t
+#include "types.h"  // Para Settings, SettingsStats, Language
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DAS CONFIGURAÇÕES (CACHE COM GRAVAÇÃO ADIADA) ===
+// ============================================================================
+// Todas as configurações (idioma e fuso) ficam numa struct em RAM e no NVS
+// num único registro (NVS_KEY_SETTINGS), lido uma vez no boot. Mudar uma
+// configuração só altera a RAM (e os globais current_language e
+// gmt_offset_hours); settings_tick() grava o registro inteiro quando ele está
+// SETTINGS_WRITE_DELAY_MS sem mudar, então uma sequência de ajustes custa uma
+// só gravação. Uma queda de energia dentro desse intervalo perde só o último ajuste.
+
+/**
+ * @brief Lê o registro (uma leitura do NVS) e aplica idioma e fuso aos globais.
+ *        Sem registro, lê as chaves antigas NVS_KEY_LANGUAGE/NVS_KEY_TZ_OFFSET uma vez e
+ *        agenda a gravação do registro (as chaves antigas são apagadas junto).
+ *        Valores fora da faixa voltam ao padrão (PT_BR, GMT+0).
+ */
+void settings_load();
+
+/**
+ * @brief Configurações atuais (em RAM, gravadas ou não).
+ */
+const Settings &settings_get();
+
+/**
+ * @brief Altera o idioma (RAM e current_language) e agenda a gravação.
+ */
+void settings_setLanguage(Language language);
+
+/**
+ * @brief Altera o fuso (RAM e gmt_offset_hours) e agenda a gravação.
+ * @return false se estiver fora de -12 a +14 (nada muda).
+ */
+bool settings_setTimezone(int gmt_offset_hours);
+
+/**
+ * @brief Grava o registro se houver mudança pendente há pelo menos SETTINGS_WRITE_DELAY_MS.
+ *        Chamar na atualização regular (500 ms).
+ * @param now_ms millis() atual.
+ */
+void settings_tick(uint32_t now_ms);
+
+/**
+ * @brief Grava já a mudança pendente, se houver (antes de desligar ou reiniciar).
+ * @return true se não havia nada pendente ou se a gravação deu certo.
+ */
+bool settings_flush();
+
+/**
+ * @brief Há mudança ainda não gravada?
+ */
+bool settings_pending();
+
+/**
+ * @brief Leituras, gravações e mudanças coalescidas.
+ */
+const SettingsStats &settings_getStats();
@@ -8,142 +8,1084 @@
 #include "ui.h"
 #include "types.h"
 #include "totp.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "hotp_journal.h"
+#include "verifier.h"
+#include "storage.h"
+#include "crc32.h"
+#include "base32.h"
+#include "record_store.h"
+#include "crypto/aes_backend.h"
+#include "crypto/aes_gcm.h"
+#include "crypto/pbkdf2.h"
 
 // Storage (NVS)
 void loadServices();
 bool storage_saveServiceList();
-bool storage_saveService(const char *, const char *);
+bool storage_saveService(const char *, const char *, OtpAlgorithm, uint8_t, uint16_t, OtpKind, uint64_t);
 bool storage_deleteService(int);
 
-void loadServices() {
-    if (!preferences.begin("totp-app", true)) { // Abre NVS no modo somente leitura
-        Serial.println(getText(STR_ERROR_NVS_LOAD));
-        service_count = 0; // Zera contagem se não conseguir ler
-        return;
+// Parâmetros OTP de um serviço empacotados em um único uint32 (campo 'params' do cofre):
+// bits 0-6 algoritmo, bit 7 HOTP, 8-15 dígitos, 16-31 período. No formato antigo ficavam em
+// "svc_%d_params"; serviços gravados antes dessa chave existir assumem o padrão TOTP SHA1/6/30.
+static const uint32_t PARAMS_HOTP_FLAG = 0x80;
+
+static uint32_t pack_service_params(const TOTPService &service) {
+    return (uint32_t)service.algorithm | (service.kind == OtpKind::HOTP ? PARAMS_HOTP_FLAG : 0) |
+           ((uint32_t)service.digits << 8) | ((uint32_t)service.period << 16);
+}
+
+static const uint32_t DEFAULT_SERVICE_PARAMS =
+    (uint32_t)OtpAlgorithm::SHA1 | ((uint32_t)TOTP_DEFAULT_DIGITS << 8) | ((uint32_t)TOTP_INTERVAL_SECONDS << 16);
+
+// Desempacota e valida; parâmetros fora do suportado voltam ao padrão
+static void unpack_service_params(uint32_t packed, const char *name, TOTPService *service) {
+    OtpKind kind = (packed & PARAMS_HOTP_FLAG) ? OtpKind::HOTP : OtpKind::TOTP;
+    uint8_t algorithm = packed & 0x7F;
+    uint8_t digits = (packed >> 8) & 0xFF;
+    uint16_t period = packed >> 16;
+    if (algorithm > (uint8_t)OtpAlgorithm::SHA512 || (digits != 6 && digits != 8) ||
+        period == 0 || period > TOTP_MAX_PERIOD_SECONDS) {
+        Serial.printf("[WARN] Parâmetros OTP inválidos para '%s' (0x%08lx). Usando padrão.\n",
+                      name, (unsigned long)packed);
+        packed = DEFAULT_SERVICE_PARAMS;
+        kind = OtpKind::TOTP;
+        algorithm = packed & 0x7F;
+        digits = (packed >> 8) & 0xFF;
+        period = packed >> 16;
+    }
+    service->algorithm = (OtpAlgorithm)algorithm;
+    service->digits = digits;
+    service->period = period;
+    service->kind = kind;
+}
+
+// ============================================================================
+// === ÍNDICE DO COFRE EM UMA IMAGEM ===
+// ============================================================================
+// O índice de todos os serviços é uma só imagem: VaultHeader seguido de 'count' registros,
+//   name_len (1) | params (4) | counter (8, só HOTP) | secret_id (4) | nome
+// O nome vai sem '\0'. Os segredos não estão no índice: cada um é um registro
+// do armazenamento em log da partição "vault" (record_store.h), com o secret_id
+// como id, cifrado com AES-256-GCM (ver CHAVE DA SESSÃO) e lido e decifrado só
+// quando um código daquele serviço é pedido (storage_fetchSecret). Assim o boot
+// lê só nomes e parâmetros, e nenhum segredo entra na RAM antes de ser usado.
+// O CRC-32 cobre 'log_seq', 'commit' e todos os registros: magic, versão, tamanho
+// ou CRC errados invalidam a imagem inteira, e nada é carregado pela metade.
+//
+// Com MAX_SERVICES serviços a imagem não cabe no NVS (partição de 20 KB): desde a
+// versão 7 ela é gravada em pedaços, registros de até RSTORE_MAX_RECORD_LEN bytes da
+// partição "vault" com ids VAULT_INDEX_ID_BASE | slot << 8 | pedaço. O pedaço 0 começa
+// com o VaultHeader; cada pedaço leva só registros inteiros, e o boot os lê um a um
+// (um buffer de um pedaço), até somar 'payload_len'.
+//
+// Commit A/B: a imagem nunca é regravada no lugar. O commit 'n' vai para o slot
+// inativo (slot 0 se 'n' é par, 1 se ímpar) e só depois NVS_KEY_VAULT_HEAD passa a
+// valer 'n' (um putUInt, uma entrada do NVS). Queda
+// antes da virada: o cabeçalho ainda aponta para o commit anterior, intacto no
+// outro slot. O boot lê o cabeçalho e exatamente uma imagem, a do slot que ele
+// indica, e confere que ela é mesmo o commit 'n'; só se essa imagem for inválida
+// (flash corrompida) lê o outro slot, que tem de ser o commit 'n - 1'.
+//
+// Versões 1 e 2 traziam a chave dentro de cada registro (name_len | key_len |
+// params | counter | nome | chave); a versão 3 tinha o índice atual, mas com os
+// segredos em claro ("sk_%u"), e a versão 4 com os segredos já cifrados, mas em
+// chaves "se_%u" do NVS. Todas são lidas uma vez e migradas para o formato atual.
+// Até a versão 5 não havia slots: a imagem ficava sempre em NVS_KEY_VAULT, que é
+// o slot do commit 0 (cabeçalho ausente), e o primeiro commit A/B vai para o outro.
+// Até a versão 6 a imagem de cada slot era um blob do NVS (NVS_KEY_VAULT e
+// NVS_KEY_VAULT_B, no máximo LEGACY_MAX_SERVICES serviços): o boot ainda o lê se o
+// slot não tem pedaços, e cada commit apaga o blob do slot que acabou de gravar.
+struct VaultHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t count;       // Número de registros
+    uint32_t payload_len; // Bytes após o cabeçalho
+    uint32_t crc;         // CRC-32 de 'log_seq' e dos registros
+    uint32_t log_seq;     // Primeira entrada do log ainda não incluída no blob (desde a versão 2)
+    uint32_t commit;      // Número do commit A/B desta imagem (desde a versão 6)
+};
+
+static const uint32_t VAULT_MAGIC = 0x544C5656; // "VVLT"
+static const uint8_t VAULT_VERSION = 7;
+static const size_t VAULT_V1_HEADER_SIZE = 16;  // Versão 1: sem 'log_seq', CRC só dos registros
+static const size_t VAULT_V2_HEADER_SIZE = 20;  // Versões 2 a 5: sem 'commit'
+static const size_t VAULT_RECORD_MAX = 1 + 4 + 8 + 4 + MAX_SERVICE_NAME_LEN;
+static const size_t VAULT_KEYED_RECORD_MAX = 2 + 4 + 8 + MAX_SERVICE_NAME_LEN + MAX_SECRET_BIN_LEN; // Versões 1 e 2
+static const int LEGACY_MAX_SERVICES = 100;     // Limite das versões até a 6 (blob no NVS)
+static const size_t VAULT_MAX_BYTES = sizeof(VaultHeader) + LEGACY_MAX_SERVICES * VAULT_KEYED_RECORD_MAX;
+static const size_t VAULT_CHUNK_RECORDS = (RSTORE_MAX_RECORD_LEN - sizeof(VaultHeader)) / VAULT_RECORD_MAX;
+
+// Um pedaço fecha quando o maior registro possível não cabe mais: todo pedaço leva ao
+// menos VAULT_CHUNK_RECORDS registros, e a imagem cheia cabe no slot
+static_assert((MAX_SERVICES + VAULT_CHUNK_RECORDS - 1) / VAULT_CHUNK_RECORDS <= VAULT_INDEX_MAX_CHUNKS,
+              "VAULT_INDEX_MAX_CHUNKS não comporta MAX_SERVICES registros");
+static_assert(VAULT_INDEX_MAX_CHUNKS <= 256, "o pedaço ocupa 8 bits do id do registro");
+
+static uint8_t vault_buf[VAULT_MAX_BYTES]; // Blob do NVS (até a versão 6); zerado após cada uso (formato antigo contém chaves)
+static uint8_t chunk_buf[RSTORE_MAX_RECORD_LEN]; // Um pedaço da imagem na partição (versão 7)
+static uint32_t next_secret_id = 0;        // Próximo secret_id livre (maior id carregado ou citado no journal HOTP + 1)
+static bool secrets_unsaved = false;       // Serviços lidos de um formato antigo: índice ainda a regravar
+static int unsealed_secrets = 0;           // Segredos do formato antigo ainda sem registro cifrado
+static bool sealing_on_load = false;       // Segunda leitura da migração: segredos antigos selados ao ler
+static bool plain_secret_keys = false;     // Cofre versão 3: "sk_%u" em claro a apagar após a migração
+static bool nvs_sealed_secrets = false;    // Cofre versão 4: "se_%u" cifrados a mover para a partição
+static uint32_t vault_commit = 0;          // Commit carregado ou gravado por último (o próximo vai para o outro slot)
+
+static void stage_old_secret(int id, const uint8_t *key, size_t length); // Ver "CHAVE DA SESSÃO"
+
+static const char *vault_slot_key(uint32_t commit) {
+    return (commit & 1) ? NVS_KEY_VAULT_B : NVS_KEY_VAULT;
+}
+
+static uint32_t vault_chunk_id(uint32_t commit, int chunk) {
+    return VAULT_INDEX_ID_BASE | ((commit & 1) << 8) | (uint32_t)chunk;
+}
+
+// ============================================================================
+// === LOG INCREMENTAL DO COFRE ===
+// ============================================================================
+// Adicionar ou deletar um serviço não regrava o cofre: grava só uma entrada
+// pequena num anel de VAULT_LOG_SLOTS chaves "vlog_%d" (slot = seq % slots).
+//   ADD: o registro do novo serviço, no mesmo formato do blob (entra no fim da lista);
+//        o segredo vai antes para o seu registro na partição "vault"
+//   DEL: só o secret_id removido (tombstone); o registro do segredo é removido em seguida.
+//        O secret_id não depende da posição nem do id em RAM, então a entrada não
+//        menciona nenhum outro serviço. Entradas antigas (posição removida) continuam legíveis
+// No boot, o blob é carregado e as entradas a partir de 'log_seq' são reaplicadas
+// em ordem, o que reconstrói exatamente a lista em RAM. A sequência para na
+// primeira entrada ausente, de outra volta do anel ou com CRC errado (gravação
+// interrompida). A compactação regrava o blob com 'log_seq' = próxima entrada,
+// o que descarta o log inteiro de uma vez; roda em storage_tick() quando metade
+// do anel está ocupada, e só de forma síncrona se o anel encher antes disso.
+// As chaves antigas do log são apagadas depois, uma por tick.
+struct VaultLogEntry {
+    uint32_t seq;
+    uint8_t op;           // VAULT_LOG_ADD, VAULT_LOG_DEL_ID (ou VAULT_LOG_ADD_KEYED e VAULT_LOG_DEL, só lidos)
+    uint8_t reserved;
+    uint16_t index;       // Posição do serviço na ordem de exibição (informativo; DEL antigo: posição removida)
+    uint32_t crc;         // CRC-32 de seq/op/index e do registro
+};
+
+static const uint8_t VAULT_LOG_ADD_KEYED = 1; // Registro com a chave embutida (só lido, para migração)
+static const uint8_t VAULT_LOG_DEL = 2;       // Por posição na lista (só lido)
+static const uint8_t VAULT_LOG_ADD = 3;
+static const uint8_t VAULT_LOG_DEL_ID = 4;    // Registro = secret_id do serviço removido
+
+static uint32_t log_seq = 0;       // Primeira entrada fora do blob
+static uint32_t log_next = 0;      // Próxima entrada a gravar (log_next - log_seq = entradas vivas)
+static uint32_t log_stale_from = 0; // Entradas [log_stale_from, log_seq) já compactadas, ainda no NVS
+static bool vault_rewrite_needed = true; // Sem blob válido: a próxima mudança grava o cofre inteiro
+static StorageStats storage_stats = {0, 0, 0, 0, 0, 0, 0, 0};
+
+static void nvs_secret_key(uint32_t secret_id, char *key, size_t size) {
+    snprintf(key, size, "se_%u", (unsigned)secret_id);
+}
+
+static void plain_secret_key(uint32_t secret_id, char *key, size_t size) {
+    snprintf(key, size, "sk_%u", (unsigned)secret_id);
+}
+
+static void log_key(uint32_t seq, char *key, size_t size) {
+    snprintf(key, size, "vlog_%u", (unsigned)(seq % VAULT_LOG_SLOTS));
+}
+
+static uint32_t log_entry_crc(const VaultLogEntry &entry, const uint8_t *record, size_t record_len) {
+    uint32_t crc = crc32_update((const uint8_t *)&entry.seq, sizeof(entry.seq));
+    crc = crc32_update(&entry.op, sizeof(entry.op), crc);
+    crc = crc32_update((const uint8_t *)&entry.index, sizeof(entry.index), crc);
+    return crc32_update(record, record_len, crc);
+}
+
+// Empacota o registro do serviço de id 'index' em 'out'. Retorna o tamanho.
+static size_t serialize_record(int index, uint8_t *out) {
+    const TOTPService &service = services[index];
+    uint8_t name_len = (uint8_t)namestore_length(index);
+    uint32_t params = pack_service_params(service);
+    size_t pos = 0;
+    out[pos++] = name_len;
+    memcpy(&out[pos], &params, sizeof(params));
+    pos += sizeof(params);
+    if (service.kind == OtpKind::HOTP) {
+        memcpy(&out[pos], &service.counter, sizeof(uint64_t));
+        pos += sizeof(uint64_t);
+    }
+    memcpy(&out[pos], &service.secret_id, sizeof(uint32_t));
+    pos += sizeof(uint32_t);
+    memcpy(&out[pos], namestore_get(index), name_len);
+    return pos + name_len;
+}
+
+// Lê um registro de 'data' (até 'length' bytes) para um id novo, no fim da ordem de exibição.
+// No formato atual o id fica sem chave residente; no antigo ('keyed') a chave embutida entra
+// na arena e ganha um secret_id novo, gravado depois pela migração.
+// Retorna os bytes consumidos, ou 0 se o registro for inválido.
+static size_t parse_record(const uint8_t *data, size_t length, bool keyed) {
+    if (length < (keyed ? 6u : 5u)) return 0;
+    size_t pos = 0;
+    uint8_t name_len = data[pos++];
+    uint8_t key_len = keyed ? data[pos++] : 0;
+    uint32_t params;
+    memcpy(&params, &data[pos], sizeof(params));
+    pos += sizeof(params);
+    bool hotp = (params & PARAMS_HOTP_FLAG) != 0;
+    size_t needed = (hotp ? sizeof(uint64_t) : 0) + (keyed ? 0 : sizeof(uint32_t)) + name_len + key_len;
+    if (name_len == 0 || name_len > MAX_SERVICE_NAME_LEN || pos + needed > length) return 0;
+    int id = svcmap_alloc();
+    if (id < 0) return 0; // Lista cheia
+    TOTPService &service = services[id];
+    service.counter = 0;
+    if (hotp) {
+        memcpy(&service.counter, &data[pos], sizeof(uint64_t));
+        pos += sizeof(uint64_t);
+    }
+    if (!keyed) {
+        memcpy(&service.secret_id, &data[pos], sizeof(uint32_t));
+        pos += sizeof(uint32_t);
+    }
+    if (!namestore_set(id, (const char *)&data[pos], name_len)) {
+        svcmap_release(id);
+        return 0;
+    }
+    pos += name_len;
+    unpack_service_params(params, namestore_get(id), &service);
+    if (service.kind != OtpKind::HOTP) service.counter = 0;
+    if (keyed) {
+        service.secret_id = next_secret_id++;
+        stage_old_secret(id, &data[pos], key_len);
+        pos += key_len;
+    } else if (service.secret_id >= next_secret_id) {
+        next_secret_id = service.secret_id + 1;
+    }
+    return pos;
+}
+
+// Id do serviço com o secret_id dado, ou -1
+static int find_secret(uint32_t secret_id) {
+    int slots = svcmap_slots();
+    for (int i = 0; i < slots; i++) {
+        if (svcmap_isLive(i) && services[i].secret_id == secret_id) return i;
+    }
+    return -1;
+}
+
+// Remoção durante o load (antes da tabela de códigos e do journal existirem)
+static void replay_delete(int id) {
+    svcmap_release(id);
+    memset(&services[id], 0, sizeof(TOTPService));
+    keystore_evict(id);
+    namestore_remove(id);
+}
+
+// Grava a imagem do índice (commit 'commit') a partir de 'services', na ordem de exibição,
+// nos pedaços do slot do commit. Duas passadas: a primeira só calcula tamanho e CRC (RAM),
+// para o cabeçalho ir no pedaço 0. Retorna o número de pedaços gravados, ou 0 se falhou.
+static int vault_write_image(uint32_t first_log_seq, uint32_t commit) {
+    uint8_t record[VAULT_RECORD_MAX];
+    uint32_t crc = crc32_update((const uint8_t *)&first_log_seq, sizeof(first_log_seq));
+    crc = crc32_update((const uint8_t *)&commit, sizeof(commit), crc);
+    uint32_t payload_len = 0;
+    for (int p = 0; p < service_count; p++) {
+        size_t length = serialize_record(svcmap_at(p), record);
+        crc = crc32_update(record, length, crc);
+        payload_len += length;
+    }
+    VaultHeader header = {VAULT_MAGIC, VAULT_VERSION, 0, (uint16_t)service_count, payload_len, crc, first_log_seq, commit};
+    memcpy(chunk_buf, &header, sizeof(header));
+    size_t pos = sizeof(header);
+    int chunk = 0;
+    for (int p = 0; p < service_count; p++) {
+        if (pos + VAULT_RECORD_MAX > sizeof(chunk_buf)) { // Só registros inteiros em cada pedaço
+            if (!rstore_put(vault_chunk_id(commit, chunk++), chunk_buf, pos)) return 0;
+            pos = 0;
+        }
+        pos += serialize_record(svcmap_at(p), &chunk_buf[pos]);
+    }
+    return rstore_put(vault_chunk_id(commit, chunk++), chunk_buf, pos) ? chunk : 0;
+}
+
+// Lê a imagem do commit 'commit' dos pedaços do slot dele, um por vez, para 'services'.
+// Retorna false se o slot não tem pedaços, se eles são de outro commit ou se a imagem é
+// inválida (a lista pode ter ficado pela metade).
+static bool vault_read_image(uint32_t commit, uint32_t *first_log_seq, uint8_t *version) {
+    size_t length = 0;
+    VaultHeader header;
+    if (!rstore_get(vault_chunk_id(commit, 0), chunk_buf, sizeof(chunk_buf), &length) || length < sizeof(header)) {
+        return false;
     }
-    service_count = preferences.getInt("svc_count", 0); // Lê contador, default 0
+    memcpy(&header, chunk_buf, sizeof(header));
+    if (header.magic != VAULT_MAGIC || header.version != VAULT_VERSION || header.count > MAX_SERVICES ||
+        header.commit != commit) { // Pedaços de outro commit (virada que não aconteceu)
+        return false;
+    }
+    uint32_t crc = crc32_update((const uint8_t *)&header.log_seq, sizeof(header.log_seq));
+    crc = crc32_update((const uint8_t *)&header.commit, sizeof(header.commit), crc);
+    size_t pos = sizeof(header);
+    uint32_t payload_read = 0;
+    int records = 0;
+    for (int chunk = 1;; chunk++) {
+        crc = crc32_update(&chunk_buf[pos], length - pos, crc);
+        payload_read += length - pos;
+        while (pos < length) {
+            size_t len = parse_record(&chunk_buf[pos], length - pos, false);
+            if (len == 0) return false;
+            pos += len;
+            records++;
+        }
+        if (payload_read >= header.payload_len) break;
+        if (chunk >= VAULT_INDEX_MAX_CHUNKS ||
+            !rstore_get(vault_chunk_id(commit, chunk), chunk_buf, sizeof(chunk_buf), &length)) {
+            return false; // Pedaço ausente ou adulterado
+        }
+        pos = 0;
+    }
+    *first_log_seq = header.log_seq;
+    *version = header.version;
+    return payload_read == header.payload_len && records == header.count && crc == header.crc;
+}
+
+// Apaga os pedaços do slot de 'commit' a partir de 'first' (sobras de uma imagem maior).
+static void vault_trim_slot(uint32_t commit, int first) {
+    for (int chunk = first; chunk < VAULT_INDEX_MAX_CHUNKS && rstore_contains(vault_chunk_id(commit, chunk)); chunk++) {
+        rstore_remove(vault_chunk_id(commit, chunk));
+    }
+}
+
+// Valida o blob do NVS (até a versão 6) em 'vault_buf' como o commit 'commit' e preenche
+// 'services' (e a arena, no formato antigo). Imagens sem número de commit (até a versão 5)
+// só valem como commit 0. Retorna false se o blob for inválido (a lista pode ter ficado pela metade).
+static bool vault_parse(size_t length, uint32_t commit, uint32_t *first_log_seq, uint8_t *version) {
+    VaultHeader header = {};
+    if (length < VAULT_V1_HEADER_SIZE) return false;
+    memcpy(&header, vault_buf, VAULT_V1_HEADER_SIZE);
+    size_t header_size = header.version == 1   ? VAULT_V1_HEADER_SIZE
+                         : header.version < 6 ? VAULT_V2_HEADER_SIZE
+                                               : sizeof(VaultHeader);
+    if (header.magic != VAULT_MAGIC || header.version < 1 || header.version >= VAULT_VERSION || // 7: só na partição
+        length < header_size || header.count > MAX_SERVICES || header.payload_len != length - header_size) {
+        return false;
+    }
+    memcpy(&header, vault_buf, header_size);
+    if (header.commit != commit) return false; // Imagem de outro commit (virada que não aconteceu)
+    const uint8_t *payload = &vault_buf[header_size];
+    uint32_t crc = header.version == 1 ? 0 : crc32_update((const uint8_t *)&header.log_seq, sizeof(header.log_seq));
+    if (header.version >= 6) crc = crc32_update((const uint8_t *)&header.commit, sizeof(header.commit), crc);
+    if (crc32_update(payload, header.payload_len, crc) != header.crc) return false;
+    size_t pos = 0;
+    for (int i = 0; i < header.count; i++) {
+        size_t len = parse_record(&payload[pos], header.payload_len - pos, header.version < 3);
+        if (len == 0) return false;
+        pos += len;
+    }
+    *first_log_seq = header.log_seq;
+    *version = header.version;
+    return pos == header.payload_len;
+}
+
+// Reaplica as entradas do log a partir de 'log_seq'. Requer o namespace aberto.
+static void replay_log() {
+    static uint8_t entry_buf[sizeof(VaultLogEntry) + VAULT_KEYED_RECORD_MAX];
+    log_next = log_seq;
+    for (int n = 0; n < VAULT_LOG_SLOTS; n++) {
+        char key[12];
+        log_key(log_next, key, sizeof(key));
+        size_t length = preferences.getBytesLength(key);
+        if (length < sizeof(VaultLogEntry) || length > sizeof(entry_buf) ||
+            preferences.getBytes(key, entry_buf, length) != length) {
+            break;
+        }
+        VaultLogEntry entry;
+        memcpy(&entry, entry_buf, sizeof(entry));
+        const uint8_t *record = &entry_buf[sizeof(entry)];
+        size_t record_len = length - sizeof(entry);
+        if (entry.seq != log_next || entry.crc != log_entry_crc(entry, record, record_len)) break;
+        int removed = -1;
+        if (entry.op == VAULT_LOG_DEL_ID && record_len == sizeof(uint32_t)) {
+            uint32_t secret_id;
+            memcpy(&secret_id, record, sizeof(secret_id));
+            removed = find_secret(secret_id);
+        } else if (entry.op == VAULT_LOG_DEL) {
+            removed = svcmap_at(entry.index);
+        }
+        bool applied = entry.op == VAULT_LOG_DEL || entry.op == VAULT_LOG_DEL_ID
+                           ? removed >= 0
+                           : (entry.op == VAULT_LOG_ADD || entry.op == VAULT_LOG_ADD_KEYED) &&
+                                 parse_record(record, record_len, entry.op == VAULT_LOG_ADD_KEYED) == record_len;
+        if (!applied) {
+            Serial.printf("[WARN] Entrada %u do log do cofre inválida. Ignorando o resto do log.\n", (unsigned)entry.seq);
+            break;
+        }
+        if (removed >= 0) replay_delete(removed);
+        log_next++;
+    }
+    memset(entry_buf, 0, sizeof(entry_buf));
+    // Entradas de voltas anteriores do anel ainda gravadas: apagadas aos poucos por storage_tick()
+    log_stale_from = log_seq >= VAULT_LOG_SLOTS ? log_seq - VAULT_LOG_SLOTS : 0;
+}
+
+// Lê a imagem do commit 'commit' para 'services': os pedaços do slot dele na partição ou,
+// se o slot ainda não tem pedaços, o blob do NVS (um getBytes; até a versão 6). Requer o
+// namespace aberto. Se for inválida, a lista volta a ficar vazia.
+static bool load_vault_slot(uint32_t commit, uint8_t *version) {
+    bool ok;
+    if (rstore_contains(vault_chunk_id(commit, 0))) {
+        ok = vault_read_image(commit, &log_seq, version);
+    } else {
+        const char *key = vault_slot_key(commit);
+        size_t length = preferences.getBytesLength(key);
+        ok = length > 0 && length <= VAULT_MAX_BYTES && preferences.getBytes(key, vault_buf, length) == length &&
+             vault_parse(length, commit, &log_seq, version);
+        memset(vault_buf, 0, sizeof(vault_buf));
+    }
+    if (!ok) {
+        keystore_clear();
+        namestore_clear();
+        svcmap_clear();
+        next_secret_id = 0;
+        log_seq = 0;
+        secrets_unsaved = false;
+        unsealed_secrets = 0;
+    }
+    return ok;
+}
+
+// Depois de carregar o slot anterior, entradas do log gravadas depois dele (inclusive de
+// após o commit perdido) podem continuar no NVS. A próxima gravação começa além da maior
+// delas e regrava o cofre inteiro, para que nenhuma seja reaplicada como nova.
+// Requer o namespace aberto. Só roda no boot após uma imagem inválida.
+static void skip_stale_log() {
+    VaultLogEntry entry;
+    for (int n = 0; n < VAULT_LOG_SLOTS; n++) {
+        char key[12];
+        log_key((uint32_t)n, key, sizeof(key));
+        size_t length = preferences.getBytesLength(key);
+        if (length < sizeof(entry) || length > VAULT_MAX_BYTES || preferences.getBytes(key, vault_buf, length) != length) {
+            continue;
+        }
+        memcpy(&entry, vault_buf, sizeof(entry));
+        if (entry.seq >= log_next) log_next = entry.seq + 1;
+    }
+    memset(vault_buf, 0, sizeof(vault_buf));
+    vault_rewrite_needed = true;
+}
+
+// ============================================================================
+// === CHAVE DA SESSÃO (AES-256-GCM) ===
+// ============================================================================
+// Cada segredo é gravado no registro 'secret_id' como  IV (12) | cifrado | tag (16),
+// com o secret_id como AAD: um registro copiado para o id de outro é recusado.
+// A chave AES vem de PBKDF2-HMAC-SHA256 sobre o MAC do eFuse (a senha do aparelho;
+// um PIN futuro entra aqui) e um sal aleatório em NVS_KEY_VAULT_KDF. Ela é derivada
+// uma vez por desbloqueio e fica só na RAM durante a sessão. O mesmo registro guarda
+// a tag de um texto vazio, que confirma a chave sem decifrar nenhum segredo.
+// Desbloquear custa VAULT_KDF_ITERATIONS, qualquer que seja o número de serviços;
+// cada segredo é decifrado só quando é buscado.
+struct VaultKdfRecord {
+    uint8_t salt[16];
+    uint8_t iv[AES_GCM_IV_LEN];
+    uint8_t tag[AES_GCM_TAG_LEN]; // GCM de um texto vazio: confirma a chave derivada
+};
+
+static const size_t SECRET_RECORD_MAX = AES_GCM_IV_LEN + MAX_SECRET_BIN_LEN + AES_GCM_TAG_LEN;
+static const uint8_t KDF_CHECK_AAD[] = {'v', 'k', 'd', 'f'};
+
+static AesGcmKey session_key;
+static bool session_unlocked = false;
+
+static void fill_random(uint8_t *out, size_t length) {
+    for (size_t i = 0; i < length; i += 4) {
+        uint32_t r = esp_random(); // TRNG do ESP32
+        memcpy(&out[i], &r, length - i < 4 ? length - i : 4);
+    }
+}
+
+static void derive_session_key(const uint8_t *salt) {
+    uint64_t mac = ESP.getEfuseMac();
+    uint8_t key[AES256_KEY_LEN];
+    pbkdf2_hmac_sha256((const uint8_t *)&mac, sizeof(mac), salt, sizeof(VaultKdfRecord::salt),
+                       VAULT_KDF_ITERATIONS, key, sizeof(key));
+    aesgcm_setKey(key, &session_key);
+    memset(key, 0, sizeof(key));
+}
+
+// Cifra uma chave para o registro 'secret_id'. Requer a sessão desbloqueada.
+static bool seal_key(uint32_t secret_id, const uint8_t *key, size_t key_len) {
+    if (!session_unlocked) return false;
+    uint8_t record[SECRET_RECORD_MAX];
+    fill_random(record, AES_GCM_IV_LEN);
+    aesgcm_encrypt(&session_key, record, (const uint8_t *)&secret_id, sizeof(secret_id), key,
+                   &record[AES_GCM_IV_LEN], key_len, &record[AES_GCM_IV_LEN + key_len]);
+    return rstore_put(secret_id, record, AES_GCM_IV_LEN + key_len + AES_GCM_TAG_LEN);
+}
+
+// Cifra a chave residente do serviço para o seu registro. Requer a sessão desbloqueada.
+static bool seal_secret(int index) {
+    const uint8_t *key;
+    size_t key_len;
+    return keystore_get(index, &key, &key_len) && seal_key(services[index].secret_id, key, key_len);
+}
+
+// Segredo lido de um formato antigo (ainda sem registro cifrado). O cache só comporta
+// KEY_CACHE_SLOTS chaves, então na segunda leitura da migração (sessão já desbloqueada)
+// cada um é selado assim que lido, sem ficar na RAM. Fora dela, ou se a selagem falhar,
+// fica residente só se houver slot livre, e o índice não é regravado nesta sessão.
+static void stage_old_secret(int id, const uint8_t *key, size_t length) {
+    secrets_unsaved = true;
+    if (sealing_on_load && seal_key(services[id].secret_id, key, length)) return;
+    unsealed_secrets++;
+    keystore_set(id, key, length); // Sem slot livre: código indisponível até a migração
+}
+
+bool storage_writeVault() {
+    if (unsealed_secrets > 0) return false; // O índice nunca aponta para segredos ausentes
+    if (nvs_sealed_secrets) return false;   // Nem para segredos ainda no NVS (versão 4)
+    uint32_t commit = vault_commit + 1;
+    int chunks = vault_write_image(log_next, commit);                              // Slot inativo
+    bool ok = chunks > 0 && preferences.putUInt(NVS_KEY_VAULT_HEAD, commit) == sizeof(commit); // Virada
+    if (ok) {
+        vault_trim_slot(commit, chunks); // Sobras de uma imagem maior no mesmo slot
+        // Blob da versão 6 no mesmo slot: substituído pelos pedaços (o do outro slot é o commit anterior)
+        if (preferences.isKey(vault_slot_key(commit))) preferences.remove(vault_slot_key(commit));
+        vault_commit = commit;
+        hotp_markFolded(); // Contadores HOTP no commit novo; o anterior vira o fallback
+        log_seq = log_next; // Todas as entradas do log agora estão no blob
+        vault_rewrite_needed = false;
+        secrets_unsaved = false; // Índice no formato atual
+        storage_stats.compactions++;
+    }
+    return ok;
+}
+
+// Grava uma entrada do log (ADD com o registro do id 'index', ou DEL_ID com o secret_id
+// dele). Requer o namespace aberto. Para ADD, chamar depois de o serviço estar em 'services';
+// para DEL_ID, antes de removê-lo. Retorna false se a entrada não foi gravada (anel cheio,
+// cofre ainda inexistente ou erro): o chamador grava então o cofre inteiro.
+static bool append_log(uint8_t op, int index) {
+    if (vault_rewrite_needed || secrets_unsaved || nvs_sealed_secrets || log_next - log_seq >= (uint32_t)VAULT_LOG_SLOTS) {
+        storage_stats.forced_compactions++;
+        return false;
+    }
+    static uint8_t entry_buf[sizeof(VaultLogEntry) + VAULT_RECORD_MAX];
+    size_t record_len = sizeof(uint32_t);
+    if (op == VAULT_LOG_ADD) record_len = serialize_record(index, &entry_buf[sizeof(VaultLogEntry)]);
+    else memcpy(&entry_buf[sizeof(VaultLogEntry)], &services[index].secret_id, record_len);
+    VaultLogEntry entry = {log_next, op, 0, (uint16_t)svcmap_positionOf(index), 0};
+    entry.crc = log_entry_crc(entry, &entry_buf[sizeof(entry)], record_len);
+    memcpy(entry_buf, &entry, sizeof(entry));
+    char key[12];
+    log_key(log_next, key, sizeof(key));
+    size_t length = sizeof(entry) + record_len;
+    bool ok = preferences.putBytes(key, entry_buf, length) == length;
+    memset(entry_buf, 0, sizeof(entry_buf));
+    if (ok) {
+        log_next++;
+        storage_stats.log_appends++;
+    }
+    return ok;
+}
+
+// ============================================================================
+// === FORMATO ANTIGO (UMA CHAVE POR CAMPO) E MIGRAÇÃO ===
+// ============================================================================
+// Antes do cofre, cada serviço ocupava "svc_%d_name", "svc_%d_secret" (Base32),
+// "svc_%d_params" e "svc_%d_ctr", com o total em "svc_count". Só é lido uma vez,
+// no primeiro boot após a atualização, e apagado depois que o cofre é gravado.
+// Cofres das versões 1 a 3 (chaves dentro do blob ou "sk_%u" em claro) passam pela mesma migração.
+
+// Lê o formato antigo para 'services' e a arena. Requer o namespace aberto. Retorna o valor de "svc_count".
+static int load_legacy_services() {
+    int stored_count = preferences.getInt("svc_count", 0); // Lê contador, default 0
     // Validações básicas do contador
-    if (service_count < 0) service_count = 0;
-    if (service_count > MAX_SERVICES) {
-        Serial.printf("[WARN] Contador NVS (%d) > MAX (%d). Limitando.\n", service_count, MAX_SERVICES);
-        service_count = MAX_SERVICES;
+    if (stored_count < 0) stored_count = 0;
+    if (stored_count > MAX_SERVICES) {
+        Serial.printf("[WARN] Contador NVS (%d) > MAX (%d). Limitando.\n", stored_count, MAX_SERVICES);
+        stored_count = MAX_SERVICES;
     }
 
     int valid_count = 0; // Contador para serviços válidos encontrados
-    for (int i = 0; i < service_count; i++) {
-        char name_key[16]; char secret_key[16];
+    for (int i = 0; i < stored_count; i++) {
+        char name_key[24]; char secret_key[24]; char params_key[24]; char counter_key[24]; // Maior "svc_%d_*" + '\0'
         snprintf(name_key, sizeof(name_key), "svc_%d_name", i);
         snprintf(secret_key, sizeof(secret_key), "svc_%d_secret", i);
+        snprintf(params_key, sizeof(params_key), "svc_%d_params", i);
+        snprintf(counter_key, sizeof(counter_key), "svc_%d_ctr", i);
 
         String name_str = preferences.getString(name_key, "");
         String secret_str = preferences.getString(secret_key, "");
+        uint32_t params = preferences.getUInt(params_key, DEFAULT_SERVICE_PARAMS);
 
         // Verifica se os dados carregados são válidos (não vazios e dentro dos limites)
-        if (name_str.length() > 0 && name_str.length() <= MAX_SERVICE_NAME_LEN &&
-            secret_str.length() > 0 && secret_str.length() <= MAX_SECRET_B32_LEN)
+        // O segredo é decodificado aqui (única decodificação Base32 do serviço) e vai para stage_old_secret
+        uint8_t key[MAX_SECRET_BIN_LEN];
+        int key_len = secret_str.length() > 0 && secret_str.length() <= MAX_SECRET_B32_LEN
+                          ? base32_decode((const uint8_t *)secret_str.c_str(), secret_str.length(), key, sizeof(key))
+                          : 0;
+        int id = svcmap_alloc(); // Ids seguidos: a lista sai compactada
+        if (name_str.length() > 0 && name_str.length() <= MAX_SERVICE_NAME_LEN && key_len > 0)
         {
-            // Copia para a posição correta no array 'services', compactando a lista
-            strncpy(services[valid_count].name, name_str.c_str(), MAX_SERVICE_NAME_LEN);
-            services[valid_count].name[MAX_SERVICE_NAME_LEN] = '\0';
-            strncpy(services[valid_count].secret_b32, secret_str.c_str(), MAX_SECRET_B32_LEN);
-            services[valid_count].secret_b32[MAX_SECRET_B32_LEN] = '\0';
+            if (!namestore_set(id, name_str.c_str(), name_str.length())) { // Arena de nomes cheia
+                memset(key, 0, sizeof(key));
+                svcmap_release(id);
+                Serial.printf("[WARN] Sem espaço para o nome do serviço %d. Pulando.\n", i);
+                continue;
+            }
+            unpack_service_params(params, namestore_get(id), &services[id]);
+            services[id].counter = services[id].kind == OtpKind::HOTP ? preferences.getULong64(counter_key, 0) : 0;
+            services[id].secret_id = next_secret_id++;
+            stage_old_secret(id, key, key_len);
+            memset(key, 0, sizeof(key));
             valid_count++; // Incrementa apenas se o serviço for válido
         } else {
+            svcmap_release(id);
             Serial.printf("[WARN] Serviço %d inválido/ausente no NVS. Pulando.\n", i);
             // Não incrementa valid_count
         }
     }
+    if (valid_count != stored_count) {
+        Serial.printf("Serviços compactados de %d para %d.\n", stored_count, valid_count);
+    }
+    return stored_count;
+}
+
+// Cofre versão 3: lê os segredos em claro para a migração cifrá-los (stage_old_secret).
+// Requer o namespace aberto.
+static void load_plain_secrets() {
+    uint8_t secret[MAX_SECRET_BIN_LEN];
+    for (int p = 0; p < service_count; p++) {
+        int id = svcmap_at(p);
+        char key[16];
+        plain_secret_key(services[id].secret_id, key, sizeof(key));
+        size_t length = preferences.getBytesLength(key);
+        if (length > 0 && length <= sizeof(secret) && preferences.getBytes(key, secret, length) == length) {
+            stage_old_secret(id, secret, length);
+        } else {
+            unsealed_secrets++; // Segredo ausente: o formato antigo fica para a próxima tentativa
+        }
+    }
+    memset(secret, 0, sizeof(secret));
+    secrets_unsaved = plain_secret_keys = true;
+}
+
+// Grava o índice no formato atual (os segredos já foram selados na segunda leitura); com
+// 'legacy_count' >= 0, apaga também as chaves do formato antigo, e com 'plain_secret_keys'
+// os "sk_%u" em claro. Se algum segredo ficou sem registro, o índice não é gravado e o
+// formato antigo fica intacto para a próxima tentativa.
+static void migrate_secrets(int legacy_count) {
+    if (!storage_unlock() || !preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return;
+    }
+    // Dois commits: o segundo regrava o slot da imagem antiga (que pode ter chaves em claro),
+    // então nenhum dos dois slots fica no formato antigo
+    bool ok = storage_writeVault() && storage_writeVault();
+    if (ok) {
+        for (int i = 0; i < legacy_count; i++) {
+            char key[24]; // Maior "svc_%d_*" + '\0'
+            snprintf(key, sizeof(key), "svc_%d_name", i);
+            preferences.remove(key);
+            snprintf(key, sizeof(key), "svc_%d_secret", i);
+            preferences.remove(key);
+            snprintf(key, sizeof(key), "svc_%d_params", i);
+            preferences.remove(key);
+            snprintf(key, sizeof(key), "svc_%d_ctr", i);
+            preferences.remove(key);
+        }
+        if (legacy_count >= 0) preferences.remove("svc_count");
+        for (int p = 0; plain_secret_keys && p < service_count; p++) {
+            char key[16];
+            plain_secret_key(services[svcmap_at(p)].secret_id, key, sizeof(key));
+            preferences.remove(key);
+        }
+        plain_secret_keys = false;
+    }
+    preferences.end();
+    if (!ok) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return;
+    }
+    Serial.printf("[NVS] Migrado para o índice com segredos cifrados: %d serviços.\n", service_count);
+}
+
+// Cofre versão 4: cada "se_%u" do NVS é copiado como está (mesma chave e AAD) para
+// o seu registro na partição, o índice é gravado na versão atual e só então as
+// chaves do NVS são apagadas. Se algo falhar, o NVS fica intacto para a próxima tentativa.
+static void migrate_nvs_secrets() {
+    if (!rstore_isMounted() || !preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return;
+    }
+    uint8_t record[SECRET_RECORD_MAX];
+    bool ok = true;
+    for (int p = 0; ok && p < service_count; p++) {
+        uint32_t secret_id = services[svcmap_at(p)].secret_id;
+        char name[16];
+        nvs_secret_key(secret_id, name, sizeof(name));
+        size_t length = preferences.getBytesLength(name);
+        if (length == 0) continue; // Já ausente: storage_fetchSecret() acusa ao exibir
+        ok = length <= sizeof(record) && preferences.getBytes(name, record, length) == length &&
+             rstore_put(secret_id, record, length);
+    }
+    memset(record, 0, sizeof(record));
+    nvs_sealed_secrets = false; // Libera storage_writeVault(), que regrava o índice na versão atual
+    ok = ok && storage_writeVault();
+    nvs_sealed_secrets = !ok;
+    for (int p = 0; ok && p < service_count; p++) {
+        char name[16];
+        nvs_secret_key(services[svcmap_at(p)].secret_id, name, sizeof(name));
+        preferences.remove(name);
+    }
+    preferences.end();
+    if (!ok) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return;
+    }
+    Serial.printf("[NVS] Segredos de %d serviços movidos para a partição \"vault\".\n", service_count);
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+// Lê o índice (cofre ou formato antigo) e o journal HOTP para 'services', do zero.
+// Retorna false se o NVS não abriu; 'legacy_count' >= 0 se veio do formato antigo.
+static bool load_index(int *legacy_count) {
+    keystore_clear(); // Chaves vêm de novo do cofre, já binárias
+    namestore_clear();
+    svcmap_clear(); // Ids seguidos na ordem do cofre
+    if (!preferences.begin("totp-app", true)) { // Abre NVS no modo somente leitura
+        Serial.println(getText(STR_ERROR_NVS_LOAD));
+        return false;
+    }
+    *legacy_count = -1;
+    log_seq = log_next = log_stale_from = 0;
+    next_secret_id = 0;
+    secrets_unsaved = plain_secret_keys = nvs_sealed_secrets = false;
+    unsealed_secrets = 0;
+    vault_rewrite_needed = true;
+    vault_commit = preferences.getUInt(NVS_KEY_VAULT_HEAD, 0); // 0: nenhum commit A/B ainda (versão <= 5 ou vazio)
+    if (vault_commit > 0 || preferences.getBytesLength(NVS_KEY_VAULT) > 0) {
+        uint8_t version = 0;
+        bool ok = load_vault_slot(vault_commit, &version); // Uma leitura: o slot do último commit
+        bool fallback = false;
+        if (!ok && vault_commit > 0 && load_vault_slot(vault_commit - 1, &version)) {
+            Serial.printf("[WARN] Cofre: commit %u inválido. Carregado o commit anterior.\n", (unsigned)vault_commit);
+            vault_commit--; // O próximo commit regrava o slot inválido; o bom fica intacto até a virada
+            storage_stats.slot_fallbacks++;
+            ok = fallback = true;
+        }
+        if (ok) {
+            vault_rewrite_needed = false;
+            replay_log(); // Adições e remoções feitas depois da última compactação
+            if (fallback) skip_stale_log();
+            if (version == 3) load_plain_secrets();
+            nvs_sealed_secrets = version == 4;
+        } else {
+            Serial.println("[ERROR] Cofre inválido (formato ou CRC). Nenhum serviço carregado.");
+            plain_secret_keys = false;
+        }
+    } else if (preferences.isKey("svc_count")) {
+        *legacy_count = load_legacy_services();
+    }
+    hotp_recoverJournal(); // Contadores HOTP: o maior entre o cofre e o journal
+    // Id de um serviço removido ainda citado no journal não volta a ser entregue
+    if (hotp_secretIdLimit() > next_secret_id) next_secret_id = hotp_secretIdLimit();
     preferences.end(); // Fecha NVS
+    return true;
+}
+
+void loadServices() {
+    uint32_t start_us = micros();
+    aesgcm_clearKey(&session_key); // Nova sessão: a chave é derivada de novo no primeiro uso
+    session_unlocked = false;
+    if (!rstore_begin()) { // Índice dos segredos em RAM: uma leitura de cada setor em uso
+        Serial.println("[ERROR] Partição \"vault\" ausente (tabela de partições antiga?). Segredos indisponíveis.");
+    }
+    int legacy_count;
+    if (!load_index(&legacy_count)) return;
 
-    // Se encontramos menos serviços válidos do que o contador indicava, ajusta
-    if (valid_count != service_count) {
-        Serial.printf("Serviços compactados de %d para %d.\n", service_count, valid_count);
-        service_count = valid_count;
-        // Opcional: Salvar a lista compactada de volta no NVS
-        // storage_saveServiceList();
+    uint32_t load_us = micros() - start_us;
+    // Formato antigo (chaves em claro ou embutidas): o cache não comporta todas as chaves,
+    // então o índice é lido de novo com a sessão desbloqueada, selando cada segredo ao ler
+    if (secrets_unsaved && rstore_isMounted() && storage_unlock()) {
+        sealing_on_load = true;
+        load_index(&legacy_count);
+        sealing_on_load = false;
     }
-    Serial.printf("[NVS] %d serviços válidos carregados.\n", service_count);
+    if (secrets_unsaved) migrate_secrets(legacy_count);
+    if (nvs_sealed_secrets) migrate_nvs_secrets();
+    Serial.printf("[NVS] %d serviços válidos carregados em %lu us (%s, %u entradas de log).\n", service_count,
+                  (unsigned long)load_us, legacy_count >= 0 ? "formato antigo" : "cofre",
+                  (unsigned)(log_next - log_seq));
 }
 
 
 // ---- Funções de Armazenamento (NVS) ----
 bool storage_saveServiceList() {
+    uint32_t start_us = micros();
     if(!preferences.begin("totp-app", false)) { // Abre NVS para leitura/escrita
         Serial.println(getText(STR_ERROR_NVS_SAVE));
         return false;
     }
-    int old_count = preferences.getInt("svc_count", 0); // Lê contador antigo
-    // Remove chaves de serviços que não existem mais (se lista diminuiu)
-    for(int i = service_count; i < old_count; ++i) {
-        char name_key[16], secret_key[16];
-        snprintf(name_key,sizeof(name_key),"svc_%d_name",i);
-        snprintf(secret_key,sizeof(secret_key),"svc_%d_secret",i);
-        preferences.remove(name_key);
-        preferences.remove(secret_key);
-    }
-    // Salva o novo contador de serviços
-    preferences.putInt("svc_count", service_count);
-    bool success = true;
-    // Salva cada serviço atual no NVS
-    for(int i = 0; i < service_count; i++) {
-        char name_key[16], secret_key[16];
-        snprintf(name_key,sizeof(name_key),"svc_%d_name",i);
-        snprintf(secret_key,sizeof(secret_key),"svc_%d_secret",i);
-        if(!preferences.putString(name_key, services[i].name)) success = false;
-        if(!preferences.putString(secret_key, services[i].secret_b32)) success = false;
-    }
+    bool success = storage_writeVault(); // Uma imagem com todos os serviços
     preferences.end(); // Fecha NVS
-    if (!success) Serial.println(getText(STR_ERROR_NVS_SAVE));
+    if (!success) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+    } else {
+        Serial.printf("[NVS] Cofre salvo: %d serviços em %lu us.\n", service_count,
+                      (unsigned long)(micros() - start_us));
+    }
     return success;
 }
 
-bool storage_saveService(const char *name, const char *secret_b32) {
-    if(service_count >= MAX_SERVICES){
-        ui_showTemporaryMessage(getText(STR_ERROR_MAX_SERVICES), COLOR_ERROR);
+// Adiciona o serviço só na RAM: id livre no fim da ordem de exibição, chave decodificada
+// e residente, nome na arena. Retorna o id, ou -1 com a mensagem de erro em 'error'.
+static int add_to_ram(const char *name, const char *secret_b32, OtpAlgorithm algorithm, uint8_t digits, uint16_t period,
+                      OtpKind kind, uint64_t counter, StringID *error) {
+    int id = svcmap_alloc(); // Id livre, no fim da ordem de exibição
+    if(id < 0){
+        *error = STR_ERROR_MAX_SERVICES;
+        return -1;
+    }
+    // Decodifica o segredo uma única vez, direto para a arena de chaves (fica residente)
+    codetable_reserveSlot(); // Cache cheio: a chave menos usada sai (volta sob demanda)
+    if(keystore_decode(id, secret_b32) == 0){
+        svcmap_release(id);
+        *error = STR_ERROR_SECRET_INVALID;
+        return -1;
+    }
+    // Adiciona ao array em memória (nome na arena de nomes, truncado como antes)
+    if (!namestore_set(id, name, strnlen(name, MAX_SERVICE_NAME_LEN))) { // Arena de nomes cheia
+        keystore_evict(id);
+        svcmap_release(id);
+        *error = STR_ERROR_NAME_SPACE;
+        return -1;
+    }
+    services[id].algorithm = algorithm;
+    services[id].digits = digits;
+    services[id].period = period;
+    services[id].kind = kind;
+    services[id].counter = kind == OtpKind::HOTP ? counter : 0;
+    services[id].secret_id = next_secret_id++;
+    return id;
+}
+
+// Tira o serviço da RAM: libera o id e apaga o registro, a chave, o nome, o estado
+// dos códigos e do journal HOTP e os códigos aceitos pelo verificador. Os demais
+// serviços não se movem.
+static void forget_service(int id) {
+    verifier_forgetService(services[id].secret_id);
+    svcmap_release(id);
+    memset(&services[id], 0, sizeof(TOTPService));
+    keystore_evict(id);
+    namestore_remove(id);
+    codetable_removeKey(id);
+    hotp_removeService(id);
+}
+
+bool storage_saveService(const char *name, const char *secret_b32, OtpAlgorithm algorithm, uint8_t digits, uint16_t period,
+                         OtpKind kind, uint64_t counter) {
+    StringID error;
+    int id = add_to_ram(name, secret_b32, algorithm, digits, period, kind, counter, &error);
+    if(id < 0){
+        ui_showTemporaryMessage(getText(error), COLOR_ERROR);
         return false;
     }
-    // Adiciona ao array em memória
-    strncpy(services[service_count].name, name, MAX_SERVICE_NAME_LEN);
-    services[service_count].name[MAX_SERVICE_NAME_LEN] = '\0';
-    strncpy(services[service_count].secret_b32, secret_b32, MAX_SECRET_B32_LEN);
-    services[service_count].secret_b32[MAX_SECRET_B32_LEN] = '\0';
-    service_count++; // Incrementa contador
-    // Salva a lista inteira atualizada no NVS
-    return storage_saveServiceList();
+    codetable_ensureKey(id); // Prepara os midstates da chave nova uma única vez
+
+    // Persiste o segredo cifrado e o registro novo (uma entrada de log), sem regravar os demais
+    uint32_t start_us = micros();
+    if (!storage_unlock() || !preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return false;
+    }
+    bool success = seal_secret(id) && // Segredo antes do índice que aponta para ele
+                   (append_log(VAULT_LOG_ADD, id) || storage_writeVault());
+    preferences.end();
+    if (!success) Serial.println(getText(STR_ERROR_NVS_SAVE));
+    else Serial.printf("[NVS] Serviço adicionado em %lu us.\n", (unsigned long)(micros() - start_us));
+    return success;
 }
 
 bool storage_deleteService(int index) {
-    if(index < 0 || index >= service_count) {
-        Serial.printf("[ERROR] Tentativa de deletar índice inválido: %d\n", index);
+    if(!svcmap_isLive(index)) {
+        Serial.printf("[ERROR] Tentativa de deletar id inválido: %d\n", index);
         return false;
     }
-    Serial.printf("[NVS] Deletando '%s' (idx %d)\n", services[index].name, index);
-    // Desloca os elementos seguintes para cobrir o espaço removido
-    for(int i = index; i < service_count - 1; i++) {
-        services[i] = services[i+1];
+    Serial.printf("[NVS] Deletando '%s' (id %d)\n", namestore_get(index), index);
+    uint32_t start_us = micros();
+    if (!preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        return false;
     }
-    service_count--; // Decrementa o contador
-    memset(&services[service_count], 0, sizeof(TOTPService)); // Limpa a última posição (agora vazia)
+    bool suc = append_log(VAULT_LOG_DEL_ID, index); // Tombstone antes de mexer na RAM
+    uint32_t secret_id = services[index].secret_id;
+    int position = svcmap_positionOf(index);
+    forget_service(index); // Só o id removido é liberado: os demais serviços não se movem na RAM
 
-    // Ajusta o índice do serviço atual, se necessário
-    if(current_service_index >= service_count && service_count > 0) {
-        current_service_index = service_count - 1; // Seleciona o último item se o deletado era o último ou além
-    } else if (service_count == 0) {
-        current_service_index = 0; // Zera se não houver mais serviços
+    // Outro serviço selecionado continua selecionado (mesmo id); se era o removido,
+    // seleciona o que tomou a posição dele (ou o novo último)
+    if (current_service_index == index) {
+        current_service_index = svcmap_at(position < service_count ? position : service_count - 1); // -1 se vazia
     }
-    // Se deletou um item *antes* do atual, o índice atual continua apontando para o mesmo serviço (que subiu uma posição)
-    // Se deletou o item *atual*, o índice agora aponta para o próximo item (que tomou o lugar do deletado)
 
-    bool suc = storage_saveServiceList(); // Salva a nova lista (menor) no NVS
+    if (!suc) suc = storage_writeVault(); // Sem entrada de log: grava a lista (menor) inteira
+    preferences.end();
+    if (suc) rstore_remove(secret_id); // Só depois que o índice não aponta mais para ele
+    if (!suc) Serial.println(getText(STR_ERROR_NVS_SAVE));
+    else Serial.printf("[NVS] Serviço removido em %lu us.\n", (unsigned long)(micros() - start_us));
 
-    // Recarrega a chave do serviço que agora está no índice atual
+    // Seleciona o serviço atual (consulta à tabela)
     if(service_count > 0) {
-        decodeCurrentServiceKey();
+        selectCurrentService();
     } else { // Se não houver mais serviços
-        current_totp.valid_key_loaded = false;
-        snprintf(current_totp.code, sizeof(current_totp.code),"%s",getText(STR_TOTP_CODE_ERROR));
+        invalidateCurrentTOTP();
     }
     return suc;
 }
 
 
+
+void storage_tick() {
+    if ((log_next - log_seq) * 2 >= (uint32_t)VAULT_LOG_SLOTS) { // Metade do anel ocupada: compacta
+        if (!preferences.begin("totp-app", false)) return;
+        if (!storage_writeVault()) Serial.println(getText(STR_ERROR_NVS_SAVE));
+        preferences.end();
+        return;
+    }
+    // Uma chave de log já compactada por chamada; slots reutilizados por entradas vivas ficam
+    while (log_stale_from < log_seq) {
+        uint32_t seq = log_stale_from++;
+        if (seq + VAULT_LOG_SLOTS < log_next) continue; // Slot já sobrescrito por uma entrada viva
+        char key[12];
+        log_key(seq, key, sizeof(key));
+        if (!preferences.begin("totp-app", false)) return;
+        if (preferences.isKey(key)) {
+            preferences.remove(key);
+            storage_stats.stale_removed++;
+        }
+        preferences.end();
+        return;
+    }
+}
+
+bool storage_unlock() {
+    if (session_unlocked) return true;
+    uint32_t start_us = micros();
+    if (!preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_LOAD));
+        return false;
+    }
+    VaultKdfRecord kdf;
+    bool exists = preferences.getBytesLength(NVS_KEY_VAULT_KDF) == sizeof(kdf) &&
+                  preferences.getBytes(NVS_KEY_VAULT_KDF, &kdf, sizeof(kdf)) == sizeof(kdf);
+    if (!exists) fill_random(kdf.salt, sizeof(kdf.salt)); // Primeiro desbloqueio: sal novo
+    derive_session_key(kdf.salt);
+    bool ok;
+    if (exists) {
+        ok = aesgcm_decrypt(&session_key, kdf.iv, KDF_CHECK_AAD, sizeof(KDF_CHECK_AAD), nullptr, nullptr, 0, kdf.tag);
+    } else {
+        fill_random(kdf.iv, sizeof(kdf.iv));
+        aesgcm_encrypt(&session_key, kdf.iv, KDF_CHECK_AAD, sizeof(KDF_CHECK_AAD), nullptr, nullptr, 0, kdf.tag);
+        ok = preferences.putBytes(NVS_KEY_VAULT_KDF, &kdf, sizeof(kdf)) == sizeof(kdf);
+    }
+    preferences.end();
+    if (!ok) {
+        aesgcm_clearKey(&session_key);
+        Serial.println("[ERROR] Cofre: chave derivada não confere (NVS de outro aparelho?).");
+        return false;
+    }
+    session_unlocked = true;
+    storage_stats.unlock_us = micros() - start_us;
+    Serial.printf("[NVS] Cofre desbloqueado em %lu us (%u iterações, AES %s).\n", (unsigned long)storage_stats.unlock_us,
+                  (unsigned)VAULT_KDF_ITERATIONS, aes_backend_name());
+    return true;
+}
+
+bool storage_fetchSecret(int index) {
+    if (!svcmap_isLive(index) || !storage_unlock()) return false;
+    uint32_t start_us = micros();
+    uint32_t secret_id = services[index].secret_id;
+    uint8_t record[SECRET_RECORD_MAX];
+    uint8_t secret[MAX_SECRET_BIN_LEN];
+    size_t length = 0;
+    bool ok = rstore_get(secret_id, record, sizeof(record), &length) && length > AES_GCM_IV_LEN + AES_GCM_TAG_LEN;
+    size_t secret_len = ok ? length - AES_GCM_IV_LEN - AES_GCM_TAG_LEN : 0;
+    ok = ok && aesgcm_decrypt(&session_key, record, (const uint8_t *)&secret_id, sizeof(secret_id),
+                              &record[AES_GCM_IV_LEN], secret, secret_len, &record[AES_GCM_IV_LEN + secret_len]);
+    if (ok && keystore_slot(index) < 0) codetable_reserveSlot(); // Sem slot: a chave menos usada sai
+    ok = ok && keystore_set(index, secret, secret_len);
+    memset(secret, 0, sizeof(secret)); // Cópia na pilha não sobrevive à chamada
+    if (ok) {
+        storage_stats.secret_reads++;
+        storage_stats.secret_read_us += micros() - start_us;
+    } else {
+        Serial.printf("[ERROR] Segredo de '%s' ausente, adulterado ou de outra chave.\n", namestore_get(index));
+    }
+    return ok;
+}
+
+const StorageStats &storage_getStats() {
+    return storage_stats;
+}
+
+// ============================================================================
+// === IMPORTAÇÃO EM LOTE ===
+// ============================================================================
+// Cada serviço do lote tem o segredo selado assim que chega (storage_importService): o
+// cache só comporta KEY_CACHE_SLOTS chaves. O índice é gravado uma única vez no commit;
+// até lá nenhum registro do lote é apontado pelo cofre, e o abort os apaga.
+
+static uint16_t import_ids[MAX_SERVICES]; // Ids adicionados pelo lote em andamento
+static int import_pending = 0;
+
+int storage_importService(const char *name, const char *secret_b32, OtpAlgorithm algorithm, uint8_t digits,
+                          uint16_t period, OtpKind kind, uint64_t counter) {
+    if (!storage_unlock()) return STORAGE_ERR_WRITE;
+    StringID error;
+    int id = add_to_ram(name, secret_b32, algorithm, digits, period, kind, counter, &error);
+    if (id < 0) {
+        return error == STR_ERROR_SECRET_INVALID ? STORAGE_ERR_INVALID_SECRET
+               : error == STR_ERROR_NAME_SPACE   ? STORAGE_ERR_NAME_SPACE
+                                                 : STORAGE_ERR_FULL;
+    }
+    if (!seal_secret(id)) {
+        rstore_remove(services[id].secret_id); // Registro parcial, se houver
+        forget_service(id);
+        return STORAGE_ERR_WRITE;
+    }
+    keystore_evict(id); // Volta sob demanda, como as chaves dos demais serviços
+    import_ids[import_pending++] = (uint16_t)id;
+    return id;
+}
+
+bool storage_importCommit() {
+    if (import_pending == 0) return true;
+    uint32_t start_us = micros();
+    if (!preferences.begin("totp-app", false)) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        storage_importAbort();
+        return false;
+    }
+    bool ok = storage_writeVault(); // Um único commit para o lote inteiro (segredos já selados)
+    preferences.end();
+    if (!ok) {
+        Serial.println(getText(STR_ERROR_NVS_SAVE));
+        storage_importAbort();
+        return false;
+    }
+    Serial.printf("[NVS] Lote importado: %d serviços em %lu us.\n", import_pending, (unsigned long)(micros() - start_us));
+    import_pending = 0;
+    return true;
+}
+
+void storage_importAbort() {
+    while (import_pending > 0) {
+        int id = import_ids[--import_pending];
+        rstore_remove(services[id].secret_id); // O índice nunca apontou para ele
+        forget_service(id);
+    }
+}
@@ -8,45 +8,123 @@
 // ============================================================================
 
 /**
- * @brief Carrega as configurações gerais (idioma, fuso horário) do NVS.
- *        Atualiza as variáveis globais correspondentes (current_language, gmt_offset_hours).
- * @return true se o carregamento foi bem-sucedido (namespace aberto), false caso contrário.
+ * @brief Carrega o índice do cofre (o slot do último commit: os pedaços dele na partição "vault",
+ *        lidos um a um, ou o blob do NVS de um cofre até a versão 6) para
+ *        o array global 'services': nomes e parâmetros, sem nenhum segredo. Os serviços recebem
+ *        ids na ordem do cofre (ver service_map.h; remoções do log reaplicado deixam ids livres).
+ *        Atualiza 'service_count'.
+ *        Se essa imagem for inválida, carrega a do commit anterior, no outro slot.
+ *        Depois da imagem, reaplica o log de adições/remoções ainda não compactado.
+ *        Se só existir um formato antigo (chaves "svc_%d_*", cofre com chaves embutidas ou
+ *        segredos em claro ou cifrados no NVS), carrega-o e migra para o índice com um registro
+ *        cifrado por serviço na partição "vault". Monta também essa partição (rstore_begin).
+ *        Se nenhum dos dois slots tiver uma imagem válida, nenhum serviço é carregado.
  */
-bool loadSettings();
+void loadServices();
 
 /**
- * @brief Salva as configurações gerais atuais (idioma, fuso horário) no NVS.
- * @return true se a gravação foi bem-sucedida, false caso contrário.
+ * @brief Salva TODO o array global 'services' atual como uma imagem do índice (storage_writeVault).
+ * @return true se a operação foi bem-sucedida, false em caso de erro no NVS.
  */
-bool saveSettings();
+bool storage_saveServiceList();
 
 /**
- * @brief Carrega a lista de serviços TOTP do NVS para o array global 'services'.
- *        Atualiza a variável global 'service_count'.
- *        Realiza compactação se encontrar entradas inválidas/removidas.
+ * @brief Grava a imagem do cofre (todos os serviços, com CRC) nos pedaços do slot inativo na
+ *        partição "vault" e só então vira NVS_KEY_VAULT_HEAD para ela (commit A/B): uma queda no
+ *        meio deixa o commit anterior valendo. Compacta o log: as entradas gravadas até aqui passam
+ *        a fazer parte da imagem. Requer o namespace "totp-app" aberto para escrita. Registra o
+ *        commit no journal HOTP (hotp_markFolded), sem apagar entradas.
+ * @return true se a imagem foi gravada inteira e o cabeçalho aponta para ela.
  */
-void loadServices();
+bool storage_writeVault();
 
 /**
- * @brief Salva TODO o array global 'services' atual no NVS.
- *        Sobrescreve ou remove entradas conforme necessário com base em 'service_count'.
- * @return true se a operação foi bem-sucedida, false em caso de erro no NVS.
+ * @brief Deriva a chave AES-256-GCM da sessão (PBKDF2, uma vez por loadServices) e a confere com o
+ *        registro NVS_KEY_VAULT_KDF, criando-o no primeiro uso. Chamada sob demanda pela
+ *        primeira busca ou gravação de segredo; o custo não depende do número de serviços.
+ *        Abre o namespace: não chamar com ele já aberto.
+ * @return true se a sessão está desbloqueada.
+ */
+bool storage_unlock();
+
+/**
+ * @brief Lê (uma consulta ao índice do armazenamento de registros) e decifra o segredo
+ *        do serviço para a arena de chaves. Chamado pelo cache de chaves (codetable_ensureKey)
+ *        só quando um código daquele serviço é pedido. Pode abrir o namespace (desbloqueio):
+ *        não chamar com ele já aberto.
+ * @param index Id do serviço.
+ * @return true se o segredo foi lido, autenticado e está residente.
+ */
+bool storage_fetchSecret(int index);
+
+/**
+ * @brief Compactação em segundo plano: regrava o cofre quando metade do log está ocupada,
+ *        ou apaga uma chave de log já compactada. No máximo uma gravação por chamada.
+ *        Chamar na atualização regular (500 ms).
+ */
+void storage_tick();
+
+/**
+ * @brief Gravações do cofre e do log (entradas, compactações, chaves antigas apagadas).
  */
-bool saveServiceList();
+const StorageStats &storage_getStats();
 
 /**
- * @brief Adiciona um novo serviço ao final do array 'services' e salva a lista inteira no NVS.
- *        Verifica se o limite MAX_SERVICES foi atingido.
+ * @brief Adiciona um novo serviço com um id livre, no fim da ordem de exibição, e o persiste com duas
+ *        gravações: o segredo cifrado (registro na partição "vault") e uma entrada no log do cofre (o cofre inteiro só é
+ *        regravado se o log estiver cheio).
+ *        Recusa com STR_ERROR_MAX_SERVICES se já há MAX_SERVICES serviços, ou com
+ *        STR_ERROR_NAME_SPACE se o nome não cabe na arena de nomes (ver NAME_ARENA_BYTES).
  * @param name Nome do novo serviço.
  * @param secret_b32 Segredo Base32 do novo serviço.
+ * @param algorithm Algoritmo HMAC do serviço (padrão SHA1).
+ * @param digits Dígitos do código (6 ou 8).
+ * @param period Período TOTP em segundos.
+ * @param kind TOTP (padrão) ou HOTP.
+ * @param counter Contador inicial (apenas HOTP).
  * @return true se o serviço foi adicionado e salvo com sucesso, false caso contrário (erro NVS ou limite atingido).
  */
-bool storage_saveService(const char *name, const char *secret_b32);
+bool storage_saveService(const char *name, const char *secret_b32,
+                         OtpAlgorithm algorithm = OtpAlgorithm::SHA1, uint8_t digits = TOTP_DEFAULT_DIGITS,
+                         uint16_t period = TOTP_INTERVAL_SECONDS, OtpKind kind = OtpKind::TOTP, uint64_t counter = 0);
+
+/**
+ * @brief Remove o serviço do id especificado: libera só esse id (os outros serviços não se
+ *        movem na RAM), grava um tombstone com o secret_id dele no log do cofre e apaga o segredo.
+ *        Se era o serviço atual, current_service_index passa ao que ocupou a posição dele na ordem.
+ * @param index O id do serviço a ser deletado.
+ * @return true se o serviço foi deletado e a lista salva com sucesso, false caso contrário (id inválido ou erro NVS).
+ */
+bool storage_deleteService(int index);
+// --- Motivos de recusa de storage_importService() (valores negativos) ---
+constexpr int STORAGE_ERR_FULL = -1;           // Já há MAX_SERVICES serviços
+constexpr int STORAGE_ERR_INVALID_SECRET = -2; // Segredo Base32 inválido ou longo demais
+constexpr int STORAGE_ERR_WRITE = -3;          // Cofre bloqueado ou falha ao selar o segredo
+constexpr int STORAGE_ERR_NAME_SPACE = -4;     // O nome não cabe na arena de nomes (NAME_ARENA_BYTES)
+
+/**
+ * @brief Importação em lote: adiciona um serviço na RAM (id livre no fim da ordem de exibição)
+ *        e sela o segredo dele na partição "vault" na hora; a chave sai da RAM em seguida. O
+ *        índice só passa a apontar para os serviços do lote em storage_importCommit;
+ *        storage_importAbort os descarta. Parâmetros como em storage_saveService. Não mostra
+ *        mensagens na tela.
+ * @return Id do serviço, ou STORAGE_ERR_FULL / STORAGE_ERR_INVALID_SECRET / STORAGE_ERR_WRITE /
+ *         STORAGE_ERR_NAME_SPACE.
+ */
+int storage_importService(const char *name, const char *secret_b32, OtpAlgorithm algorithm, uint8_t digits,
+                          uint16_t period, OtpKind kind, uint64_t counter);
+
+/**
+ * @brief Persiste o lote: grava o cofre uma única vez (commit A/B, compacta o log) com os
+ *        serviços importados, cujos segredos já estão selados. Se a gravação falhar, os
+ *        segredos do lote são removidos e o lote sai da RAM: o cofre continua o de antes.
+ *        Abre o namespace: não chamar com ele já aberto.
+ * @return true se o lote inteiro está no cofre (também com o lote vazio).
+ */
+bool storage_importCommit();
 
 /**
- * @brief Remove o serviço no índice especificado do array 'services',
- *        desloca os itens subsequentes e salva a lista atualizada no NVS.
- * @param index O índice do serviço a ser deletado.
- * @return true se o serviço foi deletado e a lista salva com sucesso, false caso contrário (índice inválido ou erro NVS).
+ * @brief Descarta os serviços do lote ainda não persistido: ids liberados e segredos já
+ *        selados removidos da partição (o índice nunca apontou para eles).
  */
-bool storage_deleteService(int index);
\ No newline at end of file
+void storage_importAbort();
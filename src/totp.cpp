@@ -1,37 +1,77 @@
-#include <TimeLib.h>
+// O núcleo OTP (preparação de chaves e geradores) não depende do Arduino e também
+// compila no ambiente 'native'; a integração com a tela (serviço atual, TimeLib,
+// i18n) fica no bloco ARDUINO no fim do arquivo.
 #include "totp.h"
+#include "types.h"
+#include "crypto/hmac_sha1.h"
+#include "crypto/hmac_sha1_batch.h"
+#include "crypto/hmac_sha256.h"
+#include "crypto/hmac_sha512.h"
+
+#ifdef ARDUINO
+#include <TimeLib.h>
 #include "globals.h"
 #include "i18n.h"
 #include "ui.h"
-#include "types.h"
-#include <mbedtls/md.h>
-
-// ---- Funções de Decodificação Base32 e TOTP ----
-int base32_decode(const uint8_t *encoded, size_t encodedLength, uint8_t *result, size_t bufSize) {
-    int buffer = 0, bitsLeft = 0, count = 0;
-    for (size_t i = 0; i < encodedLength && count < bufSize; i++) {
-        uint8_t ch = encoded[i], value = 255;
-        if (ch >= 'A' && ch <= 'Z') value = ch - 'A';
-        else if (ch >= 'a' && ch <= 'z') value = ch - 'a';
-        else if (ch >= '2' && ch <= '7') value = ch - '2' + 26;
-        else if (ch == '=') continue; // Ignora padding
-        else continue; // Ignora caracteres inválidos
-        buffer = (buffer << 5) | value;
-        bitsLeft += 5;
-        if (bitsLeft >= 8) {
-            result[count++] = (buffer >> (bitsLeft - 8)) & 0xFF;
-            bitsLeft -= 8;
-        }
+#include "code_table.h"
+#include "hotp_journal.h"
+#include "service_map.h"
+#define TOTP_LOG(...) Serial.printf(__VA_ARGS__)
+#else
+#include <stdio.h>
+#define TOTP_LOG(...) printf(__VA_ARGS__)
+#endif
+
+// ---- Geradores Especializados por (Algoritmo, Dígitos) ----
+// Cada combinação vira uma função própria: tamanho do hash, posição do nibble de
+// offset e módulo são constantes de compilação, então o caminho SHA-1/6 dígitos
+// continua exatamente o mesmo código de antes (sem desvios por parâmetro).
+template <OtpAlgorithm A> struct OtpHmac;
+
+template <> struct OtpHmac<OtpAlgorithm::SHA1> {
+    static constexpr size_t DIGEST_LEN = SHA1_DIGEST_LEN;
+    static void mac(const TOTPKeyState *state, const uint8_t *msg, size_t len, uint8_t *out) {
+        hmac_sha1_short(&state->hmac.sha1, msg, len, out);
     }
-    return count;
-}
+};
 
-uint32_t generateTOTP(const uint8_t *key, size_t keyLength, uint64_t timestamp, uint32_t interval = TOTP_INTERVAL_SECONDS) {
-    if (!key || keyLength == 0) {
-        Serial.printf("[ERROR] generateTOTP: Chave inválida (len=%d)\n", keyLength);
-        return 0;
+template <> struct OtpHmac<OtpAlgorithm::SHA256> {
+    static constexpr size_t DIGEST_LEN = SHA256_DIGEST_LEN;
+    static void mac(const TOTPKeyState *state, const uint8_t *msg, size_t len, uint8_t *out) {
+        hmac_sha256_short(&state->hmac.sha256, msg, len, out);
     }
-    uint64_t counter = timestamp / interval;
+};
+
+template <> struct OtpHmac<OtpAlgorithm::SHA512> {
+    static constexpr size_t DIGEST_LEN = SHA512_DIGEST_LEN;
+    static void mac(const TOTPKeyState *state, const uint8_t *msg, size_t len, uint8_t *out) {
+        hmac_sha512_short(&state->hmac.sha512, msg, len, out);
+    }
+};
+
+static constexpr uint32_t pow10u(uint8_t digits) {
+    return digits == 0 ? 1 : 10 * pow10u(digits - 1);
+}
+
+// Extração dinâmica (RFC 4226): último nibble do hash define o offset; extrai 4 bytes
+// a partir dele e zera o bit mais significativo do primeiro byte
+static inline uint32_t dynamic_truncate(const uint8_t *hash, size_t hashLength) {
+    int offset = hash[hashLength - 1] & 0x0F;
+    return ((hash[offset] & 0x7F) << 24) |
+           ((hash[offset + 1] & 0xFF) << 16) |
+           ((hash[offset + 2] & 0xFF) << 8)  |
+           (hash[offset + 3] & 0xFF);
+}
+
+// Contador TOTP do estado; período padrão com divisor constante (evita divisão
+// 64 bits por variável no caso comum)
+static inline uint64_t totp_counter(const TOTPKeyState *state, uint64_t timestamp) {
+    return state->period == TOTP_INTERVAL_SECONDS ? timestamp / TOTP_INTERVAL_SECONDS
+                                                  : timestamp / state->period;
+}
+
+template <OtpAlgorithm A, uint8_t Digits>
+static uint32_t otp_generate(const TOTPKeyState *state, uint64_t counter) {
     uint8_t counterBytes[8];
     // Converte counter para Big-Endian byte array
     for (int i = 7; i >= 0; i--) {
@@ -39,90 +79,265 @@ uint32_t generateTOTP(const uint8_t *key, size_t keyLength, uint64_t timestamp,
         counter >>= 8;
     }
 
-    uint8_t hash[20]; // SHA-1 output é 20 bytes
-    mbedtls_md_context_t ctx;
-    mbedtls_md_info_t const *info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA1);
-    if (!info) {
-        Serial.println("[ERROR] generateTOTP: mbedtls_md_info_from_type falhou");
-        return 0; // Não conseguiu obter info SHA1
+    uint8_t hash[OtpHmac<A>::DIGEST_LEN];
+    OtpHmac<A>::mac(state, counterBytes, sizeof(counterBytes), hash); // Só pilha, sem caminho de erro
+
+    // Tamanho do hash e módulo constantes por instanciação
+    return dynamic_truncate(hash, OtpHmac<A>::DIGEST_LEN) % pow10u(Digits);
+}
+
+// Escolhe a instanciação; nulo para combinação não suportada
+static OtpGenerator select_generator(OtpAlgorithm algorithm, uint8_t digits) {
+    switch (algorithm) {
+        case OtpAlgorithm::SHA1:
+            return digits == 6 ? otp_generate<OtpAlgorithm::SHA1, 6> :
+                   digits == 8 ? otp_generate<OtpAlgorithm::SHA1, 8> : nullptr;
+        case OtpAlgorithm::SHA256:
+            return digits == 6 ? otp_generate<OtpAlgorithm::SHA256, 6> :
+                   digits == 8 ? otp_generate<OtpAlgorithm::SHA256, 8> : nullptr;
+        case OtpAlgorithm::SHA512:
+            return digits == 6 ? otp_generate<OtpAlgorithm::SHA512, 6> :
+                   digits == 8 ? otp_generate<OtpAlgorithm::SHA512, 8> : nullptr;
     }
+    return nullptr;
+}
 
-    mbedtls_md_init(&ctx);
-    // Configura para HMAC-SHA1
-    if (mbedtls_md_setup(&ctx, info, 1) != 0) { // 1 = use HMAC
-        Serial.println("[ERROR] generateTOTP: mbedtls_md_setup falhou");
-        mbedtls_md_free(&ctx); return 0;
+bool prepareTOTPKey(const uint8_t *key, size_t keyLength, TOTPKeyState *state,
+                    OtpAlgorithm algorithm, uint8_t digits, uint16_t period) {
+    if (!key || keyLength == 0 || !state) {
+        TOTP_LOG("[ERROR] prepareTOTPKey: Chave inválida (len=%d)\n", (int)keyLength);
+        return false;
     }
-    if (mbedtls_md_hmac_starts(&ctx, key, keyLength) != 0) {
-        Serial.println("[ERROR] generateTOTP: mbedtls_md_hmac_starts falhou");
-        mbedtls_md_free(&ctx); return 0;
+    OtpGenerator generator = select_generator(algorithm, digits);
+    if (!generator || period == 0 || period > TOTP_MAX_PERIOD_SECONDS) {
+        TOTP_LOG("[ERROR] prepareTOTPKey: Parâmetros inválidos (algo=%d, digits=%d, period=%d)\n",
+                      (int)algorithm, digits, period);
+        return false;
     }
-    if (mbedtls_md_hmac_update(&ctx, counterBytes, 8) != 0) {
-        Serial.println("[ERROR] generateTOTP: mbedtls_md_hmac_update falhou");
-        mbedtls_md_free(&ctx); return 0;
+    switch (algorithm) {
+        case OtpAlgorithm::SHA1:   hmac_sha1_prepare(key, keyLength, &state->hmac.sha1); break;
+        case OtpAlgorithm::SHA256: hmac_sha256_prepare(key, keyLength, &state->hmac.sha256); break;
+        case OtpAlgorithm::SHA512: hmac_sha512_prepare(key, keyLength, &state->hmac.sha512); break;
     }
-    if (mbedtls_md_hmac_finish(&ctx, hash) != 0) {
-        Serial.println("[ERROR] generateTOTP: mbedtls_md_hmac_finish falhou");
-        mbedtls_md_free(&ctx); return 0;
+    state->generate = generator;
+    state->algorithm = algorithm;
+    state->digits = digits;
+    state->period = period;
+    return true;
+}
+
+uint32_t generateOTPFromState(const TOTPKeyState *state, uint64_t counter) {
+    if (!state || !state->generate) return 0;
+    return state->generate(state, counter);
+}
+
+uint32_t generateTOTPFromState(const TOTPKeyState *state, uint64_t timestamp) {
+    if (!state || !state->generate) return 0;
+    return state->generate(state, totp_counter(state, timestamp));
+}
+
+#if TOTP_BATCH_HMAC
+// Pares SHA-1 acumulados antes de cada chamada ao lote (múltiplo das faixas)
+static constexpr size_t BATCH_CHUNK = HMAC_SHA1_BATCH_LANES * 4;
+
+struct Sha1BatchChunk {
+    const HmacSha1Key *keys[BATCH_CHUNK];
+    uint64_t counters[BATCH_CHUNK];
+    int index[BATCH_CHUNK]; // Posição do serviço em 'keys'/'codes'
+    size_t pending;
+};
+
+// Processa os pares acumulados e grava os códigos truncados com os dígitos de cada serviço
+static void flush_sha1_chunk(Sha1BatchChunk *chunk, const TOTPKeyState *keys, uint32_t *codes) {
+    uint8_t hashes[BATCH_CHUNK][SHA1_DIGEST_LEN];
+    hmac_sha1_counter_batch(chunk->keys, chunk->counters, chunk->pending, hashes);
+    for (size_t j = 0; j < chunk->pending; j++) {
+        int i = chunk->index[j];
+        codes[i] = dynamic_truncate(hashes[j], SHA1_DIGEST_LEN) % pow10u(keys[i].digits);
     }
-    mbedtls_md_free(&ctx); // Libera contexto
+    chunk->pending = 0;
+}
 
-    // Extração dinâmica (RFC 4226)
-    int offset = hash[19] & 0x0F; // Último nibble do hash define o offset (0-15)
-    // Extrai 4 bytes a partir do offset, zera o bit mais significativo do primeiro byte
-    uint32_t binaryCode =
-        ((hash[offset] & 0x7F) << 24) |
-        ((hash[offset + 1] & 0xFF) << 16) |
-        ((hash[offset + 2] & 0xFF) << 8)  |
-        (hash[offset + 3] & 0xFF);
+void generateTOTPBatch(const TOTPKeyState *keys, const bool *key_valid, int count, uint64_t timestamp, uint32_t *codes) {
+    Sha1BatchChunk chunk;
+    chunk.pending = 0;
+    for (int i = 0; i < count; i++) {
+        if (!key_valid[i]) {
+            codes[i] = 0;
+        } else if (keys[i].algorithm == OtpAlgorithm::SHA1) {
+            chunk.keys[chunk.pending] = &keys[i].hmac.sha1;
+            chunk.counters[chunk.pending] = totp_counter(&keys[i], timestamp);
+            chunk.index[chunk.pending] = i;
+            if (++chunk.pending == BATCH_CHUNK) flush_sha1_chunk(&chunk, keys, codes);
+        } else {
+            codes[i] = generateTOTPFromState(&keys[i], timestamp); // SHA-256/512: caminho individual
+        }
+    }
+    if (chunk.pending > 0) flush_sha1_chunk(&chunk, keys, codes);
+}
+#else
+void generateTOTPBatch(const TOTPKeyState *keys, const bool *key_valid, int count, uint64_t timestamp, uint32_t *codes) {
+    // Motor SHA do hardware processa um bloco por vez: um serviço de cada vez
+    for (int i = 0; i < count; i++) {
+        codes[i] = key_valid[i] ? generateTOTPFromState(&keys[i], timestamp) : 0;
+    }
+}
+#endif
 
-    // Retorna os últimos 6 dígitos
-    return binaryCode % 1000000;
+uint32_t generateTOTP(const uint8_t *key, size_t keyLength, uint64_t timestamp, uint32_t interval) {
+    TOTPKeyState state;
+    if (interval == 0 || interval > TOTP_MAX_PERIOD_SECONDS ||
+        !prepareTOTPKey(key, keyLength, &state, OtpAlgorithm::SHA1, TOTP_DEFAULT_DIGITS, interval)) {
+        return 0;
+    }
+    return generateTOTPFromState(&state, timestamp);
 }
 
-// ---- Funções TOTP ----
-bool decodeCurrentServiceKey(){
-    if(service_count <= 0 || current_service_index >= service_count || current_service_index < 0){
-        current_totp.valid_key_loaded = false;
-        snprintf(current_totp.code, sizeof(current_totp.code), "%s", getText(STR_TOTP_CODE_ERROR));
-        // Serial.println("[TOTP] Índice inválido ou sem serviços.");
+// k-ésimo desvio na ordem do mais próximo ao mais distante: 0, -1, +1, -2, +2, ...
+static inline int window_offset(int k) {
+    return (k & 1) ? -((k + 1) / 2) : k / 2;
+}
+
+bool verifyTOTPFromState(const TOTPKeyState *state, uint64_t timestamp, uint32_t code, uint8_t window, int *offset) {
+    if (!state || !state->generate || code >= pow10u(state->digits)) return false;
+    uint64_t counter = totp_counter(state, timestamp);
+    int total = 2 * window + 1;
+    // Testa do mais próximo ao mais distante: o desvio devolvido é o menor possível.
+    // Todos os contadores partem dos mesmos midstates (só as compressões do contador e
+    // do hash final); no SHA-1 com lote, cada bloco de contadores vai junto pelas faixas.
+#if TOTP_BATCH_HMAC
+    if (state->algorithm == OtpAlgorithm::SHA1) {
+        const HmacSha1Key *keys[BATCH_CHUNK];
+        uint64_t counters[BATCH_CHUNK];
+        int offsets[BATCH_CHUNK];
+        uint8_t hashes[BATCH_CHUNK][SHA1_DIGEST_LEN];
+        uint32_t modulus = pow10u(state->digits);
+        for (int k = 0; k < total;) {
+            size_t pending = 0;
+            for (; k < total && pending < BATCH_CHUNK; k++) {
+                int candidate = window_offset(k);
+                if (candidate < 0 && counter < (uint64_t)-candidate) continue; // Antes da época Unix
+                keys[pending] = &state->hmac.sha1;
+                counters[pending] = counter + candidate;
+                offsets[pending++] = candidate;
+            }
+            hmac_sha1_counter_batch(keys, counters, pending, hashes);
+            for (size_t j = 0; j < pending; j++) {
+                if (dynamic_truncate(hashes[j], SHA1_DIGEST_LEN) % modulus == code) {
+                    if (offset) *offset = offsets[j];
+                    return true;
+                }
+            }
+        }
         return false;
     }
-    const char* secret_b32 = services[current_service_index].secret_b32;
-    // Serial.printf("[TOTP] Decodificando chave para '%s': %s\n", services[current_service_index].name, secret_b32);
-    int decoded_len = base32_decode((const uint8_t*)secret_b32, strlen(secret_b32), current_totp.key_bin, MAX_SECRET_BIN_LEN);
+#endif
+    for (int k = 0; k < total; k++) {
+        int candidate = window_offset(k);
+        if (candidate < 0 && counter < (uint64_t)-candidate) continue; // Antes da época Unix
+        if (state->generate(state, counter + candidate) == code) {
+            if (offset) *offset = candidate;
+            return true;
+        }
+    }
+    return false;
+}
 
-    if(decoded_len > 0 && decoded_len <= MAX_SECRET_BIN_LEN){
-        current_totp.key_bin_len = decoded_len;
-        current_totp.valid_key_loaded = true;
-        current_totp.last_generated_interval = 0; // Força geração inicial
-        updateCurrentTOTP(); // Gera o primeiro código para a nova chave
-        // Serial.printf("[TOTP] Chave decodificada com sucesso (%d bytes).\n", decoded_len);
+#ifdef ARDUINO
+// ---- Funções TOTP (serviço exibido) ----
+// Traços com os dígitos do serviço atual (HOTP antes do pedido, chave ainda sendo buscada)
+static void show_dashes(){
+    uint8_t digits = services[current_service_index].digits;
+    memset(current_totp.code, '-', digits);
+    current_totp.code[digits] = '\0';
+}
+
+bool selectCurrentService(bool allow_fetch){
+    current_totp.key_pending = false;
+    if(!svcmap_isLive(current_service_index)){
+        invalidateCurrentTOTP();
+        // Serial.println("[TOTP] Índice inválido ou sem serviços.");
+        return false;
+    }
+    // Navegação: chave fora do cache fica para a atualização de 500 ms (sem flash nem AES-GCM no botão)
+    if(!allow_fetch && !codetable_keyState(current_service_index)){
+        current_totp.valid_key_loaded = false;
+        current_totp.key_pending = true;
+        show_dashes();
         return true;
-    } else {
+    }
+    // Segredo lido do NVS só na primeira vez que o serviço é exibido (depois fica no cache de chaves)
+    if(!codetable_ensureKey(current_service_index)){
         current_totp.valid_key_loaded = false;
-        current_totp.key_bin_len = 0;
         snprintf(current_totp.code, sizeof(current_totp.code), "%s", getText(STR_ERROR_B32_DECODE));
-        Serial.printf("[ERROR] Falha ao decodificar Base32 para '%s'. Len: %d\n", services[current_service_index].name, decoded_len);
         return false;
     }
+    current_totp.valid_key_loaded = true;
+    current_totp.last_generated_window = UINT64_MAX; // Força cópia do código da tabela
+    if(services[current_service_index].kind == OtpKind::HOTP){
+        // HOTP: nenhum código até o usuário pedir (cada código consome um contador)
+        show_dashes();
+        return true;
+    }
+    updateCurrentTOTP();
+    return true;
+}
+
+bool finishPendingService(){
+    if(!current_totp.key_pending) return false;
+    if(!selectCurrentService()){
+        ui_showTemporaryMessage(getText(STR_ERROR_B32_DECODE), COLOR_ERROR);
+    }
+    return true;
+}
+
+bool advanceCurrentHOTP(){
+    if(!svcmap_isLive(current_service_index) || services[current_service_index].kind != OtpKind::HOTP){
+        return false;
+    }
+    uint32_t code;
+    if(!hotp_generate(current_service_index, &code)) return false;
+    snprintf(current_totp.code, sizeof(current_totp.code), "%0*lu",
+             (int)services[current_service_index].digits, (unsigned long)code);
+    return true;
 }
 
-void updateCurrentTOTP(){
+bool updateCurrentTOTP(){
+    if (current_totp.key_pending) return false; // Placeholder até finishPendingService()
     // Se não houver chave válida carregada, mostra erro e sai
     if (!current_totp.valid_key_loaded) {
         snprintf(current_totp.code, sizeof(current_totp.code), "%s", getText(STR_TOTP_CODE_ERROR));
-        return;
+        return false;
+    }
+    if (services[current_service_index].kind == OtpKind::HOTP) {
+        return false; // Código HOTP só muda em advanceCurrentHOTP()
     }
     uint64_t current_unix_time_utc = now(); // Usa tempo UTC do TimeLib
-    uint32_t current_interval = current_unix_time_utc / TOTP_INTERVAL_SECONDS;
+    // Na fronteira só troca para o buffer de lookahead (gera na hora apenas se não estiver pronto)
+    codetable_update(current_unix_time_utc);
 
-    // Gera um novo código apenas se o intervalo de tempo mudou
-    if (current_interval != current_totp.last_generated_interval) {
-        uint32_t totp_code_val = generateTOTP(current_totp.key_bin, current_totp.key_bin_len, current_unix_time_utc);
-        snprintf(current_totp.code, sizeof(current_totp.code), "%06lu", totp_code_val); // Formata com 6 dígitos
-        current_totp.last_generated_interval = current_interval; // Atualiza último intervalo gerado
-        // Serial.printf("[TOTP] Novo código gerado: %s\n", current_totp.code);
+    // Copia da tabela apenas se a janela mudou (ou após troca de serviço)
+    uint64_t table_window = codetable_activeWindowStart();
+    if (table_window != current_totp.last_generated_window) {
+        uint32_t totp_code_val;
+        if (codetable_getCode(current_service_index, &totp_code_val)) {
+            // Formata com os dígitos do serviço (6 ou 8), preservando zeros à esquerda
+            snprintf(current_totp.code, sizeof(current_totp.code), "%0*lu",
+                     (int)services[current_service_index].digits, (unsigned long)totp_code_val);
+        } else {
+            snprintf(current_totp.code, sizeof(current_totp.code), "%s", getText(STR_TOTP_CODE_ERROR));
+        }
+        current_totp.last_generated_window = table_window; // Atualiza última janela exibida
+        return true;
     }
-    // Se o intervalo não mudou, o código existente em current_totp.code é mantido
-}
\ No newline at end of file
+    // Se a janela não mudou, o código existente em current_totp.code é mantido
+    return false;
+}
+
+void invalidateCurrentTOTP(){
+    current_totp.valid_key_loaded = false;
+    current_totp.key_pending = false;
+    current_totp.last_generated_window = UINT64_MAX;
+    snprintf(current_totp.code, sizeof(current_totp.code), "%s", getText(STR_TOTP_CODE_ERROR));
+}
+#endif // ARDUINO
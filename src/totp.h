@@ -3,24 +3,15 @@
 #include <stddef.h> // Para size_t
 #include <stdint.h> // Para uint8_t, uint32_t, uint64_t
 #include "config.h" // Para constantes como TOTP_INTERVAL_SECONDS
+#include "types.h"  // Para TOTPKeyState
 
 // ============================================================================
 // === FUNÇÕES PÚBLICAS DO MÓDULO TOTP ===
 // ============================================================================
 
 /**
- * @brief Decodifica uma string Base32 em um buffer binário.
- *        Ignora caracteres inválidos e padding ('=').
- * @param encoded Ponteiro para a string Base32 codificada.
- * @param encodedLength Comprimento da string Base32.
- * @param result Buffer onde o resultado binário será armazenado.
- * @param bufSize Tamanho do buffer de resultado.
- * @return O número de bytes decodificados escritos no buffer 'result', ou 0 em caso de erro ou entrada vazia.
- */
-int base32_decode(const uint8_t *encoded, size_t encodedLength, uint8_t *result, size_t bufSize);
-
-/**
- * @brief Gera um código TOTP (HMAC-SHA1) para um determinado timestamp.
+ * @brief Gera um código TOTP (HMAC-SHA1, 6 dígitos) para um determinado timestamp.
+ *        Usa o kernel HMAC-SHA1 próprio (src/crypto); não aloca memória do heap.
  * @param key Ponteiro para a chave secreta binária.
  * @param keyLength Comprimento da chave secreta em bytes.
  * @param timestamp Timestamp Unix (UTC) para o qual gerar o código.
@@ -30,20 +21,102 @@ int base32_decode(const uint8_t *encoded, size_t encodedLength, uint8_t *result,
 uint32_t generateTOTP(const uint8_t *key, size_t keyLength, uint64_t timestamp, uint32_t interval = TOTP_INTERVAL_SECONDS);
 
 /**
- * @brief Decodifica a chave secreta Base32 do serviço atualmente selecionado
- *        (current_service_index) e armazena o resultado binário internamente (se necessário).
- *        Atualiza o estado 'current_totp.valid_key_loaded'.
- * @return true se a decodificação foi bem-sucedida, false caso contrário (índice inválido, erro de decodificação).
+ * @brief Pré-computa os midstates HMAC (blocos K ^ ipad e K ^ opad) de uma chave e escolhe
+ *        o gerador especializado para (algoritmo, dígitos).
+ *        Deve ser chamada uma vez por chave decodificada; o estado resultante é
+ *        reutilizado por generateTOTPFromState() em todos os intervalos seguintes.
+ * @param key Ponteiro para a chave secreta binária.
+ * @param keyLength Comprimento da chave secreta em bytes.
+ * @param state Estado de saída (midstates, parâmetros e gerador).
+ * @param algorithm Algoritmo HMAC (SHA1, SHA256 ou SHA512).
+ * @param digits Dígitos do código (6 ou 8).
+ * @param period Período TOTP em segundos (1 a TOTP_MAX_PERIOD_SECONDS).
+ * @return true se o estado foi preparado, false se a chave ou os parâmetros forem inválidos.
+ */
+bool prepareTOTPKey(const uint8_t *key, size_t keyLength, TOTPKeyState *state,
+                    OtpAlgorithm algorithm = OtpAlgorithm::SHA1, uint8_t digits = TOTP_DEFAULT_DIGITS,
+                    uint16_t period = TOTP_INTERVAL_SECONDS);
+
+/**
+ * @brief Gera um código OTP para um contador explícito (RFC 4226) a partir de um estado preparado.
+ *        Custa apenas as compressões do contador e do hash final (duas no SHA-1/SHA-256).
+ * @param state Estado preparado por prepareTOTPKey().
+ * @param counter Contador de 64 bits.
+ * @return O código com os dígitos do estado, ou 0 em caso de erro.
+ */
+uint32_t generateOTPFromState(const TOTPKeyState *state, uint64_t counter);
+
+/**
+ * @brief Gera um código TOTP a partir de um estado preparado, usando o período do próprio estado.
+ * @param state Estado preparado por prepareTOTPKey().
+ * @param timestamp Timestamp Unix (UTC) para o qual gerar o código.
+ * @return O código com os dígitos do estado, ou 0 em caso de erro.
+ */
+uint32_t generateTOTPFromState(const TOTPKeyState *state, uint64_t timestamp);
+
+/**
+ * @brief Gera os códigos TOTP de vários serviços para o mesmo timestamp.
+ *        Chaves SHA-1 passam pelo HMAC em lote (várias faixas intercaladas/SIMD, ver
+ *        crypto/hmac_sha1_batch.h) quando TOTP_BATCH_HMAC está ativo; as demais usam
+ *        generateTOTPFromState(). O resultado é idêntico ao da geração individual.
+ * @param keys Estados preparados por prepareTOTPKey().
+ * @param key_valid Marca de chave válida por entrada (entradas inválidas recebem 0).
+ * @param count Número de serviços.
+ * @param timestamp Timestamp Unix (UTC).
+ * @param codes Saída: um código por serviço.
+ */
+void generateTOTPBatch(const TOTPKeyState *keys, const bool *key_valid, int count, uint64_t timestamp, uint32_t *codes);
+
+/**
+ * @brief Verifica um código candidato contra os intervalos [-window, +window] em torno de 'timestamp'.
+ *        Busca do desvio 0 para fora e reutiliza os midstates do estado em todos os contadores;
+ *        no SHA-1 com TOTP_BATCH_HMAC os contadores da janela passam juntos pelo lote.
+ * @param state Estado preparado por prepareTOTPKey().
+ * @param timestamp Timestamp Unix (UTC) de referência.
+ * @param code Código numérico candidato.
+ * @param window Número de intervalos aceitos para cada lado (tolerância de relógio).
+ * @param offset Saída opcional: desvio em intervalos do código encontrado (ex: -1 = anterior).
+ * @return true se o código corresponde a algum intervalo da janela.
+ */
+bool verifyTOTPFromState(const TOTPKeyState *state, uint64_t timestamp, uint32_t code, uint8_t window, int *offset);
+
+// --- Integração com a tela (apenas no build Arduino; dependem de TimeLib e da tabela do cofre) ---
+
+/**
+ * @brief Seleciona o serviço em current_service_index para exibição.
+ *        Consulta O(1) na tabela do cofre (code_table): não decodifica Base32 nem calcula HMAC.
+ *        Atualiza 'current_totp' (código e 'valid_key_loaded'). Serviço HOTP mostra
+ *        traços até advanceCurrentHOTP().
+ * @param allow_fetch false na navegação (prev/next): chave fora do cache não é lida da
+ *        flash aqui; mostra traços e marca 'key_pending' para finishPendingService().
+ * @return true se o serviço tem chave válida (ou pendente), false caso contrário (índice inválido, erro de decodificação no load).
+ */
+bool selectCurrentService(bool allow_fetch = true);
+
+/**
+ * @brief Busca a chave deixada pendente por selectCurrentService(false) e mostra o código.
+ *        Chamar na atualização regular de 500 ms, antes de desenhar a tela.
+ * @return true se havia chave pendente ('current_totp.code' mudou).
+ */
+bool finishPendingService();
+
+/**
+ * @brief Verifica se a janela da tabela do cofre mudou desde o último código exibido.
+ *        Se sim, promove o buffer de lookahead (ou gera a tabela, se o lookahead não
+ *        estiver pronto) e copia o código do serviço atual para 'current_totp',
+ *        formatado com os dígitos do serviço.
+ *        Barata quando a janela não mudou; pode ser chamada a cada iteração do loop.
+ * @return true se 'current_totp.code' mudou e precisa ser redesenhado.
  */
-bool decodeCurrentServiceKey();
+bool updateCurrentTOTP();
 
 /**
- * @brief Verifica se o intervalo de tempo TOTP mudou desde a última geração.
- *        Se sim, gera um novo código TOTP para o serviço atual (usando a chave decodificada)
- *        e atualiza a struct global 'current_totp' (código e último intervalo).
- * @return void
+ * @brief Serviço atual HOTP: gera o código do contador atual e avança o contador
+ *        (uma gravação no journal, ver hotp_journal.h). Copia para 'current_totp'.
+ * @return true se o código foi gerado (contador persistido), false se o serviço
+ *         não é HOTP ou o NVS falhou.
  */
-void updateCurrentTOTP();
+bool advanceCurrentHOTP();
 
 /**
  * @brief Marca o código TOTP atual como inválido e define o placeholder.
@@ -1,6 +1,9 @@
 #pragma once // Include guard
 
 #include "config.h" // Necessário para constantes como MAX_SERVICE_NAME_LEN
+#include "crypto/hmac_sha1.h"   // Para HmacSha1Key (midstates HMAC)
+#include "crypto/hmac_sha256.h" // Para HmacSha256Key
+#include "crypto/hmac_sha512.h" // Para HmacSha512Key
 
 // ============================================================================
 // === ENUMERAÇÕES ===
@@ -35,6 +38,19 @@ enum ScreenState {
   SCREEN_READ_RFID
 };
 
+// --- Algoritmo HMAC de um Serviço OTP (RFC 6238) ---
+enum class OtpAlgorithm : uint8_t {
+    SHA1 = 0,   // Padrão (Google Authenticator e maioria dos serviços)
+    SHA256 = 1,
+    SHA512 = 2,
+};
+
+// --- Tipo de OTP do Serviço ---
+enum class OtpKind : uint8_t {
+    TOTP = 0,   // Baseado em tempo (RFC 6238), padrão
+    HOTP = 1,   // Baseado em contador (RFC 4226): avança a cada código gerado
+};
+
 // --- Idiomas Suportados ---
 enum class Language : uint8_t {
     PT_BR,      // Português (Brasil)
@@ -76,14 +92,14 @@ enum class Language : uint8_t {
 //     CONFIRM_DELETE_PROMPT, // Ex: "Deletar serviço:"
 
 //     // Mensagens de Status/Sucesso
-//     SERVICE_ADDED, SERVICE_DELETED, TIME_ADJUSTED_FMT, TIMEZONE_SAVED_FMT,
+//     SERVICE_ADDED, SERVICE_DELETED, SERVICES_IMPORTED_FMT, TIME_ADJUSTED_FMT, TIMEZONE_SAVED_FMT,
 //     LANG_SAVED,
 
 //     // Mensagens de Erro
 //     ERROR_RTC_FAILED, ERROR_NO_SERVICES, ERROR_JSON_PARSE_FMT, ERROR_JSON_INVALID_SERVICE,
 //     ERROR_JSON_INVALID_TIME, ERROR_SERVICE_NAME_INVALID, ERROR_SECRET_INVALID,
 //     ERROR_SECRET_B32_INVALID, ERROR_TIME_VALUES_INVALID, ERROR_SAVING_NVS, ERROR_DELETING,
-//     ERROR_NVS_LOAD, ERROR_NVS_SAVE, ERROR_B32_DECODE, ERROR_MAX_SERVICES,
+//     ERROR_NVS_LOAD, ERROR_NVS_SAVE, ERROR_B32_DECODE, ERROR_MAX_SERVICES, ERROR_NAME_SPACE,
 //     ERROR_TOTP_GENERATION, ERROR_RFID_READ,
 
 //     // Mensagens de Status da Tela de Boot
@@ -132,6 +148,7 @@ enum StringID {
   STR_CONFIRM_DELETE_PROMPT,
   STR_SERVICE_ADDED,
   STR_SERVICE_DELETED,
+  STR_SERVICES_IMPORTED_FMT,
   STR_TIME_ADJUSTED_FMT,
   STR_TIMEZONE_SAVED_FMT,
   STR_LANG_SAVED,
@@ -149,6 +166,7 @@ enum StringID {
   STR_ERROR_NVS_SAVE,
   STR_ERROR_B32_DECODE,
   STR_ERROR_MAX_SERVICES,
+  STR_ERROR_NAME_SPACE,
   STR_TOTP_CODE_ERROR,
   STR_TOTP_NO_SERVICE_TITLE,
   STR_CARD_READ_FMT,
@@ -163,18 +181,193 @@ enum StringID {
 
 // --- Representação de um Serviço TOTP Armazenado ---
 struct TOTPService {
-  char name[MAX_SERVICE_NAME_LEN + 1];      // Nome do serviço (visível ao usuário)
-  char secret_b32[MAX_SECRET_B32_LEN + 1];  // Segredo em formato Base32
-  // A chave binária não é armazenada aqui para economizar RAM; é decodificada sob demanda.
+  uint64_t counter;                         // HOTP: próximo contador a usar (journal em hotp_journal.cpp)
+  uint32_t secret_id;                       // Id do registro do segredo (cifrado) na partição "vault", lido só sob demanda
+  uint16_t period;                          // Período em segundos (padrão TOTP_INTERVAL_SECONDS; ignorado no HOTP)
+  OtpAlgorithm algorithm;                   // Algoritmo HMAC (padrão SHA1)
+  uint8_t digits;                           // Dígitos do código (6 ou 8)
+  OtpKind kind;                             // TOTP ou HOTP
+  // O nome fica na arena de nomes (name_arena) e o segredo só entra na RAM quando um
+  // código é pedido: chave binária num slot do cache (key_arena) e midstates no mesmo
+  // slot de code_table.keys. Campos do maior para o menor: 24 bytes, sem buracos internos.
+};
+
+// --- Arena de Nomes dos Serviços ---
+// Nomes terminados em '\0', contíguos: a busca por nome e a lista percorrem memória
+// seguida. Indexada pelo id do serviço; cada nome ocupa só o próprio comprimento.
+// Remover deixa um buraco em vez de mover os outros nomes; os buracos só são
+// recolhidos quando um nome novo não cabe mais no fim.
+static_assert(NAME_ARENA_BYTES <= UINT16_MAX, "NameArena::offset guarda posições em uint16_t");
+struct NameArena {
+  char data[NAME_ARENA_BYTES];        // Nomes concatenados (cada um com seu '\0')
+  uint16_t offset[MAX_SERVICES];      // Início do nome de cada id em 'data'
+  uint8_t length[MAX_SERVICES];       // Comprimento de cada nome sem o '\0' (0 = id sem nome)
+  uint16_t used;                      // Bytes ocupados em 'data' (nomes e buracos)
+  uint16_t holes;                     // Bytes de nomes removidos ainda abaixo de 'used'
+};
+
+// --- Arena de Chaves Binárias ---
+// Cache das chaves residentes (buscadas na partição sob demanda), contíguas e sem padding.
+// Só KEY_CACHE_SLOTS slots, cada um com o id dono; o id chega ao slot por busca nesses
+// poucos slots. Comprimento 0 = slot livre. Liberar uma chave compacta a arena.
+static_assert(MAX_SERVICES <= INT16_MAX, "ids de serviço cabem em int16_t (-1 = nenhum)");
+struct KeyArena {
+  uint8_t data[KEY_ARENA_BYTES];      // Chaves concatenadas
+  uint16_t offset[KEY_CACHE_SLOTS];   // Início da chave de cada slot em 'data'
+  uint8_t length[KEY_CACHE_SLOTS];    // Comprimento em bytes de cada chave (0 = slot livre)
+  int16_t id[KEY_CACHE_SLOTS];        // Id do serviço dono de cada slot (-1 = livre)
+  uint16_t used;                      // Bytes ocupados em 'data'
+};
+
+// --- Chave de um Serviço Pronta para Gerar Códigos ---
+// Midstates HMAC (blocos K ^ ipad e K ^ opad) do algoritmo do serviço, mais o gerador
+// especializado para (algoritmo, dígitos) escolhido em prepareTOTPKey(). Gerar um código
+// custa só as compressões do contador e do hash final, sem desvios por parâmetro.
+struct TOTPKeyState;
+typedef uint32_t (*OtpGenerator)(const TOTPKeyState *state, uint64_t counter);
+
+struct TOTPKeyState {
+  OtpGenerator generate;              // Instanciação especializada (ver totp.cpp)
+  OtpAlgorithm algorithm;
+  uint8_t digits;
+  uint16_t period;                    // Período em segundos
+  union {
+    HmacSha1Key sha1;
+    HmacSha256Key sha256;
+    HmacSha512Key sha512;
+  } hmac;
 };
 
 // --- Informações sobre o Código TOTP sendo Exibido ---
+// A chave e os midstates ficam na tabela do cofre (CodeTable); aqui só o que a UI mostra.
 struct CurrentTOTPInfo {
-  char code[7];                       // Código formatado ("123456" ou placeholder)
-  uint32_t last_generated_interval;   // Otimização: último intervalo de tempo para o qual o código foi gerado
-  uint8_t key_bin[MAX_SECRET_BIN_LEN];
-  size_t key_bin_len;
+  char code[TOTP_MAX_DIGITS + 1];     // Código formatado ("123456", "12345678" ou placeholder)
+  uint64_t last_generated_window;     // Otimização: início da janela da tabela da qual o código foi copiado
   bool valid_key_loaded;              // Indica se a chave do serviço atual foi decodificada com sucesso
+  bool key_pending;                   // Chave fora do cache ao navegar: placeholder até a atualização de 500 ms buscá-la
+};
+
+// --- Tabela de Códigos das Chaves Residentes ---
+// Midstates preparados uma vez por chave carregada e códigos regenerados uma vez por janela.
+// Uma janela vai de uma fronteira de período de algum serviço até a próxima; com todos
+// os serviços em 30 s ela coincide com o intervalo TOTP.
+// Dois buffers de códigos: o ativo (janela atual) e o de lookahead (próxima janela),
+// calculado antes da fronteira e promovido trocando apenas 'active'.
+// Tudo por slot do cache de chaves (KEY_CACHE_SLOTS), não por serviço: só as chaves
+// residentes têm midstates e códigos.
+struct CodeTable {
+  TOTPKeyState keys[KEY_CACHE_SLOTS]; // Midstates HMAC e parâmetros da chave de cada slot
+  bool key_valid[KEY_CACHE_SLOTS];    // Midstates prontos para a chave de 'key_owner'
+  int16_t key_owner[KEY_CACHE_SLOTS]; // Id cuja chave gerou os midstates do slot
+  uint32_t codes[2][KEY_CACHE_SLOTS]; // Códigos por buffer
+  uint64_t window_start[2];           // Timestamp (UTC) de início da janela de cada buffer
+  uint64_t window_end[2];             // Timestamp (UTC) da próxima fronteira (exclusivo)
+  bool ready[2];                      // Buffer contém códigos completos para sua janela
+  uint8_t active;                     // Buffer exibido (0 ou 1); o outro é o lookahead
+};
+
+// --- Medição da Latência de Virada de Intervalo (rollover -> pixel) ---
+struct RolloverStats {
+  uint32_t last_latency_us;           // Última latência entre detectar a virada e o código na tela
+  uint32_t max_latency_us;            // Pior latência observada
+  uint32_t samples;                   // Número de viradas medidas
+  uint32_t lookahead_hits;            // Viradas servidas pelo buffer de lookahead (sem HMAC)
+  uint32_t lookahead_misses;          // Viradas que precisaram gerar a tabela na hora
+  uint32_t over_frame;                // Viradas acima de FRAME_BUDGET_US
+};
+
+// --- Perfil do Boot (reset -> primeiro código na tela) ---
+struct BootPhaseTime {
+  const char *name;                   // Nome curto e estável (chave no relatório JSON)
+  uint32_t us;                        // Duração da fase
+};
+
+struct BootProfile {
+  BootPhaseTime phases[BOOT_MAX_PHASES]; // Fases na ordem em que terminaram
+  uint8_t count;                      // Fases registradas
+  uint32_t user_wait_us;              // Menu na tela até o usuário abrir os códigos (fora do total)
+  uint32_t total_us;                  // Soma das fases: reset até o primeiro código na tela
+  bool complete;                      // Primeiro código desenhado (ou primeira tela, sem serviços)
+};
+
+// --- Linha do Tempo de Códigos (pré-cálculo no USB) ---
+struct TimelineStats {
+  uint32_t hits;                      // Códigos servidos pela linha do tempo em bateria (sem HMAC)
+  uint32_t misses;                    // Consultas em bateria fora da linha do tempo (HMAC na hora)
+  uint32_t precomputed;               // Códigos gerados antecipadamente no USB
+  uint64_t precompute_us;             // Tempo de CPU gasto gerando-os (base da estimativa de economia)
+};
+
+// --- Journal de Contadores HOTP ---
+struct HotpJournalStats {
+  uint32_t journal_writes;            // Entradas gravadas (uma por código HOTP gerado)
+  uint32_t fold_writes;               // Gravações do cofre feitas para dobrar o journal
+  uint32_t forced_folds;              // Dobras síncronas (anel cheio de entradas ainda necessárias)
+};
+
+// --- Configurações do Usuário (settings.cpp) ---
+// Imagem exata do registro NVS_KEY_SETTINGS: um putBytes grava todas de uma vez.
+struct Settings {
+  uint8_t version;                    // Formato do registro (SETTINGS_VERSION em settings.cpp)
+  uint8_t language;                   // Language
+  int8_t gmt_offset_hours;            // Fuso horário, -12 a +14
+  uint8_t reserved;
+};
+
+struct SettingsStats {
+  uint32_t reads;                     // Leituras do NVS (uma por boot; mais só na migração)
+  uint32_t writes;                    // Registros gravados
+  uint32_t coalesced;                 // Mudanças absorvidas por uma gravação posterior
+};
+
+// --- Log Incremental do Cofre ---
+struct StorageStats {
+  uint32_t log_appends;               // Entradas gravadas (uma por serviço adicionado ou removido)
+  uint32_t compactions;               // Gravações do cofre inteiro (compactação, dobra HOTP, lista)
+  uint32_t forced_compactions;        // Mudanças que gravaram o cofre inteiro (log cheio ou cofre inexistente)
+  uint32_t secret_reads;              // Segredos buscados no NVS sob demanda
+  uint32_t stale_removed;             // Chaves de log já compactadas apagadas em segundo plano
+  uint32_t unlock_us;                 // Duração do último desbloqueio (PBKDF2 + conferência da chave)
+  uint32_t secret_read_us;            // Tempo total das buscas de segredo (leitura da flash + AES-GCM)
+  uint32_t slot_fallbacks;            // Boots que carregaram o slot anterior (imagem do último commit inválida)
+};
+
+// --- Importação em Lote (service_import.h) ---
+struct ImportStats {
+  uint32_t bytes;                     // Bytes do documento consumidos
+  uint32_t entries;                   // Objetos lidos do array
+  uint32_t imported;                  // Serviços adicionados (0 se o lote não foi gravado)
+  uint32_t rejected;                  // Entradas inválidas (campo ausente ou fora dos limites, Base32 inválido)
+  uint32_t over_capacity;             // Entradas válidas descartadas por já haver MAX_SERVICES serviços
+  uint32_t over_name_space;           // Entradas válidas descartadas porque o nome não coube na arena de nomes
+  uint32_t parse_us;                  // Parse, validação e decodificação (só RAM)
+  uint32_t commit_us;                 // Segredos selados + uma gravação do cofre
+};
+
+// --- Acesso ao NVS (nvs_backend.h) ---
+// Contadores cumulativos; a diferença antes/depois de uma ação mede o custo dela.
+struct NvsStats {
+  uint32_t reads;                     // Leituras (get*, getBytesLength, isKey)
+  uint32_t writes;                    // Gravações (put*)
+  uint32_t removes;                   // Remoções (remove, clear)
+  uint32_t bytes_read;                // Bytes de valor lidos
+  uint32_t bytes_written;             // Bytes de valor gravados
+  uint32_t entries_written;           // Entradas de 32 bytes gravadas (host: modelo do NVS; alvo: 0)
+  uint32_t page_erases;               // Páginas de 4 KB apagadas (host: modelo do NVS; alvo: 0)
+  uint32_t busy_us;                   // Tempo no NVS (alvo: medido; host: latência modelada)
+};
+
+// --- Armazenamento de Registros na Flash (partição "vault") ---
+struct RecordStoreStats {
+  uint32_t records;                   // Registros vivos no índice
+  uint32_t live_bytes;                // Bytes ocupados por registros vivos (com cabeçalho)
+  uint32_t free_sectors;              // Setores apagados, prontos para gravação
+  uint32_t appends;                   // Registros gravados (gravações, remoções e realocações)
+  uint32_t bytes_written;             // Bytes gravados na flash (com cabeçalhos)
+  uint32_t gc_sectors;                // Setores coletados (e apagados)
+  uint32_t gc_relocated;              // Registros vivos copiados pela coleta
+  uint32_t forced_gc;                 // Coletas feitas dentro de uma gravação (a de fundo não acompanhou)
+  uint32_t sector_erases;             // Setores apagados (coleta e abertura de setor não apagado): desgaste
 };
 
 // --- Informações da Bateria e Alimentação ---
@@ -189,6 +382,11 @@ struct TempData {
     // Para Adição de Serviço
     char service_name[MAX_SERVICE_NAME_LEN + 1];
     char service_secret[MAX_SECRET_B32_LEN + 1];
+    OtpAlgorithm service_algorithm;
+    uint8_t service_digits;
+    uint16_t service_period;
+    OtpKind service_kind;
+    uint64_t service_counter;
     // Para Edição de Hora
     int edit_time_field; // 0=hora, 1=minuto, 2=segundo
     int edit_hour;
@@ -5,6 +5,9 @@
 #include "types.h" // Já incluído via outros, mas explícito
 #include "hardware.h" // Para powerUp/DownRFID e battery_info
 #include "totp.h"     // Para TOTP_INTERVAL_SECONDS
+#include "boot_profile.h" // Para os ganchos do perfil do boot
+#include "name_store.h" // Para os nomes dos serviços
+#include "service_map.h" // Para validar o id do serviço atual
 #include <TimeLib.h>  // Para now(), hour(), minute(), second()
 
 // ============================================================================
@@ -26,8 +29,9 @@
 static char last_drawn_clock_str[9] = "";
 static int last_drawn_batt_level = -1;
 static bool last_drawn_usb_state = false;
-static char last_drawn_totp_code[7] = "";
-static uint32_t last_drawn_totp_interval = 0; // Usado para progresso
+static char last_drawn_totp_code[TOTP_MAX_DIGITS + 1] = "";
+static uint32_t last_drawn_totp_remaining = 0; // Usado para progresso (segundos restantes desenhados)
+static uint32_t last_drawn_totp_period = 0;    // Período do serviço desenhado na barra
 
 // ============================================================================
 // === INICIALIZAÇÃO DA UI ===
@@ -51,7 +55,7 @@ void initSprites() {
 
     // --- Sprite do Código TOTP ---
     spr_totp_code.setColorDepth(16); // Mais cores para antialiasing da fonte grande
-    uint16_t totpW = tft.textWidth("000000", FONT_SIZE_TOTP_CODE) + 10; // Largura + margem
+    uint16_t totpW = tft.textWidth("00000000", FONT_SIZE_TOTP_CODE) + 10; // Largura (até 8 dígitos) + margem
     uint16_t totpH = tft.fontHeight(FONT_SIZE_TOTP_CODE) + 4;      // Altura + margem
     spr_totp_code.createSprite(totpW, totpH);
     spr_totp_code.setTextDatum(MC_DATUM); // Middle Center alignment
@@ -93,6 +97,11 @@ void changeScreen(ScreenState new_screen) {
     request_full_redraw = true; // Força redesenho completo da nova tela
 
     // Ações de entrada na tela *nova*
+    if (new_screen == ScreenState::SCREEN_TOTP_VIEW) {
+        bootprof_codeRequested(); // Fim da espera no menu (fora do tempo de boot)
+        // Primeira entrada depois do boot (ou após um erro): desbloqueia o cofre e busca o segredo aqui
+        if (!current_totp.valid_key_loaded && !current_totp.key_pending) selectCurrentService();
+    }
     if (new_screen == ScreenState::SCREEN_MENU_MAIN) {
         resetMenuState(main_menu_state);
         // Centralizar visão no item atual
@@ -283,14 +292,23 @@ void ui_updateTotpCodeSprite() {
 }
 
 void ui_updateProgressBarSprite(uint64_t current_timestamp_utc) {
-    uint32_t current_interval = current_timestamp_utc / TOTP_INTERVAL_SECONDS;
-    // Otimização: Só redesenha se o intervalo (segundos restantes) mudou
-    if (last_drawn_totp_interval != current_interval) {
-        last_drawn_totp_interval = current_interval;
-        uint32_t seconds_remaining = TOTP_INTERVAL_SECONDS - (current_timestamp_utc % TOTP_INTERVAL_SECONDS);
+    // Cada serviço tem seu período; a barra acompanha o do serviço exibido
+    uint32_t period = TOTP_INTERVAL_SECONDS;
+    if (svcmap_isLive(current_service_index)) {
+        period = services[current_service_index].period;
+    }
+    uint32_t seconds_remaining = period - (current_timestamp_utc % period);
+    if (svcmap_isLive(current_service_index) &&
+        services[current_service_index].kind == OtpKind::HOTP) {
+        seconds_remaining = 0; // HOTP não expira: barra vazia
+    }
+    // Otimização: Só redesenha se os segundos restantes (ou o período) mudaram
+    if (last_drawn_totp_remaining != seconds_remaining || last_drawn_totp_period != period) {
+        last_drawn_totp_remaining = seconds_remaining;
+        last_drawn_totp_period = period;
         int bar_width = spr_progress_bar.width();
         int bar_height = spr_progress_bar.height();
-        int progress_w = map(seconds_remaining, 0, TOTP_INTERVAL_SECONDS, 0, bar_width);
+        int progress_w = map(seconds_remaining, 0, period, 0, bar_width);
         progress_w = constrain(progress_w, 0, bar_width);
 
         spr_progress_bar.fillSprite(COLOR_BAR_BG); // Fundo da barra
@@ -318,8 +336,8 @@ void ui_updateProgressBarSprite(uint64_t current_timestamp_utc) {
 // Helper para obter a chave JSON do título da tela
 const char* getScreenTitleKey(ScreenState state) {
     if (state == ScreenState::SCREEN_TOTP_VIEW) {
-        return (service_count > 0 && current_service_index >= 0 && current_service_index < service_count)
-               ? services[current_service_index].name // Usa o nome do serviço como "chave" direta (não traduzível por padrão)
+        return svcmap_isLive(current_service_index)
+               ? namestore_get(current_service_index) // Usa o nome do serviço como "chave" direta (não traduzível por padrão)
                : getText(StringID::NONE); // Chave para "Sem Serviço"
     }
     switch(state){
@@ -466,7 +484,7 @@ void ui_drawScreenTOTPContent(bool full_redraw) {
         tft.fillRect(0, content_y_start, tft.width(), content_height + footer_height, COLOR_BG);
 
         // Desenha contorno da barra de progresso (se houver serviço)
-        if (service_count > 0 && current_service_index != -1) {
+        if (svcmap_isLive(current_service_index)) {
              int prog_bar_outline_w = spr_progress_bar.width() + 4;
              int prog_bar_outline_h = spr_progress_bar.height() + 4;
              int prog_bar_outline_x = (tft.width() - prog_bar_outline_w) / 2;
@@ -495,9 +513,10 @@ void ui_drawScreenTOTPContent(bool full_redraw) {
     }
 
     // Atualiza e desenha sprites (se houver serviço)
-    if (service_count > 0 && current_service_index != -1) {
+    if (svcmap_isLive(current_service_index)) {
         ui_updateTotpCodeSprite();
         ui_updateProgressBarSprite(now()); // Passa tempo atual
+        bootprof_codeDrawn(); // Primeiro código na tela: fecha o perfil do boot
     }
 }
 
@@ -707,8 +726,8 @@ void ui_drawScreenServiceDeleteConfirmContent(bool full_redraw) {
 
         // Mostra nome do serviço a ser deletado
         tft.setTextColor(COLOR_FG);
-        if (service_count > 0 && current_service_index >= 0 && current_service_index < service_count) {
-            tft.drawString(services[current_service_index].name, tft.width() / 2, center_y + 35);
+        if (svcmap_isLive(current_service_index)) {
+            tft.drawString(namestore_get(current_service_index), tft.width() / 2, center_y + 35);
         } else {
             tft.drawString("???", tft.width() / 2, center_y + 35); // Fallback
         }
@@ -0,0 +1,105 @@
+#include "verifier.h"
+#include "globals.h"
+#include "totp.h"
+#include "code_table.h"
+#include "name_store.h"
+#include "crypto/sha_backend.h"
+
+// ============================================================================
+// === DEFINIÇÕES INTERNAS E VARIÁVEIS ESTÁTICAS ===
+// ============================================================================
+
+// Um código aceito: serviço (secret_id, estável se a lista for reordenada ou um nome
+// for reaproveitado por outro serviço) e contador
+struct ReplayEntry {
+    uint32_t secret_id;
+    uint64_t counter;
+};
+
+static ReplayEntry replay_cache[VERIFY_REPLAY_CACHE_SIZE];
+static int replay_used = 0; // Entradas válidas
+static int replay_next = 0; // Próxima posição do anel (sobrescreve a mais antiga)
+
+static bool replay_contains(uint32_t secret_id, uint64_t counter) {
+    for (int i = 0; i < replay_used; i++) {
+        if (replay_cache[i].secret_id == secret_id && replay_cache[i].counter == counter) return true;
+    }
+    return false;
+}
+
+static void replay_remember(uint32_t secret_id, uint64_t counter) {
+    replay_cache[replay_next] = {secret_id, counter};
+    replay_next = (replay_next + 1) % VERIFY_REPLAY_CACHE_SIZE;
+    if (replay_used < VERIFY_REPLAY_CACHE_SIZE) replay_used++;
+}
+
+// Converte o texto do código; exige exatamente 'digits' algarismos
+static bool parse_code(const char *text, uint8_t digits, uint32_t *code) {
+    uint32_t value = 0;
+    uint8_t n = 0;
+    for (; text[n]; n++) {
+        if (n >= digits || text[n] < '0' || text[n] > '9') return false;
+        value = value * 10 + (uint32_t)(text[n] - '0');
+    }
+    if (n != digits) return false;
+    *code = value;
+    return true;
+}
+
+// ============================================================================
+// === API PÚBLICA ===
+// ============================================================================
+
+VerifyResult verifier_check(const char *service_name, const char *code, uint8_t window, uint64_t timestamp, int *offset) {
+    int index = service_name ? namestore_find(service_name) : -1;
+    // HOTP fica de fora: conferir um código de contador exigiria avançar o contador do aparelho
+    if (index < 0 || !codetable_ensureKey(index) || !codetable_isTimeBased(index)) {
+        return VerifyResult::UNKNOWN_SERVICE;
+    }
+    const TOTPKeyState *state = codetable_keyState(index);
+    uint32_t candidate;
+    if (!code || !parse_code(code, state->digits, &candidate)) return VerifyResult::INVALID_CODE;
+    if (window > VERIFY_MAX_WINDOW) window = VERIFY_MAX_WINDOW;
+
+    int matched;
+    sha_backend_acquire(); // Uma reserva do motor SHA para a janela inteira
+    bool ok = verifyTOTPFromState(state, timestamp, candidate, window, &matched);
+    sha_backend_release();
+    if (!ok) return VerifyResult::REJECTED;
+
+    *offset = matched;
+    uint64_t counter = timestamp / state->period + matched;
+    uint32_t secret_id = services[index].secret_id;
+    if (replay_contains(secret_id, counter)) return VerifyResult::REPLAYED;
+    replay_remember(secret_id, counter);
+    return VerifyResult::ACCEPTED;
+}
+
+void verifier_clearReplayCache() {
+    replay_used = 0;
+    replay_next = 0;
+}
+
+void verifier_forgetService(uint32_t secret_id) {
+    // Compacta o anel na ordem de idade: a mais antiga continua a próxima sobrescrita
+    int oldest = (replay_next - replay_used + VERIFY_REPLAY_CACHE_SIZE) % VERIFY_REPLAY_CACHE_SIZE;
+    int kept = 0;
+    for (int k = 0; k < replay_used; k++) {
+        const ReplayEntry &entry = replay_cache[(oldest + k) % VERIFY_REPLAY_CACHE_SIZE];
+        if (entry.secret_id == secret_id) continue;
+        replay_cache[(oldest + kept++) % VERIFY_REPLAY_CACHE_SIZE] = entry;
+    }
+    replay_used = kept;
+    replay_next = (oldest + kept) % VERIFY_REPLAY_CACHE_SIZE;
+}
+
+const char *verifier_resultName(VerifyResult result) {
+    switch (result) {
+        case VerifyResult::ACCEPTED:        return "ok";
+        case VerifyResult::REJECTED:        return "reject";
+        case VerifyResult::REPLAYED:        return "replay";
+        case VerifyResult::UNKNOWN_SERVICE: return "unknown";
+        case VerifyResult::INVALID_CODE:    return "invalid";
+    }
+    return "?";
+}
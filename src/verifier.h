@@ -0,0 +1,49 @@
+#pragma once // Include guard
+
+#include <stdint.h> // Para uint8_t, uint32_t, uint64_t
+
+// ============================================================================
+// === FUNÇÕES PÚBLICAS DO VERIFICADOR DE CÓDIGOS ===
+// ============================================================================
+// Modo verificador: o aparelho confere um código recebido pela Serial para um
+// serviço do cofre, como um segundo fator offline (ex: bancada de testes sem
+// servidor). A busca cobre +-window intervalos (verifyTOTPFromState) sobre os
+// midstates já preparados em 'code_table'. Códigos aceitos entram num cache de
+// replay (VERIFY_REPLAY_CACHE_SIZE entradas, por secret_id e contador) e são
+// recusados se apresentados de novo. Remover um serviço apaga as entradas dele.
+
+enum class VerifyResult : uint8_t {
+  ACCEPTED,        // Código confere com algum intervalo da janela
+  REJECTED,        // Nenhum intervalo da janela confere
+  REPLAYED,        // Confere, mas o mesmo contador já foi aceito antes
+  UNKNOWN_SERVICE, // Nome não existe no cofre, a chave é inválida ou o serviço é HOTP
+  INVALID_CODE     // Não tem exatamente os dígitos do serviço
+};
+
+/**
+ * @brief Verifica um código candidato para o serviço com o nome dado.
+ * @param service_name Nome do serviço (comparação exata).
+ * @param code Código em texto, com os dígitos do serviço (zeros à esquerda preservados).
+ * @param window Intervalos aceitos para cada lado (limitado a VERIFY_MAX_WINDOW).
+ * @param timestamp Timestamp Unix (UTC) de referência.
+ * @param offset Saída: desvio em intervalos do código aceito (válido em ACCEPTED e REPLAYED).
+ * @return Resultado da verificação.
+ */
+VerifyResult verifier_check(const char *service_name, const char *code, uint8_t window, uint64_t timestamp, int *offset);
+
+/**
+ * @brief Esquece todos os códigos aceitos (ex: testes, troca de cofre).
+ */
+void verifier_clearReplayCache();
+
+/**
+ * @brief Esquece os códigos aceitos de um serviço removido (espelha storage_deleteService).
+ * @param secret_id secret_id do serviço removido.
+ */
+void verifier_forgetService(uint32_t secret_id);
+
+/**
+ * @brief Nome curto e estável do resultado, usado na resposta pela Serial.
+ * @return String constante, ex: "ok", "replay".
+ */
+const char *verifier_resultName(VerifyResult result);
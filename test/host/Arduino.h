@@ -0,0 +1,76 @@
+#pragma once // Include guard
+
+// ============================================================================
+// === SUBSTITUTO MÍNIMO DO Arduino.h PARA O HOST (env native-storage) ===
+// ============================================================================
+// Só o que a pilha de armazenamento usa: Serial (stdout), String, micros/millis
+// (relógio monotônico do host), delay, ESP.getEfuseMac e esp_random.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+struct HostSerial {
+    void begin(unsigned long) {}
+    int printf(const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        int written = vprintf(format, args);
+        va_end(args);
+        return written;
+    }
+    void print(const char *text) { fputs(text, stdout); }
+    void println(const char *text = "") { puts(text); }
+};
+inline HostSerial Serial;
+
+class String {
+public:
+    String(const char *text = "") : value(text ? text : "") {}
+    size_t length() const { return value.size(); }
+    const char *c_str() const { return value.c_str(); }
+    void trim() {
+        size_t first = value.find_first_not_of(" \t\r\n");
+        size_t last = value.find_last_not_of(" \t\r\n");
+        value = first == std::string::npos ? "" : value.substr(first, last - first + 1);
+    }
+
+private:
+    std::string value;
+};
+
+inline uint32_t micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline uint32_t millis() {
+    return micros() / 1000;
+}
+
+inline void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+template <typename T> T max(T a, T b) { return a > b ? a : b; }
+template <typename T> T min(T a, T b) { return a < b ? a : b; }
+
+struct HostEsp {
+    uint64_t getEfuseMac() { return 0x0000AABBCCDDEEFFULL; } // MAC fixo: a chave do cofre sobrevive ao "reboot"
+};
+inline HostEsp ESP;
+
+// xorshift32: determinístico entre execuções (os benchmarks ficam reproduzíveis)
+inline uint32_t esp_random() {
+    static uint32_t state = 0x12345678;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
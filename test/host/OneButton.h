@@ -0,0 +1,3 @@
+#pragma once // Include guard
+
+class OneButton {};
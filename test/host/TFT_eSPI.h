@@ -0,0 +1,14 @@
+#pragma once // Include guard
+
+#include <stdint.h>
+
+// Só as cores usadas em config.h; nenhum módulo do env native-storage desenha
+class TFT_eSPI {};
+class TFT_eSprite {};
+
+enum : uint16_t {
+    TFT_BLACK = 0x0000, TFT_NAVY = 0x000F, TFT_DARKGREEN = 0x03E0, TFT_BLUE = 0x001F,
+    TFT_RED = 0xF800, TFT_MAGENTA = 0xF81F, TFT_YELLOW = 0xFFE0, TFT_WHITE = 0xFFFF,
+    TFT_ORANGE = 0xFDA0, TFT_GREEN = 0x07E0, TFT_CYAN = 0x07FF, TFT_LIGHTGREY = 0xD69A,
+    TFT_DARKGREY = 0x7BEF
+};
@@ -0,0 +1,10 @@
+#pragma once // Include guard
+
+#include <stdint.h>
+
+// Relógio de parede do host: os testes o ajustam diretamente (definido em host_env.h)
+extern uint64_t host_now;
+
+inline uint64_t now() {
+    return host_now;
+}
@@ -0,0 +1,68 @@
+#pragma once // Include guard
+
+// ============================================================================
+// === AMBIENTE DA PILHA DE ARMAZENAMENTO NO HOST (env native-storage) ===
+// ============================================================================
+// O env native-storage compila storage, hotp_journal, code_table, settings, boot_profile e companhia sem
+// globals.cpp, ui.cpp, i18n.cpp nem o bloco ARDUINO de totp.cpp (tela, botões,
+// JSON). Este header define as variáveis globais que esses módulos usam e
+// substitui as poucas funções de interface que chamam. Incluir em exatamente
+// um arquivo por teste (o test_main.cpp).
+
+#include <stdio.h>
+#include "globals.h"
+#include "code_table.h"
+#include "service_map.h"
+#include "i18n.h"
+#include "totp.h"
+#include "ui.h"
+
+uint64_t host_now = 1700000000ULL; // Relógio de TimeLib.h (ajustável pelos testes)
+
+TOTPService services[MAX_SERVICES];
+int service_count = 0;
+int current_service_index = -1;
+CurrentTOTPInfo current_totp = {"------", 0, false, false};
+CodeTable code_table = {};
+NameArena name_arena = {};
+KeyArena key_arena = {};
+NvsStore preferences;
+int gmt_offset_hours = 0;
+Language current_language = Language::PT_BR;
+ScreenState current_screen = ScreenState::SCREEN_MENU_MAIN;
+
+const char *getText(StringID key) {
+    static char text[16];
+    snprintf(text, sizeof(text), "<str %d>", (int)key);
+    return text;
+}
+
+void ui_showTemporaryMessage(const char *msg, uint16_t color) {
+    (void)color;
+    printf("[UI] %s\n", msg);
+}
+
+// Versões sem tela de totp.cpp: só o que o armazenamento precisa (busca do segredo)
+bool selectCurrentService(bool allow_fetch) {
+    current_totp.key_pending = svcmap_isLive(current_service_index) && !allow_fetch &&
+                               !codetable_keyState(current_service_index);
+    if (current_totp.key_pending) {
+        snprintf(current_totp.code, sizeof(current_totp.code), "%.*s",
+                 (int)services[current_service_index].digits, "--------");
+        current_totp.valid_key_loaded = false;
+        return true;
+    }
+    current_totp.valid_key_loaded = svcmap_isLive(current_service_index) && codetable_ensureKey(current_service_index);
+    return current_totp.valid_key_loaded;
+}
+
+bool finishPendingService() {
+    if (!current_totp.key_pending) return false;
+    selectCurrentService();
+    return true;
+}
+
+void invalidateCurrentTOTP() {
+    current_totp.valid_key_loaded = false;
+    current_totp.key_pending = false;
+}
@@ -0,0 +1,25 @@
+#pragma once // Include guard
+
+// ============================================================================
+// === BOOT SIMULADO DOS TESTES DO COFRE ===
+// ============================================================================
+// Queda de energia: enche de lixo todo o estado do cofre em RAM ('services' e as
+// arenas de chaves e de nomes) e recarrega só do NVS e da partição "vault", como
+// no boot. Compartilhado pelos testes da placa e do host; um estado novo em RAM
+// entra aqui, não em cópias por teste.
+// Host (test/host no include path): #include <power_cycle.h>
+// Placa: #include "../host/power_cycle.h"
+
+#include <string.h>
+#include "globals.h"
+#include "code_table.h"
+#include "storage.h"
+
+static inline void power_cycle() {
+    memset(services, 0xA5, sizeof(services));
+    memset(&key_arena, 0xA5, sizeof(key_arena));
+    memset(&name_arena, 0xA5, sizeof(name_arena));
+    service_count = 0;
+    loadServices();
+    codetable_rebuildKeys();
+}
@@ -0,0 +1,142 @@
+/*
+  AES-256-GCM e PBKDF2-HMAC-SHA256 no host: vetores do documento do GCM (casos
+  13 a 16), do RFC 7914 / RFC 6070 para SHA-256, recusa de tag, AAD ou IV
+  trocados e ida e volta em todos os comprimentos de segredo.
+  Executar: pio test -e native -f native/test_aes_gcm
+*/
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "crypto/aes_gcm.h"
+#include "crypto/pbkdf2.h"
+
+static size_t from_hex(const char *hex, uint8_t *out) {
+    size_t n = strlen(hex) / 2;
+    for (size_t i = 0; i < n; i++) {
+        unsigned v;
+        sscanf(&hex[2 * i], "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+    return n;
+}
+
+static const char *K15 = "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308";
+static const char *IV15 = "cafebabefacedbaddecaf888";
+static const char *P15 = "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+                         "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255";
+static const char *C15 = "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+                         "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad";
+
+// Cifra e confere texto cifrado e tag; depois decifra de volta
+static void check_vector(const char *k, const char *iv, const char *p, const char *a, const char *c, const char *t) {
+    uint8_t key[32], nonce[12], plain[64], aad[32], cipher[64], tag[16];
+    uint8_t expected_cipher[64], expected_tag[16], out[64], back[64];
+    from_hex(k, key);
+    from_hex(iv, nonce);
+    size_t len = from_hex(p, plain);
+    size_t aad_len = from_hex(a, aad);
+    from_hex(c, expected_cipher);
+    from_hex(t, expected_tag);
+    AesGcmKey gcm;
+    aesgcm_setKey(key, &gcm);
+    aesgcm_encrypt(&gcm, nonce, aad, aad_len, plain, out, len, tag);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected_tag, tag, 16);
+    if (len > 0) TEST_ASSERT_EQUAL_HEX8_ARRAY(expected_cipher, out, len);
+    memcpy(cipher, out, len);
+    TEST_ASSERT_TRUE(aesgcm_decrypt(&gcm, nonce, aad, aad_len, cipher, back, len, tag));
+    if (len > 0) TEST_ASSERT_EQUAL_HEX8_ARRAY(plain, back, len);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_gcm_spec_vectors() {
+    const char *zero_key = "0000000000000000000000000000000000000000000000000000000000000000";
+    check_vector(zero_key, "000000000000000000000000", "", "", "", "530f8afbc74536b9a963b4f1c4cb738b");
+    check_vector(zero_key, "000000000000000000000000", "00000000000000000000000000000000", "",
+                 "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919");
+    check_vector(K15, IV15, P15, "", C15, "b094dac5d93471bdec1a502270e3cc6c");
+    // Caso 16: com AAD e último bloco parcial (60 bytes)
+    char p16[121], c16[121];
+    memcpy(p16, P15, 120);
+    p16[120] = '\0';
+    memcpy(c16, C15, 120);
+    c16[120] = '\0';
+    check_vector(K15, IV15, p16, "feedfacedeadbeeffeedfacedeadbeefabaddad2", c16, "76fc6ece0f4e1768cddf8853bb2d551b");
+}
+
+// Qualquer bit trocado no texto cifrado, na tag, no AAD ou no IV: recusado e saída zerada
+void test_gcm_rejects_tampering() {
+    uint8_t key[32], nonce[12], aad[4] = {1, 0, 0, 0}, plain[20], cipher[20], tag[16], out[20];
+    for (int i = 0; i < 32; i++) key[i] = (uint8_t)(i * 7);
+    for (int i = 0; i < 12; i++) nonce[i] = (uint8_t)(i + 100);
+    for (int i = 0; i < 20; i++) plain[i] = (uint8_t)(i * 13 + 1);
+    AesGcmKey gcm;
+    aesgcm_setKey(key, &gcm);
+    aesgcm_encrypt(&gcm, nonce, aad, sizeof(aad), plain, cipher, sizeof(plain), tag);
+
+    for (size_t bit = 0; bit < sizeof(cipher) * 8; bit++) {
+        cipher[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        memset(out, 0xAA, sizeof(out));
+        TEST_ASSERT_FALSE(aesgcm_decrypt(&gcm, nonce, aad, sizeof(aad), cipher, out, sizeof(out), tag));
+        TEST_ASSERT_EACH_EQUAL_UINT8(0, out, sizeof(out));
+        cipher[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    }
+    for (size_t i = 0; i < sizeof(tag); i++) {
+        tag[i] ^= 0x01;
+        TEST_ASSERT_FALSE(aesgcm_decrypt(&gcm, nonce, aad, sizeof(aad), cipher, out, sizeof(out), tag));
+        tag[i] ^= 0x01;
+    }
+    aad[0] = 2; // Registro de outro segredo
+    TEST_ASSERT_FALSE(aesgcm_decrypt(&gcm, nonce, aad, sizeof(aad), cipher, out, sizeof(out), tag));
+    aad[0] = 1;
+    nonce[11] ^= 0x80;
+    TEST_ASSERT_FALSE(aesgcm_decrypt(&gcm, nonce, aad, sizeof(aad), cipher, out, sizeof(out), tag));
+    nonce[11] ^= 0x80;
+    key[0] ^= 0x01; // Chave errada (outro aparelho ou outra senha)
+    AesGcmKey wrong;
+    aesgcm_setKey(key, &wrong);
+    TEST_ASSERT_FALSE(aesgcm_decrypt(&wrong, nonce, aad, sizeof(aad), cipher, out, sizeof(out), tag));
+    TEST_ASSERT_TRUE(aesgcm_decrypt(&gcm, nonce, aad, sizeof(aad), cipher, out, sizeof(out), tag));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(plain, out, sizeof(plain));
+}
+
+// Todos os comprimentos de segredo do cofre (1 a 64 bytes): ida e volta
+void test_gcm_roundtrip_all_lengths() {
+    uint8_t key[32] = {0x42}, nonce[12] = {0}, plain[64], cipher[64], out[64], tag[16];
+    AesGcmKey gcm;
+    aesgcm_setKey(key, &gcm);
+    for (size_t len = 1; len <= sizeof(plain); len++) {
+        for (size_t i = 0; i < len; i++) plain[i] = (uint8_t)(len + i);
+        nonce[0] = (uint8_t)len;
+        aesgcm_encrypt(&gcm, nonce, nullptr, 0, plain, cipher, len, tag);
+        TEST_ASSERT_TRUE(memcmp(plain, cipher, len) != 0);
+        TEST_ASSERT_TRUE(aesgcm_decrypt(&gcm, nonce, nullptr, 0, cipher, out, len, tag));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(plain, out, len);
+    }
+}
+
+void test_pbkdf2_sha256_vectors() {
+    uint8_t out[32], expected[32];
+    const uint8_t *password = (const uint8_t *)"password";
+    const uint8_t *salt = (const uint8_t *)"salt";
+    pbkdf2_hmac_sha256(password, 8, salt, 4, 1, out, sizeof(out));
+    from_hex("120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b", expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, 32);
+    pbkdf2_hmac_sha256(password, 8, salt, 4, 4096, out, sizeof(out));
+    from_hex("c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a", expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, 32);
+    pbkdf2_hmac_sha256(password, 8, salt, 4, 4096, out, 16); // Saída truncada: prefixo do bloco
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, 16);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gcm_spec_vectors);
+    RUN_TEST(test_gcm_rejects_tampering);
+    RUN_TEST(test_gcm_roundtrip_all_lengths);
+    RUN_TEST(test_pbkdf2_sha256_vectors);
+    return UNITY_END();
+}
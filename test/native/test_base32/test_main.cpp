@@ -0,0 +1,154 @@
+/*
+  Base32 (RFC 4648) no host: vetores do RFC, tabela inteira (256 bytes em todas
+  as posições do grupo), ida e volta para todos os tamanhos de chave e erros.
+  Executar: pio test -e native -f native/test_base32
+*/
+
+#include <unity.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "base32.h"
+
+static const size_t MAX_KEY_LEN = 64; // Igual a MAX_SECRET_BIN_LEN (config.h depende do Arduino)
+static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+void setUp() {}
+void tearDown() {}
+
+static int decode_str(const char *s, uint8_t *out, size_t outSize) {
+    return base32_decode((const uint8_t *)s, strlen(s), out, outSize);
+}
+
+// RFC 4648, seção 10: com e sem padding, maiúsculas e minúsculas
+void test_rfc4648_vectors() {
+    static const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    static const char *padded[] = {"", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB", "MZXW6YTBOI======"};
+    static const char *unpadded[] = {"", "MY", "MZXQ", "MZXW6", "MZXW6YQ", "MZXW6YTB", "MZXW6YTBOI"};
+    static const char *lower[] = {"", "my======", "mzxq====", "mzxw6===", "mzxw6yq=", "mzxw6ytb", "mzxw6ytboi======"};
+    for (size_t i = 0; i < sizeof(plain) / sizeof(plain[0]); i++) {
+        uint8_t out[16];
+        size_t n = strlen(plain[i]);
+        TEST_ASSERT_EQUAL_INT(n, decode_str(padded[i], out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(plain[i], out, n);
+        TEST_ASSERT_EQUAL_INT(n, decode_str(unpadded[i], out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(plain[i], out, n);
+        TEST_ASSERT_EQUAL_INT(n, decode_str(lower[i], out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(plain[i], out, n);
+
+        char enc[32];
+        TEST_ASSERT_EQUAL_INT(strlen(unpadded[i]), base32_encode((const uint8_t *)plain[i], n, enc, sizeof(enc)));
+        TEST_ASSERT_EQUAL_STRING(unpadded[i], enc);
+    }
+}
+
+// Cada um dos 256 valores de byte em cada posição de um grupo completo e de um grupo final
+void test_every_byte_every_position() {
+    for (int c = 0; c < 256; c++) {
+        bool valid = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '2' && c <= '7');
+        for (size_t pos = 0; pos < 16; pos++) {
+            uint8_t in[16], out[10];
+            memset(in, 'A', sizeof(in));
+            in[pos] = (uint8_t)c;
+            int r = base32_decode(in, sizeof(in), out, sizeof(out));
+            if (c == '=' && pos == 15) {
+                TEST_ASSERT_EQUAL_INT(9, r); // Padding legítimo: 15 caracteres úteis
+            } else if (valid) {
+                TEST_ASSERT_EQUAL_INT(10, r);
+            } else {
+                TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_CHAR, r);
+            }
+        }
+        // Grupo final incompleto (7 caracteres -> 4 bytes)
+        for (size_t pos = 0; pos < 7; pos++) {
+            uint8_t in[7], out[4];
+            memset(in, 'A', sizeof(in));
+            in[pos] = (uint8_t)c;
+            int r = base32_decode(in, sizeof(in), out, sizeof(out));
+            if (valid) TEST_ASSERT_EQUAL_INT(4, r);
+            else if (c == '=' && pos == 6) TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_LENGTH, r); // 6 úteis
+            else TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_CHAR, r);
+        }
+    }
+}
+
+// Valor de cada caractere do alfabeto: grupo "cAAAAAAA" decodifica para c << 35
+void test_alphabet_values() {
+    for (int v = 0; v < 32; v++) {
+        char in[9] = "AAAAAAAA";
+        in[0] = ALPHABET[v];
+        uint8_t out[5];
+        TEST_ASSERT_EQUAL_INT(5, decode_str(in, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_HEX8(v << 3, out[0]);
+        in[7] = ALPHABET[v];
+        in[0] = 'A';
+        TEST_ASSERT_EQUAL_INT(5, decode_str(in, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_HEX8(v, out[4]);
+    }
+}
+
+// Ida e volta para todos os tamanhos de 0 a MAX_KEY_LEN, com dados pseudoaleatórios
+void test_roundtrip_all_lengths() {
+    uint32_t seed = 0x5EED;
+    for (size_t len = 0; len <= MAX_KEY_LEN; len++) {
+        for (int round = 0; round < 64; round++) {
+            uint8_t data[MAX_KEY_LEN], out[MAX_KEY_LEN];
+            for (size_t i = 0; i < len; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                data[i] = seed >> 24;
+            }
+            char enc[MAX_KEY_LEN * 2];
+            int chars = base32_encode(data, len, enc, sizeof(enc));
+            TEST_ASSERT_EQUAL_INT((len * 8 + 4) / 5, chars);
+            TEST_ASSERT_EQUAL_INT(len, base32_decodedLength((const uint8_t *)enc, chars));
+            TEST_ASSERT_EQUAL_INT(len, base32_decode((const uint8_t *)enc, chars, out, MAX_KEY_LEN));
+            TEST_ASSERT_EQUAL_MEMORY(data, out, len);
+        }
+    }
+}
+
+// Comprimentos impossíveis (resto 1, 3 ou 6) e comprimento calculado antes de decodificar
+void test_lengths() {
+    static const int expected_tail[8] = {0, -1, 1, -1, 2, 3, -1, 4};
+    for (size_t n = 0; n <= 200; n++) {
+        uint8_t in[200];
+        memset(in, 'B', sizeof(in));
+        int expected = expected_tail[n % 8] < 0 ? BASE32_ERR_INVALID_LENGTH : (int)(n / 8) * 5 + expected_tail[n % 8];
+        TEST_ASSERT_EQUAL_INT(expected, base32_decodedLength(in, n));
+        uint8_t out[200];
+        TEST_ASSERT_EQUAL_INT(expected, base32_decode(in, n, out, sizeof(out)));
+    }
+}
+
+// Resultado maior que o buffer: erro e nenhum byte escrito
+void test_too_long_writes_nothing() {
+    uint8_t in[104];
+    memset(in, 'C', sizeof(in)); // 104 caracteres = 65 bytes
+    uint8_t out[MAX_KEY_LEN + 1];
+    memset(out, 0xA5, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_TOO_LONG, base32_decode(in, sizeof(in), out, MAX_KEY_LEN));
+    for (size_t i = 0; i < sizeof(out); i++) TEST_ASSERT_EQUAL_HEX8(0xA5, out[i]);
+    TEST_ASSERT_EQUAL_INT(65, base32_decode(in, sizeof(in), out, sizeof(out)));
+}
+
+void test_padding_rules() {
+    uint8_t out[16];
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_CHAR, decode_str("MZ=W6YTB", out, sizeof(out)));   // '=' no meio
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_LENGTH, decode_str("MZXW6==", out, sizeof(out)));  // Total não múltiplo de 8
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_CHAR, decode_str("M=======", out, sizeof(out)));   // 7 '=' (máximo é 6)
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_LENGTH, decode_str("MZX=====", out, sizeof(out))); // 3 caracteres úteis
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_CHAR, decode_str("MZXW 6YT", out, sizeof(out)));   // Espaço
+    TEST_ASSERT_EQUAL_INT(BASE32_ERR_INVALID_CHAR, decode_str("MZXW6YT1", out, sizeof(out)));   // '1' fora do alfabeto
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rfc4648_vectors);
+    RUN_TEST(test_every_byte_every_position);
+    RUN_TEST(test_alphabet_values);
+    RUN_TEST(test_roundtrip_all_lengths);
+    RUN_TEST(test_lengths);
+    RUN_TEST(test_too_long_writes_nothing);
+    RUN_TEST(test_padding_rules);
+    return UNITY_END();
+}
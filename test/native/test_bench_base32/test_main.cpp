@@ -0,0 +1,98 @@
+/*
+  Benchmark no host: decodificador Base32 por tabela (grupos de 8) x o decodificador
+  anterior, caractere a caractere com desvios por faixa.
+  Executar: pio test -e native -f native/test_bench_base32 -v   (mostra as mensagens)
+*/
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "base32.h"
+
+static const int BENCH_SECRETS = 1024;
+static const int BENCH_ROUNDS = 200;
+
+// Decodificador anterior (referência): ignora caracteres inválidos e padding
+static int reference_decode(const uint8_t *encoded, size_t encodedLength, uint8_t *result, size_t bufSize) {
+    int buffer = 0, bitsLeft = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < encodedLength && count < bufSize; i++) {
+        uint8_t ch = encoded[i], value = 255;
+        if (ch >= 'A' && ch <= 'Z') value = ch - 'A';
+        else if (ch >= 'a' && ch <= 'z') value = ch - 'a';
+        else if (ch >= '2' && ch <= '7') value = ch - '2' + 26;
+        else continue;
+        buffer = (buffer << 5) | value;
+        bitsLeft += 5;
+        if (bitsLeft >= 8) {
+            result[count++] = (buffer >> (bitsLeft - 8)) & 0xFF;
+            bitsLeft -= 8;
+        }
+    }
+    return (int)count;
+}
+
+static char secrets[BENCH_SECRETS][112];
+static size_t secret_lens[BENCH_SECRETS];
+
+void setUp() {}
+void tearDown() {}
+
+// Segredos de 20 bytes (32 caracteres, típico) e 64 bytes (103 caracteres)
+static void make_secrets(size_t keyLength) {
+    uint32_t seed = 0xB32B32 + (uint32_t)keyLength;
+    for (int s = 0; s < BENCH_SECRETS; s++) {
+        uint8_t key[64];
+        for (size_t i = 0; i < keyLength; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            key[i] = seed >> 24;
+        }
+        secret_lens[s] = base32_encode(key, keyLength, secrets[s], sizeof(secrets[s]));
+    }
+}
+
+static double time_decoder(int (*decode)(const uint8_t *, size_t, uint8_t *, size_t), uint32_t *checksum) {
+    uint8_t out[64];
+    uint32_t sum = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int s = 0; s < BENCH_SECRETS; s++) {
+            int n = decode((const uint8_t *)secrets[s], secret_lens[s], out, sizeof(out));
+            sum += n + out[0] + out[n - 1];
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    *checksum = sum;
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)BENCH_ROUNDS * BENCH_SECRETS);
+}
+
+static void bench_key_length(size_t keyLength) {
+    make_secrets(keyLength);
+    // Mesma saída nos dois decodificadores antes de medir
+    for (int s = 0; s < BENCH_SECRETS; s++) {
+        uint8_t a[64], b[64];
+        TEST_ASSERT_EQUAL_INT(keyLength, base32_decode((const uint8_t *)secrets[s], secret_lens[s], a, sizeof(a)));
+        TEST_ASSERT_EQUAL_INT(keyLength, reference_decode((const uint8_t *)secrets[s], secret_lens[s], b, sizeof(b)));
+        TEST_ASSERT_EQUAL_MEMORY(b, a, keyLength);
+    }
+    uint32_t sum_ref, sum_table;
+    double ns_ref = time_decoder(reference_decode, &sum_ref);
+    double ns_table = time_decoder(base32_decode, &sum_table);
+    TEST_ASSERT_EQUAL_UINT32(sum_ref, sum_table);
+    char line[160];
+    snprintf(line, sizeof(line), "chave de %u bytes (%u chars): referencia %.1f ns, tabela %.1f ns por segredo (%.2fx)",
+             (unsigned)keyLength, (unsigned)secret_lens[0], ns_ref, ns_table, ns_ref / ns_table);
+    TEST_MESSAGE(line);
+}
+
+void bench_20_byte_keys() { bench_key_length(20); }
+void bench_64_byte_keys() { bench_key_length(64); }
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_20_byte_keys);
+    RUN_TEST(bench_64_byte_keys);
+    return UNITY_END();
+}
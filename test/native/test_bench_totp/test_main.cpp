@@ -0,0 +1,147 @@
+/*
+  Benchmark do núcleo TOTP no host: ns por código, códigos por segundo e alocações
+  de heap por código, para cada caminho (chave não preparada, midstate, lote, SHA-256/512),
+  e o custo de uma verificação +-10 intervalos no pior caso (nenhum intervalo confere).
+  Executar: pio test -e native -f native/test_bench_totp -v   (mostra as mensagens)
+*/
+
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "crypto/hmac_sha1_batch.h"
+#include "totp.h"
+
+// ---- Contagem de alocações ----
+// operator new em qualquer host; malloc/calloc/realloc também na glibc (interposição).
+static volatile unsigned long heap_allocations = 0;
+
+void *operator new(size_t size) {
+    heap_allocations++;
+    void *p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void *malloc(size_t size) { heap_allocations++; return __libc_malloc(size); }
+extern "C" void *calloc(size_t n, size_t size) { heap_allocations++; return __libc_calloc(n, size); }
+extern "C" void *realloc(void *p, size_t size) { heap_allocations++; return __libc_realloc(p, size); }
+static const char *ALLOC_SCOPE = "malloc+new";
+#else
+static const char *ALLOC_SCOPE = "new";
+#endif
+
+static const int BENCH_KEYS = 512;
+static const int BENCH_ROUNDS = 400;
+static const uint64_t BENCH_TIMESTAMP = 1234567890ULL;
+
+static uint8_t raw_keys[BENCH_KEYS][64];
+static TOTPKeyState states[BENCH_KEYS];
+static bool valid[BENCH_KEYS];
+static uint32_t codes[BENCH_KEYS];
+static volatile uint32_t sink;
+
+void setUp() {}
+void tearDown() {}
+
+static void report(const char *label, double elapsed_ns, double total_codes, unsigned long allocs) {
+    char line[200];
+    snprintf(line, sizeof(line), "%-28s %8.1f ns/codigo  %10.0f codigos/s  %.3f alocacoes/codigo (%s)",
+             label, elapsed_ns / total_codes, total_codes * 1e9 / elapsed_ns, allocs / total_codes, ALLOC_SCOPE);
+    TEST_MESSAGE(line);
+}
+
+static void prepare_all(OtpAlgorithm algorithm, size_t keyLength) {
+    uint32_t seed = 0x7074 + (uint32_t)algorithm;
+    for (int i = 0; i < BENCH_KEYS; i++) {
+        for (size_t b = 0; b < keyLength; b++) {
+            seed = seed * 1664525u + 1013904223u;
+            raw_keys[i][b] = seed >> 24;
+        }
+        valid[i] = prepareTOTPKey(raw_keys[i], keyLength, &states[i], algorithm, 6, 30);
+    }
+}
+
+// Caminho sem cache: prepara a chave a cada código (como o generateTOTP original)
+void bench_unprepared_key() {
+    prepare_all(OtpAlgorithm::SHA1, 20);
+    unsigned long a0 = heap_allocations;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS / 4; r++) {
+        for (int i = 0; i < BENCH_KEYS; i++) sink = generateTOTP(raw_keys[i], 20, BENCH_TIMESTAMP + r * 30);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    report("generateTOTP (sem midstate)", ns, (double)BENCH_KEYS * (BENCH_ROUNDS / 4), heap_allocations - a0);
+}
+
+static void bench_from_state(const char *label, OtpAlgorithm algorithm, size_t keyLength) {
+    prepare_all(algorithm, keyLength);
+    unsigned long a0 = heap_allocations;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_KEYS; i++) sink = generateTOTPFromState(&states[i], BENCH_TIMESTAMP + r * 30);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    unsigned long allocs = heap_allocations - a0;
+    report(label, ns, (double)BENCH_KEYS * BENCH_ROUNDS, allocs);
+    TEST_ASSERT_EQUAL_UINT32(0, allocs); // Caminho quente sem heap
+}
+
+void bench_sha1_from_state() { bench_from_state("SHA-1 midstate", OtpAlgorithm::SHA1, 20); }
+void bench_sha256_from_state() { bench_from_state("SHA-256 midstate", OtpAlgorithm::SHA256, 32); }
+void bench_sha512_from_state() { bench_from_state("SHA-512 midstate", OtpAlgorithm::SHA512, 64); }
+
+void bench_sha1_batch() {
+    prepare_all(OtpAlgorithm::SHA1, 20);
+    unsigned long a0 = heap_allocations;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        generateTOTPBatch(states, valid, BENCH_KEYS, BENCH_TIMESTAMP + r * 30, codes);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    unsigned long allocs = heap_allocations - a0;
+    char label[48];
+    snprintf(label, sizeof(label), "SHA-1 lote [%s]", hmac_sha1_batch_name());
+    report(label, ns, (double)BENCH_KEYS * BENCH_ROUNDS, allocs);
+    TEST_ASSERT_EQUAL_UINT32(0, allocs);
+}
+
+// Pior caso do verificador: percorre os 21 contadores sem encontrar o código
+void bench_verify_window() {
+    prepare_all(OtpAlgorithm::SHA1, 20);
+    const uint8_t window = 10;
+    unsigned long a0 = heap_allocations;
+    unsigned long accepted = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_KEYS; i++) {
+        uint32_t wrong = (generateTOTPFromState(&states[i], BENCH_TIMESTAMP) + 1) % 1000000;
+        int offset;
+        accepted += verifyTOTPFromState(&states[i], BENCH_TIMESTAMP, wrong, window, &offset);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    unsigned long allocs = heap_allocations - a0;
+    char line[160];
+    snprintf(line, sizeof(line), "verificacao +-%d (SHA-1)     %8.2f us/verificacao  %.1f ns/contador  (%lu colisoes)",
+             window, ns / BENCH_KEYS / 1000.0, ns / BENCH_KEYS / (2 * window + 2), accepted);
+    TEST_MESSAGE(line); // 2 * window + 2: inclui a geração do código errado
+    TEST_ASSERT_EQUAL_UINT32(0, allocs);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_unprepared_key);
+    RUN_TEST(bench_sha1_from_state);
+    RUN_TEST(bench_sha1_batch);
+    RUN_TEST(bench_sha256_from_state);
+    RUN_TEST(bench_sha512_from_state);
+    RUN_TEST(bench_verify_window);
+    return UNITY_END();
+}
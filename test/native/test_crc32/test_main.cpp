@@ -0,0 +1,49 @@
+/*
+  CRC-32 no host: valor de verificação padrão, cálculo em partes e detecção de
+  um bit trocado em qualquer posição.
+  Executar: pio test -e native -f native/test_crc32
+*/
+
+#include <unity.h>
+#include <string.h>
+
+#include "crc32.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Valor de verificação do CRC-32/ISO-HDLC ("123456789")
+void test_check_value() {
+    const char *check = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32_update((const uint8_t *)check, strlen(check)));
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, crc32_update(nullptr, 0));
+}
+
+void test_incremental_matches_one_shot() {
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)(i * 31 + 7);
+    uint32_t whole = crc32_update(data, sizeof(data));
+    for (size_t split = 0; split <= sizeof(data); split += 37) {
+        uint32_t crc = crc32_update(data, split);
+        TEST_ASSERT_EQUAL_HEX32(whole, crc32_update(data + split, sizeof(data) - split, crc));
+    }
+}
+
+void test_detects_single_bit_flip() {
+    uint8_t data[64];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)i;
+    uint32_t reference = crc32_update(data, sizeof(data));
+    for (size_t bit = 0; bit < sizeof(data) * 8; bit++) {
+        data[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        TEST_ASSERT_NOT_EQUAL(reference, crc32_update(data, sizeof(data)));
+        data[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_check_value);
+    RUN_TEST(test_incremental_matches_one_shot);
+    RUN_TEST(test_detects_single_bit_flip);
+    return UNITY_END();
+}
@@ -0,0 +1,220 @@
+/*
+  Armazenamento de registros sobre a flash simulada: milhares de registros com
+  consulta pelo índice, remontagem (boot), coleta de setores com substituições e
+  tombstones, e gravações cortadas por queda de energia.
+  Executar: pio test -e native -f native/test_record_store
+*/
+
+#include <unity.h>
+#include <string.h>
+#include <chrono>
+
+#include "config.h"
+#include "record_store.h"
+
+static const int MANY = RSTORE_MAX_RECORDS;
+
+// Conteúdo determinístico por id e versão, com comprimento variável (38 a 101 bytes)
+static size_t make_record(uint32_t id, uint32_t version, uint8_t *out) {
+    size_t length = 38 + (id * 7 + version) % 64;
+    for (size_t i = 0; i < length; i++) out[i] = (uint8_t)(id * 31 + version * 17 + i);
+    return length;
+}
+
+static void assert_record(uint32_t id, uint32_t version) {
+    uint8_t expected[RSTORE_MAX_RECORD_LEN];
+    uint8_t actual[RSTORE_MAX_RECORD_LEN];
+    size_t length = make_record(id, version, expected);
+    size_t got = 0;
+    TEST_ASSERT_TRUE(rstore_get(id, actual, sizeof(actual), &got));
+    TEST_ASSERT_EQUAL(length, got);
+    TEST_ASSERT_EQUAL_MEMORY(expected, actual, length);
+}
+
+static void put(uint32_t id, uint32_t version) {
+    uint8_t data[RSTORE_MAX_RECORD_LEN];
+    size_t length = make_record(id, version, data);
+    TEST_ASSERT_TRUE(rstore_put(id, data, length));
+}
+
+void setUp() {
+    TEST_ASSERT_TRUE(rstore_begin());
+    rstore_format();
+}
+
+void tearDown() {}
+
+// Milhares de registros: todos legíveis antes e depois de remontar
+void test_thousands_of_records() {
+    for (int id = 0; id < MANY; id++) put((uint32_t)id * 3 + 1, 0);
+    TEST_ASSERT_EQUAL_UINT32(MANY, rstore_getStats().records);
+    uint8_t data[8] = {1};
+    TEST_ASSERT_FALSE(rstore_put(999999, data, sizeof(data))); // Índice cheio: recusa id novo
+    TEST_ASSERT_TRUE(rstore_put(1, data, sizeof(data)));       // Mas substitui um existente
+    put(1, 0);
+    TEST_ASSERT_TRUE(rstore_begin());
+    TEST_ASSERT_EQUAL_UINT32(MANY, rstore_getStats().records);
+    for (int id = 0; id < MANY; id++) assert_record((uint32_t)id * 3 + 1, 0);
+    TEST_ASSERT_FALSE(rstore_contains(2));
+}
+
+// A consulta não depende do número de registros: 100 e MANY registros custam quase o mesmo
+static double lookup_ns(int records, bool *found_out) {
+    rstore_format();
+    for (int id = 0; id < records; id++) put((uint32_t)id, 0);
+    uint8_t out[RSTORE_MAX_RECORD_LEN];
+    size_t length;
+    const int lookups = 20000;
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < lookups; n++) {
+        found += rstore_get((uint32_t)((n * 7919) % records), out, sizeof(out), &length);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    *found_out = found == lookups;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / lookups;
+}
+
+void test_lookup_is_constant_time() {
+    bool all_small, all_large;
+    double small = lookup_ns(100, &all_small);
+    double large = lookup_ns(MANY, &all_large);
+    TEST_ASSERT_TRUE(all_small && all_large);
+    printf("[BENCH] rstore_get: %.0f ns com 100 registros, %.0f ns com %d\n", small, large, MANY);
+    TEST_ASSERT_TRUE(large < small * 3 + 200);
+}
+
+// Substituições e remoções contínuas: a coleta em segundo plano acompanha, nada
+// se perde e a coleta síncrona (dentro de uma gravação) não acontece
+void test_background_gc_keeps_up() {
+    const int live = 500;
+    RecordStoreStats before = rstore_getStats();
+    static uint32_t version[live];
+    static bool present[live];
+    for (int id = 0; id < live; id++) {
+        put((uint32_t)id, 0);
+        version[id] = 0;
+        present[id] = true;
+    }
+    for (int step = 0; step < 40000; step++) {
+        uint32_t id = (uint32_t)((step * 2654435761u) >> 7) % live;
+        if (step % 5 == 0 && present[id]) {
+            TEST_ASSERT_TRUE(rstore_remove(id));
+            present[id] = false;
+        } else {
+            put(id, ++version[id]);
+            present[id] = true;
+        }
+        if (step % 8 == 0) rstore_tick();
+    }
+    RecordStoreStats stats = rstore_getStats();
+    TEST_ASSERT_TRUE(stats.gc_sectors > before.gc_sectors);
+    TEST_ASSERT_EQUAL_UINT32(before.forced_gc, stats.forced_gc);
+    TEST_ASSERT_TRUE(rstore_begin());
+    for (int id = 0; id < live; id++) {
+        if (present[id]) assert_record((uint32_t)id, version[id]);
+        else TEST_ASSERT_FALSE(rstore_contains((uint32_t)id));
+    }
+    printf("[BENCH] %lu gravações, %lu setores coletados, %lu realocados\n",
+           (unsigned long)(stats.appends - before.appends), (unsigned long)(stats.gc_sectors - before.gc_sectors),
+           (unsigned long)(stats.gc_relocated - before.gc_relocated));
+}
+
+// Sem rstore_tick(): a gravação coleta sozinha quando só resta a reserva, e os
+// registros que nunca mudam são realocados a cada volta do anel
+void test_forced_gc_without_ticks() {
+    RecordStoreStats before = rstore_getStats();
+    for (uint32_t id = 1000; id < 1300; id++) put(id, 0);
+    for (int step = 0; step < 30000; step++) put((uint32_t)(step % 50), (uint32_t)step);
+    RecordStoreStats stats = rstore_getStats();
+    TEST_ASSERT_TRUE(stats.forced_gc > before.forced_gc);
+    TEST_ASSERT_TRUE(stats.gc_relocated - before.gc_relocated >= 300);
+    TEST_ASSERT_TRUE(rstore_begin());
+    for (int id = 0; id < 50; id++) assert_record((uint32_t)id, (uint32_t)(29950 + id));
+    for (uint32_t id = 1000; id < 1300; id++) assert_record(id, 0);
+}
+
+// Tombstone sobrevive à remontagem, e a remoção não mexe em nenhum outro registro
+void test_remove_is_local() {
+    for (uint32_t id = 0; id < 10; id++) put(id, 0);
+    uint32_t written = rstore_getStats().bytes_written;
+    TEST_ASSERT_TRUE(rstore_remove(4));
+    TEST_ASSERT_EQUAL_UINT32(12, rstore_getStats().bytes_written - written); // Só o tombstone
+    TEST_ASSERT_TRUE(rstore_remove(4)); // Já removido: nada a fazer
+    TEST_ASSERT_EQUAL_UINT32(12, rstore_getStats().bytes_written - written);
+    TEST_ASSERT_TRUE(rstore_begin());
+    TEST_ASSERT_FALSE(rstore_contains(4));
+    for (uint32_t id = 0; id < 10; id++) {
+        if (id != 4) assert_record(id, 0);
+    }
+}
+
+// Último registro de 'id' na flash simulada, percorrendo os setores em ordem de endereço
+// (nos testes abaixo, a mesma ordem da gravação)
+static size_t find_last(uint32_t id) {
+    const uint8_t *flash = rstore_hostFlash();
+    size_t found = 0;
+    for (size_t s = 0; s < RSTORE_HOST_FLASH_BYTES; s += RSTORE_SECTOR_SIZE) {
+        for (size_t p = s + 8; p + 12 <= s + RSTORE_SECTOR_SIZE;) {
+            uint32_t record_id;
+            uint16_t length;
+            memcpy(&record_id, &flash[p], sizeof(record_id));
+            memcpy(&length, &flash[p + 4], sizeof(length));
+            if (record_id == 0xFFFFFFFF) break;
+            if (record_id == id) found = p;
+            p += 12 + ((length + 3u) & ~3u);
+        }
+    }
+    return found;
+}
+
+// Queda de energia no meio da última gravação: a versão anterior continua valendo
+// e as gravações seguintes vão para um setor novo
+void test_torn_write_keeps_previous_version() {
+    put(7, 1);
+    put(8, 1);
+    put(7, 2);
+    uint8_t *flash = rstore_hostFlash();
+    size_t pos = find_last(7);
+    TEST_ASSERT_TRUE(pos > 0);
+    memset(&flash[pos], 0xFF, 12); // Dados gravados, cabeçalho ainda não
+    TEST_ASSERT_TRUE(rstore_begin());
+    assert_record(7, 1);
+    assert_record(8, 1);
+    uint32_t free_sectors = rstore_getStats().free_sectors;
+    put(9, 1); // Nada é gravado depois dos restos da gravação cortada
+    TEST_ASSERT_EQUAL_UINT32(free_sectors - 1, rstore_getStats().free_sectors);
+    TEST_ASSERT_TRUE(rstore_begin());
+    assert_record(9, 1);
+
+    // Cabeçalho gravado pela metade (CRC ainda apagado): mesmo resultado
+    put(8, 2);
+    pos = find_last(8);
+    memset(&flash[pos + 8], 0xFF, 4);
+    TEST_ASSERT_TRUE(rstore_begin());
+    assert_record(8, 1);
+    assert_record(9, 1);
+}
+
+// Um bit trocado num registro já gravado: a leitura recusa em vez de devolver lixo
+void test_corrupted_record_is_rejected() {
+    put(3, 0);
+    size_t pos = find_last(3);
+    TEST_ASSERT_TRUE(pos > 0);
+    rstore_hostFlash()[pos + 12 + 5] ^= 0x01;
+    uint8_t out[RSTORE_MAX_RECORD_LEN];
+    size_t length;
+    TEST_ASSERT_FALSE(rstore_get(3, out, sizeof(out), &length));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_thousands_of_records);
+    RUN_TEST(test_lookup_is_constant_time);
+    RUN_TEST(test_background_gc_keeps_up);
+    RUN_TEST(test_forced_gc_without_ticks);
+    RUN_TEST(test_remove_is_local);
+    RUN_TEST(test_torn_write_keeps_previous_version);
+    RUN_TEST(test_corrupted_record_is_rejected);
+    return UNITY_END();
+}
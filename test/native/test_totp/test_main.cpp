@@ -0,0 +1,128 @@
+/*
+  Núcleo TOTP no host (src/totp.cpp + src/crypto, sem Arduino): vetores RFC 4226,
+  RFC 6238 (SHA-1/256/512, 8 dígitos) e segredos Base32 ponta a ponta.
+  Executar: pio test -e native -f native/test_totp
+*/
+
+#include <unity.h>
+#include <string.h>
+
+#include "base32.h"
+#include "totp.h"
+
+static const uint8_t RFC_KEY[] = "12345678901234567890";
+static const uint8_t RFC_KEY_SHA256[] = "12345678901234567890123456789012";
+static const uint8_t RFC_KEY_SHA512[] = "1234567890123456789012345678901234567890123456789012345678901234";
+static const uint64_t RFC6238_TIMES[] = {59ULL, 1111111109ULL, 1111111111ULL, 1234567890ULL, 2000000000ULL, 20000000000ULL};
+static const size_t RFC6238_COUNT = sizeof(RFC6238_TIMES) / sizeof(RFC6238_TIMES[0]);
+
+void setUp() {}
+void tearDown() {}
+
+// RFC 4226, Apêndice D: HOTP com contadores 0..9
+void test_rfc4226_vectors() {
+    static const uint32_t expected[] = {755224, 287082, 359152, 969429, 338314,
+                                        254676, 287922, 162583, 399871, 520489};
+    TOTPKeyState state;
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY, 20, &state));
+    for (int c = 0; c < 10; c++) {
+        TEST_ASSERT_EQUAL_UINT32(expected[c], generateOTPFromState(&state, c));
+        TEST_ASSERT_EQUAL_UINT32(expected[c], generateTOTP(RFC_KEY, 20, c, 1)); // Intervalo 1 s = contador
+    }
+}
+
+// RFC 6238, Apêndice B: os três algoritmos com 8 dígitos
+void test_rfc6238_vectors() {
+    static const uint32_t sha1[] = {94287082, 7081804, 14050471, 89005924, 69279037, 65353130};
+    static const uint32_t sha256[] = {46119246, 68084774, 67062674, 91819424, 90698825, 77737706};
+    static const uint32_t sha512[] = {90693936, 25091201, 99943326, 93441116, 38618901, 47863826};
+    TOTPKeyState s1, s256, s512;
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY, 20, &s1, OtpAlgorithm::SHA1, 8, 30));
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY_SHA256, 32, &s256, OtpAlgorithm::SHA256, 8, 30));
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY_SHA512, 64, &s512, OtpAlgorithm::SHA512, 8, 30));
+    for (size_t i = 0; i < RFC6238_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT32(sha1[i], generateTOTPFromState(&s1, RFC6238_TIMES[i]));
+        TEST_ASSERT_EQUAL_UINT32(sha256[i], generateTOTPFromState(&s256, RFC6238_TIMES[i]));
+        TEST_ASSERT_EQUAL_UINT32(sha512[i], generateTOTPFromState(&s512, RFC6238_TIMES[i]));
+        TEST_ASSERT_EQUAL_UINT32(sha1[i] % 1000000, generateTOTP(RFC_KEY, 20, RFC6238_TIMES[i]));
+    }
+}
+
+// Segredo Base32 -> chave -> código, como no load do cofre
+void test_base32_secret_to_code() {
+    static const char *secrets[] = {
+        "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ",
+        "gezdgnbvgy3tqojqgezdgnbvgy3tqojq",
+        "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ========", // Padding extra inválido (mais de 6 '=')
+    };
+    uint8_t key[64];
+    for (int i = 0; i < 2; i++) {
+        int len = base32_decode((const uint8_t *)secrets[i], strlen(secrets[i]), key, sizeof(key));
+        TEST_ASSERT_EQUAL_INT(20, len);
+        TEST_ASSERT_EQUAL_UINT32(287082, generateTOTP(key, len, 59));
+    }
+    TEST_ASSERT_TRUE(base32_decode((const uint8_t *)secrets[2], strlen(secrets[2]), key, sizeof(key)) < 0);
+    // Chave SHA-512 de 64 bytes também cabe no limite do cofre
+    char b32[128];
+    TEST_ASSERT_EQUAL_INT(103, base32_encode(RFC_KEY_SHA512, 64, b32, sizeof(b32)));
+    TEST_ASSERT_EQUAL_INT(64, base32_decode((const uint8_t *)b32, 103, key, sizeof(key)));
+    TEST_ASSERT_EQUAL_MEMORY(RFC_KEY_SHA512, key, 64);
+}
+
+// Lote (faixas SIMD no host) igual à geração individual, com algoritmos e períodos misturados
+void test_batch_matches_single_shot() {
+    static TOTPKeyState keys[37];
+    static bool valid[37];
+    uint32_t codes[37];
+    for (int i = 0; i < 37; i++) {
+        uint8_t key[20];
+        for (int b = 0; b < 20; b++) key[b] = (uint8_t)(i * 31 + b * 7);
+        OtpAlgorithm algo = i % 5 == 4 ? OtpAlgorithm::SHA256 : OtpAlgorithm::SHA1;
+        valid[i] = prepareTOTPKey(key, 20, &keys[i], algo, i % 3 ? 6 : 8, i % 4 ? 30 : 60) && i != 11;
+    }
+    generateTOTPBatch(keys, valid, 37, 1234567890ULL, codes);
+    for (int i = 0; i < 37; i++) {
+        TEST_ASSERT_EQUAL_UINT32(valid[i] ? generateTOTPFromState(&keys[i], 1234567890ULL) : 0, codes[i]);
+    }
+}
+
+// Verificador: desvio mais próximo, limites da janela e dígitos do serviço
+void test_verify_window() {
+    TOTPKeyState state;
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY, 20, &state));
+    const uint64_t ts = 1234567890ULL;
+    int offset = 99;
+    TEST_ASSERT_TRUE(verifyTOTPFromState(&state, ts, generateTOTPFromState(&state, ts), 0, &offset));
+    TEST_ASSERT_EQUAL_INT(0, offset);
+    TEST_ASSERT_TRUE(verifyTOTPFromState(&state, ts, generateTOTPFromState(&state, ts - 30), 1, &offset));
+    TEST_ASSERT_EQUAL_INT(-1, offset);
+    TEST_ASSERT_TRUE(verifyTOTPFromState(&state, ts, generateTOTPFromState(&state, ts + 10 * 30), 10, &offset));
+    TEST_ASSERT_EQUAL_INT(10, offset);
+    TEST_ASSERT_FALSE(verifyTOTPFromState(&state, ts, generateTOTPFromState(&state, ts + 11 * 30), 10, &offset));
+    TEST_ASSERT_FALSE(verifyTOTPFromState(&state, ts, 1000000, 10, &offset)); // Mais dígitos que o serviço
+
+    // Perto da época: contadores negativos são ignorados, não embrulham
+    TEST_ASSERT_TRUE(verifyTOTPFromState(&state, 59, 287082, 2, &offset)); // RFC 4226, contador 1
+    TEST_ASSERT_EQUAL_INT(0, offset);
+    TEST_ASSERT_TRUE(verifyTOTPFromState(&state, 0, 287082, 2, &offset));
+    TEST_ASSERT_EQUAL_INT(1, offset);
+}
+
+void test_invalid_parameters() {
+    TOTPKeyState state;
+    TEST_ASSERT_FALSE(prepareTOTPKey(RFC_KEY, 0, &state));
+    TEST_ASSERT_FALSE(prepareTOTPKey(RFC_KEY, 20, &state, OtpAlgorithm::SHA1, 7, 30));
+    TEST_ASSERT_FALSE(prepareTOTPKey(RFC_KEY, 20, &state, OtpAlgorithm::SHA1, 6, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, generateTOTP(RFC_KEY, 20, 59, 0));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rfc4226_vectors);
+    RUN_TEST(test_rfc6238_vectors);
+    RUN_TEST(test_base32_secret_to_code);
+    RUN_TEST(test_batch_matches_single_shot);
+    RUN_TEST(test_verify_window);
+    RUN_TEST(test_invalid_parameters);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+/*
+  Arena de nomes dos serviços: RAM reservada por 100 serviços contra os slots de
+  tamanho fixo anteriores (nome de 21 bytes em cada TOTPService), velocidade de
+  percorrer a lista e de buscar por nome, e remoção (buracos), recolha e arena cheia.
+  Executar: pio test -e native-storage -f native_storage/test_bench_service_arena
+*/
+
+#include <unity.h>
+#include <host_env.h>
+#include <chrono>
+
+#include "name_store.h"
+
+// Layout anterior, só para comparação: nome embutido em cada slot
+struct FixedSlotService {
+    char name[MAX_SERVICE_NAME_LEN + 1];
+    OtpAlgorithm algorithm;
+    uint8_t digits;
+    uint16_t period;
+    OtpKind kind;
+    uint64_t counter;
+    uint32_t secret_id;
+};
+
+static const char *TYPICAL[] = {"GitHub", "Google", "AWS root", "Microsoft", "Dropbox", "banco", "VPN trabalho",
+                                "Discord", "Cloudflare", "ProtonMail", "npm", "Steam", "Twitter", "GitLab"};
+static const int TYPICAL_COUNT = sizeof(TYPICAL) / sizeof(TYPICAL[0]);
+
+static FixedSlotService fixed[MAX_SERVICES];
+
+static void name_for(int i, char *out, size_t size) {
+    snprintf(out, size, "%s %d", TYPICAL[i % TYPICAL_COUNT], i / TYPICAL_COUNT);
+}
+
+// Mesmos nomes nos dois layouts
+static void fill(int count) {
+    namestore_clear();
+    memset(fixed, 0, sizeof(fixed));
+    for (int i = 0; i < count; i++) {
+        char name[MAX_SERVICE_NAME_LEN + 1];
+        name_for(i, name, sizeof(name));
+        TEST_ASSERT_TRUE(namestore_set(i, name, strlen(name)));
+        strcpy(fixed[i].name, name);
+    }
+}
+
+// Hash FNV-1a de todos os nomes (o que o journal HOTP e a lista fazem: tocar cada nome)
+static uint32_t hash(uint32_t h, const char *name) {
+    for (; *name; name++) h = (h ^ (uint8_t)*name) * 16777619u;
+    return h;
+}
+
+template <typename F>
+static double ns_per_pass(int passes, F body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < passes; p++) body();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / passes;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// RAM reservada (estática) para a lista de serviços, por 100 serviços
+void test_ram_per_100_services() {
+    size_t before = sizeof(FixedSlotService) * 100;
+    size_t after = sizeof(TOTPService) * 100 + sizeof(NameArena) * 100 / MAX_SERVICES;
+    fill(MAX_SERVICES);
+    printf("[BENCH] Lista de 100 serviços: slots fixos %u B (%u por serviço), arena %u B (%u por serviço + %u de nomes)"
+           " -> %u B a menos (%.0f%%)\n",
+           (unsigned)before, (unsigned)sizeof(FixedSlotService), (unsigned)after, (unsigned)sizeof(TOTPService),
+           (unsigned)(sizeof(NameArena) / MAX_SERVICES), (unsigned)(before - after), 100.0 * (before - after) / before);
+    printf("[BENCH] Nomes típicos ocupam %u de %u B da arena\n", (unsigned)name_arena.used, (unsigned)NAME_ARENA_BYTES);
+    TEST_ASSERT_EQUAL(24, sizeof(TOTPService)); // Sem buracos entre os campos
+    TEST_ASSERT_TRUE(after < before);
+    TEST_ASSERT_TRUE(name_arena.used <= NAME_ARENA_BYTES);
+}
+
+// Percorrer a lista e buscar por nome: memória seguida contra um nome a cada 48 bytes
+void test_iteration_speed() {
+    fill(MAX_SERVICES);
+    const int passes = 20000;
+    volatile uint32_t sink = 0;
+    double fixed_scan = ns_per_pass(passes, [&] {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < MAX_SERVICES; i++) h = hash(h, fixed[i].name);
+        sink = sink + h;
+    });
+    double arena_scan = ns_per_pass(passes, [&] {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < MAX_SERVICES; i++) h = hash(h, namestore_get(i));
+        sink = sink + h;
+    });
+    char last[MAX_SERVICE_NAME_LEN + 1];
+    name_for(MAX_SERVICES - 1, last, sizeof(last)); // Pior caso: último da lista
+    double fixed_find = ns_per_pass(passes, [&] {
+        int found = -1;
+        for (int i = 0; i < MAX_SERVICES && found < 0; i++) {
+            if (strcmp(fixed[i].name, last) == 0) found = i;
+        }
+        sink = sink + found;
+    });
+    double arena_find = ns_per_pass(passes, [&] { sink = sink + namestore_find(last); });
+    TEST_ASSERT_EQUAL(MAX_SERVICES - 1, namestore_find(last));
+    printf("[BENCH] Percorrer %d nomes: slots fixos %.0f ns, arena %.0f ns\n", MAX_SERVICES, fixed_scan, arena_scan);
+    printf("[BENCH] Buscar o último nome: slots fixos %.0f ns, arena %.0f ns\n", fixed_find, arena_find);
+    TEST_ASSERT_TRUE(arena_scan < fixed_scan * 2 + 500);
+    TEST_ASSERT_TRUE(arena_find < fixed_find * 2 + 500);
+}
+
+// Remoção deixa um buraco sem mover os outros nomes; quando um nome novo não cabe no
+// fim, os buracos são recolhidos; nome que não cabe nem assim é recusado inteiro
+void test_remove_and_full_arena() {
+    fill(5);
+    char third[MAX_SERVICE_NAME_LEN + 1];
+    strcpy(third, namestore_get(3));
+    const char *third_at = namestore_get(3);
+    uint16_t used = name_arena.used;
+    size_t free_before = namestore_free();
+    size_t removed = namestore_length(1);
+    namestore_remove(1);
+    TEST_ASSERT_EQUAL(used, name_arena.used); // Nada se move
+    TEST_ASSERT_EQUAL(free_before + removed + 1, namestore_free());
+    TEST_ASSERT_TRUE(third_at == namestore_get(3)); // Mesmo endereço
+    TEST_ASSERT_EQUAL_STRING(third, namestore_get(3));
+    TEST_ASSERT_EQUAL(3, namestore_find(third));
+    TEST_ASSERT_EQUAL(-1, namestore_find("Google")); // Prefixo não é o nome
+    TEST_ASSERT_EQUAL_STRING("", namestore_get(1));
+    size_t last = namestore_length(4);
+    namestore_remove(4); // Último da arena: só encolhe
+    TEST_ASSERT_EQUAL(used - last - 1, name_arena.used);
+
+    namestore_clear();
+    const char *longest = "12345678901234567890";
+    int fitted = 0;
+    while (fitted < MAX_SERVICES && namestore_set(fitted, longest, strlen(longest))) fitted++;
+    TEST_ASSERT_EQUAL(NAME_ARENA_BYTES / (MAX_SERVICE_NAME_LEN + 1), fitted);
+    TEST_ASSERT_TRUE(namestore_free() < MAX_SERVICE_NAME_LEN + 1);
+    TEST_ASSERT_TRUE(namestore_set(fitted, "x", 1)); // O que cabe ainda entra
+    TEST_ASSERT_FALSE(namestore_set(fitted + 1, longest, MAX_SERVICE_NAME_LEN + 1)); // Longo demais
+    TEST_ASSERT_FALSE(namestore_set(fitted + 1, longest, strlen(longest)));          // Sem espaço nem nos buracos
+    namestore_remove(10);
+    TEST_ASSERT_TRUE(namestore_set(fitted + 1, "recolhido", 9)); // Não cabe no fim: recolhe o buraco
+    TEST_ASSERT_EQUAL(0, name_arena.holes);
+    TEST_ASSERT_EQUAL_STRING("recolhido", namestore_get(fitted + 1));
+    TEST_ASSERT_EQUAL_STRING("x", namestore_get(fitted));
+    for (int i = 0; i < fitted; i++) {
+        if (i != 10) TEST_ASSERT_EQUAL_STRING(longest, namestore_get(i));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ram_per_100_services);
+    RUN_TEST(test_iteration_speed);
+    RUN_TEST(test_remove_and_full_arena);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+/*
+  Custo de cada ação do usuário no armazenamento, medido no modelo de NVS do host:
+  operações, bytes gravados, entradas de 32 bytes, apagamentos de página e tempo
+  modelado do NVS, mais bytes e apagamentos de setor na partição "vault".
+  Termina com o desgaste por página depois de um uso prolongado.
+  Executar: pio test -e native-storage -f native_storage/test_bench_storage_actions
+*/
+
+#include <unity.h>
+#include <host_env.h>
+
+#include "hotp_journal.h"
+#include "key_store.h"
+#include "nvs_backend.h"
+#include "record_store.h"
+#include "service_map.h"
+#include "storage.h"
+#include <power_cycle.h>
+
+static const int BASE_SERVICES = 20;
+static const char *SECRET = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+
+struct Snapshot {
+    NvsStats nvs;
+    RecordStoreStats vault;
+};
+
+static Snapshot take() {
+    return {nvs_getStats(), rstore_getStats()};
+}
+
+// Uma linha da tabela: diferença entre dois retratos dividida por 'repeats'
+static void report(const char *action, const Snapshot &before, const Snapshot &after, int repeats) {
+    double n = repeats;
+    printf("[BENCH] %-22s %6.1f %6.1f %8.1f %7.1f %5.2f %9.2f | %8.1f %5.2f\n", action,
+           (after.nvs.reads - before.nvs.reads) / n, (after.nvs.writes + after.nvs.removes - before.nvs.writes - before.nvs.removes) / n,
+           (after.nvs.bytes_written - before.nvs.bytes_written) / n,
+           (after.nvs.entries_written - before.nvs.entries_written) / n,
+           (after.nvs.page_erases - before.nvs.page_erases) / n, (after.nvs.busy_us - before.nvs.busy_us) / n / 1000.0,
+           (after.vault.bytes_written - before.vault.bytes_written) / n,
+           (after.vault.sector_erases - before.vault.sector_erases) / n);
+}
+
+static void tick() {
+    storage_tick();
+    hotp_tick();
+    rstore_tick();
+}
+
+static void add_service(int n, OtpKind kind) {
+    char name[12];
+    snprintf(name, sizeof(name), "svc%03d", n);
+    TEST_ASSERT_TRUE(storage_saveService(name, SECRET, OtpAlgorithm::SHA1, 6, 30, kind, 0));
+}
+
+void setUp() {
+    nvs_hostReset();
+    TEST_ASSERT_TRUE(rstore_begin());
+    rstore_format();
+    keystore_clear();
+    service_count = 0;
+    power_cycle();
+    for (int i = 0; i < BASE_SERVICES; i++) add_service(i, i == 0 ? OtpKind::HOTP : OtpKind::TOTP);
+    for (int i = 0; i < VAULT_LOG_SLOTS; i++) tick(); // Log compactado: cada ação parte do estado de repouso
+    power_cycle();
+}
+
+void tearDown() {}
+
+void test_cost_per_action() {
+    printf("[BENCH] %-22s %6s %6s %8s %7s %5s %9s | %8s %5s\n", "ação (média)", "leit.", "grav.", "bytes",
+           "entr.", "pág.", "NVS (ms)", "vault B", "set.");
+
+    Snapshot before = take();
+    power_cycle();
+    Snapshot after = take();
+    report("boot (índice)", before, after, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, after.nvs.writes - before.nvs.writes); // Boot não grava nada
+    TEST_ASSERT_EQUAL_UINT32(0, after.vault.appends - before.vault.appends);
+
+    before = take();
+    TEST_ASSERT_TRUE(codetable_ensureKey(5)); // Primeiro código: desbloqueio (PBKDF2) + um segredo
+    after = take();
+    report("primeiro código", before, after, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, after.nvs.writes - before.nvs.writes);
+
+    before = take();
+    for (int i = 6; i < 6 + KEY_CACHE_SLOTS; i++) TEST_ASSERT_TRUE(codetable_ensureKey(i));
+    after = take();
+    report("outro serviço", before, after, KEY_CACHE_SLOTS);
+
+    const int adds = VAULT_LOG_SLOTS / 4; // Sem encher o log: o caso comum
+    before = take();
+    for (int i = 0; i < adds; i++) add_service(BASE_SERVICES + i, OtpKind::TOTP);
+    after = take();
+    report("adicionar serviço", before, after, adds);
+    TEST_ASSERT_EQUAL_UINT32(adds, after.nvs.writes - before.nvs.writes);  // Uma entrada de log cada
+    TEST_ASSERT_EQUAL_UINT32(adds, after.vault.appends - before.vault.appends); // Um segredo selado cada
+
+    before = take();
+    for (int i = 0; i < adds; i++) TEST_ASSERT_TRUE(storage_deleteService(svcmap_at(BASE_SERVICES)));
+    after = take();
+    report("remover serviço", before, after, adds);
+    TEST_ASSERT_EQUAL_UINT32(adds, after.nvs.writes - before.nvs.writes);  // Um tombstone cada
+    TEST_ASSERT_EQUAL_UINT32(adds, after.vault.appends - before.vault.appends); // Um tombstone de segredo cada
+
+    before = take();
+    int ticks = 0;
+    for (; ticks < VAULT_LOG_SLOTS && storage_getStats().compactions == 0; ticks++) tick();
+    for (int i = 0; i < VAULT_LOG_SLOTS; i++, ticks++) tick(); // Limpeza das chaves de log já compactadas
+    after = take();
+    report("compactação (total)", before, after, 1);
+
+    const int presses = HOTP_JOURNAL_SLOTS * 4;
+    before = take();
+    for (int i = 0; i < presses; i++) {
+        uint32_t code;
+        TEST_ASSERT_TRUE(hotp_generate(0, &code));
+        if (i % 4 == 3) tick(); // Uma atualização regular a cada poucos toques
+    }
+    after = take();
+    report("código HOTP (c/ dobra)", before, after, presses);
+    TEST_ASSERT_TRUE(after.nvs.writes - before.nvs.writes < (uint32_t)presses * 2);
+}
+
+// Uso prolongado (um ano de toques HOTP e algumas trocas de serviço): o desgaste se
+// espalha pelas páginas em vez de se concentrar numa só
+void test_wear_after_long_use() {
+    const int days = 365;
+    for (int day = 0; day < days; day++) {
+        for (int press = 0; press < 5; press++) {
+            uint32_t code;
+            TEST_ASSERT_TRUE(hotp_generate(0, &code));
+        }
+        if (day % 30 == 0) {
+            add_service(100 + day, OtpKind::TOTP);
+            TEST_ASSERT_TRUE(storage_deleteService(svcmap_at(service_count - 1)));
+        }
+        for (int t = 0; t < 4; t++) tick();
+    }
+    uint32_t min_erases = UINT32_MAX, max_erases = 0, total = 0;
+    printf("[BENCH] Apagamentos por página do NVS após %d dias:", days);
+    for (int p = 0; p < NVS_HOST_PAGES; p++) {
+        uint32_t erases = nvs_hostPageErases(p);
+        printf(" %lu", (unsigned long)erases);
+        if (erases < min_erases) min_erases = erases;
+        if (erases > max_erases) max_erases = erases;
+        total += erases;
+    }
+    const NvsStats &stats = nvs_getStats();
+    printf("\n[BENCH] %lu gravações, %lu KB gravados, %lu entradas ocupadas, NVS ocupado %lu ms no total\n",
+           (unsigned long)stats.writes, (unsigned long)(stats.bytes_written / 1024),
+           (unsigned long)nvs_hostUsedEntries(), (unsigned long)(stats.busy_us / 1000));
+    TEST_ASSERT_TRUE(total > 0);
+    TEST_ASSERT_TRUE(max_erases <= min_erases + 2); // Rodízio: nenhuma página fica para trás
+    TEST_ASSERT_TRUE(max_erases < 100000);           // Bem abaixo da vida útil de um setor
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cost_per_action);
+    RUN_TEST(test_wear_after_long_use);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+/*
+  Perfil do boot: as fases do setup() que não dependem da tela (configurações,
+  índice do cofre com MAX_SERVICES serviços) cronometradas pelo mesmo perfil do
+  firmware; o desbloqueio e o primeiro segredo só ao abrir a tela de códigos, a
+  espera no menu fora do total, o relatório JSON e o boot sem serviços, que
+  termina na primeira tela.
+  Executar: pio test -e native-storage -f native_storage/test_boot_profile
+*/
+
+#include <unity.h>
+#include <host_env.h>
+
+#include "boot_profile.h"
+#include "key_store.h"
+#include "nvs_backend.h"
+#include "record_store.h"
+#include "service_map.h"
+#include "settings.h"
+#include "storage.h"
+
+static const char *SECRET = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+static const uint32_t USER_WAIT_MS = 100; // Bem acima do "first_code", que agora inclui o desbloqueio
+
+// Cofre com 'count' serviços já compactado, como depois de uso normal
+static void fill(int count) {
+    for (int i = 0; i < count; i++) {
+        char name[12];
+        snprintf(name, sizeof(name), "svc%03d", i);
+        TEST_ASSERT_TRUE(storage_saveService(name, SECRET));
+    }
+    storage_saveServiceList();
+}
+
+// Mesma sequência do setup() e do loop(), sem tela e botões
+static void profiled_boot(bool open_codes) {
+    memset(services, 0xA5, sizeof(services));
+    service_count = 0;
+    current_service_index = -1;
+    current_screen = ScreenState::SCREEN_MENU_MAIN;
+    uint32_t secret_reads = storage_getStats().secret_reads;
+    bootprof_begin();
+    settings_load();
+    bootprof_mark("settings");
+    loadServices();
+    codetable_rebuildKeys();
+    bootprof_mark("services");
+    current_service_index = service_count > 0 ? svcmap_at(0) : -1;
+    invalidateCurrentTOTP();
+    bootprof_endSetup();
+    bootprof_frameDrawn(); // Menu na tela
+    bootprof_frameDrawn(); // Desenhos seguintes não contam
+    TEST_ASSERT_EQUAL_UINT32(secret_reads, storage_getStats().secret_reads); // Menu sem desbloqueio nem segredo
+    if (!open_codes) return;
+    delay(USER_WAIT_MS); // Usuário escolhe "ver códigos"
+    current_screen = ScreenState::SCREEN_TOTP_VIEW;
+    bootprof_codeRequested();
+    if (!current_totp.valid_key_loaded) TEST_ASSERT_TRUE(selectCurrentService()); // Entrada na tela (changeScreen)
+    TEST_ASSERT_EQUAL_UINT32(secret_reads + 1, storage_getStats().secret_reads);
+    bootprof_codeDrawn();
+}
+
+static int phase_index(const BootProfile &profile, const char *name) {
+    for (int i = 0; i < profile.count; i++) {
+        if (strcmp(profile.phases[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+void setUp() {
+    nvs_hostReset();
+    TEST_ASSERT_TRUE(rstore_begin());
+    rstore_format();
+    keystore_clear();
+    service_count = 0;
+    loadServices();
+}
+
+void tearDown() {}
+
+// Fases em ordem, total = soma das fases, espera do usuário separada
+void test_boot_to_first_code() {
+    fill(MAX_SERVICES);
+    NvsStats before = nvs_getStats();
+    profiled_boot(true);
+    NvsStats after = nvs_getStats();
+    const BootProfile &profile = bootprof_get();
+    TEST_ASSERT_TRUE(profile.complete);
+
+    const char *expected[] = {"runtime", "settings", "services", "first_frame", "first_code"};
+    TEST_ASSERT_EQUAL(5, profile.count);
+    uint64_t sum = 0;
+    for (int i = 0; i < profile.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(expected[i], profile.phases[i].name);
+        sum += profile.phases[i].us;
+    }
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)sum, profile.total_us);
+    TEST_ASSERT_TRUE(profile.user_wait_us >= USER_WAIT_MS * 1000);
+    TEST_ASSERT_TRUE(profile.phases[phase_index(profile, "first_code")].us < USER_WAIT_MS * 1000);
+
+    uint32_t setup_us = profile.total_us - profile.phases[0].us; // Sem o "runtime" do processo de teste
+    printf("[BENCH] Boot com %d serviços: %.1f ms de CPU no host + %.1f ms de NVS modelado (%lu leituras)\n",
+           MAX_SERVICES, setup_us / 1000.0, (after.busy_us - before.busy_us) / 1000.0,
+           (unsigned long)(after.reads - before.reads));
+    TEST_ASSERT_TRUE(setup_us + (after.busy_us - before.busy_us) < BOOT_BUDGET_MS * 1000);
+}
+
+// Relatório de máquina: uma linha JSON com todas as fases, também truncada com segurança
+void test_json_report() {
+    fill(3);
+    profiled_boot(true);
+    char json[384];
+    size_t length = bootprof_formatJson(json, sizeof(json));
+    TEST_ASSERT_EQUAL(strlen(json), length);
+    TEST_ASSERT_EQUAL('{', json[0]);
+    TEST_ASSERT_EQUAL('}', json[length - 1]);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"phases\":{\"runtime\":"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"first_code\":"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"complete\":true"));
+    char total[32];
+    snprintf(total, sizeof(total), "\"total_us\":%lu,", (unsigned long)bootprof_get().total_us);
+    TEST_ASSERT_NOT_NULL(strstr(json, total));
+
+    char small[24];
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, bootprof_formatJson(small, sizeof(small)));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+}
+
+// Sem serviços não há código a mostrar: o perfil termina na primeira tela
+void test_no_services_ends_at_first_frame() {
+    profiled_boot(false);
+    const BootProfile &profile = bootprof_get();
+    TEST_ASSERT_TRUE(profile.complete);
+    TEST_ASSERT_EQUAL_STRING("first_frame", profile.phases[profile.count - 1].name);
+    uint32_t total = profile.total_us;
+    bootprof_codeRequested(); // Ganchos depois do fim não mudam nada
+    bootprof_codeDrawn();
+    bootprof_mark("late");
+    TEST_ASSERT_EQUAL_UINT32(total, bootprof_get().total_us);
+    TEST_ASSERT_EQUAL_STRING("first_frame", bootprof_get().phases[bootprof_get().count - 1].name);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_to_first_code);
+    RUN_TEST(test_json_report);
+    RUN_TEST(test_no_services_ends_at_first_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,275 @@
+/*
+  Importação em lote de um array JSON de serviços: o documento chega em pedaços de
+  qualquer tamanho (até um byte por vez), cada entrada é validada, decodificada e
+  tem o segredo selado ao fechar, entradas ruins são puladas, JSON malformado não deixa nada no cofre e o
+  lote inteiro custa um único commit do cofre. Termina com 500 entradas além de
+  MAX_SERVICES contra adições unitárias.
+  Executar: pio test -e native-storage -f native_storage/test_bulk_import
+*/
+
+#include <unity.h>
+#include <host_env.h>
+
+#include "key_store.h"
+#include "name_store.h"
+#include "nvs_backend.h"
+#include "record_store.h"
+#include "service_import.h"
+#include "service_map.h"
+#include "storage.h"
+#include <power_cycle.h>
+
+static const char *SECRETS[] = {"JBSWY3DPEHPK3PXP", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ", "MFRGGZDFMZTWQ2LK"};
+
+// Alimenta o documento em pedaços de 'chunk' bytes
+static ImportStatus feed(const char *json, size_t chunk) {
+    import_begin();
+    ImportStatus status = ImportStatus::RUNNING;
+    size_t length = strlen(json);
+    for (size_t pos = 0; pos < length && status == ImportStatus::RUNNING; pos += chunk) {
+        status = import_feed(&json[pos], length - pos < chunk ? length - pos : chunk);
+    }
+    return status;
+}
+
+static void assert_order(const char *expected) {
+    char text[MAX_SERVICES * (MAX_SERVICE_NAME_LEN + 1)] = "";
+    size_t pos = 0;
+    for (int p = 0; p < service_count; p++) {
+        pos += snprintf(&text[pos], sizeof(text) - pos, p ? ",%s" : "%s", namestore_get(svcmap_at(p)));
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+// Todos os segredos decifram da partição (as chaves importadas não ficam residentes)
+static void assert_secrets() {
+    for (int p = 0; p < service_count; p++) TEST_ASSERT_TRUE(storage_fetchSecret(svcmap_at(p)));
+}
+
+void setUp() {
+    nvs_hostReset();
+    TEST_ASSERT_TRUE(rstore_begin());
+    rstore_format();
+    keystore_clear();
+    current_service_index = -1;
+    power_cycle();
+    TEST_ASSERT_TRUE(storage_unlock()); // Registro do KDF fora das medições
+}
+
+void tearDown() {
+    import_cancel();
+}
+
+// Um byte por vez, com escapes, campos opcionais e campos desconhecidos (inclusive
+// aninhados): tudo gravado com um único commit do cofre e nenhuma entrada de log
+void test_import_streams_byte_by_byte() {
+    TEST_ASSERT_TRUE(storage_saveService("old", SECRETS[0]));
+    const char *json =
+        " [\r\n"
+        "  {\"name\":\"Git\\u00e9\",\"secret\":\"JBSWY3DPEHPK3PXP\",\"issuer\":{\"a\":[1,{\"b\":\"]}\"}]}},\n"
+        "  {\"secret\":\"GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ\",\"name\":\"a\\\"b\",\"algorithm\":\"sha256\",\"digits\":8,"
+        "\"period\":60,\"note\":null,\"pinned\":true},\n"
+        "  {\"name\":\"ctr\",\"secret\":\"mfrggzdfmztwq2lk\",\"type\":\"HOTP\",\"counter\":18446744073709551615}\n"
+        "]\n";
+    StorageStats storage = storage_getStats();
+    NvsStats nvs = nvs_getStats();
+    TEST_ASSERT_EQUAL(ImportStatus::DONE, feed(json, 1));
+    TEST_ASSERT_FALSE(import_isActive());
+
+    const ImportStats &stats = import_getStats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.imported);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.rejected);
+    TEST_ASSERT_EQUAL_UINT32(strlen(json) - 1, stats.bytes); // Parou no ']': o '\n' final não foi consumido
+    TEST_ASSERT_EQUAL_UINT32(storage.log_appends, storage_getStats().log_appends);
+    TEST_ASSERT_EQUAL_UINT32(storage.compactions + 1, storage_getStats().compactions);
+    TEST_ASSERT_EQUAL_UINT32(1, nvs_getStats().writes - nvs.writes); // Só o cabeçalho: a imagem vai para a partição
+
+    assert_order("old,Git\xc3\xa9,a\"b,ctr");
+    for (int p = 1; p < service_count; p++) { // Chaves seladas e fora da RAM
+        const uint8_t *key;
+        size_t length;
+        TEST_ASSERT_FALSE(keystore_get(svcmap_at(p), &key, &length));
+    }
+    power_cycle();
+    assert_order("old,Git\xc3\xa9,a\"b,ctr");
+    const TOTPService &sha256 = services[svcmap_at(2)];
+    TEST_ASSERT_EQUAL(OtpAlgorithm::SHA256, sha256.algorithm);
+    TEST_ASSERT_EQUAL(8, sha256.digits);
+    TEST_ASSERT_EQUAL(60, sha256.period);
+    const TOTPService &hotp = services[svcmap_at(3)];
+    TEST_ASSERT_EQUAL(OtpKind::HOTP, hotp.kind);
+    TEST_ASSERT_TRUE(hotp.counter == UINT64_MAX);
+    assert_secrets();
+}
+
+// Entradas inválidas são contadas e puladas sem interromper o documento
+void test_invalid_entries_are_skipped() {
+    const char *json = "["
+                       "{\"name\":\"ok1\",\"secret\":\"JBSWY3DPEHPK3PXP\"},"
+                       "{\"name\":\"no-secret\"},"
+                       "{\"secret\":\"JBSWY3DPEHPK3PXP\"},"
+                       "{\"name\":\"bad-b32\",\"secret\":\"JBSWY3DP1\"},"
+                       "{\"name\":\"name-longer-than-twenty\",\"secret\":\"JBSWY3DPEHPK3PXP\"},"
+                       "{\"name\":\"\",\"secret\":\"JBSWY3DPEHPK3PXP\"},"
+                       "{\"name\":\"digits\",\"secret\":\"JBSWY3DPEHPK3PXP\",\"digits\":7},"
+                       "{\"name\":\"period\",\"secret\":\"JBSWY3DPEHPK3PXP\",\"period\":-30},"
+                       "{\"name\":\"frac\",\"secret\":\"JBSWY3DPEHPK3PXP\",\"period\":30.5},"
+                       "{\"name\":\"algo\",\"secret\":\"JBSWY3DPEHPK3PXP\",\"algorithm\":\"MD5\"},"
+                       "{\"name\":7,\"secret\":\"JBSWY3DPEHPK3PXP\"},"
+                       "{\"name\":\"nested\",\"secret\":[\"JBSWY3DPEHPK3PXP\"]},"
+                       "{},"
+                       "{\"name\":\"ok2\",\"secret\":\"JBSWY3DPEHPK3PXP\"}"
+                       "]";
+    TEST_ASSERT_EQUAL(ImportStatus::DONE, feed(json, 7));
+    const ImportStats &stats = import_getStats();
+    TEST_ASSERT_EQUAL_UINT32(14, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.imported);
+    TEST_ASSERT_EQUAL_UINT32(12, stats.rejected);
+    assert_order("ok1,ok2");
+
+    TEST_ASSERT_EQUAL(ImportStatus::DONE, feed(" [ ] ", 64)); // Array vazio: nada a gravar
+    TEST_ASSERT_EQUAL_UINT32(0, import_getStats().entries);
+    power_cycle();
+    assert_order("ok1,ok2");
+}
+
+// JSON malformado, ou envio interrompido, não deixa nada do lote na RAM nem na flash
+void test_malformed_document_discards_batch() {
+    TEST_ASSERT_TRUE(storage_saveService("old", SECRETS[0]));
+    const char *broken[] = {
+        "[{\"name\":\"a\",\"secret\":\"JBSWY3DPEHPK3PXP\"},{\"name\":\"b\" \"secret\":\"x\"}]", // Falta ':'
+        "[{\"name\":\"a\",\"secret\":\"JBSWY3DPEHPK3PXP\"},\"b\"]",                            // Não é objeto
+        "[{\"name\":\"a\",\"secret\":\"JBSWY3DPEHPK3PXP\",\"on\":tru}]",                       // Literal inválido
+        "[{\"name\":\"a\\x\",\"secret\":\"JBSWY3DPEHPK3PXP\"}]",                              // Escape inválido
+        "{\"name\":\"a\",\"secret\":\"JBSWY3DPEHPK3PXP\"}",                                   // Não é array
+    };
+    NvsStats nvs = nvs_getStats();
+    RecordStoreStats vault = rstore_getStats();
+    for (const char *json : broken) {
+        TEST_ASSERT_EQUAL(ImportStatus::FAILED, feed(json, 5));
+        TEST_ASSERT_FALSE(import_isActive());
+        TEST_ASSERT_EQUAL_UINT32(0, import_getStats().imported);
+        assert_order("old");
+    }
+    TEST_ASSERT_EQUAL(ImportStatus::RUNNING, feed("[{\"name\":\"a\",\"secret\":\"JBSWY3DPEHPK3PXP\"},{\"na", 3));
+    TEST_ASSERT_EQUAL(2, service_count); // "a" já está na RAM, ainda não gravado
+    import_cancel();
+    assert_order("old");
+    TEST_ASSERT_EQUAL(ImportStatus::FAILED, import_feed("]", 1)); // Nada aberto
+    TEST_ASSERT_EQUAL_UINT32(0, nvs_getStats().writes - nvs.writes);
+    TEST_ASSERT_EQUAL_UINT32(vault.records, rstore_getStats().records); // Segredos selados pelo lote apagados
+
+    TEST_ASSERT_TRUE(storage_saveService("new", SECRETS[1])); // Ids liberados pelo lote voltam a servir
+    power_cycle();
+    assert_order("old,new");
+    assert_secrets();
+}
+
+// Entrada válida recusada por falta de espaço na arena de nomes é contada à parte (nem
+// inválida nem MAX_SERVICES); um segredo ruim depois dela continua rejeitado
+void test_name_arena_full_counted_separately() {
+    int expected = (int)(NAME_ARENA_BYTES / (MAX_SERVICE_NAME_LEN + 1)); // Nomes de 20 caracteres
+    if (expected > MAX_SERVICES) expected = MAX_SERVICES;
+    const int entries = expected + 20;
+    import_begin();
+    ImportStatus status = import_feed("[", 1);
+    for (int i = 0; i < entries && status == ImportStatus::RUNNING; i++) {
+        char entry[96];
+        int length = snprintf(entry, sizeof(entry), "{\"name\":\"twenty-chr-name-%04d\",\"secret\":\"%s\"},", i,
+                              SECRETS[i % 3]);
+        status = import_feed(entry, length);
+    }
+    const char *tail = "{\"name\":\"x\",\"secret\":\"JBSWY3DP1\"}]";
+    TEST_ASSERT_EQUAL(ImportStatus::DONE, import_feed(tail, strlen(tail)));
+    const ImportStats &stats = import_getStats();
+    TEST_ASSERT_EQUAL_UINT32(entries + 1, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(expected, stats.imported);
+    TEST_ASSERT_EQUAL_UINT32(entries - expected, stats.over_name_space);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.over_capacity);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.rejected);
+    TEST_ASSERT_EQUAL(expected, service_count);
+}
+
+// MAX_SERVICES + 500 entradas em pedaços de 64 bytes (o documento nunca existe inteiro na
+// memória): MAX_SERVICES importadas, o resto contado; comparado com MAX_SERVICES adições unitárias
+void test_bench_import_over_capacity() {
+    const int entries = MAX_SERVICES + 500;
+    NvsStats nvs = nvs_getStats();
+    RecordStoreStats vault = rstore_getStats();
+    uint32_t start_us = micros();
+    import_begin();
+    TEST_ASSERT_EQUAL(ImportStatus::RUNNING, import_feed("[", 1));
+    ImportStatus status = ImportStatus::RUNNING;
+    for (int i = 0; i < entries && status == ImportStatus::RUNNING; i++) {
+        char entry[160];
+        int length = snprintf(entry, sizeof(entry), "%s{\"name\":\"svc%04d\",\"secret\":\"%s\",\"digits\":%d}",
+                              i ? ",\n" : "", i, SECRETS[i % 3], i % 2 ? 8 : 6);
+        for (int pos = 0; pos < length && status == ImportStatus::RUNNING; pos += 64) {
+            status = import_feed(&entry[pos], length - pos < 64 ? length - pos : 64);
+        }
+    }
+    TEST_ASSERT_EQUAL(ImportStatus::RUNNING, status);
+    TEST_ASSERT_EQUAL(ImportStatus::DONE, import_feed("]", 1));
+    uint32_t import_us = micros() - start_us;
+    const ImportStats stats = import_getStats();
+    NvsStats after = nvs_getStats();
+    RecordStoreStats after_vault = rstore_getStats();
+    uint32_t import_writes = after.writes - nvs.writes;
+    uint32_t import_bytes = after.bytes_written - nvs.bytes_written;
+    uint32_t import_erases = after.page_erases - nvs.page_erases;
+    uint32_t import_busy_us = after.busy_us - nvs.busy_us;
+    uint32_t import_sealed = after_vault.appends - vault.appends;
+    uint32_t import_vault_bytes = after_vault.bytes_written - vault.bytes_written;
+
+    TEST_ASSERT_EQUAL_UINT32(entries, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(MAX_SERVICES, stats.imported);
+    TEST_ASSERT_EQUAL_UINT32(entries - MAX_SERVICES, stats.over_capacity);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.over_name_space);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.rejected);
+    TEST_ASSERT_EQUAL(MAX_SERVICES, service_count);
+    TEST_ASSERT_EQUAL_UINT32(1, import_writes); // Um commit do cofre: só o cabeçalho vai para o NVS
+    TEST_ASSERT_TRUE(import_sealed > MAX_SERVICES); // Um segredo selado cada, mais os pedaços da imagem
+    TEST_ASSERT_TRUE(import_sealed <= MAX_SERVICES + VAULT_INDEX_MAX_CHUNKS);
+
+    // Mesmos serviços, um por vez, como pela tela de confirmação
+    setUp();
+    nvs = nvs_getStats();
+    vault = rstore_getStats();
+    start_us = micros();
+    for (int i = 0; i < MAX_SERVICES; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "svc%04d", i);
+        TEST_ASSERT_TRUE(storage_saveService(name, SECRETS[i % 3], OtpAlgorithm::SHA1, i % 2 ? 8 : 6));
+    }
+    uint32_t single_us = micros() - start_us;
+    after = nvs_getStats();
+    after_vault = rstore_getStats();
+    uint32_t single_writes = after.writes - nvs.writes;
+    uint32_t single_busy_us = after.busy_us - nvs.busy_us;
+
+    printf("[BENCH] %-22s %8s %6s %9s %5s %9s %10s\n", "importação", "entradas", "grav.", "bytes NVS", "pág.",
+           "NVS (ms)", "total (ms)");
+    printf("[BENCH] %-22s %8d %6lu %9lu %5lu %9.2f %10.2f\n", "lote (array JSON)", entries,
+           (unsigned long)import_writes, (unsigned long)import_bytes, (unsigned long)import_erases,
+           import_busy_us / 1000.0, (import_us + import_busy_us) / 1000.0);
+    printf("[BENCH] %-22s %8d %6lu %9lu %5lu %9.2f %10.2f\n", "adições unitárias", MAX_SERVICES,
+           (unsigned long)single_writes, (unsigned long)(after.bytes_written - nvs.bytes_written),
+           (unsigned long)(after.page_erases - nvs.page_erases), single_busy_us / 1000.0,
+           (single_us + single_busy_us) / 1000.0);
+    printf("[BENCH] lote: parse %.2f ms, commit %.2f ms, %lu bytes; partição: %lu B (lote) x %lu B (unitárias)\n",
+           stats.parse_us / 1000.0, stats.commit_us / 1000.0, (unsigned long)stats.bytes,
+           (unsigned long)import_vault_bytes, (unsigned long)(after_vault.bytes_written - vault.bytes_written));
+    TEST_ASSERT_TRUE(import_writes < single_writes);
+    TEST_ASSERT_TRUE(import_busy_us < single_busy_us);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_import_streams_byte_by_byte);
+    RUN_TEST(test_invalid_entries_are_skipped);
+    RUN_TEST(test_malformed_document_discards_batch);
+    RUN_TEST(test_name_arena_full_counted_separately);
+    RUN_TEST(test_bench_import_over_capacity);
+    return UNITY_END();
+}
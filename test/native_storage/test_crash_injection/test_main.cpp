@@ -0,0 +1,245 @@
+/*
+  Queda de energia injetada em cada gravação do NVS durante as ações do usuário
+  (adicionar, remover, código HOTP, compactação e dobra do journal). Depois de
+  religar, a lista de serviços é a de antes ou a de depois da ação, todos os
+  segredos decifram e nenhum contador HOTP volta atrás.
+  Executar: pio test -e native-storage -f native_storage/test_crash_injection
+*/
+
+#include <unity.h>
+#include <host_env.h>
+
+#include "hotp_journal.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "nvs_backend.h"
+#include "record_store.h"
+#include "service_map.h"
+#include "storage.h"
+#include <power_cycle.h>
+
+static const char *SECRETS[] = {"JBSWY3DPEHPK3PXP", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ", "MFRGGZDFMZTWQ2LK"};
+static const int MAX_FAIL_POINTS = 64; // Mais gravações do que qualquer ação faz
+
+// Lista de serviços como texto ("nome:contador," em ordem) para comparar estados
+struct ListImage {
+    char text[MAX_SERVICES * 24];
+};
+
+static ListImage image() {
+    ListImage out = {};
+    size_t pos = 0;
+    for (int p = 0; p < service_count && pos < sizeof(out.text); p++) {
+        int id = svcmap_at(p);
+        pos += snprintf(&out.text[pos], sizeof(out.text) - pos, "%s:%llu,", namestore_get(id),
+                        (unsigned long long)services[id].counter);
+    }
+    return out;
+}
+
+static int find_service(const char *name) {
+    return namestore_find(name);
+}
+
+static const int HOTP_SERVICES = HOTP_JOURNAL_SLOTS / 2 + 1; // Um código de cada já pede a dobra
+
+static int find_hotp(int n) {
+    char name[8];
+    snprintf(name, sizeof(name), "h%d", n);
+    return find_service(name);
+}
+
+// Estado inicial de cada rodada: cofre compactado e journal HOTP com uma entrada
+// ainda não dobrada por serviço HOTP
+static void prepare() {
+    nvs_hostReset();
+    TEST_ASSERT_TRUE(rstore_begin());
+    rstore_format();
+    keystore_clear();
+    service_count = 0;
+    power_cycle();
+    TEST_ASSERT_TRUE(storage_saveService("web", SECRETS[0]));
+    for (int n = 0; n < HOTP_SERVICES; n++) {
+        char name[8];
+        snprintf(name, sizeof(name), "h%d", n);
+        TEST_ASSERT_TRUE(storage_saveService(name, SECRETS[1], OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 0));
+    }
+    TEST_ASSERT_TRUE(storage_saveService("mail", SECRETS[2]));
+    storage_saveServiceList(); // Cofre com todos; as adições da ação vão para o log
+    for (int n = 0; n < HOTP_SERVICES; n++) {
+        uint32_t code;
+        TEST_ASSERT_TRUE(hotp_generate(find_hotp(n), &code));
+    }
+    power_cycle();
+}
+
+enum class Action { ADD, DELETE, HOTP, COMPACT, FOLD };
+
+static const char *action_name(Action action) {
+    switch (action) {
+    case Action::ADD: return "adicionar";
+    case Action::DELETE: return "remover";
+    case Action::HOTP: return "código HOTP";
+    case Action::COMPACT: return "compactar";
+    default: return "dobrar journal";
+    }
+}
+
+// Gera um código do serviço HOTP 'n'; atualiza o maior contador já mostrado
+static bool press(int n, uint64_t *shown) {
+    int index = find_hotp(n);
+    uint32_t code;
+    if (index < 0 || !hotp_generate(index, &code)) return false;
+    shown[n] = services[index].counter; // Código mostrado: este contador não pode voltar
+    return true;
+}
+
+// Executa a ação, registrando em 'shown' os contadores HOTP dos códigos mostrados
+static void run(Action action, uint64_t *shown) {
+    switch (action) {
+    case Action::ADD:
+        storage_saveService("new", SECRETS[2]);
+        break;
+    case Action::DELETE:
+        storage_deleteService(find_service("web"));
+        break;
+    case Action::HOTP:
+        for (int i = 0; i < HOTP_JOURNAL_SLOTS + 2; i++) { // Reutiliza slots ainda necessários: dobra forçada
+            if (!press(0, shown)) break;
+        }
+        break;
+    case Action::COMPACT:
+        for (int i = 0; i < VAULT_LOG_SLOTS; i++) storage_tick(); // Grava o cofre e apaga o log
+        storage_saveServiceList();
+        break;
+    case Action::FOLD:
+        press(1, shown);
+        hotp_tick(); // Metade do anel com entradas necessárias: uma gravação do cofre
+        press(2, shown);
+        break;
+    }
+}
+
+// Todos os segredos decifram (o GCM autentica cada registro) e ficam residentes
+static void assert_secrets() {
+    for (int i = 0; i < service_count; i++) {
+        TEST_ASSERT_TRUE(codetable_ensureKey(i));
+        const uint8_t *key;
+        size_t length;
+        TEST_ASSERT_TRUE(keystore_get(i, &key, &length));
+        TEST_ASSERT_TRUE(length > 0);
+    }
+}
+
+// Contadores atuais de todos os serviços HOTP
+static void counters(uint64_t *out) {
+    for (int n = 0; n < HOTP_SERVICES; n++) {
+        int index = find_hotp(n);
+        out[n] = index >= 0 ? services[index].counter : 0;
+    }
+}
+
+static void crash_everywhere(Action action) {
+    // Rodada sem queda: estado final esperado e número de gravações da ação
+    prepare();
+    ListImage before = image();
+    uint64_t initial[HOTP_SERVICES];
+    counters(initial);
+    uint64_t shown[HOTP_SERVICES];
+    memcpy(shown, initial, sizeof(shown));
+    NvsStats start = nvs_getStats();
+    run(action, shown);
+    NvsStats end = nvs_getStats();
+    uint32_t mutations = end.writes + end.removes - start.writes - start.removes;
+    power_cycle();
+    ListImage after = image();
+    TEST_ASSERT_TRUE(mutations > 0 && mutations < MAX_FAIL_POINTS);
+
+    int crashes = 0;
+    for (uint32_t k = 0; k < mutations; k++) {
+        prepare();
+        memcpy(shown, initial, sizeof(shown));
+        nvs_hostFailAfter(k);
+        run(action, shown);
+        bool lost = nvs_hostPowerLost();
+        nvs_hostFailAfter(UINT32_MAX); // Religa
+        power_cycle();
+        if (lost) crashes++;
+
+        ListImage now = image();
+        if (action == Action::ADD || action == Action::DELETE) {
+            bool matches = strcmp(now.text, before.text) == 0 || strcmp(now.text, after.text) == 0;
+            if (!matches) printf("  %s, queda após %lu gravações: '%s'\n", action_name(action), (unsigned long)k, now.text);
+            TEST_ASSERT_TRUE(matches);
+        } else {
+            TEST_ASSERT_EQUAL(HOTP_SERVICES + 2, service_count); // Só contadores mudam
+        }
+        uint64_t reloaded[HOTP_SERVICES];
+        counters(reloaded);
+        for (int n = 0; n < HOTP_SERVICES; n++) {
+            TEST_ASSERT_TRUE(find_hotp(n) >= 0);
+            TEST_ASSERT_TRUE(reloaded[n] >= shown[n]); // Nenhum código repetido
+        }
+        assert_secrets();
+    }
+    printf("[CRASH] %-15s %2lu gravações, %2d quedas injetadas: estado consistente em todas\n", action_name(action),
+           (unsigned long)mutations, crashes);
+}
+
+void setUp() {}
+
+void tearDown() {
+    nvs_hostFailAfter(UINT32_MAX);
+}
+
+void test_crash_during_add() {
+    crash_everywhere(Action::ADD);
+}
+
+void test_crash_during_delete() {
+    crash_everywhere(Action::DELETE);
+}
+
+void test_crash_during_hotp() {
+    crash_everywhere(Action::HOTP);
+}
+
+void test_crash_during_compaction() {
+    crash_everywhere(Action::COMPACT);
+}
+
+void test_crash_during_fold() {
+    crash_everywhere(Action::FOLD);
+}
+
+// O espelho em arquivo sobrevive ao "processo": religar relendo o arquivo dá o mesmo estado
+void test_file_mirror_survives_restart() {
+    const char *path = "nvs_crash_mirror.bin";
+    remove(path);
+    TEST_ASSERT_TRUE(nvs_hostAttachFile(path));
+    prepare();
+    ListImage before = image();
+    uint32_t erases = 0;
+    for (int p = 0; p < NVS_HOST_PAGES; p++) erases += nvs_hostPageErases(p);
+    TEST_ASSERT_TRUE(nvs_hostAttachFile(nullptr)); // Sem espelho: descarta a RAM...
+    TEST_ASSERT_TRUE(nvs_hostAttachFile(path));    // ...e recarrega do arquivo
+    uint32_t reloaded = 0;
+    for (int p = 0; p < NVS_HOST_PAGES; p++) reloaded += nvs_hostPageErases(p);
+    power_cycle();
+    TEST_ASSERT_EQUAL_STRING(before.text, image().text);
+    TEST_ASSERT_EQUAL_UINT32(erases, reloaded);
+    assert_secrets();
+    nvs_hostAttachFile(nullptr);
+    remove(path);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crash_during_add);
+    RUN_TEST(test_crash_during_delete);
+    RUN_TEST(test_crash_during_hotp);
+    RUN_TEST(test_crash_during_compaction);
+    RUN_TEST(test_crash_during_fold);
+    RUN_TEST(test_file_mirror_survives_restart);
+    return UNITY_END();
+}
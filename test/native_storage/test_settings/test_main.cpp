@@ -0,0 +1,123 @@
+/*
+  Configurações num só registro do NVS com gravação adiada: uma leitura no boot,
+  vários ajustes seguidos viram uma gravação, migração das chaves antigas de
+  idioma e fuso, e valores inválidos voltando ao padrão.
+  Executar: pio test -e native-storage -f native_storage/test_settings
+*/
+
+#include <unity.h>
+#include <host_env.h>
+
+#include "nvs_backend.h"
+#include "settings.h"
+
+// Boot simulado: esquece a RAM e relê o registro
+static void power_cycle() {
+    current_language = Language::PT_BR;
+    gmt_offset_hours = 0;
+    settings_load();
+}
+
+// Grava como a atualização regular faria depois do intervalo sem mudanças
+static void settle() {
+    settings_tick(millis() + SETTINGS_WRITE_DELAY_MS);
+}
+
+void setUp() {
+    nvs_hostReset();
+    power_cycle();
+}
+
+void tearDown() {}
+
+// Sem registro: padrão. Com registro: boot com uma leitura do NVS e nenhuma gravação
+void test_boot_is_one_read() {
+    TEST_ASSERT_EQUAL(Language::PT_BR, current_language);
+    TEST_ASSERT_FALSE(settings_pending());
+    TEST_ASSERT_TRUE(settings_setTimezone(2));
+    settle();
+    NvsStats before = nvs_getStats();
+    power_cycle();
+    NvsStats after = nvs_getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, after.reads - before.reads);
+    TEST_ASSERT_EQUAL_UINT32(0, after.writes - before.writes);
+    TEST_ASSERT_EQUAL(2, gmt_offset_hours);
+}
+
+// Ajustes seguidos (fuso andando hora a hora, idioma trocado) viram uma só gravação
+void test_edits_coalesce_into_one_write() {
+    NvsStats before = nvs_getStats();
+    SettingsStats stats = settings_getStats();
+    for (int h = 1; h <= 10; h++) TEST_ASSERT_TRUE(settings_setTimezone(-h));
+    settings_setLanguage(Language::EN_US);
+    settings_tick(millis()); // Ainda dentro do intervalo: nada gravado
+    TEST_ASSERT_TRUE(settings_pending());
+    TEST_ASSERT_EQUAL_UINT32(0, nvs_getStats().writes - before.writes);
+    settle();
+    TEST_ASSERT_FALSE(settings_pending());
+    TEST_ASSERT_EQUAL_UINT32(1, nvs_getStats().writes - before.writes);
+    TEST_ASSERT_EQUAL_UINT32(1, settings_getStats().writes - stats.writes);
+    TEST_ASSERT_EQUAL_UINT32(10, settings_getStats().coalesced - stats.coalesced);
+    settle(); // Nada pendente: nada a gravar
+    TEST_ASSERT_EQUAL_UINT32(1, nvs_getStats().writes - before.writes);
+
+    power_cycle();
+    TEST_ASSERT_EQUAL(Language::EN_US, current_language);
+    TEST_ASSERT_EQUAL(-10, gmt_offset_hours);
+}
+
+// Voltar ao valor gravado antes do intervalo não conta como mudança nova
+void test_unchanged_value_is_not_written() {
+    NvsStats before = nvs_getStats();
+    TEST_ASSERT_TRUE(settings_setTimezone(0));
+    settings_setLanguage(Language::PT_BR);
+    TEST_ASSERT_FALSE(settings_pending());
+    TEST_ASSERT_FALSE(settings_setTimezone(15));
+    TEST_ASSERT_EQUAL(0, gmt_offset_hours);
+    settle();
+    TEST_ASSERT_EQUAL_UINT32(0, nvs_getStats().writes - before.writes);
+}
+
+// Chaves antigas: lidas uma vez, regravadas como registro e apagadas
+void test_legacy_keys_are_migrated() {
+    preferences.begin("totp-app", false);
+    preferences.putInt(NVS_KEY_LANGUAGE, (int)Language::EN_US);
+    preferences.putInt(NVS_KEY_TZ_OFFSET, -3);
+    preferences.end();
+    power_cycle();
+    TEST_ASSERT_EQUAL(Language::EN_US, current_language);
+    TEST_ASSERT_EQUAL(-3, gmt_offset_hours);
+    TEST_ASSERT_TRUE(settings_pending());
+    settle();
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey(NVS_KEY_LANGUAGE));
+    TEST_ASSERT_FALSE(preferences.isKey(NVS_KEY_TZ_OFFSET));
+    TEST_ASSERT_TRUE(preferences.isKey(NVS_KEY_SETTINGS));
+    preferences.end();
+    NvsStats before = nvs_getStats();
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT32(1, nvs_getStats().reads - before.reads);
+    TEST_ASSERT_EQUAL(Language::EN_US, current_language);
+    TEST_ASSERT_EQUAL(-3, gmt_offset_hours);
+}
+
+// Valores fora da faixa no NVS voltam ao padrão em vez de chegar à UI
+void test_invalid_values_fall_back() {
+    Settings bad = {1, NUM_LANGUAGES, 40, 0};
+    preferences.begin("totp-app", false);
+    preferences.putBytes(NVS_KEY_SETTINGS, &bad, sizeof(bad));
+    preferences.end();
+    power_cycle();
+    TEST_ASSERT_EQUAL(Language::PT_BR, current_language);
+    TEST_ASSERT_EQUAL(0, gmt_offset_hours);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_is_one_read);
+    RUN_TEST(test_edits_coalesce_into_one_write);
+    RUN_TEST(test_unchanged_value_is_not_written);
+    RUN_TEST(test_legacy_keys_are_migrated);
+    RUN_TEST(test_invalid_values_fall_back);
+    return UNITY_END();
+}
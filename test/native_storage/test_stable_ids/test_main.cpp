@@ -0,0 +1,166 @@
+/*
+  Ids estáveis dos serviços: remover um serviço não move nem regrava os outros (RAM,
+  NVS e partição "vault"), o serviço selecionado continua o mesmo, o id liberado é
+  reutilizado no fim da ordem de exibição, a ordem sobrevive ao boot e tombstones
+  antigos (por posição) ainda são reaplicados.
+  Executar: pio test -e native-storage -f native_storage/test_stable_ids
+*/
+
+#include <unity.h>
+#include <host_env.h>
+
+#include "crc32.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "nvs_backend.h"
+#include "record_store.h"
+#include "service_map.h"
+#include "storage.h"
+#include <power_cycle.h>
+
+static const char *SECRET = "JBSWY3DPEHPK3PXP";
+static const int COUNT = 40;
+
+static void add(const char *name) {
+    TEST_ASSERT_TRUE(storage_saveService(name, SECRET));
+}
+
+static void assert_order(const char *expected) {
+    char text[MAX_SERVICES * (MAX_SERVICE_NAME_LEN + 1)] = "";
+    size_t pos = 0;
+    for (int p = 0; p < service_count; p++) {
+        pos += snprintf(&text[pos], sizeof(text) - pos, p ? ",%s" : "%s", namestore_get(svcmap_at(p)));
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+void setUp() {
+    nvs_hostReset();
+    TEST_ASSERT_TRUE(rstore_begin());
+    rstore_format();
+    keystore_clear();
+    current_service_index = -1;
+    power_cycle();
+}
+
+void tearDown() {}
+
+// Remover o primeiro de COUNT serviços: uma gravação no NVS e um tombstone na partição;
+// nenhum outro registro em RAM muda de lugar ou de conteúdo, nem a seleção
+void test_delete_touches_only_its_record() {
+    for (int i = 0; i < COUNT; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "s%02d", i);
+        add(name);
+    }
+    for (int id = 0; id < KEY_CACHE_SLOTS; id++) TEST_ASSERT_TRUE(codetable_ensureKey(COUNT - 1 - id));
+    current_service_index = 7;
+    static TOTPService before[MAX_SERVICES];
+    static TOTPKeyState keys_before[KEY_CACHE_SLOTS];
+    const char *names_before[COUNT];
+    memcpy(before, services, sizeof(services));
+    memcpy(keys_before, code_table.keys, sizeof(keys_before));
+    for (int id = 0; id < COUNT; id++) names_before[id] = namestore_get(id);
+
+    NvsStats nvs = nvs_getStats();
+    RecordStoreStats vault = rstore_getStats();
+    TEST_ASSERT_TRUE(storage_deleteService(0));
+    TEST_ASSERT_EQUAL_UINT32(1, nvs_getStats().writes - nvs.writes); // Só o tombstone do log
+    TEST_ASSERT_EQUAL_UINT32(0, nvs_getStats().removes - nvs.removes);
+    TEST_ASSERT_EQUAL_UINT32(12, rstore_getStats().bytes_written - vault.bytes_written); // Tombstone do segredo
+
+    TEST_ASSERT_EQUAL(COUNT - 1, service_count);
+    TEST_ASSERT_FALSE(svcmap_isLive(0));
+    TEST_ASSERT_EQUAL(7, current_service_index);
+    TEST_ASSERT_EQUAL_MEMORY(&before[1], &services[1], (COUNT - 1) * sizeof(TOTPService));
+    TEST_ASSERT_EQUAL_MEMORY(keys_before, code_table.keys, sizeof(keys_before)); // Id 0 fora do cache: nenhum slot muda
+    for (int id = 1; id < COUNT; id++) {
+        TEST_ASSERT_TRUE(names_before[id] == namestore_get(id)); // Nome no mesmo endereço
+        TEST_ASSERT_EQUAL(id - 1, svcmap_positionOf(id));
+    }
+    power_cycle();
+    TEST_ASSERT_EQUAL(COUNT - 1, service_count);
+    TEST_ASSERT_EQUAL_STRING("s01", namestore_get(svcmap_at(0)));
+    TEST_ASSERT_EQUAL_STRING("s39", namestore_get(svcmap_at(COUNT - 2)));
+}
+
+// Remover o selecionado passa a seleção ao que ocupou a posição dele (ou ao novo último);
+// remover outro não mexe na seleção; lista vazia fica sem seleção
+void test_selection_follows_order() {
+    add("a");
+    add("b");
+    add("c");
+    add("d");
+    current_service_index = namestore_find("b");
+    TEST_ASSERT_TRUE(storage_deleteService(namestore_find("b")));
+    TEST_ASSERT_EQUAL_STRING("c", namestore_get(current_service_index));
+    TEST_ASSERT_TRUE(storage_deleteService(namestore_find("a")));
+    TEST_ASSERT_EQUAL_STRING("c", namestore_get(current_service_index));
+    current_service_index = namestore_find("d");
+    TEST_ASSERT_TRUE(storage_deleteService(current_service_index));
+    TEST_ASSERT_EQUAL_STRING("c", namestore_get(current_service_index));
+    TEST_ASSERT_TRUE(storage_deleteService(current_service_index));
+    TEST_ASSERT_EQUAL(0, service_count);
+    TEST_ASSERT_EQUAL(-1, current_service_index);
+    TEST_ASSERT_FALSE(storage_deleteService(0)); // Id já livre
+}
+
+// O id liberado volta no próximo serviço, no fim da ordem; a navegação segue a ordem e
+// dá a volta; depois do boot a ordem é a mesma
+void test_freed_id_reused_at_end_of_order() {
+    add("a");
+    add("b");
+    add("c");
+    int b = namestore_find("b");
+    TEST_ASSERT_TRUE(storage_deleteService(b));
+    add("d");
+    TEST_ASSERT_EQUAL(b, namestore_find("d"));
+    TEST_ASSERT_EQUAL(3, svcmap_slots()); // Nenhum id novo
+    assert_order("a,c,d");
+    int a = namestore_find("a");
+    TEST_ASSERT_EQUAL(namestore_find("c"), svcmap_step(a, 1));
+    TEST_ASSERT_EQUAL(namestore_find("d"), svcmap_step(a, -1));
+    TEST_ASSERT_EQUAL(a, svcmap_step(a, 3));
+    TEST_ASSERT_EQUAL(-1, svcmap_step(b + MAX_SERVICES, 1));
+    power_cycle();
+    assert_order("a,c,d");
+    preferences.begin("totp-app", false);
+    TEST_ASSERT_TRUE(storage_writeVault()); // Compactado: o cofre grava na ordem de exibição
+    preferences.end();
+    power_cycle();
+    assert_order("a,c,d");
+}
+
+// Log gravado antes dos ids estáveis: o tombstone guarda a posição removida
+void test_position_tombstone_still_replays() {
+    add("a"); // Grava o cofre
+    add("b"); // Entradas de log 0 e 1
+    add("c");
+    struct {
+        uint32_t seq;
+        uint8_t op;
+        uint8_t reserved;
+        uint16_t index;
+        uint32_t crc;
+    } entry = {2, 2, 0, 1, 0}; // DEL da posição 1 ("b")
+    uint32_t crc = crc32_update((const uint8_t *)&entry.seq, sizeof(entry.seq));
+    crc = crc32_update(&entry.op, sizeof(entry.op), crc);
+    entry.crc = crc32_update((const uint8_t *)&entry.index, sizeof(entry.index), crc);
+    preferences.begin("totp-app", false);
+    TEST_ASSERT_EQUAL(sizeof(entry), preferences.putBytes("vlog_2", &entry, sizeof(entry)));
+    preferences.end();
+    power_cycle();
+    assert_order("a,c");
+    add("d"); // O log continua depois da entrada antiga
+    power_cycle();
+    assert_order("a,c,d");
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_delete_touches_only_its_record);
+    RUN_TEST(test_selection_follows_order);
+    RUN_TEST(test_freed_id_reused_at_end_of_order);
+    RUN_TEST(test_position_tombstone_still_replays);
+    return UNITY_END();
+}
@@ -0,0 +1,121 @@
+/*
+  HMAC-SHA1 em lote (faixas intercaladas) x laço escalar de hmac_sha1_short().
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_bench_batch_hmac
+  Compara saída byte a byte e mede a vazão em códigos por segundo.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "crypto/hmac_sha1_batch.h"
+#include "crypto/sha_backend.h"
+#include "totp.h"
+
+static const size_t BENCH_PAIRS = 256;
+static const int BENCH_ROUNDS = 20;
+
+static HmacSha1Key bench_keys[BENCH_PAIRS];
+static const HmacSha1Key *bench_key_ptrs[BENCH_PAIRS];
+static uint64_t bench_counters[BENCH_PAIRS];
+static uint8_t bench_out[BENCH_PAIRS][SHA1_DIGEST_LEN];
+
+void setUp() {}
+void tearDown() {}
+
+static void counter_bytes(uint64_t counter, uint8_t *out) {
+    for (int i = 7; i >= 0; i--) {
+        out[i] = counter & 0xFF;
+        counter >>= 8;
+    }
+}
+
+void test_prepare_pairs() {
+    uint32_t seed = 0xBADC0DE;
+    for (size_t i = 0; i < BENCH_PAIRS; i++) {
+        uint8_t key[20];
+        for (size_t b = 0; b < sizeof(key); b++) {
+            seed = seed * 1664525u + 1013904223u;
+            key[b] = seed >> 24;
+        }
+        hmac_sha1_prepare(key, sizeof(key), &bench_keys[i]);
+        bench_key_ptrs[i] = &bench_keys[i];
+        seed = seed * 1664525u + 1013904223u;
+        bench_counters[i] = ((uint64_t)seed << 20) ^ i; // Usa também os 32 bits altos
+    }
+}
+
+// Cada tamanho de lote (inclusive rodadas incompletas) deve reproduzir o caminho individual
+void test_batch_matches_single_shot() {
+    for (size_t n = 1; n <= 2 * HMAC_SHA1_BATCH_LANES + 1; n++) {
+        hmac_sha1_counter_batch(bench_key_ptrs, bench_counters, n, bench_out);
+        for (size_t i = 0; i < n; i++) {
+            uint8_t msg[8], expected[SHA1_DIGEST_LEN];
+            counter_bytes(bench_counters[i], msg);
+            hmac_sha1_short(&bench_keys[i], msg, sizeof(msg), expected);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, bench_out[i], SHA1_DIGEST_LEN);
+        }
+    }
+}
+
+// RFC 4226 pelo lote: mesma chave em todas as faixas, contadores 0..9
+void test_batch_rfc4226() {
+    static const uint32_t expected[] = {755224, 287082, 359152, 969429, 338314,
+                                        254676, 287922, 162583, 399871, 520489};
+    HmacSha1Key key;
+    hmac_sha1_prepare((const uint8_t *)"12345678901234567890", 20, &key);
+    const HmacSha1Key *keys[10];
+    uint64_t counters[10];
+    for (int c = 0; c < 10; c++) {
+        keys[c] = &key;
+        counters[c] = c;
+    }
+    hmac_sha1_counter_batch(keys, counters, 10, bench_out);
+    for (int c = 0; c < 10; c++) {
+        const uint8_t *h = bench_out[c];
+        int offset = h[19] & 0x0F;
+        uint32_t bin = ((h[offset] & 0x7F) << 24) | (h[offset + 1] << 16) | (h[offset + 2] << 8) | h[offset + 3];
+        TEST_ASSERT_EQUAL_UINT32(expected[c], bin % 1000000);
+    }
+}
+
+void bench_throughput() {
+    uint8_t msg[8], hash[SHA1_DIGEST_LEN];
+    sha_backend_acquire();
+    uint32_t t0 = micros();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (size_t i = 0; i < BENCH_PAIRS; i++) {
+            counter_bytes(bench_counters[i] + r, msg);
+            hmac_sha1_short(&bench_keys[i], msg, sizeof(msg), hash);
+        }
+    }
+    uint32_t scalar_us = micros() - t0;
+    sha_backend_release();
+
+    t0 = micros();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        hmac_sha1_counter_batch(bench_key_ptrs, bench_counters, BENCH_PAIRS, bench_out);
+    }
+    uint32_t batch_us = micros() - t0;
+
+    float total = (float)BENCH_PAIRS * BENCH_ROUNDS;
+    char line[160];
+    snprintf(line, sizeof(line), "laco escalar [%s]: %.0f codigos/s (%.2f us/codigo)",
+             sha_backend_name(), total * 1e6f / scalar_us, scalar_us / total);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "lote [%s]: %.0f codigos/s (%.2f us/codigo), %.2fx; tabela usa lote: %s",
+             hmac_sha1_batch_name(), total * 1e6f / batch_us, batch_us / total,
+             (float)scalar_us / batch_us, TOTP_BATCH_HMAC ? "sim" : "nao");
+    TEST_MESSAGE(line);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_prepare_pairs);
+    RUN_TEST(test_batch_matches_single_shot);
+    RUN_TEST(test_batch_rfc4226);
+    RUN_TEST(bench_throughput);
+    UNITY_END();
+}
+
+void loop() {}
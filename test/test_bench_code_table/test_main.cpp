@@ -0,0 +1,81 @@
+/*
+  Benchmark da regeneração completa da tabela de códigos (50, 500 e 5000 serviços).
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_bench_code_table
+  Cada tamanho usa o mesmo núcleo da tabela global (codetable_generate).
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+#include <esp_heap_caps.h>
+
+#include "code_table.h"
+#include "crypto/sha_backend.h"
+#include "totp.h"
+
+static const int BENCH_SIZES[] = {50, 500, 5000};
+static const int MAX_BENCH_SIZE = 5000;
+static const uint64_t BENCH_TIMESTAMP = 1234567890ULL;
+
+static TOTPKeyState *bench_keys = nullptr;
+static bool *bench_valid = nullptr;
+static uint32_t *bench_codes = nullptr;
+
+// Prefere PSRAM para os 5000 midstates; cai para RAM interna se não houver
+static void *bench_alloc(size_t size) {
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_prepare_keys() {
+    bench_keys = (TOTPKeyState *)bench_alloc(MAX_BENCH_SIZE * sizeof(TOTPKeyState));
+    bench_valid = (bool *)bench_alloc(MAX_BENCH_SIZE * sizeof(bool));
+    bench_codes = (uint32_t *)bench_alloc(MAX_BENCH_SIZE * sizeof(uint32_t));
+    TEST_ASSERT_NOT_NULL(bench_keys);
+    TEST_ASSERT_NOT_NULL(bench_valid);
+    TEST_ASSERT_NOT_NULL(bench_codes);
+
+    uint32_t seed = 0xC0FFEE;
+    for (int i = 0; i < MAX_BENCH_SIZE; i++) {
+        uint8_t key[20];
+        for (size_t b = 0; b < sizeof(key); b++) {
+            seed = seed * 1664525u + 1013904223u;
+            key[b] = seed >> 24;
+        }
+        bench_valid[i] = prepareTOTPKey(key, sizeof(key), &bench_keys[i]);
+    }
+}
+
+// A tabela deve conter exatamente os mesmos códigos da geração individual
+void test_table_matches_single_shot() {
+    codetable_generate(bench_keys, bench_valid, 50, BENCH_TIMESTAMP, bench_codes);
+    for (int i = 0; i < 50; i++) {
+        TEST_ASSERT_EQUAL_UINT32(generateTOTPFromState(&bench_keys[i], BENCH_TIMESTAMP), bench_codes[i]);
+    }
+}
+
+void bench_full_regeneration() {
+    for (size_t s = 0; s < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); s++) {
+        int n = BENCH_SIZES[s];
+        uint32_t t0 = micros();
+        codetable_generate(bench_keys, bench_valid, n, BENCH_TIMESTAMP, bench_codes);
+        uint32_t elapsed = micros() - t0;
+        char line[128];
+        snprintf(line, sizeof(line), "[%s] %d servicos: %.3f ms por regeneracao, %.2f us/servico",
+                 sha_backend_name(), n, elapsed / 1000.0f, (float)elapsed / n);
+        TEST_MESSAGE(line);
+    }
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_prepare_keys);
+    RUN_TEST(test_table_matches_single_shot);
+    RUN_TEST(bench_full_regeneration);
+    UNITY_END();
+}
+
+void loop() {}
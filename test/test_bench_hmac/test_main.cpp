@@ -0,0 +1,127 @@
+/*
+  Microbenchmark HMAC-SHA1: kernel próprio (src/crypto) x caminho mbedtls_md antigo.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_bench_hmac
+  Reporta latência por código (us, ciclos) e o impacto de cada caminho no heap.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+#include <esp_heap_caps.h>
+#include <mbedtls/md.h>
+
+#include "crypto/hmac_sha1.h"
+#include "crypto/sha_backend.h"
+#include "totp.h"
+
+static const uint8_t RFC_KEY[] = "12345678901234567890"; // Chave dos vetores RFC 4226/6238
+static const size_t RFC_KEY_LEN = 20;
+static const int BENCH_ITERATIONS = 2000;
+
+// Caminho de referência: exatamente o que generateTOTP() fazia antes (init/setup/free por chamada)
+static bool hmac_mbedtls_md(const uint8_t *key, size_t keyLength, const uint8_t *msg, size_t msgLength, uint8_t *out) {
+    mbedtls_md_context_t ctx;
+    const mbedtls_md_info_t *info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA1);
+    mbedtls_md_init(&ctx);
+    bool ok = info && mbedtls_md_setup(&ctx, info, 1) == 0 &&
+              mbedtls_md_hmac_starts(&ctx, key, keyLength) == 0 &&
+              mbedtls_md_hmac_update(&ctx, msg, msgLength) == 0 &&
+              mbedtls_md_hmac_finish(&ctx, out) == 0;
+    mbedtls_md_free(&ctx);
+    return ok;
+}
+
+static void counter_to_bytes(uint64_t counter, uint8_t *bytes) {
+    for (int i = 7; i >= 0; i--) { bytes[i] = counter & 0xFF; counter >>= 8; }
+}
+
+struct HeapSnapshot {
+    size_t free_bytes;
+    size_t largest_block;
+    size_t min_free;
+};
+
+static HeapSnapshot heap_snapshot() {
+    HeapSnapshot s;
+    s.free_bytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s.largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s.min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    return s;
+}
+
+static void report(const char *label, uint32_t total_us, uint32_t total_cycles, const HeapSnapshot &before, const HeapSnapshot &after) {
+    char line[160];
+    snprintf(line, sizeof(line), "%s: %.2f us/code, %lu ciclos/code, heap livre %d -> %d, maior bloco %d -> %d, pico de uso %d B",
+             label, (float)total_us / BENCH_ITERATIONS, (unsigned long)(total_cycles / BENCH_ITERATIONS),
+             (int)before.free_bytes, (int)after.free_bytes, (int)before.largest_block, (int)after.largest_block,
+             (int)(before.min_free - after.min_free));
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Ambos os caminhos devem produzir o mesmo HMAC para uma faixa de contadores
+void test_kernel_matches_mbedtls() {
+    HmacSha1Key key;
+    hmac_sha1_prepare(RFC_KEY, RFC_KEY_LEN, &key);
+    for (uint64_t c = 0; c < 256; c++) {
+        uint8_t msg[8], expected[SHA1_DIGEST_LEN], actual[SHA1_DIGEST_LEN];
+        counter_to_bytes(c * 7919, msg);
+        TEST_ASSERT_TRUE(hmac_mbedtls_md(RFC_KEY, RFC_KEY_LEN, msg, sizeof(msg), expected));
+        hmac_sha1_short(&key, msg, sizeof(msg), actual);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, actual, SHA1_DIGEST_LEN);
+    }
+}
+
+void bench_mbedtls_md() {
+    uint8_t msg[8], out[SHA1_DIGEST_LEN];
+    HeapSnapshot before = heap_snapshot();
+    uint32_t t0 = micros(), c0 = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        counter_to_bytes(i, msg);
+        hmac_mbedtls_md(RFC_KEY, RFC_KEY_LEN, msg, sizeof(msg), out);
+    }
+    uint32_t c1 = ESP.getCycleCount(), t1 = micros();
+    report("mbedtls_md (setup/free por codigo)", t1 - t0, c1 - c0, before, heap_snapshot());
+}
+
+void bench_kernel_full() {
+    uint8_t msg[8], out[SHA1_DIGEST_LEN];
+    HeapSnapshot before = heap_snapshot();
+    uint32_t t0 = micros(), c0 = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        HmacSha1Key key; // Chave reprocessada a cada código (equivalente a generateTOTP)
+        hmac_sha1_prepare(RFC_KEY, RFC_KEY_LEN, &key);
+        counter_to_bytes(i, msg);
+        hmac_sha1_short(&key, msg, sizeof(msg), out);
+    }
+    uint32_t c1 = ESP.getCycleCount(), t1 = micros();
+    report("kernel pilha (prepare + hmac)", t1 - t0, c1 - c0, before, heap_snapshot());
+}
+
+void bench_kernel_midstate() {
+    uint8_t msg[8], out[SHA1_DIGEST_LEN];
+    HmacSha1Key key;
+    hmac_sha1_prepare(RFC_KEY, RFC_KEY_LEN, &key);
+    HeapSnapshot before = heap_snapshot();
+    uint32_t t0 = micros(), c0 = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        counter_to_bytes(i, msg);
+        hmac_sha1_short(&key, msg, sizeof(msg), out);
+    }
+    uint32_t c1 = ESP.getCycleCount(), t1 = micros();
+    report("kernel pilha (midstate em cache)", t1 - t0, c1 - c0, before, heap_snapshot());
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    TEST_MESSAGE(sha_backend_name());
+    RUN_TEST(test_kernel_matches_mbedtls);
+    RUN_TEST(bench_mbedtls_md);
+    RUN_TEST(bench_kernel_full);
+    RUN_TEST(bench_kernel_midstate);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,126 @@
+/*
+  Benchmark do carregamento e da gravação da lista de serviços: formato antigo
+  (quatro chaves por serviço, String por leitura) contra o cofre em um blob.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_bench_vault
+  Apaga o namespace "totp-app" do NVS.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "base32.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "storage.h"
+
+static const int BENCH_SERVICES = 50; // Limite antigo: acima de ~80 serviços o formato antigo não cabe no NVS (5 páginas)
+static const char *BENCH_SECRET = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"; // 20 bytes, caso típico
+
+// Cópia da gravação anterior ao cofre (uma chave por campo), só para comparação
+static void legacy_save() {
+    preferences.begin("totp-app", false);
+    preferences.putInt("svc_count", service_count);
+    for (int i = 0; i < service_count; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "svc_%d_name", i);
+        preferences.putString(key, namestore_get(i));
+        snprintf(key, sizeof(key), "svc_%d_secret", i);
+        preferences.putString(key, BENCH_SECRET); // Só KEY_CACHE_SLOTS chaves cabem na RAM: o Base32 vem da constante
+        snprintf(key, sizeof(key), "svc_%d_params", i);
+        preferences.putUInt(key, (uint32_t)services[i].algorithm | ((uint32_t)services[i].digits << 8) |
+                                     ((uint32_t)services[i].period << 16));
+        snprintf(key, sizeof(key), "svc_%d_ctr", i);
+        preferences.remove(key);
+    }
+    preferences.end();
+}
+
+// Cópia da leitura anterior ao cofre: três getString/getUInt e um Base32 por serviço
+static int legacy_load() {
+    preferences.begin("totp-app", true);
+    int count = preferences.getInt("svc_count", 0);
+    namestore_clear();
+    uint8_t key_bin[MAX_SECRET_BIN_LEN];
+    int valid = 0;
+    for (int i = 0; i < count; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "svc_%d_name", i);
+        String name = preferences.getString(key, "");
+        snprintf(key, sizeof(key), "svc_%d_secret", i);
+        String secret = preferences.getString(key, "");
+        snprintf(key, sizeof(key), "svc_%d_params", i);
+        preferences.getUInt(key, 0);
+        if (name.length() > 0 && base32_decode((const uint8_t *)secret.c_str(), secret.length(), key_bin, sizeof(key_bin)) > 0) {
+            namestore_set(valid, name.c_str(), name.length());
+            valid++;
+        }
+    }
+    memset(key_bin, 0, sizeof(key_bin));
+    preferences.end();
+    return valid;
+}
+
+static void report(const char *label, uint32_t elapsed_us) {
+    char line[112];
+    snprintf(line, sizeof(line), "%d servicos, %-28s %8.2f ms", BENCH_SERVICES, label, elapsed_us / 1000.0f);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fill_services() {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    keystore_clear();
+    namestore_clear();
+    svcmap_clear();
+    for (int i = 0; i < BENCH_SERVICES; i++) {
+        int id = svcmap_alloc();
+        char name[MAX_SERVICE_NAME_LEN + 1];
+        TEST_ASSERT_TRUE(namestore_set(id, name, snprintf(name, sizeof(name), "service-%d", i)));
+        services[id].algorithm = OtpAlgorithm::SHA1;
+        services[id].digits = TOTP_DEFAULT_DIGITS;
+        services[id].period = TOTP_INTERVAL_SECONDS;
+        services[id].kind = OtpKind::TOTP;
+        services[id].counter = 0;
+    }
+}
+
+void bench_legacy_layout() {
+    uint32_t t0 = micros();
+    legacy_save();
+    report("antes: gravacao por chaves", micros() - t0);
+    t0 = micros();
+    int loaded = legacy_load();
+    report("antes: leitura por chaves", micros() - t0);
+    TEST_ASSERT_EQUAL(BENCH_SERVICES, loaded);
+    t0 = micros();
+    loadServices(); // Primeiro boot após a atualização: lê o formato antigo e grava o cofre
+    report("migracao (leitura + cofre)", micros() - t0);
+    TEST_ASSERT_EQUAL(BENCH_SERVICES, service_count);
+}
+
+void bench_vault() {
+    uint32_t t0 = micros();
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    report("depois: gravacao do cofre", micros() - t0);
+    t0 = micros();
+    loadServices();
+    report("depois: leitura do cofre", micros() - t0);
+    TEST_ASSERT_EQUAL(BENCH_SERVICES, service_count);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_fill_services);
+    RUN_TEST(bench_legacy_layout);
+    RUN_TEST(bench_vault);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,128 @@
+/*
+  Benchmark do cofre cifrado: desbloqueio (PBKDF2 + conferência da chave) e tempo
+  até o primeiro código com poucos e com muitos serviços, busca de um segredo
+  (leitura NVS + AES-GCM) e o custo de um bloco AES no motor de hardware contra
+  o C++ portável.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_bench_vault_crypto
+  Apaga o namespace "totp-app" do NVS.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "storage.h"
+#include "crypto/aes_backend.h"
+#include "crypto/aes_gcm.h"
+
+static const char *BENCH_SECRET = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"; // 20 bytes, caso típico
+static const int FETCH_ROUNDS = 50;
+static const int BLOCK_ROUNDS = 1000;
+
+static void report(const char *label, float value, const char *unit) {
+    char line[112];
+    snprintf(line, sizeof(line), "%-44s %10.2f %s", label, value, unit);
+    TEST_MESSAGE(line);
+}
+
+static void fill_vault(int count) {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    keystore_clear();
+    service_count = 0;
+    loadServices();
+    for (int i = 0; i < count; i++) {
+        char name[MAX_SERVICE_NAME_LEN + 1];
+        snprintf(name, sizeof(name), "svc-%d", i); // Curtos: cabem MAX_SERVICES na arena de nomes
+        TEST_ASSERT_TRUE(storage_saveService(name, BENCH_SECRET));
+    }
+}
+
+// Boot até o primeiro código: índice, desbloqueio e um segredo, qualquer que seja o tamanho
+static void bench_first_code(int count) {
+    fill_vault(count);
+    uint32_t t0 = micros();
+    loadServices();
+    codetable_rebuildKeys();
+    TEST_ASSERT_TRUE(codetable_ensureKey(0));
+    uint32_t elapsed = micros() - t0;
+    char label[64];
+    snprintf(label, sizeof(label), "%d servicos: boot ate o 1o segredo", count);
+    report(label, elapsed / 1000.0f, "ms");
+    snprintf(label, sizeof(label), "%d servicos: desbloqueio", count);
+    report(label, storage_getStats().unlock_us / 1000.0f, "ms");
+}
+
+void setUp() {}
+void tearDown() {}
+
+void bench_unlock_does_not_scale() {
+    TEST_MESSAGE(aes_backend_name());
+    bench_first_code(5);
+    bench_first_code(MAX_SERVICES);
+}
+
+// Cada busca: leitura do registro na partição "vault" e decifragem; a chave sai da arena antes da próxima
+void bench_fetch_secret() {
+    fill_vault(KEY_CACHE_SLOTS);
+    loadServices();
+    codetable_rebuildKeys();
+    TEST_ASSERT_TRUE(storage_unlock());
+    StorageStats before = storage_getStats();
+    for (int r = 0; r < FETCH_ROUNDS; r++) {
+        int index = r % service_count;
+        keystore_evict(index);
+        TEST_ASSERT_TRUE(storage_fetchSecret(index));
+    }
+    StorageStats after = storage_getStats();
+    uint32_t reads = after.secret_reads - before.secret_reads;
+    report("busca de segredo (NVS + AES-GCM)", (float)(after.secret_read_us - before.secret_read_us) / reads, "us");
+}
+
+// Só a decifragem de um segredo de 20 e de 64 bytes, sem o NVS
+void bench_gcm_decrypt() {
+    uint8_t key[AES256_KEY_LEN] = {1}, iv[AES_GCM_IV_LEN] = {2}, aad[4] = {0};
+    uint8_t plain[MAX_SECRET_BIN_LEN] = {3}, cipher[MAX_SECRET_BIN_LEN], out[MAX_SECRET_BIN_LEN], tag[AES_GCM_TAG_LEN];
+    AesGcmKey gcm;
+    aesgcm_setKey(key, &gcm);
+    const size_t lengths[] = {20, MAX_SECRET_BIN_LEN};
+    for (size_t length : lengths) {
+        aesgcm_encrypt(&gcm, iv, aad, sizeof(aad), plain, cipher, length, tag);
+        uint32_t t0 = micros();
+        for (int r = 0; r < BLOCK_ROUNDS; r++) {
+            TEST_ASSERT_TRUE(aesgcm_decrypt(&gcm, iv, aad, sizeof(aad), cipher, out, length, tag));
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "AES-GCM decifragem, %u bytes", (unsigned)length);
+        report(label, (float)(micros() - t0) / BLOCK_ROUNDS, "us");
+    }
+    aesgcm_clearKey(&gcm);
+}
+
+void bench_aes_block() {
+    uint8_t key_bytes[AES256_KEY_LEN] = {4}, block[AES_BLOCK_LEN] = {5}, hw[AES_BLOCK_LEN], soft[AES_BLOCK_LEN];
+    Aes256Key key;
+    aes256_setKey(key_bytes, &key);
+    uint32_t t0 = micros();
+    for (int r = 0; r < BLOCK_ROUNDS; r++) aes256_encryptBlock(&key, block, hw);
+    report("bloco AES-256, backend selecionado", (float)(micros() - t0) / BLOCK_ROUNDS, "us");
+    t0 = micros();
+    for (int r = 0; r < BLOCK_ROUNDS; r++) aes256_encryptBlock_portable(&key, block, soft);
+    report("bloco AES-256, portavel", (float)(micros() - t0) / BLOCK_ROUNDS, "us");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(soft, hw, AES_BLOCK_LEN); // Mesmo resultado nos dois backends
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(bench_unlock_does_not_scale);
+    RUN_TEST(bench_fetch_secret);
+    RUN_TEST(bench_gcm_decrypt);
+    RUN_TEST(bench_aes_block);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,132 @@
+/*
+  Linha do tempo de códigos: preenchimento no USB, consulta em bateria, cobertura,
+  remoção e invalidação, mais a economia estimada de CPU/energia.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_code_timeline
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "code_timeline.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "totp.h"
+
+static const uint64_t T0 = 1234567890ULL;
+
+static void add_service(const char *name, const char *secret_b32, uint16_t period) {
+    int id = svcmap_alloc();
+    TEST_ASSERT_TRUE(keystore_decode(id, secret_b32) > 0);
+    TOTPService &s = services[id];
+    TEST_ASSERT_TRUE(namestore_set(id, name, strlen(name)));
+    s.algorithm = OtpAlgorithm::SHA1;
+    s.digits = TOTP_DEFAULT_DIGITS;
+    s.period = period;
+}
+
+// Enche a linha do tempo no USB (várias atualizações regulares, se o orçamento exigir)
+static void fill_on_usb(uint64_t timestamp) {
+    for (int i = 0; i < 1000 && timeline_coverageSeconds(timestamp) < TIMELINE_INTERVALS * 30 - 30; i++) {
+        timeline_tick(timestamp, true);
+    }
+}
+
+void setUp() {
+    keystore_clear();
+    namestore_clear();
+    svcmap_clear();
+    add_service("a", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ", 30);
+    add_service("b", "JBSWY3DPEHPK3PXP", 30);
+    add_service("c", "MZXW6YTBOI", 60);
+    codetable_rebuildKeys();
+}
+
+void tearDown() {
+    keystore_clear();
+    namestore_clear();
+    svcmap_clear();
+}
+
+void test_empty_until_usb() {
+    uint32_t code;
+    TEST_ASSERT_FALSE(timeline_lookup(0, T0, &code));
+    TEST_ASSERT_EQUAL_UINT32(0, timeline_coverageSeconds(T0));
+}
+
+// Todos os intervalos pré-calculados batem com a geração individual
+void test_usb_fill_matches_single_shot() {
+    fill_on_usb(T0);
+    for (int i = 0; i < service_count; i++) {
+        uint32_t period = services[i].period;
+        for (int k = 0; k < TIMELINE_INTERVALS; k++) {
+            uint64_t ts = T0 + (uint64_t)k * period;
+            uint32_t code;
+            TEST_ASSERT_TRUE(timeline_lookup(i, ts, &code));
+            TEST_ASSERT_EQUAL_UINT32(generateTOTPFromState(codetable_keyState(i), ts), code);
+        }
+        uint32_t code;
+        TEST_ASSERT_FALSE(timeline_lookup(i, T0 - period, &code)); // Passado não fica no anel
+    }
+}
+
+// Em bateria a tabela só indexa a linha do tempo: todas as consultas acertam
+void test_battery_hits_and_savings() {
+    fill_on_usb(T0);
+    timeline_tick(T0, false);
+    TimelineStats before = timeline_getStats();
+    for (int w = 0; w < 10; w++) {
+        codetable_update(T0 + (uint64_t)w * 30);
+        codetable_prepareLookahead(T0 + (uint64_t)w * 30);
+        timeline_tick(T0 + (uint64_t)w * 30, false); // Em bateria não gera nada
+    }
+    TimelineStats after = timeline_getStats();
+    TEST_ASSERT_TRUE(after.hits > before.hits);
+    TEST_ASSERT_EQUAL_UINT32(before.misses, after.misses);
+    TEST_ASSERT_EQUAL_UINT32(before.precomputed, after.precomputed);
+    uint32_t code;
+    TEST_ASSERT_TRUE(codetable_getCode(1, &code));
+    TEST_ASSERT_EQUAL_UINT32(generateTOTPFromState(codetable_keyState(1), T0 + 9 * 30), code);
+    timeline_tick(T0 + 300, true); // De volta ao USB: imprime a sessão
+}
+
+// Ao avançar o tempo no USB, os intervalos vencidos saem e novos entram
+void test_ring_slides_forward() {
+    fill_on_usb(T0);
+    uint64_t later = T0 + 10 * 60;
+    fill_on_usb(later);
+    uint32_t code;
+    TEST_ASSERT_FALSE(timeline_lookup(0, T0, &code));
+    uint64_t last = later + (uint64_t)(TIMELINE_INTERVALS - 1) * 30;
+    TEST_ASSERT_TRUE(timeline_lookup(0, last, &code));
+    TEST_ASSERT_EQUAL_UINT32(generateTOTPFromState(codetable_keyState(0), last), code);
+}
+
+void test_remove_and_invalidate() {
+    fill_on_usb(T0);
+    uint32_t expected = generateTOTPFromState(codetable_keyState(2), T0);
+    svcmap_release(1);
+    keystore_evict(1);
+    codetable_removeKey(1);
+    uint32_t code;
+    TEST_ASSERT_FALSE(timeline_lookup(1, T0, &code)); // Anel do id removido descartado
+    TEST_ASSERT_TRUE(timeline_lookup(2, T0, &code));  // O dos outros ids não se move
+    TEST_ASSERT_EQUAL_UINT32(expected, code);
+    codetable_loadKey(2); // Chave recarregada: anel descartado
+    TEST_ASSERT_FALSE(timeline_lookup(2, T0, &code));
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_until_usb);
+    RUN_TEST(test_usb_fill_matches_single_shot);
+    RUN_TEST(test_battery_hits_and_savings);
+    RUN_TEST(test_ring_slides_forward);
+    RUN_TEST(test_remove_and_invalidate);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,268 @@
+/*
+  Serviços HOTP: códigos RFC 4226, uma gravação pequena por código, dobra preguiçosa
+  do journal, recuperação após queda de energia (o contador nunca volta atrás) e
+  entradas presas ao serviço, não ao nome.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_hotp_journal
+  Apaga o namespace "totp-app" do NVS.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "hotp_journal.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "record_store.h"
+#include "service_map.h"
+#include "storage.h"
+#include "totp.h"
+#include "../host/power_cycle.h"
+
+static const char *RFC_SECRET = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"; // "12345678901234567890"
+static const uint32_t RFC4226_CODES[] = {755224, 287082, 359152, 969429, 338314,
+                                         254676, 287922, 162583, 399871, 520489};
+
+static int find_service(const char *name) {
+    return namestore_find(name);
+}
+
+void setUp() {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    keystore_clear();
+    service_count = 0;
+    power_cycle(); // Zera também o journal em RAM
+    TEST_ASSERT_TRUE(storage_saveService("web", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(storage_saveService("hotp", RFC_SECRET, OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 0));
+}
+
+void tearDown() {}
+
+void test_rfc4226_sequence_one_write_per_code() {
+    int index = find_service("hotp");
+    HotpJournalStats before = hotp_getStats();
+    for (int c = 0; c < 10; c++) {
+        uint32_t code;
+        TEST_ASSERT_TRUE(hotp_generate(index, &code));
+        TEST_ASSERT_EQUAL_UINT32(RFC4226_CODES[c], code);
+    }
+    HotpJournalStats after = hotp_getStats();
+    TEST_ASSERT_EQUAL_UINT32(10, after.journal_writes - before.journal_writes);
+    TEST_ASSERT_EQUAL_UINT32(0, after.fold_writes - before.fold_writes); // Anel com folga: nada a dobrar
+    TEST_ASSERT_EQUAL_UINT64(10, services[index].counter);
+    uint32_t code;
+    TEST_ASSERT_FALSE(hotp_generate(find_service("web"), &code)); // TOTP não tem contador
+}
+
+// Queda logo após cada código (com e sem dobra no meio): o contador recarregado é
+// exatamente o próximo a usar, nunca um já mostrado
+void test_power_loss_after_every_code() {
+    uint64_t issued = 0;
+    for (int step = 0; step < 3 * HOTP_JOURNAL_SLOTS; step++) {
+        int index = find_service("hotp");
+        uint32_t code;
+        TEST_ASSERT_TRUE(hotp_generate(index, &code));
+        TEST_ASSERT_EQUAL_UINT32(generateOTPFromState(codetable_keyState(index), issued), code);
+        issued++;
+        if (step % 3 == 0) hotp_tick(); // Dobra preguiçosa em parte das iterações
+        if (step % 2 == 0) {
+            power_cycle();
+            index = find_service("hotp");
+            TEST_ASSERT_TRUE(index >= 0);
+            TEST_ASSERT_EQUAL_UINT64(issued, services[index].counter);
+        }
+    }
+}
+
+// Com a dobra preguiçosa rodando, nenhuma dobra síncrona no caminho do botão e
+// no máximo uma gravação do registro principal a cada meio anel
+void test_lazy_fold_bounds_writes() {
+    int index = find_service("hotp");
+    HotpJournalStats before = hotp_getStats();
+    const int presses = 8 * HOTP_JOURNAL_SLOTS;
+    for (int p = 0; p < presses; p++) {
+        uint32_t code;
+        TEST_ASSERT_TRUE(hotp_generate(index, &code));
+        hotp_tick();
+    }
+    HotpJournalStats after = hotp_getStats();
+    TEST_ASSERT_EQUAL_UINT32(presses, after.journal_writes - before.journal_writes);
+    TEST_ASSERT_EQUAL_UINT32(0, after.forced_folds - before.forced_folds);
+    TEST_ASSERT_LESS_OR_EQUAL(presses / (HOTP_JOURNAL_SLOTS / 2), after.fold_writes - before.fold_writes);
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT64(presses, services[find_service("hotp")].counter);
+}
+
+// Um serviço só: a entrada mais nova supera as antigas, então o anel dá várias
+// voltas sem nenhuma gravação além da entrada de cada código
+void test_single_service_ring_wrap() {
+    int index = find_service("hotp");
+    HotpJournalStats before = hotp_getStats();
+    const int presses = 3 * HOTP_JOURNAL_SLOTS + 5;
+    for (int p = 0; p < presses; p++) {
+        uint32_t code;
+        TEST_ASSERT_TRUE(hotp_generate(index, &code));
+    }
+    HotpJournalStats after = hotp_getStats();
+    TEST_ASSERT_EQUAL_UINT32(0, after.fold_writes - before.fold_writes);
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT64(presses, services[find_service("hotp")].counter);
+}
+
+// Mais serviços em rodízio do que cabem no anel: sem a dobra em segundo plano,
+// reutilizar um slot exige dobra síncrona; com ela, nunca. Os contadores sobrevivem.
+static void press_round_robin(int services_used, int rounds, bool with_ticks) {
+    for (int r = 0; r < rounds; r++) {
+        for (int s = 0; s < services_used; s++) {
+            char name[8];
+            snprintf(name, sizeof(name), "h%d", s);
+            uint32_t code;
+            TEST_ASSERT_TRUE(hotp_generate(find_service(name), &code));
+            if (with_ticks) hotp_tick();
+        }
+    }
+}
+
+void test_many_services_ring_wrap() {
+    const int used = HOTP_JOURNAL_SLOTS + 4;
+    for (int s = 0; s < used; s++) {
+        char name[8];
+        snprintf(name, sizeof(name), "h%d", s);
+        TEST_ASSERT_TRUE(storage_saveService(name, RFC_SECRET, OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 100));
+    }
+    HotpJournalStats before = hotp_getStats();
+    press_round_robin(used, 2, false);
+    HotpJournalStats mid = hotp_getStats();
+    TEST_ASSERT_TRUE(mid.forced_folds > before.forced_folds);
+    for (int t = 0; t < HOTP_JOURNAL_SLOTS; t++) hotp_tick(); // Dobra em segundo plano alcança o anel
+    press_round_robin(used, 2, true);
+    HotpJournalStats after = hotp_getStats();
+    TEST_ASSERT_EQUAL_UINT32(mid.forced_folds, after.forced_folds);
+    power_cycle();
+    for (int s = 0; s < used; s++) {
+        char name[8];
+        snprintf(name, sizeof(name), "h%d", s);
+        TEST_ASSERT_EQUAL_UINT64(104, services[find_service(name)].counter);
+    }
+}
+
+// Cofre e journal fora de ordem (queda entre gravações): vale sempre o maior
+// valor, em qualquer sentido
+void test_stale_records_never_rewind() {
+    int index = find_service("hotp");
+    uint32_t code;
+    for (int p = 0; p < 5; p++) TEST_ASSERT_TRUE(hotp_generate(index, &code));
+    power_cycle(); // Cofre ainda com 0, journal com 5
+    index = find_service("hotp");
+    TEST_ASSERT_EQUAL_UINT64(5, services[index].counter);
+
+    services[index].counter = 40; // Cofre à frente do journal
+    preferences.begin("totp-app", false);
+    TEST_ASSERT_TRUE(storage_writeVault()); // Sem apagar o journal
+    preferences.end();
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT64(40, services[find_service("hotp")].counter);
+}
+
+// Commit mais novo corrompido: o boot carrega o anterior (A/B) e o journal, que a gravação
+// do cofre não apaga, devolve os contadores mais novos
+void test_journal_survives_commit_fallback() {
+    int index = find_service("hotp");
+    uint32_t code;
+    for (int p = 0; p < 3; p++) TEST_ASSERT_TRUE(hotp_generate(index, &code));
+    TEST_ASSERT_TRUE(storage_saveServiceList()); // Commit n: contador 3
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_EQUAL(16, preferences.getBytesLength("hj_0"));
+    preferences.end();
+    for (int p = 0; p < 2; p++) TEST_ASSERT_TRUE(hotp_generate(index, &code));
+    TEST_ASSERT_TRUE(storage_saveServiceList()); // Commit n + 1: contador 5
+
+    preferences.begin("totp-app", true);
+    uint32_t head = preferences.getUInt(NVS_KEY_VAULT_HEAD, 0);
+    preferences.end();
+    uint32_t chunk = VAULT_INDEX_ID_BASE | ((head & 1) << 8);
+    static uint8_t image[RSTORE_MAX_RECORD_LEN];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(rstore_get(chunk, image, sizeof(image), &length));
+    image[length - 1] ^= 0x01;
+    TEST_ASSERT_TRUE(rstore_put(chunk, image, length));
+    uint32_t fallbacks = storage_getStats().slot_fallbacks;
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT32(fallbacks + 1, storage_getStats().slot_fallbacks);
+    TEST_ASSERT_EQUAL_UINT64(5, services[find_service("hotp")].counter);
+}
+
+// Anel reutilizado só com os dois commits em dia: mesmo com dobras síncronas, o
+// commit anterior mais o journal nunca ficam atrás do último código mostrado
+void test_ring_reuse_keeps_fallback_counters() {
+    const int used = HOTP_JOURNAL_SLOTS + 4;
+    for (int s = 0; s < used; s++) {
+        char name[8];
+        snprintf(name, sizeof(name), "h%d", s);
+        TEST_ASSERT_TRUE(storage_saveService(name, RFC_SECRET, OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 0));
+    }
+    press_round_robin(used, 3, false);
+    preferences.begin("totp-app", true);
+    uint32_t head = preferences.getUInt(NVS_KEY_VAULT_HEAD, 0);
+    preferences.end();
+    TEST_ASSERT_TRUE(rstore_remove(VAULT_INDEX_ID_BASE | ((head & 1) << 8))); // Commit mais novo perdido
+    power_cycle();
+    for (int s = 0; s < used; s++) {
+        char name[8];
+        snprintf(name, sizeof(name), "h%d", s);
+        TEST_ASSERT_EQUAL_UINT64(3, services[find_service(name)].counter);
+    }
+}
+
+// Dois serviços com o mesmo nome: cada um recupera só o próprio contador
+void test_same_name_keeps_separate_counters() {
+    TEST_ASSERT_TRUE(storage_saveService("hotp", RFC_SECRET, OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 0));
+    int first = svcmap_at(1), second = svcmap_at(2);
+    uint32_t code;
+    for (int p = 0; p < 5; p++) TEST_ASSERT_TRUE(hotp_generate(first, &code));
+    TEST_ASSERT_TRUE(hotp_generate(second, &code));
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT64(5, services[svcmap_at(1)].counter);
+    TEST_ASSERT_EQUAL_UINT64(1, services[svcmap_at(2)].counter);
+}
+
+// Remover e adicionar de novo com o mesmo nome (e, depois do boot, o mesmo secret_id
+// livre): as entradas do removido nunca voltam para o novo
+void test_deleted_service_entries_not_replayed() {
+    int index = find_service("hotp");
+    uint32_t code;
+    for (int p = 0; p < 7; p++) TEST_ASSERT_TRUE(hotp_generate(index, &code));
+    TEST_ASSERT_TRUE(storage_deleteService(index));
+    preferences.begin("totp-app", false);
+    TEST_ASSERT_TRUE(storage_writeVault()); // Log compactado, journal intacto: o maior secret_id sai do cofre
+    preferences.end();
+    power_cycle(); // Journal ainda com as entradas do removido
+    TEST_ASSERT_TRUE(storage_saveService("hotp", RFC_SECRET, OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 0));
+    TEST_ASSERT_EQUAL_UINT64(0, services[find_service("hotp")].counter);
+    power_cycle();
+    index = find_service("hotp");
+    TEST_ASSERT_EQUAL_UINT64(0, services[index].counter);
+    TEST_ASSERT_TRUE(hotp_generate(index, &code));
+    TEST_ASSERT_EQUAL_UINT32(RFC4226_CODES[0], code);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_rfc4226_sequence_one_write_per_code);
+    RUN_TEST(test_power_loss_after_every_code);
+    RUN_TEST(test_lazy_fold_bounds_writes);
+    RUN_TEST(test_single_service_ring_wrap);
+    RUN_TEST(test_many_services_ring_wrap);
+    RUN_TEST(test_stale_records_never_rewind);
+    RUN_TEST(test_journal_survives_commit_fallback);
+    RUN_TEST(test_ring_reuse_keeps_fallback_counters);
+    RUN_TEST(test_same_name_keeps_separate_counters);
+    RUN_TEST(test_deleted_service_entries_not_replayed);
+    UNITY_END();
+}
+
+void loop() {}
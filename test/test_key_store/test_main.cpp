@@ -0,0 +1,98 @@
+/*
+  Arena de chaves binárias: decodificação única por id, consulta, liberação com
+  compactação, limite de KEY_CACHE_SLOTS slots e reconstrução do Base32 para persistência.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_key_store
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "key_store.h"
+#include "totp.h"
+
+void setUp() { keystore_clear(); }
+void tearDown() { keystore_clear(); }
+
+void test_decode_and_get() {
+    TEST_ASSERT_EQUAL(20, keystore_decode(0, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"));
+    TEST_ASSERT_EQUAL(6, keystore_decode(1, "mzxw6ytboi======")); // Minúsculas e padding
+    const uint8_t *key;
+    size_t len;
+    TEST_ASSERT_TRUE(keystore_get(0, &key, &len));
+    TEST_ASSERT_EQUAL(20, len);
+    TEST_ASSERT_EQUAL_MEMORY("12345678901234567890", key, 20);
+    TEST_ASSERT_TRUE(keystore_get(1, &key, &len));
+    TEST_ASSERT_EQUAL_MEMORY("foobar", key, 6);
+    TEST_ASSERT_EQUAL(26, key_arena.used); // Sem padding entre chaves
+    TEST_ASSERT_FALSE(keystore_get(2, &key, &len));
+}
+
+void test_rejects_invalid_and_oversized() {
+    TEST_ASSERT_EQUAL(0, keystore_decode(0, ""));
+    TEST_ASSERT_EQUAL(0, keystore_decode(0, "!!!!"));
+    char too_long[MAX_SECRET_B32_LEN + 16];
+    memset(too_long, 'A', sizeof(too_long) - 1);
+    too_long[sizeof(too_long) - 1] = '\0';
+    TEST_ASSERT_EQUAL(0, keystore_decode(0, too_long)); // Mais que MAX_SECRET_BIN_LEN bytes
+    TEST_ASSERT_EQUAL(0, keystore_decode(MAX_SERVICES, "JBSWY3DPEHPK3PXP")); // Id fora do limite
+    TEST_ASSERT_EQUAL(0, key_arena.used);
+}
+
+// Liberar a chave de um id compacta os bytes, mas os outros ids continuam com a sua
+void test_evict_compacts() {
+    keystore_decode(0, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"); // 20 bytes
+    keystore_decode(1, "JBSWY3DPEHPK3PXP");                 // 10 bytes
+    keystore_decode(2, "MZXW6YTBOI");                       // 6 bytes
+    keystore_evict(1);
+    TEST_ASSERT_EQUAL(26, key_arena.used);
+    const uint8_t *key;
+    size_t len;
+    TEST_ASSERT_FALSE(keystore_get(1, &key, &len));
+    TEST_ASSERT_TRUE(keystore_get(2, &key, &len));
+    TEST_ASSERT_EQUAL(6, len);
+    TEST_ASSERT_EQUAL_MEMORY("foobar", key, 6);
+    TEST_ASSERT_TRUE(keystore_get(0, &key, &len));
+    TEST_ASSERT_EQUAL_MEMORY("12345678901234567890", key, 20);
+}
+
+// Ids altos usam os mesmos KEY_CACHE_SLOTS slots; cheio, set recusa em vez de tirar outra chave
+void test_slots_bounded() {
+    for (int i = 0; i < KEY_CACHE_SLOTS; i++) {
+        TEST_ASSERT_EQUAL(20, keystore_decode(MAX_SERVICES - 1 - i, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"));
+        TEST_ASSERT_EQUAL(i, keystore_slot(MAX_SERVICES - 1 - i));
+    }
+    TEST_ASSERT_FALSE(keystore_hasFreeSlot());
+    TEST_ASSERT_EQUAL(KEY_ARENA_BYTES, sizeof(key_arena.data));
+    TEST_ASSERT_EQUAL(0, keystore_decode(0, "MZXW6YTBOI"));                  // Sem slot livre
+    TEST_ASSERT_EQUAL(6, keystore_decode(MAX_SERVICES - 1, "MZXW6YTBOI")); // Mesmo id: mesmo slot
+    TEST_ASSERT_EQUAL(0, keystore_slot(MAX_SERVICES - 1));
+    keystore_evict(MAX_SERVICES - 2);
+    TEST_ASSERT_EQUAL(-1, keystore_slot(MAX_SERVICES - 2));
+    TEST_ASSERT_EQUAL(6, keystore_decode(0, "MZXW6YTBOI"));
+    TEST_ASSERT_EQUAL(1, keystore_slot(0)); // Ocupa o slot liberado
+}
+
+void test_encode_roundtrip() {
+    keystore_decode(0, "gezdgnbvgy3tqojq");
+    keystore_decode(1, "MZXW6YTBOI======");
+    char b32[MAX_SECRET_B32_LEN + 1];
+    TEST_ASSERT_EQUAL(16, keystore_encodeBase32(0, b32, sizeof(b32)));
+    TEST_ASSERT_EQUAL_STRING("GEZDGNBVGY3TQOJQ", b32); // Forma canônica gravada no NVS
+    TEST_ASSERT_EQUAL(10, keystore_encodeBase32(1, b32, sizeof(b32)));
+    TEST_ASSERT_EQUAL_STRING("MZXW6YTBOI", b32);
+    TEST_ASSERT_EQUAL(0, keystore_encodeBase32(1, b32, 8)); // Buffer pequeno
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_decode_and_get);
+    RUN_TEST(test_rejects_invalid_and_oversized);
+    RUN_TEST(test_evict_compacts);
+    RUN_TEST(test_slots_bounded);
+    RUN_TEST(test_encode_roundtrip);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,163 @@
+/*
+  Segredos sob demanda: o boot lê só o índice (nenhuma chave na RAM), cada serviço
+  busca seu registro cifrado na primeira exibição (ou antes, como vizinho do exibido)
+  e o cache nunca passa de KEY_CACHE_SLOTS.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_lazy_secrets
+  Apaga o namespace "totp-app" do NVS.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "storage.h"
+#include "totp.h"
+#include "verifier.h"
+#include "../host/power_cycle.h"
+
+static const int SERVICES_USED = 20;
+static const uint64_t T0 = 1700000000ULL;
+
+// Serviços com midstates prontos (chave no cache e slot preparado)
+static int resident_keys() {
+    int resident = 0;
+    for (int p = 0; p < service_count; p++) {
+        if (codetable_keyState(svcmap_at(p))) resident++;
+    }
+    return resident;
+}
+
+void setUp() {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    keystore_clear();
+    service_count = 0;
+    power_cycle();
+    for (int i = 0; i < SERVICES_USED; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "s%02d", i);
+        TEST_ASSERT_TRUE(storage_saveService(name, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ"));
+    }
+    power_cycle();
+}
+
+void tearDown() {}
+
+void test_boot_loads_no_secret() {
+    uint32_t reads = storage_getStats().secret_reads;
+    power_cycle();
+    TEST_ASSERT_EQUAL(SERVICES_USED, service_count);
+    TEST_ASSERT_EQUAL(0, key_arena.used);
+    TEST_ASSERT_EQUAL(0, resident_keys());
+    TEST_ASSERT_EQUAL_UINT32(reads, storage_getStats().secret_reads);
+}
+
+// Primeira exibição lê o segredo uma vez; as seguintes usam o cache
+void test_fetch_once_per_service() {
+    uint32_t reads = storage_getStats().secret_reads;
+    current_service_index = 3;
+    TEST_ASSERT_TRUE(selectCurrentService());
+    TEST_ASSERT_EQUAL_UINT32(reads + 1, storage_getStats().secret_reads);
+    TEST_ASSERT_TRUE(selectCurrentService());
+    TEST_ASSERT_EQUAL_UINT32(reads + 1, storage_getStats().secret_reads);
+    TEST_ASSERT_EQUAL(1, resident_keys());
+}
+
+// Rolar a lista inteira: no máximo KEY_CACHE_SLOTS chaves residentes, e a menos
+// usada é a que sai
+void test_cache_is_bounded() {
+    for (int i = 0; i < SERVICES_USED; i++) {
+        TEST_ASSERT_TRUE(codetable_ensureKey(i));
+        TEST_ASSERT_TRUE(resident_keys() <= KEY_CACHE_SLOTS);
+    }
+    TEST_ASSERT_EQUAL(KEY_CACHE_SLOTS, resident_keys());
+    TEST_ASSERT_NOT_NULL(codetable_keyState(SERVICES_USED - 1));
+    TEST_ASSERT_NULL(codetable_keyState(0));
+    const uint8_t *key;
+    size_t len;
+    TEST_ASSERT_FALSE(keystore_get(0, &key, &len)); // Bytes fora da arena, não só os midstates
+    TEST_ASSERT_TRUE(codetable_ensureKey(0));
+    TEST_ASSERT_EQUAL(KEY_CACHE_SLOTS, resident_keys());
+}
+
+// A atualização de 500 ms busca os vizinhos do serviço exibido: prev/next não leem a flash
+void test_lookahead_prefetches_neighbours() {
+    current_service_index = svcmap_at(0);
+    TEST_ASSERT_TRUE(selectCurrentService());
+    uint32_t reads = storage_getStats().secret_reads;
+    codetable_prepareLookahead(T0);
+    TEST_ASSERT_EQUAL_UINT32(reads + 2, storage_getStats().secret_reads); // Anterior (dá a volta) e próximo
+    codetable_prepareLookahead(T0);
+    TEST_ASSERT_EQUAL_UINT32(reads + 2, storage_getStats().secret_reads); // Já residentes
+    for (int delta = -1; delta <= 1; delta += 2) {
+        current_service_index = svcmap_step(svcmap_at(0), delta);
+        TEST_ASSERT_TRUE(selectCurrentService());
+    }
+    TEST_ASSERT_EQUAL_UINT32(reads + 2, storage_getStats().secret_reads);
+    TEST_ASSERT_EQUAL(3, resident_keys());
+}
+
+// prev/next com o cache frio: traços e nenhuma leitura no botão; a atualização de 500 ms busca
+void test_navigation_defers_fetch() {
+    current_service_index = svcmap_at(9);
+    TEST_ASSERT_NULL(codetable_keyState(current_service_index));
+    uint32_t reads = storage_getStats().secret_reads;
+    TEST_ASSERT_TRUE(selectCurrentService(false));
+    TEST_ASSERT_TRUE(current_totp.key_pending);
+    TEST_ASSERT_EQUAL_STRING("------", current_totp.code);
+    TEST_ASSERT_EQUAL_UINT32(reads, storage_getStats().secret_reads);
+    TEST_ASSERT_NULL(codetable_keyState(current_service_index));
+    TEST_ASSERT_TRUE(finishPendingService());
+    TEST_ASSERT_EQUAL_UINT32(reads + 1, storage_getStats().secret_reads);
+    TEST_ASSERT_FALSE(current_totp.key_pending);
+    TEST_ASSERT_TRUE(current_totp.valid_key_loaded);
+    TEST_ASSERT_FALSE(finishPendingService()); // Nada mais pendente
+    TEST_ASSERT_TRUE(selectCurrentService(false)); // Já residente: código na hora
+    TEST_ASSERT_FALSE(current_totp.key_pending);
+}
+
+// O verificador busca o segredo de um serviço ainda não exibido
+void test_verifier_fetches_secret() {
+    TEST_ASSERT_NULL(codetable_keyState(7));
+    TEST_ASSERT_TRUE(codetable_ensureKey(7));
+    char code[12];
+    snprintf(code, sizeof(code), "%06lu", (unsigned long)generateTOTPFromState(codetable_keyState(7), T0));
+    power_cycle();
+    int offset;
+    TEST_ASSERT_EQUAL((int)VerifyResult::ACCEPTED, (int)verifier_check("s07", code, 1, T0, &offset));
+}
+
+// Remover um serviço não mexe no segredo dos outros
+void test_delete_keeps_other_secrets() {
+    TEST_ASSERT_TRUE(codetable_ensureKey(5));
+    uint32_t expected = generateTOTPFromState(codetable_keyState(5), T0);
+    TEST_ASSERT_TRUE(storage_deleteService(2));
+    TEST_ASSERT_EQUAL_STRING("s05", namestore_get(5)); // Mesmo id até o próximo boot
+    TEST_ASSERT_NOT_NULL(codetable_keyState(5));       // Midstates continuam no lugar
+    power_cycle();
+    TEST_ASSERT_EQUAL(SERVICES_USED - 1, service_count);
+    int id = svcmap_at(4); // Quinto na ordem depois da remoção
+    TEST_ASSERT_EQUAL_STRING("s05", namestore_get(id));
+    TEST_ASSERT_TRUE(codetable_ensureKey(id));
+    TEST_ASSERT_EQUAL_UINT32(expected, generateTOTPFromState(codetable_keyState(id), T0));
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_loads_no_secret);
+    RUN_TEST(test_fetch_once_per_service);
+    RUN_TEST(test_cache_is_bounded);
+    RUN_TEST(test_lookahead_prefetches_neighbours);
+    RUN_TEST(test_navigation_defers_fetch);
+    RUN_TEST(test_verifier_fetches_secret);
+    RUN_TEST(test_delete_keeps_other_secrets);
+    UNITY_END();
+}
+
+void loop() {}
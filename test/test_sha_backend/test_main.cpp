@@ -0,0 +1,121 @@
+/*
+  Conformidade do backend SHA selecionado (portável por padrão; motor do S3 com
+  -DTOTP_SHA_BACKEND_HW em build_flags). Precisa passar na placa com o motor antes
+  de ele virar o padrão.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_sha_backend
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "crypto/sha_backend.h"
+#include "crypto/hmac_sha1.h"
+#include "crypto/sha256.h"
+#include "totp.h"
+
+static const uint8_t RFC_KEY[] = "12345678901234567890";
+static const size_t RFC_KEY_LEN = 20;
+// Chaves do RFC 6238 para SHA-256 (32 bytes) e SHA-512 (64 bytes)
+static const uint8_t RFC_KEY_SHA256[] = "12345678901234567890123456789012";
+static const uint8_t RFC_KEY_SHA512[] = "1234567890123456789012345678901234567890123456789012345678901234";
+static const uint64_t RFC6238_TIMES[] = {59ULL, 1111111109ULL, 1111111111ULL, 1234567890ULL, 2000000000ULL, 20000000000ULL};
+static const size_t RFC6238_COUNT = sizeof(RFC6238_TIMES) / sizeof(RFC6238_TIMES[0]);
+
+void setUp() {}
+void tearDown() {}
+
+// Backend selecionado x compressão portável, bloco a bloco
+void test_backend_matches_portable_compress() {
+    uint32_t seed = 0x12345678;
+    for (int round = 0; round < 64; round++) {
+        uint8_t block[SHA1_BLOCK_LEN];
+        for (size_t i = 0; i < SHA1_BLOCK_LEN; i++) {
+            seed = seed * 1664525u + 1013904223u; // LCG determinístico
+            block[i] = seed >> 24;
+        }
+        Sha1State hw, sw;
+        sha1_init(&hw);
+        for (int i = 0; i < 5; i++) hw.h[i] ^= seed * (i + 1); // Midstates arbitrários
+        sw = hw;
+        sha1_compress(&hw, block);
+        sha1_compress_portable(&sw, block);
+        TEST_ASSERT_EQUAL_HEX32_ARRAY(sw.h, hw.h, 5);
+
+        Sha256State hw256, sw256;
+        sha256_init(&hw256);
+        for (int i = 0; i < 8; i++) hw256.h[i] ^= seed * (i + 3);
+        sw256 = hw256;
+        sha256_compress(&hw256, block);
+        sha256_compress_portable(&sw256, block);
+        TEST_ASSERT_EQUAL_HEX32_ARRAY(sw256.h, hw256.h, 8);
+    }
+}
+
+// RFC 4226, Apêndice D: HOTP com contadores 0..9
+void test_rfc4226_vectors() {
+    static const uint32_t expected[] = {755224, 287082, 359152, 969429, 338314,
+                                        254676, 287922, 162583, 399871, 520489};
+    for (int c = 0; c < 10; c++) {
+        // Um timestamp igual ao contador com intervalo 1s dá exatamente HOTP(c)
+        TEST_ASSERT_EQUAL_UINT32(expected[c], generateTOTP(RFC_KEY, RFC_KEY_LEN, c, 1));
+    }
+}
+
+// RFC 6238, Apêndice B (SHA-1): os 6 dígitos finais dos códigos de 8 dígitos
+void test_rfc6238_sha1_vectors() {
+    static const uint32_t expected8[] = {94287082, 7081804, 14050471, 89005924, 69279037, 65353130};
+    for (size_t i = 0; i < RFC6238_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected8[i] % 1000000, generateTOTP(RFC_KEY, RFC_KEY_LEN, RFC6238_TIMES[i], 30));
+    }
+}
+
+// RFC 6238, Apêndice B completo: 8 dígitos, SHA-1/SHA-256/SHA-512 pelos geradores especializados
+void test_rfc6238_all_algorithms_8_digits() {
+    static const uint32_t sha1[] = {94287082, 7081804, 14050471, 89005924, 69279037, 65353130};
+    static const uint32_t sha256[] = {46119246, 68084774, 67062674, 91819424, 90698825, 77737706};
+    static const uint32_t sha512[] = {90693936, 25091201, 99943326, 93441116, 38618901, 47863826};
+    TOTPKeyState s1, s256, s512;
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY, RFC_KEY_LEN, &s1, OtpAlgorithm::SHA1, 8, 30));
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY_SHA256, 32, &s256, OtpAlgorithm::SHA256, 8, 30));
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY_SHA512, 64, &s512, OtpAlgorithm::SHA512, 8, 30));
+    for (size_t i = 0; i < RFC6238_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT32(sha1[i], generateTOTPFromState(&s1, RFC6238_TIMES[i]));
+        TEST_ASSERT_EQUAL_UINT32(sha256[i], generateTOTPFromState(&s256, RFC6238_TIMES[i]));
+        TEST_ASSERT_EQUAL_UINT32(sha512[i], generateTOTPFromState(&s512, RFC6238_TIMES[i]));
+    }
+}
+
+// Período próprio do serviço: equivale ao caminho genérico com o mesmo intervalo
+void test_custom_period_and_invalid_params() {
+    TOTPKeyState state;
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY, RFC_KEY_LEN, &state, OtpAlgorithm::SHA1, 6, 60));
+    TEST_ASSERT_EQUAL_UINT32(generateTOTP(RFC_KEY, RFC_KEY_LEN, 1234567890ULL, 60), generateTOTPFromState(&state, 1234567890ULL));
+    TEST_ASSERT_FALSE(prepareTOTPKey(RFC_KEY, RFC_KEY_LEN, &state, OtpAlgorithm::SHA1, 7, 30));
+    TEST_ASSERT_FALSE(prepareTOTPKey(RFC_KEY, RFC_KEY_LEN, &state, OtpAlgorithm::SHA1, 6, 0));
+}
+
+// Reserva explícita (regeneração em lote) não altera resultados
+void test_acquired_session_matches() {
+    TOTPKeyState state;
+    TEST_ASSERT_TRUE(prepareTOTPKey(RFC_KEY, RFC_KEY_LEN, &state));
+    uint32_t single = generateTOTPFromState(&state, 1234567890ULL);
+    sha_backend_acquire();
+    uint32_t batched = generateTOTPFromState(&state, 1234567890ULL);
+    sha_backend_release();
+    TEST_ASSERT_EQUAL_UINT32(single, batched);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    TEST_MESSAGE(sha_backend_name());
+    RUN_TEST(test_backend_matches_portable_compress);
+    RUN_TEST(test_rfc4226_vectors);
+    RUN_TEST(test_rfc6238_sha1_vectors);
+    RUN_TEST(test_rfc6238_all_algorithms_8_digits);
+    RUN_TEST(test_custom_period_and_invalid_params);
+    RUN_TEST(test_acquired_session_matches);
+    UNITY_END();
+}
+
+void loop() {}
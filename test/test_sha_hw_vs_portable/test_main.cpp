@@ -0,0 +1,280 @@
+/*
+  Motor SHA do S3 x compressão portável nos vetores HMAC do RFC 2202 (SHA-1) e do
+  RFC 4231 (SHA-256/SHA-512). Cada vetor é calculado duas vezes pelo mesmo HMAC de
+  teste, mudando só a compressão (sha*_compress do backend selecionado ou
+  sha*_compress_portable), e também pelo caminho curto da biblioteca (midstates).
+  Executar na placa com o motor: pio test -e lilygo-t-display-s3-sha-hw -f test_sha_hw_vs_portable
+  Sem -DTOTP_SHA_BACKEND_HW os dois lados são portáveis e o teste do backend é ignorado.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+#include <string.h>
+
+#include "crypto/sha_backend.h"
+#include "crypto/hmac_sha1.h"
+#include "crypto/hmac_sha256.h"
+#include "crypto/hmac_sha512.h"
+
+// Hash genérico: a compressão é a única parte trocada entre os dois lados
+struct HashOps {
+    size_t block_len;
+    size_t digest_len;
+    size_t length_field;  // Bytes do comprimento em bits no fim do último bloco (8 ou 16)
+    void (*init)(void *state);
+    void (*compress)(void *state, const uint8_t *block);
+    void (*store)(const void *state, uint8_t *out);
+};
+
+union AnyState {
+    Sha1State s1;
+    Sha256State s256;
+    Sha512State s512;
+};
+
+static void store_be(uint64_t word, size_t bytes, uint8_t *out) {
+    for (size_t i = 0; i < bytes; i++) out[i] = (uint8_t)(word >> (8 * (bytes - 1 - i)));
+}
+
+static void init_sha1(void *s) { sha1_init((Sha1State *)s); }
+static void hw_sha1(void *s, const uint8_t *b) { sha1_compress((Sha1State *)s, b); }
+static void sw_sha1(void *s, const uint8_t *b) { sha1_compress_portable((Sha1State *)s, b); }
+static void store_sha1(const void *s, uint8_t *out) {
+    for (int i = 0; i < 5; i++) store_be(((const Sha1State *)s)->h[i], 4, out + 4 * i);
+}
+
+static void init_sha256(void *s) { sha256_init((Sha256State *)s); }
+static void hw_sha256(void *s, const uint8_t *b) { sha256_compress((Sha256State *)s, b); }
+static void sw_sha256(void *s, const uint8_t *b) { sha256_compress_portable((Sha256State *)s, b); }
+static void store_sha256(const void *s, uint8_t *out) {
+    for (int i = 0; i < 8; i++) store_be(((const Sha256State *)s)->h[i], 4, out + 4 * i);
+}
+
+static void init_sha512(void *s) { sha512_init((Sha512State *)s); }
+static void hw_sha512(void *s, const uint8_t *b) { sha512_compress((Sha512State *)s, b); }
+static void sw_sha512(void *s, const uint8_t *b) { sha512_compress_portable((Sha512State *)s, b); }
+static void store_sha512(const void *s, uint8_t *out) {
+    for (int i = 0; i < 8; i++) store_be(((const Sha512State *)s)->h[i], 8, out + 8 * i);
+}
+
+static const HashOps SHA1_HW = {SHA1_BLOCK_LEN, SHA1_DIGEST_LEN, 8, init_sha1, hw_sha1, store_sha1};
+static const HashOps SHA1_SW = {SHA1_BLOCK_LEN, SHA1_DIGEST_LEN, 8, init_sha1, sw_sha1, store_sha1};
+static const HashOps SHA256_HW = {SHA256_BLOCK_LEN, SHA256_DIGEST_LEN, 8, init_sha256, hw_sha256, store_sha256};
+static const HashOps SHA256_SW = {SHA256_BLOCK_LEN, SHA256_DIGEST_LEN, 8, init_sha256, sw_sha256, store_sha256};
+static const HashOps SHA512_HW = {SHA512_BLOCK_LEN, SHA512_DIGEST_LEN, 16, init_sha512, hw_sha512, store_sha512};
+static const HashOps SHA512_SW = {SHA512_BLOCK_LEN, SHA512_DIGEST_LEN, 16, init_sha512, sw_sha512, store_sha512};
+
+// Hash de a || b, bloco a bloco, com o padding FIPS 180-4
+static void hash_concat(const HashOps &ops, const uint8_t *a, size_t a_len, const uint8_t *b, size_t b_len, uint8_t *out) {
+    AnyState state;
+    uint8_t block[SHA512_BLOCK_LEN];
+    size_t used = 0;
+    ops.init(&state);
+    const uint8_t *parts[2] = {a, b};
+    size_t lengths[2] = {a_len, b_len};
+    for (int p = 0; p < 2; p++) {
+        for (size_t i = 0; i < lengths[p]; i++) {
+            block[used++] = parts[p][i];
+            if (used == ops.block_len) {
+                ops.compress(&state, block);
+                used = 0;
+            }
+        }
+    }
+    block[used++] = 0x80;
+    if (used > ops.block_len - ops.length_field) {
+        memset(block + used, 0, ops.block_len - used);
+        ops.compress(&state, block);
+        used = 0;
+    }
+    memset(block + used, 0, ops.block_len - used);
+    store_be((uint64_t)(a_len + b_len) * 8, 8, block + ops.block_len - 8);
+    ops.compress(&state, block);
+    ops.store(&state, out);
+}
+
+// HMAC (RFC 2104) de qualquer tamanho de chave e mensagem
+static void hmac_with(const HashOps &ops, const uint8_t *key, size_t key_len, const uint8_t *msg, size_t msg_len, uint8_t *out) {
+    uint8_t key_block[SHA512_BLOCK_LEN] = {0};
+    if (key_len > ops.block_len) hash_concat(ops, key, key_len, nullptr, 0, key_block);
+    else memcpy(key_block, key, key_len);
+    uint8_t pad[SHA512_BLOCK_LEN];
+    uint8_t inner[SHA512_DIGEST_LEN];
+    for (size_t i = 0; i < ops.block_len; i++) pad[i] = key_block[i] ^ 0x36;
+    hash_concat(ops, pad, ops.block_len, msg, msg_len, inner);
+    for (size_t i = 0; i < ops.block_len; i++) pad[i] = key_block[i] ^ 0x5C;
+    hash_concat(ops, pad, ops.block_len, inner, ops.digest_len, out);
+}
+
+static size_t parse_hex(const char *hex, uint8_t *out) {
+    size_t n = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        char byte[3] = {hex[0], hex[1], 0};
+        out[n++] = (uint8_t)strtoul(byte, nullptr, 16);
+    }
+    return n;
+}
+
+// --- Vetores: chave e mensagem como nos RFCs (bytes repetidos ou texto) ---
+struct Vector {
+    uint8_t key_byte;     // Chave = key_len vezes este byte; 0 = chave em texto ou 0x01..0x19
+    size_t key_len;
+    const char *key_text; // Chave em texto (ex: "Jefe")
+    uint8_t msg_byte;     // Mensagem = msg_len vezes este byte; 0 = mensagem em texto
+    size_t msg_len;
+    const char *msg_text;
+};
+
+static const char LONG_KEY_FIRST[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+
+static const Vector RFC2202[] = {
+    {0x0b, 20, nullptr, 0, 0, "Hi There"},
+    {0, 4, "Jefe", 0, 0, "what do ya want for nothing?"},
+    {0xaa, 20, nullptr, 0xdd, 50, nullptr},
+    {0, 25, nullptr, 0xcd, 50, nullptr},
+    {0x0c, 20, nullptr, 0, 0, "Test With Truncation"},
+    {0xaa, 80, nullptr, 0, 0, LONG_KEY_FIRST},
+    {0xaa, 80, nullptr, 0, 0, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data"},
+};
+static const char *RFC2202_SHA1[] = {
+    "b617318655057264e28bc0b6fb378c8ef146be00", "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+    "125d7342b9ac11cd91a39af48aa17b4f63f175d3", "4c9007f4026250c6bc8414f9bf50c86c2d7235da",
+    "4c1a03424b55e07fe7f27be1d58bb9324a9a5a04", "aa4ae5e15272d00e95705637ce8a3b55ed402112",
+    "e8e99d0f45237d786d6bbaa7965c7808bbff1a91",
+};
+
+static const Vector RFC4231[] = {
+    {0x0b, 20, nullptr, 0, 0, "Hi There"},
+    {0, 4, "Jefe", 0, 0, "what do ya want for nothing?"},
+    {0xaa, 20, nullptr, 0xdd, 50, nullptr},
+    {0, 25, nullptr, 0xcd, 50, nullptr},
+    {0x0c, 20, nullptr, 0, 0, "Test With Truncation"}, // Saída truncada em 128 bits
+    {0xaa, 131, nullptr, 0, 0, LONG_KEY_FIRST},
+    {0xaa, 131, nullptr, 0, 0,
+     "This is a test using a larger than block-size key and a larger than block-size data. "
+     "The key needs to be hashed before being used by the HMAC algorithm."},
+};
+static const char *RFC4231_SHA256[] = {
+    "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7",
+    "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+    "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe",
+    "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b",
+    "a3b6167473100ee06e0c796c2955552b",
+    "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54",
+    "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2",
+};
+static const char *RFC4231_SHA512[] = {
+    "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cde"
+    "daa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854",
+    "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+    "9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737",
+    "fa73b0089d56a284efb0f0756c890be9b1b5dbdd8ee81a3655f83e33b2279d39"
+    "bf3e848279a722c806b485a47e67c807b946a337bee8942674278859e13292fb",
+    "b0ba465637458c6990e5a8c5f61d4af7e576d97ff94b872de76f8050361ee3db"
+    "a91ca5c11aa25eb4d679275cc5788063a5f19741120c4f2de2adebeb10a298dd",
+    "415fad6271580a531d4179bc891d87a6",
+    "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f352"
+    "6b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598",
+    "e37b6a775dc87dbaa4dfa9f96e5e3ffddebd71f8867289865df5a32d20cdc944"
+    "b6022cac3c4982b10d5eeb55c3e4de15134676fb6de0446065c97440fa8c6a58",
+};
+
+static const int VECTOR_COUNT = sizeof(RFC2202) / sizeof(RFC2202[0]);
+
+static uint8_t key_buf[131];
+static uint8_t msg_buf[160];
+
+static void expand(const Vector &v, size_t *key_len, size_t *msg_len) {
+    *key_len = v.key_len;
+    for (size_t i = 0; i < v.key_len; i++) {
+        key_buf[i] = v.key_text ? (uint8_t)v.key_text[i] : v.key_byte ? v.key_byte : (uint8_t)(i + 1);
+    }
+    *msg_len = v.msg_text ? strlen(v.msg_text) : v.msg_len;
+    if (v.msg_text) memcpy(msg_buf, v.msg_text, *msg_len);
+    else memset(msg_buf, v.msg_byte, *msg_len);
+}
+
+// Os dois lados contra o RFC e entre si; 'expected' pode ser truncado
+static void check_vector(const HashOps &hw, const HashOps &sw, const Vector &v, const char *expected_hex, uint8_t *hw_out) {
+    size_t key_len, msg_len;
+    expand(v, &key_len, &msg_len);
+    uint8_t expected[SHA512_DIGEST_LEN], sw_out[SHA512_DIGEST_LEN];
+    size_t expected_len = parse_hex(expected_hex, expected);
+    sha_backend_acquire();
+    hmac_with(hw, key_buf, key_len, msg_buf, msg_len, hw_out);
+    sha_backend_release();
+    hmac_with(sw, key_buf, key_len, msg_buf, msg_len, sw_out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(sw_out, hw_out, hw.digest_len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, hw_out, expected_len);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_hw_backend_selected() {
+#if !TOTP_SHA_BACKEND_ESP32S3
+    TEST_IGNORE_MESSAGE("backend portável: compilar com -e lilygo-t-display-s3-sha-hw para comparar o motor");
+#endif
+    TEST_ASSERT_EQUAL_STRING("esp32s3-hw", sha_backend_name());
+}
+
+// RFC 2202: HMAC-SHA1, inclusive chave e mensagem maiores que um bloco
+void test_rfc2202_hmac_sha1() {
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        uint8_t out[SHA512_DIGEST_LEN];
+        check_vector(SHA1_HW, SHA1_SW, RFC2202[i], RFC2202_SHA1[i], out);
+        size_t key_len, msg_len;
+        expand(RFC2202[i], &key_len, &msg_len);
+        if (msg_len > HMAC_SHA1_MAX_SHORT_MSG) continue;
+        HmacSha1Key key; // Caminho do TOTP: midstates + mensagem curta
+        uint8_t short_out[SHA1_DIGEST_LEN];
+        hmac_sha1_prepare(key_buf, key_len, &key);
+        hmac_sha1_short(&key, msg_buf, msg_len, short_out);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out, short_out, SHA1_DIGEST_LEN);
+    }
+}
+
+// RFC 4231: HMAC-SHA256
+void test_rfc4231_hmac_sha256() {
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        uint8_t out[SHA512_DIGEST_LEN];
+        check_vector(SHA256_HW, SHA256_SW, RFC4231[i], RFC4231_SHA256[i], out);
+        size_t key_len, msg_len;
+        expand(RFC4231[i], &key_len, &msg_len);
+        if (msg_len > HMAC_SHA256_MAX_SHORT_MSG) continue;
+        HmacSha256Key key;
+        uint8_t short_out[SHA256_DIGEST_LEN];
+        hmac_sha256_prepare(key_buf, key_len, &key);
+        hmac_sha256_short(&key, msg_buf, msg_len, short_out);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out, short_out, SHA256_DIGEST_LEN);
+    }
+}
+
+// RFC 4231: HMAC-SHA512 (no S3 o SHA-512 continua portável; o vetor cobre o caminho mesmo assim)
+void test_rfc4231_hmac_sha512() {
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        uint8_t out[SHA512_DIGEST_LEN];
+        check_vector(SHA512_HW, SHA512_SW, RFC4231[i], RFC4231_SHA512[i], out);
+        size_t key_len, msg_len;
+        expand(RFC4231[i], &key_len, &msg_len);
+        if (msg_len > HMAC_SHA512_MAX_SHORT_MSG) continue;
+        HmacSha512Key key;
+        uint8_t short_out[SHA512_DIGEST_LEN];
+        hmac_sha512_prepare(key_buf, key_len, &key);
+        hmac_sha512_short(&key, msg_buf, msg_len, short_out);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(out, short_out, SHA512_DIGEST_LEN);
+    }
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    TEST_MESSAGE(sha_backend_name());
+    RUN_TEST(test_hw_backend_selected);
+    RUN_TEST(test_rfc2202_hmac_sha1);
+    RUN_TEST(test_rfc4231_hmac_sha256);
+    RUN_TEST(test_rfc4231_hmac_sha512);
+    UNITY_END();
+}
+
+void loop() {}
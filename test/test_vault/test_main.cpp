@@ -0,0 +1,353 @@
+/*
+  Índice do cofre em uma imagem (pedaços na partição "vault"): ida e volta de todos os
+  campos, capacidade máxima, migração do formato antigo (uma chave por campo), commit A/B
+  (virada interrompida e imagem corrompida) e rejeição de imagens corrompidas ou truncadas.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_vault
+  Apaga o namespace "totp-app" do NVS e a partição "vault".
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "record_store.h"
+#include "storage.h"
+#include "../host/power_cycle.h"
+
+static void clear_nvs() {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    rstore_format();
+    keystore_clear();
+    service_count = 0;
+}
+
+// Pedaço 0 (cabeçalho e primeiros registros) da imagem do último commit A/B (o que o boot lê)
+static uint32_t active_vault_chunk() {
+    preferences.begin("totp-app", true);
+    uint32_t head = preferences.getUInt(NVS_KEY_VAULT_HEAD, 0);
+    preferences.end();
+    return VAULT_INDEX_ID_BASE | ((head & 1) << 8);
+}
+
+static void assert_key(int index, const char *expected_b32) {
+    char b32[MAX_SECRET_B32_LEN + 1];
+    TEST_ASSERT_TRUE(codetable_ensureKey(index)); // Segredo vem do NVS sob demanda
+    TEST_ASSERT_TRUE(keystore_encodeBase32(index, b32, sizeof(b32)) > 0);
+    TEST_ASSERT_EQUAL_STRING(expected_b32, b32);
+}
+
+void setUp() {
+    clear_nvs();
+    power_cycle(); // Zera também o estado do log em RAM
+}
+
+void tearDown() {}
+
+void test_roundtrip_all_fields() {
+    TEST_ASSERT_TRUE(storage_saveService("github", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(storage_saveService("bank", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQGEZA",
+                                         OtpAlgorithm::SHA256, 8, 60));
+    TEST_ASSERT_TRUE(storage_saveService("vpn", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ",
+                                         OtpAlgorithm::SHA1, 6, 30, OtpKind::HOTP, 1234567890123ULL));
+    power_cycle();
+    TEST_ASSERT_EQUAL(3, service_count);
+    TEST_ASSERT_EQUAL_STRING("github", namestore_get(0));
+    TEST_ASSERT_EQUAL_STRING("bank", namestore_get(1));
+    TEST_ASSERT_EQUAL_STRING("vpn", namestore_get(2));
+    TEST_ASSERT_EQUAL((int)OtpAlgorithm::SHA256, (int)services[1].algorithm);
+    TEST_ASSERT_EQUAL(8, services[1].digits);
+    TEST_ASSERT_EQUAL(60, services[1].period);
+    TEST_ASSERT_EQUAL((int)OtpKind::TOTP, (int)services[0].kind);
+    TEST_ASSERT_EQUAL((int)OtpKind::HOTP, (int)services[2].kind);
+    TEST_ASSERT_EQUAL_UINT64(1234567890123ULL, services[2].counter);
+    assert_key(0, "JBSWY3DPEHPK3PXP");
+    assert_key(1, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQGEZA");
+    assert_key(2, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ");
+}
+
+// Índice de poucos serviços num só registro da partição (pedaço 0), nada dele no NVS além
+// do cabeçalho A/B; os segredos, um registro cada
+void test_single_key_layout() {
+    TEST_ASSERT_TRUE(storage_saveService("a", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(storage_saveService("b", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(rstore_contains(active_vault_chunk()));
+    TEST_ASSERT_FALSE(rstore_contains(active_vault_chunk() + 1));
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey(NVS_KEY_VAULT));
+    TEST_ASSERT_FALSE(preferences.isKey(NVS_KEY_VAULT_B));
+    TEST_ASSERT_FALSE(preferences.isKey("svc_count"));
+    TEST_ASSERT_FALSE(preferences.isKey("svc_0_name"));
+    TEST_ASSERT_FALSE(preferences.isKey("se_0"));
+    preferences.end();
+    uint8_t record[64];
+    size_t length = 0;
+    uint32_t id_a = services[0].secret_id;
+    TEST_ASSERT_TRUE(rstore_get(id_a, record, sizeof(record), &length));
+    TEST_ASSERT_EQUAL(12 + 10 + 16, length); // IV | cifrado | tag
+    TEST_ASSERT_TRUE(rstore_get(services[1].secret_id, record, sizeof(record), &length));
+    TEST_ASSERT_EQUAL(12 + 10 + 16, length);
+    TEST_ASSERT_EQUAL_UINT32(2 + 1, rstore_getStats().records); // Segredos e o pedaço do índice
+    TEST_ASSERT_TRUE(storage_deleteService(0));
+    TEST_ASSERT_FALSE(rstore_contains(id_a)); // Segredo removido junto com o serviço
+    TEST_ASSERT_EQUAL_UINT32(1 + 1, rstore_getStats().records);
+    power_cycle();
+    TEST_ASSERT_EQUAL(1, service_count);
+    TEST_ASSERT_EQUAL_STRING("b", namestore_get(svcmap_at(0))); // Log reaplicado: "b" mantém o id 1
+    assert_key(svcmap_at(0), "JBSWY3DPEHPK3PXP");
+}
+
+// Chave de 64 bytes (o maior segredo Base32 aceito)
+static void max_secret(char *secret) {
+    const size_t b32_len = (MAX_SECRET_BIN_LEN * 8 + 4) / 5; // 103 caracteres = 64 bytes
+    memset(secret, 'A', b32_len - 1);
+    secret[b32_len - 1] = 'Q'; // Bits de sobra zerados
+    secret[b32_len] = '\0';
+}
+
+// Cofre cheio: MAX_SERVICES serviços com chaves no tamanho máximo e nomes curtos
+void test_full_capacity() {
+    char secret[MAX_SECRET_B32_LEN + 1];
+    max_secret(secret);
+    for (int i = 0; i < MAX_SERVICES; i++) {
+        char name[MAX_SERVICE_NAME_LEN + 1];
+        snprintf(name, sizeof(name), "s%d", i); // Curtos: a arena de nomes não é o limite aqui
+        TEST_ASSERT_TRUE(storage_saveService(name, secret));
+    }
+    TEST_ASSERT_FALSE(storage_saveService("one-more", secret));
+    power_cycle();
+    TEST_ASSERT_EQUAL(MAX_SERVICES, service_count);
+    int last = svcmap_at(MAX_SERVICES - 1);
+    char last_name[MAX_SERVICE_NAME_LEN + 1];
+    snprintf(last_name, sizeof(last_name), "s%d", MAX_SERVICES - 1);
+    TEST_ASSERT_EQUAL_STRING(last_name, namestore_get(last));
+    const uint8_t *key;
+    size_t len;
+    TEST_ASSERT_TRUE(codetable_ensureKey(last));
+    TEST_ASSERT_TRUE(keystore_get(last, &key, &len));
+    TEST_ASSERT_EQUAL(MAX_SECRET_BIN_LEN, len);
+}
+
+// Nomes de 20 caracteres: a arena de nomes (12 B por serviço) é o limite, não
+// MAX_SERVICES. Só NAME_ARENA_BYTES / 21 cabem; o seguinte é recusado sem perder nada
+void test_long_names_fill_name_arena() {
+    const int fit = (int)(NAME_ARENA_BYTES / (MAX_SERVICE_NAME_LEN + 1));
+    char secret[MAX_SECRET_B32_LEN + 1];
+    max_secret(secret);
+    char name[MAX_SERVICE_NAME_LEN + 1];
+    for (int i = 0; i < fit; i++) {
+        snprintf(name, sizeof(name), "service-%012d", i);
+        TEST_ASSERT_TRUE(storage_saveService(name, secret));
+    }
+    TEST_ASSERT_TRUE(fit < MAX_SERVICES);
+    snprintf(name, sizeof(name), "service-%012d", fit);
+    TEST_ASSERT_TRUE(namestore_free() < MAX_SERVICE_NAME_LEN + 1);
+    TEST_ASSERT_FALSE(storage_saveService(name, secret)); // STR_ERROR_NAME_SPACE
+    TEST_ASSERT_EQUAL(fit, service_count);
+    TEST_ASSERT_TRUE(storage_saveService("x", secret)); // Um nome curto ainda cabe nos bytes restantes
+    power_cycle();
+    TEST_ASSERT_EQUAL(fit + 1, service_count);
+    snprintf(name, sizeof(name), "service-%012d", fit - 1);
+    TEST_ASSERT_EQUAL_STRING(name, namestore_get(svcmap_at(fit - 1)));
+    TEST_ASSERT_EQUAL_STRING("x", namestore_get(svcmap_at(fit)));
+}
+
+// Primeiro boot após a atualização: formato antigo é lido, gravado no cofre e apagado
+void test_migrates_legacy_layout() {
+    preferences.begin("totp-app", false);
+    preferences.putInt("svc_count", 3);
+    preferences.putString("svc_0_name", "old-totp");
+    preferences.putString("svc_0_secret", "JBSWY3DPEHPK3PXP"); // Sem params: padrão SHA1/6/30
+    preferences.putString("svc_1_name", "");                  // Entrada inválida: compactada
+    preferences.putString("svc_2_name", "old-hotp");
+    preferences.putString("svc_2_secret", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ");
+    preferences.putUInt("svc_2_params", 0x80u | (6u << 8) | (30u << 16));
+    preferences.putULong64("svc_2_ctr", 42);
+    preferences.end();
+
+    power_cycle();
+    TEST_ASSERT_EQUAL(2, service_count);
+    TEST_ASSERT_EQUAL_STRING("old-totp", namestore_get(0));
+    TEST_ASSERT_EQUAL(30, services[0].period);
+    TEST_ASSERT_EQUAL_STRING("old-hotp", namestore_get(1));
+    TEST_ASSERT_EQUAL((int)OtpKind::HOTP, (int)services[1].kind);
+    TEST_ASSERT_EQUAL_UINT64(42, services[1].counter);
+    assert_key(1, "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ");
+
+    TEST_ASSERT_TRUE(rstore_contains(active_vault_chunk()));
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey("svc_count"));
+    TEST_ASSERT_FALSE(preferences.isKey("svc_0_name"));
+    TEST_ASSERT_FALSE(preferences.isKey("svc_2_secret"));
+    TEST_ASSERT_FALSE(preferences.isKey("svc_2_ctr"));
+    preferences.end();
+    TEST_ASSERT_TRUE(rstore_contains(services[1].secret_id)); // Segredos migrados para registros próprios
+
+    power_cycle(); // Agora do cofre
+    TEST_ASSERT_EQUAL(2, service_count);
+    TEST_ASSERT_EQUAL_UINT64(42, services[1].counter);
+    assert_key(0, "JBSWY3DPEHPK3PXP");
+}
+
+// Mais serviços antigos que slots no cache: cada segredo é selado ao ser lido, nenhum
+// fica para trás e a RAM nunca guarda mais que KEY_CACHE_SLOTS chaves
+void test_migrates_more_than_key_cache() {
+    const int count = KEY_CACHE_SLOTS * 3;
+    const char *secrets[] = {"JBSWY3DPEHPK3PXP", "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ", "MFRGGZDFMZTWQ2LK"};
+    preferences.begin("totp-app", false);
+    preferences.putInt("svc_count", count);
+    for (int i = 0; i < count; i++) {
+        char key[24], name[8];
+        snprintf(name, sizeof(name), "s%02d", i);
+        snprintf(key, sizeof(key), "svc_%d_name", i);
+        preferences.putString(key, name);
+        snprintf(key, sizeof(key), "svc_%d_secret", i);
+        preferences.putString(key, secrets[i % 3]);
+    }
+    preferences.end();
+
+    power_cycle();
+    TEST_ASSERT_EQUAL(count, service_count);
+    TEST_ASSERT_EQUAL(0, key_arena.used); // Selados, não residentes
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey("svc_count"));
+    preferences.end();
+    power_cycle(); // Agora do cofre
+    TEST_ASSERT_EQUAL(count, service_count);
+    for (int i = 0; i < count; i++) assert_key(i, secrets[i % 3]);
+}
+
+// Cada commit vai para o outro slot, e o cabeçalho só vira depois da imagem gravada:
+// sem a virada, o boot carrega o commit anterior; com a imagem nova corrompida, também
+void test_ab_commit() {
+    TEST_ASSERT_TRUE(storage_saveService("github", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(storage_saveService("bank", "GEZDGNBVGY3TQOJQ"));
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    uint32_t old_slot = active_vault_chunk();
+    preferences.begin("totp-app", true);
+    uint32_t head = preferences.getUInt(NVS_KEY_VAULT_HEAD, 0);
+    preferences.end();
+    TEST_ASSERT_TRUE(head > 0);
+
+    services[1].digits = 8; // Só um commit grava a mudança (não passa pelo log)
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    uint32_t new_slot = active_vault_chunk();
+    TEST_ASSERT_TRUE(old_slot != new_slot);
+    TEST_ASSERT_TRUE(rstore_contains(old_slot)); // Commit anterior intacto
+    preferences.begin("totp-app", false);
+    TEST_ASSERT_EQUAL_UINT32(head + 1, preferences.getUInt(NVS_KEY_VAULT_HEAD, 0));
+    preferences.putUInt(NVS_KEY_VAULT_HEAD, head); // Queda antes da virada
+    preferences.end();
+    power_cycle();
+    TEST_ASSERT_EQUAL(2, service_count);
+    TEST_ASSERT_EQUAL_STRING("bank", namestore_get(1));
+    TEST_ASSERT_EQUAL(TOTP_DEFAULT_DIGITS, services[1].digits); // Commit anterior, sem a mudança
+
+    static uint8_t image[RSTORE_MAX_RECORD_LEN];
+    preferences.begin("totp-app", false);
+    preferences.putUInt(NVS_KEY_VAULT_HEAD, head + 1);
+    preferences.end();
+    size_t length = 0;
+    TEST_ASSERT_TRUE(rstore_get(new_slot, image, sizeof(image), &length));
+    image[length - 1] ^= 0x01; // Imagem do último commit corrompida
+    TEST_ASSERT_TRUE(rstore_put(new_slot, image, length));
+    uint32_t fallbacks = storage_getStats().slot_fallbacks;
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT32(fallbacks + 1, storage_getStats().slot_fallbacks);
+    TEST_ASSERT_EQUAL(2, service_count);
+    TEST_ASSERT_EQUAL_STRING("bank", namestore_get(1));
+    TEST_ASSERT_EQUAL(TOTP_DEFAULT_DIGITS, services[1].digits); // Commit anterior, sem a mudança
+    assert_key(1, "GEZDGNBVGY3TQOJQ");
+
+    TEST_ASSERT_TRUE(storage_saveService("mail", "JBSWY3DPEHPK3PXP")); // Regrava o slot corrompido
+    TEST_ASSERT_EQUAL_UINT32(new_slot, active_vault_chunk());
+    power_cycle();
+    TEST_ASSERT_EQUAL(3, service_count);
+    TEST_ASSERT_EQUAL_UINT32(fallbacks + 1, storage_getStats().slot_fallbacks);
+    TEST_ASSERT_EQUAL_STRING("mail", namestore_get(2));
+}
+
+// Imagem em vários pedaços: um pedaço do meio adulterado invalida a imagem inteira (o boot
+// carrega o commit anterior), e uma imagem menor apaga os pedaços que sobraram no slot
+void test_multi_chunk_image() {
+    const int count = 200;
+    char name[MAX_SERVICE_NAME_LEN + 1];
+    for (int i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "s%d", i);
+        TEST_ASSERT_TRUE(storage_saveService(name, "JBSWY3DPEHPK3PXP"));
+    }
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    TEST_ASSERT_TRUE(storage_saveServiceList()); // Os dois slots com todos os serviços
+    uint32_t slot = active_vault_chunk();
+    TEST_ASSERT_TRUE(rstore_contains(slot + 2));
+    static uint8_t image[RSTORE_MAX_RECORD_LEN];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(rstore_get(slot + 1, image, sizeof(image), &length));
+    image[length - 1] ^= 0x01; // Último byte de um nome
+    TEST_ASSERT_TRUE(rstore_put(slot + 1, image, length));
+    uint32_t fallbacks = storage_getStats().slot_fallbacks;
+    power_cycle();
+    TEST_ASSERT_EQUAL_UINT32(fallbacks + 1, storage_getStats().slot_fallbacks);
+    TEST_ASSERT_EQUAL(count, service_count);
+    snprintf(name, sizeof(name), "s%d", count - 1);
+    TEST_ASSERT_EQUAL_STRING(name, namestore_get(svcmap_at(count - 1)));
+
+    while (service_count > 2) TEST_ASSERT_TRUE(storage_deleteService(svcmap_at(0)));
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    TEST_ASSERT_FALSE(rstore_contains(slot + 1));
+    TEST_ASSERT_FALSE(rstore_contains((slot ^ (1u << 8)) + 1));
+    TEST_ASSERT_EQUAL_UINT32(2 + 2, rstore_getStats().records); // Dois segredos e um pedaço por slot
+    power_cycle();
+    TEST_ASSERT_EQUAL(2, service_count);
+    snprintf(name, sizeof(name), "s%d", count - 1);
+    TEST_ASSERT_EQUAL_STRING(name, namestore_get(svcmap_at(1)));
+}
+
+// Qualquer byte trocado ou imagem truncada, sem commit anterior: nada é carregado
+void test_rejects_corrupted_vault() {
+    TEST_ASSERT_TRUE(storage_saveService("github", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(storage_saveService("bank", "GEZDGNBVGY3TQOJQ"));
+    uint32_t slot = active_vault_chunk(); // Primeiro commit: o outro slot está vazio
+    static uint8_t image[RSTORE_MAX_RECORD_LEN];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(rstore_get(slot, image, sizeof(image), &length));
+
+    for (size_t pos = 0; pos < length; pos += 3) {
+        image[pos] ^= 0x10;
+        TEST_ASSERT_TRUE(rstore_put(slot, image, length));
+        power_cycle();
+        TEST_ASSERT_EQUAL(0, service_count);
+        image[pos] ^= 0x10;
+    }
+
+    TEST_ASSERT_TRUE(rstore_put(slot, image, length - 1));
+    power_cycle();
+    TEST_ASSERT_EQUAL(0, service_count);
+
+    TEST_ASSERT_TRUE(rstore_put(slot, image, length)); // Imagem original volta a carregar
+    power_cycle();
+    TEST_ASSERT_EQUAL(2, service_count);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_roundtrip_all_fields);
+    RUN_TEST(test_single_key_layout);
+    RUN_TEST(test_full_capacity);
+    RUN_TEST(test_long_names_fill_name_arena);
+    RUN_TEST(test_migrates_legacy_layout);
+    RUN_TEST(test_migrates_more_than_key_cache);
+    RUN_TEST(test_ab_commit);
+    RUN_TEST(test_multi_chunk_image);
+    RUN_TEST(test_rejects_corrupted_vault);
+    UNITY_END();
+}
+
+void loop() {}
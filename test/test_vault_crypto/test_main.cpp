@@ -0,0 +1,239 @@
+/*
+  Segredos cifrados com AES-256-GCM: nenhum byte da chave em claro na flash, registro
+  adulterado ou trocado de serviço recusado, migração dos "sk_%u" em claro (cofre
+  versão 3) e dos "se_%u" cifrados do NVS (versão 4), e sal do PBKDF2 criado uma única vez.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_vault_crypto
+  Apaga o namespace "totp-app" do NVS e a partição "vault".
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "crc32.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "record_store.h"
+#include "storage.h"
+#include "../host/power_cycle.h"
+
+// "12345678901234567890" em Base32
+static const char *RFC_SECRET = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+static const uint8_t RFC_KEY[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9', '0',
+                                  '1', '2', '3', '4', '5', '6', '7', '8', '9', '0'};
+
+static void assert_resident_key(int index, const uint8_t *expected, size_t length) {
+    const uint8_t *key;
+    size_t key_len;
+    TEST_ASSERT_TRUE(codetable_ensureKey(index));
+    TEST_ASSERT_TRUE(keystore_get(index, &key, &key_len));
+    TEST_ASSERT_EQUAL(length, key_len);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, key, length);
+}
+
+// Pedaço 0 da imagem do último commit A/B do cofre (na partição)
+static uint32_t active_vault_chunk() {
+    preferences.begin("totp-app", true);
+    uint32_t head = preferences.getUInt(NVS_KEY_VAULT_HEAD, 0);
+    preferences.end();
+    return VAULT_INDEX_ID_BASE | ((head & 1) << 8);
+}
+
+static bool contains(const uint8_t *data, size_t length, const uint8_t *needle, size_t needle_len) {
+    for (size_t i = 0; i + needle_len <= length; i++) {
+        if (memcmp(&data[i], needle, needle_len) == 0) return true;
+    }
+    return false;
+}
+
+void setUp() {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    rstore_format();
+    keystore_clear();
+    service_count = 0;
+    power_cycle();
+}
+
+void tearDown() {}
+
+// O registro só guarda IV, cifrado e tag: nem a chave inteira nem um trecho de 8 bytes aparece
+void test_secret_not_stored_in_clear() {
+    TEST_ASSERT_TRUE(storage_saveService("rfc", RFC_SECRET));
+    uint8_t record[64];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(rstore_get(services[0].secret_id, record, sizeof(record), &length));
+    static uint8_t vault[RSTORE_MAX_RECORD_LEN];
+    size_t vault_len = 0;
+    TEST_ASSERT_TRUE(rstore_get(active_vault_chunk(), vault, sizeof(vault), &vault_len));
+    TEST_ASSERT_EQUAL(12 + sizeof(RFC_KEY) + 16, length);
+    for (size_t i = 0; i + 8 <= sizeof(RFC_KEY); i++) {
+        TEST_ASSERT_FALSE(contains(record, length, &RFC_KEY[i], 8));
+        TEST_ASSERT_FALSE(contains(vault, vault_len, &RFC_KEY[i], 8));
+    }
+    power_cycle();
+    assert_resident_key(0, RFC_KEY, sizeof(RFC_KEY));
+}
+
+// Bit trocado ou registro copiado para o id de outro serviço: recusado, nada entra na arena
+void test_tampered_or_swapped_record_rejected() {
+    TEST_ASSERT_TRUE(storage_saveService("a", RFC_SECRET));
+    TEST_ASSERT_TRUE(storage_saveService("b", "JBSWY3DPEHPK3PXP"));
+    uint8_t record_a[64], record_b[64];
+    size_t len_a = 0, len_b = 0;
+    uint32_t id_b = services[1].secret_id;
+    TEST_ASSERT_TRUE(rstore_get(services[0].secret_id, record_a, sizeof(record_a), &len_a));
+    TEST_ASSERT_TRUE(rstore_get(id_b, record_b, sizeof(record_b), &len_b));
+    TEST_ASSERT_TRUE(rstore_put(id_b, record_a, len_a)); // Segredo de 'a' no lugar do de 'b'
+    power_cycle();
+    TEST_ASSERT_FALSE(codetable_ensureKey(1));
+    const uint8_t *key;
+    size_t key_len;
+    TEST_ASSERT_FALSE(keystore_get(1, &key, &key_len));
+    assert_resident_key(0, RFC_KEY, sizeof(RFC_KEY));
+
+    record_b[14] ^= 0x01; // Primeiro byte do cifrado
+    TEST_ASSERT_TRUE(rstore_put(id_b, record_b, len_b));
+    power_cycle();
+    TEST_ASSERT_FALSE(codetable_ensureKey(1));
+    record_b[14] ^= 0x01;
+    TEST_ASSERT_TRUE(rstore_put(id_b, record_b, len_b));
+    power_cycle();
+    TEST_ASSERT_TRUE(codetable_ensureKey(1));
+}
+
+// Cofre versão 3 (índice atual, segredo em "sk_%u" em claro): cifrado e apagado no boot
+void test_migrates_plain_secrets() {
+    static uint8_t blob[64];
+    const char *name = "old";
+    uint32_t params = (uint32_t)OtpAlgorithm::SHA1 | (6u << 8) | (30u << 16);
+    uint32_t secret_id = 7;
+    const size_t header_size = 20; // sizeof(VaultHeader) da versão 2 em diante
+    size_t pos = header_size;
+    blob[pos++] = (uint8_t)strlen(name);
+    memcpy(&blob[pos], &params, 4);
+    pos += 4;
+    memcpy(&blob[pos], &secret_id, 4);
+    pos += 4;
+    memcpy(&blob[pos], name, strlen(name));
+    pos += strlen(name);
+    uint32_t log_seq = 0;
+    uint32_t payload_len = pos - header_size;
+    uint32_t crc = crc32_update(&blob[header_size], payload_len, crc32_update((const uint8_t *)&log_seq, 4));
+    uint32_t magic = 0x544C5656;
+    uint16_t count = 1;
+    memcpy(&blob[0], &magic, 4);
+    blob[4] = 3; // Versão
+    blob[5] = 0;
+    memcpy(&blob[6], &count, 2);
+    memcpy(&blob[8], &payload_len, 4);
+    memcpy(&blob[12], &crc, 4);
+    memcpy(&blob[16], &log_seq, 4);
+    preferences.begin("totp-app", false);
+    preferences.putBytes(NVS_KEY_VAULT, blob, pos);
+    preferences.putBytes("sk_7", RFC_KEY, sizeof(RFC_KEY));
+    preferences.end();
+
+    power_cycle();
+    TEST_ASSERT_EQUAL(1, service_count);
+    TEST_ASSERT_EQUAL_STRING("old", namestore_get(0));
+    TEST_ASSERT_EQUAL(0, key_arena.used); // Migrado e tirado da RAM, como num boot comum
+    uint8_t record[64];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(rstore_get(7, record, sizeof(record), &length));
+    TEST_ASSERT_EQUAL(12 + sizeof(RFC_KEY) + 16, length);
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey("sk_7"));
+    TEST_ASSERT_FALSE(preferences.isKey(NVS_KEY_VAULT)); // A imagem antiga não fica como commit anterior
+    preferences.end();
+    for (uint32_t slot = 0; slot < 2; slot++) { // Os dois slots no formato atual, na partição
+        TEST_ASSERT_TRUE(rstore_get(VAULT_INDEX_ID_BASE | (slot << 8), blob, sizeof(blob), &length));
+        TEST_ASSERT_EQUAL(7, blob[4]);
+    }
+    assert_resident_key(0, RFC_KEY, sizeof(RFC_KEY));
+
+    power_cycle(); // Agora do formato atual
+    assert_resident_key(0, RFC_KEY, sizeof(RFC_KEY));
+}
+
+// Cofre versão 4 (segredos já cifrados, mas em "se_%u" no NVS): cada registro é copiado
+// como está para a partição, o índice passa à versão atual e as chaves do NVS somem
+void test_migrates_nvs_sealed_secrets() {
+    TEST_ASSERT_TRUE(storage_saveService("a", RFC_SECRET));
+    TEST_ASSERT_TRUE(storage_saveService("b", "JBSWY3DPEHPK3PXP"));
+    TEST_ASSERT_TRUE(storage_saveServiceList());
+    static uint8_t blob[128];
+    size_t blob_len = 0;
+    TEST_ASSERT_TRUE(rstore_get(active_vault_chunk(), blob, sizeof(blob), &blob_len));
+    TEST_ASSERT_TRUE(rstore_remove(VAULT_INDEX_ID_BASE));            // Cofre versão 4: só no NVS
+    TEST_ASSERT_TRUE(rstore_remove(VAULT_INDEX_ID_BASE | (1u << 8)));
+    preferences.begin("totp-app", false);
+    // Imagem versão 4: cabeçalho de 20 bytes (sem 'commit'), num só slot e sem cabeçalho A/B
+    uint32_t log_seq, payload_len;
+    memcpy(&log_seq, &blob[16], 4);
+    memmove(&blob[20], &blob[24], blob_len - 24);
+    blob_len -= 4;
+    payload_len = blob_len - 20;
+    uint32_t crc = crc32_update(&blob[20], payload_len, crc32_update((const uint8_t *)&log_seq, 4));
+    blob[4] = 4;
+    memcpy(&blob[8], &payload_len, 4);
+    memcpy(&blob[12], &crc, 4);
+    preferences.remove(NVS_KEY_VAULT_HEAD);
+    preferences.remove(NVS_KEY_VAULT_B);
+    preferences.putBytes(NVS_KEY_VAULT, blob, blob_len);
+    for (int i = 0; i < service_count; i++) {
+        uint8_t record[64];
+        size_t length = 0;
+        char key[16];
+        snprintf(key, sizeof(key), "se_%u", (unsigned)services[i].secret_id);
+        TEST_ASSERT_TRUE(rstore_get(services[i].secret_id, record, sizeof(record), &length));
+        preferences.putBytes(key, record, length);
+        TEST_ASSERT_TRUE(rstore_remove(services[i].secret_id));
+    }
+    preferences.end();
+
+    power_cycle();
+    TEST_ASSERT_EQUAL(2, service_count);
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey("se_0"));
+    TEST_ASSERT_FALSE(preferences.isKey("se_1"));
+    preferences.end();
+    TEST_ASSERT_TRUE(rstore_get(active_vault_chunk(), blob, sizeof(blob), &blob_len));
+    TEST_ASSERT_EQUAL(7, blob[4]);
+    assert_resident_key(0, RFC_KEY, sizeof(RFC_KEY));
+    power_cycle(); // Agora do formato atual
+    assert_resident_key(0, RFC_KEY, sizeof(RFC_KEY));
+    TEST_ASSERT_TRUE(codetable_ensureKey(1));
+}
+
+// Sal criado no primeiro desbloqueio e nunca mais regravado
+void test_kdf_record_written_once() {
+    TEST_ASSERT_TRUE(storage_unlock());
+    TEST_ASSERT_TRUE(storage_saveService("a", RFC_SECRET));
+    uint8_t before[64], after[64];
+    preferences.begin("totp-app", true);
+    size_t length = preferences.getBytes(NVS_KEY_VAULT_KDF, before, sizeof(before));
+    preferences.end();
+    TEST_ASSERT_EQUAL(16 + 12 + 16, length);
+    TEST_ASSERT_TRUE(storage_saveService("b", RFC_SECRET));
+    TEST_ASSERT_TRUE(storage_unlock());
+    preferences.begin("totp-app", true);
+    preferences.getBytes(NVS_KEY_VAULT_KDF, after, sizeof(after));
+    preferences.end();
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(before, after, length);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_secret_not_stored_in_clear);
+    RUN_TEST(test_tampered_or_swapped_record_rejected);
+    RUN_TEST(test_migrates_plain_secrets);
+    RUN_TEST(test_migrates_nvs_sealed_secrets);
+    RUN_TEST(test_kdf_record_written_once);
+    UNITY_END();
+}
+
+void loop() {}
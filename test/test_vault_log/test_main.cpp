@@ -0,0 +1,179 @@
+/*
+  Log incremental do cofre: adicionar ou remover grava uma entrada só, o boot
+  reaplica o log sobre o blob, a compactação roda em storage_tick() e uma
+  entrada interrompida não estraga as anteriores.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_vault_log
+  Apaga o namespace "totp-app" do NVS.
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "storage.h"
+#include "../host/power_cycle.h"
+
+static const char *SECRET = "JBSWY3DPEHPK3PXP";
+
+// Modelo da lista esperada (ordem de exibição), mantido em paralelo às operações
+static char model[MAX_SERVICES][MAX_SERVICE_NAME_LEN + 1];
+static int model_count = 0;
+
+static void assert_matches_model() {
+    TEST_ASSERT_EQUAL(model_count, service_count);
+    for (int i = 0; i < model_count; i++) {
+        TEST_ASSERT_EQUAL_STRING(model[i], namestore_get(svcmap_at(i)));
+    }
+}
+
+static void add(const char *name) {
+    TEST_ASSERT_TRUE(storage_saveService(name, SECRET));
+    strcpy(model[model_count++], name);
+}
+
+// Remove o serviço na posição dada da ordem de exibição
+static void del(int position) {
+    TEST_ASSERT_TRUE(storage_deleteService(svcmap_at(position)));
+    for (int i = position; i < model_count - 1; i++) strcpy(model[i], model[i + 1]);
+    model_count--;
+    assert_matches_model(); // A RAM já tem a ordem certa, sem recarregar
+}
+
+static void drain_ticks() {
+    for (int t = 0; t < 2 * VAULT_LOG_SLOTS; t++) storage_tick();
+}
+
+void setUp() {
+    preferences.begin("totp-app", false);
+    preferences.clear();
+    preferences.end();
+    keystore_clear();
+    model_count = 0;
+    power_cycle();
+    add("base"); // Sem cofre ainda: a primeira mudança grava o blob
+}
+
+void tearDown() {}
+
+// Adicionar e remover custam uma entrada de log cada, com 1 ou 40 serviços no cofre
+void test_add_delete_write_one_entry() {
+    for (int round = 0; round < 2; round++) {
+        StorageStats before = storage_getStats();
+        add("extra");
+        del(model_count - 1);
+        StorageStats after = storage_getStats();
+        TEST_ASSERT_EQUAL_UINT32(2, after.log_appends - before.log_appends);
+        TEST_ASSERT_EQUAL_UINT32(0, after.compactions - before.compactions);
+        if (round == 0) { // Cresce o cofre e compacta antes da segunda rodada
+            for (int i = 0; i < 39; i++) {
+                char name[8];
+                snprintf(name, sizeof(name), "s%d", i);
+                add(name);
+                storage_tick();
+            }
+            drain_ticks();
+            preferences.begin("totp-app", false);
+            TEST_ASSERT_TRUE(storage_writeVault());
+            preferences.end();
+        }
+    }
+    power_cycle();
+    assert_matches_model();
+}
+
+// Sequência de adições e remoções com boots no meio: a RAM recarregada é a mesma lista
+void test_replay_matches_model() {
+    uint32_t seed = 12345;
+    for (int step = 0; step < 120; step++) {
+        seed = seed * 1664525u + 1013904223u;
+        if (model_count > 1 && (seed >> 28) < 6) {
+            del((seed >> 8) % model_count);
+        } else if (model_count < MAX_SERVICES) {
+            char name[12];
+            snprintf(name, sizeof(name), "n%d", step);
+            add(name);
+        }
+        if (step % 3 == 0) storage_tick();
+        if (step % 7 == 0) {
+            power_cycle();
+            assert_matches_model();
+        }
+    }
+    power_cycle();
+    assert_matches_model();
+}
+
+// Metade do anel ocupada: storage_tick() compacta uma vez e depois apaga as chaves antigas
+void test_background_compaction() {
+    StorageStats before = storage_getStats();
+    for (int i = 0; i < VAULT_LOG_SLOTS / 2; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "c%d", i);
+        add(name);
+    }
+    storage_tick();
+    StorageStats mid = storage_getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, mid.compactions - before.compactions);
+    TEST_ASSERT_EQUAL_UINT32(0, mid.forced_compactions - before.forced_compactions);
+    drain_ticks();
+    StorageStats after = storage_getStats();
+    TEST_ASSERT_EQUAL_UINT32(VAULT_LOG_SLOTS / 2, after.stale_removed - mid.stale_removed);
+    preferences.begin("totp-app", true);
+    TEST_ASSERT_FALSE(preferences.isKey("vlog_0"));
+    preferences.end();
+    power_cycle();
+    assert_matches_model();
+}
+
+// Sem ticks, o anel enche: uma mudança grava o cofre inteiro e nada se perde
+void test_full_log_forces_compaction() {
+    StorageStats before = storage_getStats();
+    for (int i = 0; i < VAULT_LOG_SLOTS + 3; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "f%d", i);
+        add(name);
+    }
+    StorageStats after = storage_getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, after.forced_compactions - before.forced_compactions);
+    power_cycle();
+    assert_matches_model();
+}
+
+// Queda no meio da gravação de uma entrada: ela se perde, as anteriores não
+void test_torn_entry_stops_replay() {
+    add("kept");
+    add("torn");
+    static uint8_t entry[160];
+    char key[12];
+    snprintf(key, sizeof(key), "vlog_%d", 1); // 'base' foi para o blob; "kept" = 0, "torn" = 1
+    preferences.begin("totp-app", false);
+    size_t length = preferences.getBytesLength(key);
+    TEST_ASSERT_TRUE(length > 0 && length <= sizeof(entry));
+    preferences.getBytes(key, entry, length);
+    entry[length - 1] ^= 0xFF;
+    preferences.putBytes(key, entry, length);
+    preferences.end();
+    model_count--;
+    power_cycle();
+    assert_matches_model();
+    add("after"); // Reaproveita a posição da entrada perdida
+    power_cycle();
+    assert_matches_model();
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_add_delete_write_one_entry);
+    RUN_TEST(test_replay_matches_model);
+    RUN_TEST(test_background_compaction);
+    RUN_TEST(test_full_log_forces_compaction);
+    RUN_TEST(test_torn_entry_stops_replay);
+    UNITY_END();
+}
+
+void loop() {}
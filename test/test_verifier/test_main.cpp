@@ -0,0 +1,124 @@
+/*
+  Modo verificador: busca na janela +-W por nome de serviço, desvio devolvido,
+  cache de replay e validação do código recebido.
+  Executar na placa: pio test -e lilygo-t-display-s3 -f test_verifier
+*/
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "globals.h"
+#include "code_table.h"
+#include "key_store.h"
+#include "name_store.h"
+#include "service_map.h"
+#include "totp.h"
+#include "verifier.h"
+
+static const uint64_t T0 = 1234567890ULL;
+
+// Formata o código esperado de um serviço com seus dígitos (zeros à esquerda)
+static void code_at(int index, uint64_t timestamp, char *out, size_t size) {
+    snprintf(out, size, "%0*lu", codetable_keyState(index)->digits,
+             (unsigned long)generateTOTPFromState(codetable_keyState(index), timestamp));
+}
+
+void setUp() {
+    keystore_clear();
+    namestore_clear();
+    verifier_clearReplayCache();
+    svcmap_clear();
+    const char *names[] = {"bancada", "erp"};
+    const char *secrets[] = {"GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ", "JBSWY3DPEHPK3PXP"};
+    for (int i = 0; i < 2; i++) {
+        int id = svcmap_alloc();
+        TEST_ASSERT_TRUE(keystore_decode(id, secrets[i]) > 0);
+        TEST_ASSERT_TRUE(namestore_set(id, names[i], strlen(names[i])));
+        services[id].algorithm = OtpAlgorithm::SHA1;
+        services[id].digits = i == 0 ? 6 : 8;
+        services[id].period = 30;
+        services[id].secret_id = 10 + i;
+    }
+    codetable_rebuildKeys();
+}
+
+void tearDown() {
+    keystore_clear();
+    namestore_clear();
+    svcmap_clear();
+}
+
+void test_accepts_within_window_and_reports_offset() {
+    char code[TOTP_MAX_DIGITS + 1];
+    int offset = 99;
+    code_at(0, T0 - 2 * 30, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("bancada", code, 2, T0, &offset));
+    TEST_ASSERT_EQUAL_INT(-2, offset);
+    code_at(1, T0 + 30, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("erp", code, 1, T0, &offset));
+    TEST_ASSERT_EQUAL_INT(1, offset);
+    code_at(0, T0 + 3 * 30, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::REJECTED, verifier_check("bancada", code, 2, T0, &offset));
+}
+
+// O mesmo contador não é aceito duas vezes, nem quando visto de outro instante da janela
+void test_replay_rejected() {
+    char code[TOTP_MAX_DIGITS + 1];
+    int offset;
+    code_at(0, T0, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("bancada", code, 1, T0, &offset));
+    TEST_ASSERT_EQUAL(VerifyResult::REPLAYED, verifier_check("bancada", code, 1, T0, &offset));
+    TEST_ASSERT_EQUAL(VerifyResult::REPLAYED, verifier_check("bancada", code, 1, T0 + 30, &offset));
+    TEST_ASSERT_EQUAL_INT(-1, offset);
+    code_at(0, T0 + 30, code, sizeof(code)); // Intervalo seguinte ainda é novo
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("bancada", code, 1, T0 + 30, &offset));
+}
+
+// Serviço removido e outro criado com o mesmo nome: os códigos aceitos do antigo não contam
+void test_replay_cache_follows_secret_id() {
+    char code[TOTP_MAX_DIGITS + 1];
+    int offset;
+    code_at(0, T0, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("bancada", code, 1, T0, &offset));
+    code_at(1, T0, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("erp", code, 1, T0, &offset));
+    services[0].secret_id = 20; // Mesmo nome e chave, outro registro
+    code_at(0, T0, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("bancada", code, 1, T0, &offset));
+    verifier_forgetService(20);
+    TEST_ASSERT_EQUAL(VerifyResult::ACCEPTED, verifier_check("bancada", code, 1, T0, &offset));
+    TEST_ASSERT_EQUAL(VerifyResult::REPLAYED, verifier_check("bancada", code, 1, T0, &offset));
+    code_at(1, T0, code, sizeof(code));
+    TEST_ASSERT_EQUAL(VerifyResult::REPLAYED, verifier_check("erp", code, 1, T0, &offset)); // Outros serviços ficam
+}
+
+void test_rejects_bad_input() {
+    int offset;
+    TEST_ASSERT_EQUAL(VerifyResult::UNKNOWN_SERVICE, verifier_check("nada", "123456", 1, T0, &offset));
+    TEST_ASSERT_EQUAL(VerifyResult::INVALID_CODE, verifier_check("bancada", "12345", 1, T0, &offset));
+    TEST_ASSERT_EQUAL(VerifyResult::INVALID_CODE, verifier_check("bancada", "12a456", 1, T0, &offset));
+    TEST_ASSERT_EQUAL(VerifyResult::INVALID_CODE, verifier_check("erp", "123456", 1, T0, &offset)); // Serviço de 8 dígitos
+}
+
+void bench_window_10() {
+    char line[96];
+    int offset;
+    uint32_t t0 = micros();
+    verifier_check("bancada", "000000", VERIFY_MAX_WINDOW, T0, &offset); // Quase sempre percorre a janela toda
+    uint32_t elapsed = micros() - t0;
+    snprintf(line, sizeof(line), "verificacao +-%d: %lu us", VERIFY_MAX_WINDOW, (unsigned long)elapsed);
+    TEST_MESSAGE(line);
+}
+
+void setup() {
+    delay(2000); // Aguarda a Serial USB-CDC
+    UNITY_BEGIN();
+    RUN_TEST(test_accepts_within_window_and_reports_offset);
+    RUN_TEST(test_replay_rejected);
+    RUN_TEST(test_replay_cache_follows_secret_id);
+    RUN_TEST(test_rejects_bad_input);
+    RUN_TEST(bench_window_10);
+    UNITY_END();
+}
+
+void loop() {}